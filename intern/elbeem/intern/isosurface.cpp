@@ -17,6 +17,10 @@
 #include <stdio.h>
 #include <cmath>
 
+#if PARALLEL==1
+#include <omp.h>
+#endif
+
 #ifdef sun
 #include "ieeefp.h"
 #endif
@@ -47,7 +51,8 @@ IsoSurface::IsoSurface(double iso) :
 	mSmoothSurface(0.0), mSmoothNormals(0.0),
 	mAcrossEdge(), mAdjacentFaces(),
 	mCutoff(-1), mCutArray(NULL), // off by default
-	mpIsoParts(NULL), mPartSize(0.), mSubdivs(0),
+	mpIsoParts(NULL), mPartSize(0.), mSubdivs(0), mNumThreads(1),
+	mSlabs(), mThreadEdgeVertices(),
 	mFlagCnt(1),
 	mSCrad1(0.), mSCrad2(0.), mSCcenter(0.)
 {
@@ -140,41 +145,223 @@ IsoSurface::~IsoSurface( void )
  *****************************************************************************/
 void IsoSurface::triangulate( void )
 {
-  double gsx,gsy,gsz; // grid spacing in x,y,z direction
-  double px,py,pz;    // current position in grid in x,y,z direction
-  IsoLevelCube cubie;    // struct for a small subcube
-	myTime_t tritimestart = getTime(); 
+	myTime_t tritimestart = getTime();
 
 	if(!mpData) {
 		errFatal("IsoSurface::triangulate","no LBM object, and no scalar field...!",SIMWORLD_INITERROR);
 		return;
 	}
 
+	// z layers of cubes, with subdivisions one per subdivided plane (skipping the zero plane)
+	const int layerStart = (mSubdivs<=1) ? 1 : mSubdivs;
+	const int layerEnd   = (mSubdivs<=1) ? (mSizez-2) : (mSizez-2)*mSubdivs;
+	const int numLayers  = layerEnd-layerStart;
+
+	// split the layers into slabs, which are triangulated in parallel. Vertices
+	// on the plane between two slabs belong to the lower one, so concatenating
+	// the slabs in order gives the same surface for any number of slabs.
+	int numSlabs = 1;
+	int numThreads = 1;
+#if PARALLEL==1
+	if(mNumThreads>1) {
+		// several slabs per thread for load balancing, but at least 4 layers each
+		numSlabs = std::min(4*mNumThreads, numLayers/4);
+		if(numSlabs<1) numSlabs = 1;
+		numThreads = std::min(mNumThreads, numSlabs);
+	}
+#endif // PARALLEL==1
+	mSlabs.resize(numSlabs);
+	for(int s=0;s<numSlabs;s++) {
+		mSlabs[s].layerStart = layerStart + ( s   *numLayers)/numSlabs;
+		mSlabs[s].layerEnd   = layerStart + ((s+1)*numLayers)/numSlabs;
+	}
+
+	// edge vertex arrays (two planes) for each thread
+	const int planeSize = mSizex*mSizey*mSubdivs*mSubdivs;
+	mThreadEdgeVertices.resize(numThreads-1);
+	for(int t=0;t<numThreads-1;t++) {
+		mThreadEdgeVertices[t].resize(3*2*planeSize);
+	}
+
+	// per node lists of particles for subdivisions
+	ParticleObject* *arppnt = NULL;
+	if(mSubdivs>1) {
+		if(mUseFullEdgeArrays) {
+			errMsg("IsoSurface::triangulate","Disabling mUseFullEdgeArrays!");
+		}
+
+		arppnt = new ParticleObject*[mSizez*mSizey*mSizex];
+
+		// construct pointers
+		// part test
+		int pInUse = 0;
+		// reset particles
+		// reset list array
+		for(int k=0;k<(mSizez);k++)
+			for(int j=0;j<(mSizey);j++)
+				for(int i=0;i<(mSizex);i++) {
+					arppnt[ISOLEVEL_INDEX(i,j,k)] = NULL;
+				}
+		if(mpIsoParts) {
+			for(vector<ParticleObject>::iterator pit= mpIsoParts->getParticlesBegin();
+					pit!= mpIsoParts->getParticlesEnd(); pit++) {
+				if( (*pit).getActive()==false ) continue;
+				if( (*pit).getType()!=PART_DROP) continue;
+				(*pit).setNext(NULL);
+			}
+			// build per node lists
+			for(vector<ParticleObject>::iterator pit= mpIsoParts->getParticlesBegin();
+					pit!= mpIsoParts->getParticlesEnd(); pit++) {
+				if( (*pit).getActive()==false ) continue;
+				if( (*pit).getType()!=PART_DROP) continue;
+				// check lifetime ignored here
+				ParticleObject *p = &(*pit);
+				const ntlVec3Gfx ppos = p->getPos();
+				const int pi= (int)round(ppos[0])+0;
+				const int pj= (int)round(ppos[1])+0;
+				int       pk= (int)round(ppos[2])+0;// no offset necessary
+				// 2d should be handled by solver. if(LBMDIM==2) { pk = 0; }
+
+				if(pi<0) continue;
+				if(pj<0) continue;
+				if(pk<0) continue;
+				if(pi>mSizex-1) continue;
+				if(pj>mSizey-1) continue;
+				if(pk>mSizez-1) continue;
+				ParticleObject* &pnt = arppnt[ISOLEVEL_INDEX(pi,pj,pk)];
+				if(pnt) {
+					// append
+					ParticleObject* listpnt = pnt;
+					while(listpnt) {
+						if(!listpnt->getNext()) {
+							listpnt->setNext(p); listpnt = NULL;
+						} else {
+							listpnt = listpnt->getNext();
+						}
+					}
+				} else {
+					// start new list
+					pnt = p;
+				}
+				pInUse++;
+			}
+		} // mpIsoParts
+
+		debMsgStd("IsoSurface::triangulate",DM_MSG,"Starting. Parts in use:"<<pInUse<<", Subdivs:"<<mSubdivs, 9);
+	}
+
+  // let the cubes march
+#if PARALLEL==1
+#pragma omp parallel for schedule(dynamic,1) num_threads(numThreads)
+#endif // PARALLEL==1
+	for(int s=0;s<numSlabs;s++) {
+		int thread = 0;
+#if PARALLEL==1
+		thread = omp_get_thread_num();
+#endif // PARALLEL==1
+		if(thread==0) {
+			triangulateSlab(mSlabs[s], mpEdgeVerticesX, mpEdgeVerticesY, mpEdgeVerticesZ, arppnt);
+		} else {
+			int *edgeVerts = &mThreadEdgeVertices[thread-1][0];
+			triangulateSlab(mSlabs[s], edgeVerts, edgeVerts+2*planeSize, edgeVerts+4*planeSize, arppnt);
+		}
+	}
+	if(arppnt) delete [] arppnt;
+
+	// concatenate slabs
+	vector<int> indexOffsets(numSlabs);
+	int numPoints = 0, numIndices = 0;
+	for(int s=0;s<numSlabs;s++) {
+		mSlabs[s].pointOffset = numPoints;
+		indexOffsets[s] = numIndices;
+		numPoints  += (int)mSlabs[s].points.size();
+		numIndices += (int)mSlabs[s].indices.size();
+	}
+	mPoints.resize(numPoints);
+	mIndices.resize(numIndices);
+
+#if PARALLEL==1
+#pragma omp parallel for schedule(static,1) num_threads(numThreads)
+#endif // PARALLEL==1
+	for(int s=0;s<numSlabs;s++) {
+		const IsoSlab &slab = mSlabs[s];
+		std::copy(slab.points.begin(), slab.points.end(), mPoints.begin()+slab.pointOffset);
+		for(int n=0;n<(int)slab.indices.size();n++) {
+			const int index = slab.indices[n];
+			if(index>=0) {
+				mIndices[indexOffsets[s]+n] = slab.pointOffset + index;
+			} else {
+				// vertex on the last plane of the previous slab
+				const IsoSlab &prev = mSlabs[s-1];
+				const int pos = std::lower_bound(prev.lastPlaneKeys.begin(), prev.lastPlaneKeys.end(), -2-index) -
+				                prev.lastPlaneKeys.begin();
+				mIndices[indexOffsets[s]+n] = prev.pointOffset + prev.lastPlaneVerts[pos];
+			}
+		}
+	}
+
+	if(mSubdivs>1) {
+		computeNormals();
+	}
+
+	// perform smoothing
+	float smoSubdfac = 1.;
+	if(mSubdivs>0) {
+		//smoSubdfac = 1./(float)(mSubdivs);
+		smoSubdfac = pow(0.55,(double)mSubdivs); // slightly stronger
+	}
+	if(mSmoothSurface>0. || mSmoothNormals>0.) debMsgStd("IsoSurface::triangulate",DM_MSG,"Smoothing...",10);
+	if(mSmoothSurface>0.0) { 
+		smoothSurface(mSmoothSurface*smoSubdfac, (mSmoothNormals<=0.0) ); 
+	}
+	if(mSmoothNormals>0.0) { 
+		smoothNormals(mSmoothNormals*smoSubdfac); 
+	}
+
+	myTime_t tritimeend = getTime(); 
+	debMsgStd("IsoSurface::triangulate",DM_MSG,"took "<< getTimeString(tritimeend-tritimestart)<<", S("<<mSmoothSurface<<","<<mSmoothNormals<<"),"<<
+			" verts:"<<mPoints.size()<<" tris:"<<(mIndices.size()/3)<<" subdivs:"<<mSubdivs
+		 , 10 );
+	if(mpIsoParts) debMsgStd("IsoSurface::triangulate",DM_MSG,"parts:"<<mpIsoParts->getNumParticles(), 10);
+}
+
+
+/******************************************************************************
+ * march the cubes of the layers of one slab, slab output is local and can be
+ * concatenated in slab order, see triangulate
+ *****************************************************************************/
+void IsoSurface::triangulateSlab(IsoSlab &slab, int *edgeVertsX, int *edgeVertsY, int *edgeVertsZ, ParticleObject **arppnt)
+{
+  double gsx,gsy,gsz; // grid spacing in x,y,z direction
+  double px,py,pz;    // current position in grid in x,y,z direction
+
+	slab.points.clear();
+	slab.indices.clear();
+	slab.lastPlaneKeys.clear();
+	slab.lastPlaneVerts.clear();
+
   // get grid spacing (-2 to have same spacing as sim)
   gsx = (mEnd[0]-mStart[0])/(double)(mSizex-2.0);
   gsy = (mEnd[1]-mStart[1])/(double)(mSizey-2.0);
   gsz = (mEnd[2]-mStart[2])/(double)(mSizez-2.0);
 
-  // clean up previous frame
-	mIndices.clear();
-	mPoints.clear();
-
 	// reset edge vertices
-  for(int i=0;i<mEdgeArSize;i++) {
-		mpEdgeVerticesX[i] = -1;
-		mpEdgeVerticesY[i] = -1;
-		mpEdgeVerticesZ[i] = -1;
+	const int planeSize = mSizex*mSizey*mSubdivs*mSubdivs;
+  for(int i=0;i<2*planeSize;i++) {
+		edgeVertsX[i] = -1;
+		edgeVertsY[i] = -1;
+		edgeVertsZ[i] = -1;
 	}
 
 	ntlVec3Gfx pos[8];
 	float value[8];
-	int cubeIndex;      // index entry of the cube 
-	int triIndices[12]; // vertex indices 
+	int cubeIndex;      // index entry of the cube
+	int triIndices[12]; // vertex indices
 	int *eVert[12];
 	IsoLevelVertex ilv;
 
 	// edges between which points?
-	const int mcEdges[24] = { 
+	const int mcEdges[24] = {
 		0,1,  1,2,  2,3,  3,0,
 		4,5,  5,6,  6,7,  7,4,
 		0,4,  1,5,  2,6,  3,7 };
@@ -186,13 +373,28 @@ void IsoSurface::triangulate( void )
 	const int cubieOffsetZ[8] = {
 		0,0,0,0,  1,1,1,1 };
 
+	// the vertices on the first plane of the slab are created by the layer
+	// below it, which belongs to the previous slab. Marching that layer again
+	// marks them with their edge key (-2-key), see triangulate
+	const int firstLayer = (mSubdivs<=1) ? 1 : mSubdivs;
+	const int lastLayer  = (mSubdivs<=1) ? (mSizez-2) : (mSizez-2)*mSubdivs;
+	if(slab.layerStart>=slab.layerEnd) return;
+	const int primeLayer = (slab.layerStart>firstLayer) ? slab.layerStart-1 : slab.layerStart;
+
+#define ISO_MARK_PREV_SLAB_EDGES() \
+	for(int e=4;e<8;e++) { \
+		if((mcEdgeTable[cubeIndex] & (1<<e)) && (*eVert[ e ] == -1)) { \
+			const int *edgeVerts = (e&1) ? edgeVertsY : edgeVertsX; \
+			*eVert[ e ] = -2 - (2*(int)(eVert[ e ]-edgeVerts-planeSize) + (e&1)); \
+		} \
+	}
+
 	const int coAdd=2;
-  // let the cubes march 
 	if(mSubdivs<=1) {
 
-		pz = mStart[2]-gsz*0.5;
-		for(int k=1;k<(mSizez-2);k++) {
-			pz += gsz;
+		for(int k=primeLayer;k<slab.layerEnd;k++) {
+			const bool prime = (k<slab.layerStart);
+			pz = mStart[2]+((double)k-0.5)*gsz;
 			py = mStart[1]-gsy*0.5;
 			for(int j=1;j<(mSizey-2);j++) {
 				py += gsy;
@@ -226,23 +428,27 @@ void IsoSurface::triangulate( void )
 					}
 
 					// where to look up if this point already exists
-					int edgek = 0;
-					if(mUseFullEdgeArrays) edgek=k;
+					const int edgek = 0;
 					const int baseIn = ISOLEVEL_INDEX( i+0, j+0, edgek+0);
-					eVert[ 0] = &mpEdgeVerticesX[ baseIn ];
-					eVert[ 1] = &mpEdgeVerticesY[ baseIn + 1 ];
-					eVert[ 2] = &mpEdgeVerticesX[ ISOLEVEL_INDEX( i+0, j+1, edgek+0) ];
-					eVert[ 3] = &mpEdgeVerticesY[ baseIn ];
-
-					eVert[ 4] = &mpEdgeVerticesX[ ISOLEVEL_INDEX( i+0, j+0, edgek+1) ];
-					eVert[ 5] = &mpEdgeVerticesY[ ISOLEVEL_INDEX( i+1, j+0, edgek+1) ];
-					eVert[ 6] = &mpEdgeVerticesX[ ISOLEVEL_INDEX( i+0, j+1, edgek+1) ];
-					eVert[ 7] = &mpEdgeVerticesY[ ISOLEVEL_INDEX( i+0, j+0, edgek+1) ];
-
-					eVert[ 8] = &mpEdgeVerticesZ[ baseIn ];
-					eVert[ 9] = &mpEdgeVerticesZ[ ISOLEVEL_INDEX( i+1, j+0, edgek+0) ];
-					eVert[10] = &mpEdgeVerticesZ[ ISOLEVEL_INDEX( i+1, j+1, edgek+0) ];
-					eVert[11] = &mpEdgeVerticesZ[ ISOLEVEL_INDEX( i+0, j+1, edgek+0) ];
+					eVert[ 0] = &edgeVertsX[ baseIn ];
+					eVert[ 1] = &edgeVertsY[ baseIn + 1 ];
+					eVert[ 2] = &edgeVertsX[ ISOLEVEL_INDEX( i+0, j+1, edgek+0) ];
+					eVert[ 3] = &edgeVertsY[ baseIn ];
+
+					eVert[ 4] = &edgeVertsX[ ISOLEVEL_INDEX( i+0, j+0, edgek+1) ];
+					eVert[ 5] = &edgeVertsY[ ISOLEVEL_INDEX( i+1, j+0, edgek+1) ];
+					eVert[ 6] = &edgeVertsX[ ISOLEVEL_INDEX( i+0, j+1, edgek+1) ];
+					eVert[ 7] = &edgeVertsY[ ISOLEVEL_INDEX( i+0, j+0, edgek+1) ];
+
+					eVert[ 8] = &edgeVertsZ[ baseIn ];
+					eVert[ 9] = &edgeVertsZ[ ISOLEVEL_INDEX( i+1, j+0, edgek+0) ];
+					eVert[10] = &edgeVertsZ[ ISOLEVEL_INDEX( i+1, j+1, edgek+0) ];
+					eVert[11] = &edgeVertsZ[ ISOLEVEL_INDEX( i+0, j+1, edgek+0) ];
+
+					if(prime) {
+						ISO_MARK_PREV_SLAB_EDGES();
+						continue;
+					}
 
 					// grid positions
 					pos[0] = ntlVec3Gfx(px    ,py    ,pz);
@@ -258,7 +464,7 @@ void IsoSurface::triangulate( void )
 					for(int e=0;e<12;e++) {
 						if (mcEdgeTable[cubeIndex] & (1<<e)) {
 							// is the vertex already calculated?
-							if(*eVert[ e ] < 0) {
+							if(*eVert[ e ] == -1) {
 								// interpolate edge
 								const int e1 = mcEdges[e*2  ];
 								const int e2 = mcEdges[e*2+1];
@@ -272,16 +478,16 @@ void IsoSurface::triangulate( void )
 								ilv.v = p1 + (p2-p1)*mu;
 								ilv.n = getNormal( i+cubieOffsetX[e1], j+cubieOffsetY[e1], k+cubieOffsetZ[e1]) * (1.0-mu) +
 												getNormal( i+cubieOffsetX[e2], j+cubieOffsetY[e2], k+cubieOffsetZ[e2]) * (    mu) ;
-								mPoints.push_back( ilv );
+								slab.points.push_back( ilv );
 
-								triIndices[e] = (mPoints.size()-1);
-								// store vertex 
+								triIndices[e] = (slab.points.size()-1);
+								// store vertex
 								*eVert[ e ] = triIndices[e];
 							}	else {
-								// retrieve  from vert array
+								// retrieve  from vert array (or previous slab)
 								triIndices[e] = *eVert[ e ];
 							}
-						} // along all edges 
+						} // along all edges
 					}
 
 					if( (i<coAdd+mCutoff) || (j<coAdd+mCutoff) ||
@@ -293,36 +499,30 @@ void IsoSurface::triangulate( void )
 						} else { continue; }
 					}
 
-					// Create the triangles... 
+					// Create the triangles...
 					for(int e=0; mcTriTable[cubeIndex][e]!=-1; e+=3) {
-						mIndices.push_back( triIndices[ mcTriTable[cubeIndex][e+0] ] );
-						mIndices.push_back( triIndices[ mcTriTable[cubeIndex][e+1] ] );
-						mIndices.push_back( triIndices[ mcTriTable[cubeIndex][e+2] ] );
+						slab.indices.push_back( triIndices[ mcTriTable[cubeIndex][e+0] ] );
+						slab.indices.push_back( triIndices[ mcTriTable[cubeIndex][e+1] ] );
+						slab.indices.push_back( triIndices[ mcTriTable[cubeIndex][e+2] ] );
 					}
-					
+
 				}//i
 			}// j
 
 			// copy edge arrays
-			if(!mUseFullEdgeArrays) {
-			for(int j=0;j<(mSizey-0);j++) 
-				for(int i=0;i<(mSizex-0);i++) {
-					//int edgek = 0;
-					const int dst = ISOLEVEL_INDEX( i+0, j+0, 0);
-					const int src = ISOLEVEL_INDEX( i+0, j+0, 1);
-					mpEdgeVerticesX[ dst ] = mpEdgeVerticesX[ src ];
-					mpEdgeVerticesY[ dst ] = mpEdgeVerticesY[ src ];
-					mpEdgeVerticesZ[ dst ] = mpEdgeVerticesZ[ src ];
-					mpEdgeVerticesX[ src ]=-1;
-					mpEdgeVerticesY[ src ]=-1;
-					mpEdgeVerticesZ[ src ]=-1;
-				}
-			} // */
+			for(int n=0;n<planeSize;n++) {
+				edgeVertsX[ n ] = edgeVertsX[ n+planeSize ];
+				edgeVertsY[ n ] = edgeVertsY[ n+planeSize ];
+				edgeVertsZ[ n ] = edgeVertsZ[ n+planeSize ];
+				edgeVertsX[ n+planeSize ]=-1;
+				edgeVertsY[ n+planeSize ]=-1;
+				edgeVertsZ[ n+planeSize ]=-1;
+			}
 
 		} // k
 
-  	// precalculate normals using an approximation of the scalar field gradient 
-		for(int ni=0;ni<(int)mPoints.size();ni++) { normalize( mPoints[ni].n ); }
+  	// precalculate normals using an approximation of the scalar field gradient
+		for(int ni=0;ni<(int)slab.points.size();ni++) { normalize( slab.points[ni].n ); }
 
 	} else { // subdivs
 
@@ -347,77 +547,15 @@ void IsoSurface::triangulate( void )
 		gsx *= subdfac;
 		gsy *= subdfac;
 		gsz *= subdfac;
-		if(mUseFullEdgeArrays) {
-			errMsg("IsoSurface::triangulate","Disabling mUseFullEdgeArrays!");
-		}
 
 		// subdiv local arrays
 		gfxReal orgval[8];
 		gfxReal subdAr[2][11][11]; // max 10 subdivs!
-		ParticleObject* *arppnt = new ParticleObject*[mSizez*mSizey*mSizex];
-
-		// construct pointers
-		// part test
-		int pInUse = 0;
-		int pUsedTest = 0;
-		// reset particles
-		// reset list array
-		for(int k=0;k<(mSizez);k++) 
-			for(int j=0;j<(mSizey);j++) 
-				for(int i=0;i<(mSizex);i++) {
-					arppnt[ISOLEVEL_INDEX(i,j,k)] = NULL;
-				}
-		if(mpIsoParts) {
-			for(vector<ParticleObject>::iterator pit= mpIsoParts->getParticlesBegin();
-					pit!= mpIsoParts->getParticlesEnd(); pit++) {
-				if( (*pit).getActive()==false ) continue;
-				if( (*pit).getType()!=PART_DROP) continue;
-				(*pit).setNext(NULL);
-			}
-			// build per node lists
-			for(vector<ParticleObject>::iterator pit= mpIsoParts->getParticlesBegin();
-					pit!= mpIsoParts->getParticlesEnd(); pit++) {
-				if( (*pit).getActive()==false ) continue;
-				if( (*pit).getType()!=PART_DROP) continue;
-				// check lifetime ignored here
-				ParticleObject *p = &(*pit);
-				const ntlVec3Gfx ppos = p->getPos();
-				const int pi= (int)round(ppos[0])+0; 
-				const int pj= (int)round(ppos[1])+0; 
-				int       pk= (int)round(ppos[2])+0;// no offset necessary
-				// 2d should be handled by solver. if(LBMDIM==2) { pk = 0; }
 
-				if(pi<0) continue;
-				if(pj<0) continue;
-				if(pk<0) continue;
-				if(pi>mSizex-1) continue;
-				if(pj>mSizey-1) continue;
-				if(pk>mSizez-1) continue;
-				ParticleObject* &pnt = arppnt[ISOLEVEL_INDEX(pi,pj,pk)]; 
-				if(pnt) {
-					// append
-					ParticleObject* listpnt = pnt;
-					while(listpnt) {
-						if(!listpnt->getNext()) {
-							listpnt->setNext(p); listpnt = NULL;
-						} else {
-							listpnt = listpnt->getNext();
-						}
-					}
-				} else {
-					// start new list
-					pnt = p;
-				}
-				pInUse++;
-			}
-		} // mpIsoParts
-
-		debMsgStd("IsoSurface::triangulate",DM_MSG,"Starting. Parts in use:"<<pInUse<<", Subdivs:"<<mSubdivs, 9);
-		pz = mStart[2]-(double)(0.*gsz)-0.5*orgGsz;
-		for(int ok=1;ok<(mSizez-2)*mSubdivs;ok++) {
-			pz += gsz;
+		for(int ok=primeLayer;ok<slab.layerEnd;ok++) {
+			const bool prime = (ok<slab.layerStart);
+			pz = mStart[2]-0.5*orgGsz+(double)ok*gsz;
 			const int k = ok/mSubdivs;
-			if(k<=0) continue; // skip zero plane
 			for(int j=1;j<(mSizey-2);j++) {
 				for(int i=1;i<(mSizex-2);i++) {
 
@@ -431,9 +569,9 @@ void IsoSurface::triangulate( void )
 					orgval[7] = *getData(i  ,j+1,k+1);
 
 					// prebuild subsampled array slice
-					const int sdkOffset = ok-k*mSubdivs; 
-					for(int sdk=0; sdk<2; sdk++) 
-						for(int sdj=0; sdj<mSubdivs+1; sdj++) 
+					const int sdkOffset = ok-k*mSubdivs;
+					for(int sdk=0; sdk<2; sdk++)
+						for(int sdj=0; sdj<mSubdivs+1; sdj++)
 							for(int sdi=0; sdi<mSubdivs+1; sdi++) {
 								subdAr[sdk][sdj][sdi] = ISOTRILININT(sdi*subdfac, sdj*subdfac, (sdkOffset+sdk)*subdfac);
 							}
@@ -447,7 +585,7 @@ void IsoSurface::triangulate( void )
 						if(j+poj>=mSizey-1) continue;
 					for(int poi=-poDistOffset; poi<1+poDistOffset; poi++) {
 						if(i+poi<0) continue;
-						if(i+poi>=mSizex-1) continue; 
+						if(i+poi>=mSizex-1) continue;
 						ParticleObject *p;
 						p = arppnt[ISOLEVEL_INDEX(i+poi,j+poj,k+pok)];
 						while(p) { // */
@@ -459,10 +597,9 @@ void IsoSurface::triangulate( void )
 						ParticleObject *p;
 						p = &(*pit); // */
 
-							pUsedTest++;
 							ntlVec3Gfx ppos = p->getPos();
-							const int spi= (int)round( (ppos[0]+1.-(gfxReal)i) *(gfxReal)mSubdivs-1.5); 
-							const int spj= (int)round( (ppos[1]+1.-(gfxReal)j) *(gfxReal)mSubdivs-1.5); 
+							const int spi= (int)round( (ppos[0]+1.-(gfxReal)i) *(gfxReal)mSubdivs-1.5);
+							const int spj= (int)round( (ppos[1]+1.-(gfxReal)j) *(gfxReal)mSubdivs-1.5);
 							const int spk= (int)round( (ppos[2]+1.-(gfxReal)k) *(gfxReal)mSubdivs-1.5)-sdkOffset; // why -2?
 							// 2d should be handled by solver. if(LBMDIM==2) { spk = 0; }
 
@@ -479,7 +616,7 @@ void IsoSurface::triangulate( void )
 								if(spj+swj<         0) { continue; }
 								if(spj+swj>mSubdivs+0) { continue; } // */
 							for(int swi=-icellpsize; swi<=icellpsize; swi++) {
-								if(spi+swi<         0) { continue; } 
+								if(spi+swi<         0) { continue; }
 								if(spi+swi>mSubdivs+0) { continue; } // */
 								ntlVec3Gfx cellp = ntlVec3Gfx(
 										(1.5+(gfxReal)(spi+swi))           *subdfac + (gfxReal)(i-1),
@@ -487,21 +624,21 @@ void IsoSurface::triangulate( void )
 										(1.5+(gfxReal)(spk+swk)+sdkOffset) *subdfac + (gfxReal)(k-1)
 										);
 								//if(swi==0 && swj==0 && swk==0) subdAr[spk][spj][spi] = 1.; // DEBUG
-								// clip domain boundaries again 
-								if(cellp[0]<1.) { continue; } 
-								if(cellp[1]<1.) { continue; } 
-								if(cellp[2]<1.) { continue; } 
-								if(cellp[0]>(gfxReal)mSizex-3.) { continue; } 
-								if(cellp[1]>(gfxReal)mSizey-3.) { continue; } 
-								if(cellp[2]>(gfxReal)mSizez-3.) { continue; } 
+								// clip domain boundaries again
+								if(cellp[0]<1.) { continue; }
+								if(cellp[1]<1.) { continue; }
+								if(cellp[2]<1.) { continue; }
+								if(cellp[0]>(gfxReal)mSizex-3.) { continue; }
+								if(cellp[1]>(gfxReal)mSizey-3.) { continue; }
+								if(cellp[2]>(gfxReal)mSizez-3.) { continue; }
 								gfxReal len = norm(cellp-ppos);
-								gfxReal isoadd = 0.; 
+								gfxReal isoadd = 0.;
 								const gfxReal baseIsoVal = mIsoValue*1.1;
-								if(len<pfLen) { 
+								if(len<pfLen) {
 									isoadd = baseIsoVal*1.;
-								} else { 
+								} else {
 									// falloff linear with pfLen (kernel size=2pfLen
-									isoadd = baseIsoVal*(1. - (len-pfLen)/(pfLen)); 
+									isoadd = baseIsoVal*(1. - (len-pfLen)/(pfLen));
 								}
 								if(isoadd<0.) { continue; }
 								//errMsg("ISOPPP"," at "<<PRINT_IJK<<" sp"<<PRINT_VEC(spi+swi,spj+swj,spk+swk)<<" cellp"<<cellp<<" pp"<<ppos << " l"<< len<< " add"<< isoadd);
@@ -520,14 +657,14 @@ void IsoSurface::triangulate( void )
 						px = mStart[0]+(((double)i-0.5)*orgGsx)-gsx;
 						for(int si=0;si<mSubdivs;si++) {
 							px += gsx;
-							value[0] = subdAr[0+0][sj+0][si+0]; 
-							value[1] = subdAr[0+0][sj+0][si+1]; 
-							value[2] = subdAr[0+0][sj+1][si+1]; 
-							value[3] = subdAr[0+0][sj+1][si+0]; 
-							value[4] = subdAr[0+1][sj+0][si+0]; 
-							value[5] = subdAr[0+1][sj+0][si+1]; 
-							value[6] = subdAr[0+1][sj+1][si+1]; 
-							value[7] = subdAr[0+1][sj+1][si+0]; 
+							value[0] = subdAr[0+0][sj+0][si+0];
+							value[1] = subdAr[0+0][sj+0][si+1];
+							value[2] = subdAr[0+0][sj+1][si+1];
+							value[3] = subdAr[0+0][sj+1][si+0];
+							value[4] = subdAr[0+1][sj+0][si+0];
+							value[5] = subdAr[0+1][sj+0][si+1];
+							value[6] = subdAr[0+1][sj+1][si+1];
+							value[7] = subdAr[0+1][sj+1][si+0];
 
 							// check intersections of isosurface with edges, and calculate cubie index
 							cubeIndex = 0;
@@ -545,20 +682,25 @@ void IsoSurface::triangulate( void )
 							// where to look up if this point already exists
 							const int edgek = 0;
 							const int baseIn = EDGEAR_INDEX( i+0, j+0, edgek+0, si,sj);
-							eVert[ 0] = &mpEdgeVerticesX[ baseIn ];
-							eVert[ 1] = &mpEdgeVerticesY[ baseIn + 1 ];
-							eVert[ 2] = &mpEdgeVerticesX[ EDGEAR_INDEX( i, j, edgek+0, si+0,sj+1) ];
-							eVert[ 3] = &mpEdgeVerticesY[ baseIn ];                             
-																																									
-							eVert[ 4] = &mpEdgeVerticesX[ EDGEAR_INDEX( i, j, edgek+1, si+0,sj+0) ];
-							eVert[ 5] = &mpEdgeVerticesY[ EDGEAR_INDEX( i, j, edgek+1, si+1,sj+0) ]; // with subdivs
-							eVert[ 6] = &mpEdgeVerticesX[ EDGEAR_INDEX( i, j, edgek+1, si+0,sj+1) ];
-							eVert[ 7] = &mpEdgeVerticesY[ EDGEAR_INDEX( i, j, edgek+1, si+0,sj+0) ];
-																																									
-							eVert[ 8] = &mpEdgeVerticesZ[ baseIn ];                             
-							eVert[ 9] = &mpEdgeVerticesZ[ EDGEAR_INDEX( i, j, edgek+0, si+1,sj+0) ]; // with subdivs
-							eVert[10] = &mpEdgeVerticesZ[ EDGEAR_INDEX( i, j, edgek+0, si+1,sj+1) ];
-							eVert[11] = &mpEdgeVerticesZ[ EDGEAR_INDEX( i, j, edgek+0, si+0,sj+1) ];
+							eVert[ 0] = &edgeVertsX[ baseIn ];
+							eVert[ 1] = &edgeVertsY[ baseIn + 1 ];
+							eVert[ 2] = &edgeVertsX[ EDGEAR_INDEX( i, j, edgek+0, si+0,sj+1) ];
+							eVert[ 3] = &edgeVertsY[ baseIn ];
+
+							eVert[ 4] = &edgeVertsX[ EDGEAR_INDEX( i, j, edgek+1, si+0,sj+0) ];
+							eVert[ 5] = &edgeVertsY[ EDGEAR_INDEX( i, j, edgek+1, si+1,sj+0) ]; // with subdivs
+							eVert[ 6] = &edgeVertsX[ EDGEAR_INDEX( i, j, edgek+1, si+0,sj+1) ];
+							eVert[ 7] = &edgeVertsY[ EDGEAR_INDEX( i, j, edgek+1, si+0,sj+0) ];
+
+							eVert[ 8] = &edgeVertsZ[ baseIn ];
+							eVert[ 9] = &edgeVertsZ[ EDGEAR_INDEX( i, j, edgek+0, si+1,sj+0) ]; // with subdivs
+							eVert[10] = &edgeVertsZ[ EDGEAR_INDEX( i, j, edgek+0, si+1,sj+1) ];
+							eVert[11] = &edgeVertsZ[ EDGEAR_INDEX( i, j, edgek+0, si+0,sj+1) ];
+
+							if(prime) {
+								ISO_MARK_PREV_SLAB_EDGES();
+								continue;
+							}
 
 							// grid positions
 							pos[0] = ntlVec3Gfx(px    ,py    ,pz);
@@ -574,7 +716,7 @@ void IsoSurface::triangulate( void )
 							for(int e=0;e<12;e++) {
 								if (mcEdgeTable[cubeIndex] & (1<<e)) {
 									// is the vertex already calculated?
-									if(*eVert[ e ] < 0) {
+									if(*eVert[ e ] == -1) {
 										// interpolate edge
 										const int e1 = mcEdges[e*2  ];
 										const int e2 = mcEdges[e*2+1];
@@ -586,28 +728,27 @@ void IsoSurface::triangulate( void )
 
 										// init isolevel vertex
 										ilv.v = p1 + (p2-p1)*mu; // with subdivs
-										mPoints.push_back( ilv );
-										triIndices[e] = (mPoints.size()-1);
-										// store vertex 
-										*eVert[ e ] = triIndices[e]; 
+										slab.points.push_back( ilv );
+										triIndices[e] = (slab.points.size()-1);
+										// store vertex
+										*eVert[ e ] = triIndices[e];
 									}	else {
-										// retrieve  from vert array
+										// retrieve  from vert array (or previous slab)
 										triIndices[e] = *eVert[ e ];
 									}
-								} // along all edges 
+								} // along all edges
 							}
 							// removed cutoff treatment...
 
-							// Create the triangles... 
+							// Create the triangles...
 							for(int e=0; mcTriTable[cubeIndex][e]!=-1; e+=3) {
-								mIndices.push_back( triIndices[ mcTriTable[cubeIndex][e+0] ] );
-								mIndices.push_back( triIndices[ mcTriTable[cubeIndex][e+1] ] ); // with subdivs
-								mIndices.push_back( triIndices[ mcTriTable[cubeIndex][e+2] ] );
-								//errMsg("TTT"," i1"<<mIndices[mIndices.size()-3]<<" "<< " i2"<<mIndices[mIndices.size()-2]<<" "<< " i3"<<mIndices[mIndices.size()-1]<<" "<< mIndices.size() );
+								slab.indices.push_back( triIndices[ mcTriTable[cubeIndex][e+0] ] );
+								slab.indices.push_back( triIndices[ mcTriTable[cubeIndex][e+1] ] ); // with subdivs
+								slab.indices.push_back( triIndices[ mcTriTable[cubeIndex][e+2] ] );
 							}
 
 							} // triangles in edge table?
-							
+
 						}//si
 					}// sj
 
@@ -615,46 +756,27 @@ void IsoSurface::triangulate( void )
 			}// j
 
 			// copy edge arrays
-			for(int j=0;j<(mSizey-0)*mSubdivs;j++) 
-				for(int i=0;i<(mSizex-0)*mSubdivs;i++) {
-					//int edgek = 0;
-					const int dst = EDGEAR_INDEX( 0, 0, 0, i,j);
-					const int src = EDGEAR_INDEX( 0, 0, 1, i,j);
-					mpEdgeVerticesX[ dst ] = mpEdgeVerticesX[ src ];
-					mpEdgeVerticesY[ dst ] = mpEdgeVerticesY[ src ]; // with subdivs
-					mpEdgeVerticesZ[ dst ] = mpEdgeVerticesZ[ src ];
-					mpEdgeVerticesX[ src ]=-1;
-					mpEdgeVerticesY[ src ]=-1; // with subdivs
-					mpEdgeVerticesZ[ src ]=-1;
-				}
-			// */
+			for(int n=0;n<planeSize;n++) {
+				edgeVertsX[ n ] = edgeVertsX[ n+planeSize ];
+				edgeVertsY[ n ] = edgeVertsY[ n+planeSize ]; // with subdivs
+				edgeVertsZ[ n ] = edgeVertsZ[ n+planeSize ];
+				edgeVertsX[ n+planeSize ]=-1;
+				edgeVertsY[ n+planeSize ]=-1; // with subdivs
+				edgeVertsZ[ n+planeSize ]=-1;
+			}
 
 		} // ok, k subdiv loop
 
-		//delete [] subdAr;
-		delete [] arppnt;
-		computeNormals();
 	} // with subdivs
+#undef ISO_MARK_PREV_SLAB_EDGES
 
-	// perform smoothing
-	float smoSubdfac = 1.;
-	if(mSubdivs>0) {
-		//smoSubdfac = 1./(float)(mSubdivs);
-		smoSubdfac = pow(0.55,(double)mSubdivs); // slightly stronger
-	}
-	if(mSmoothSurface>0. || mSmoothNormals>0.) debMsgStd("IsoSurface::triangulate",DM_MSG,"Smoothing...",10);
-	if(mSmoothSurface>0.0) { 
-		smoothSurface(mSmoothSurface*smoSubdfac, (mSmoothNormals<=0.0) ); 
-	}
-	if(mSmoothNormals>0.0) { 
-		smoothNormals(mSmoothNormals*smoSubdfac); 
+	// store the vertices of the last plane for the next slab, by edge key
+	if(slab.layerEnd<lastLayer) {
+		for(int n=0;n<planeSize;n++) {
+			if(edgeVertsX[n]>=0) { slab.lastPlaneKeys.push_back(2*n+0); slab.lastPlaneVerts.push_back(edgeVertsX[n]); }
+			if(edgeVertsY[n]>=0) { slab.lastPlaneKeys.push_back(2*n+1); slab.lastPlaneVerts.push_back(edgeVertsY[n]); }
+		}
 	}
-
-	myTime_t tritimeend = getTime(); 
-	debMsgStd("IsoSurface::triangulate",DM_MSG,"took "<< getTimeString(tritimeend-tritimestart)<<", S("<<mSmoothSurface<<","<<mSmoothNormals<<"),"<<
-			" verts:"<<mPoints.size()<<" tris:"<<(mIndices.size()/3)<<" subdivs:"<<mSubdivs
-		 , 10 );
-	if(mpIsoParts) debMsgStd("IsoSurface::triangulate",DM_MSG,"parts:"<<mpIsoParts->getNumParticles(), 10);
 }
 
 
@@ -769,10 +891,12 @@ void IsoSurface::setSmoothRad(float radi1, float radi2, ntlVec3Gfx mscc) {
 
 // compute normals for all generated triangles
 void IsoSurface::computeNormals() {
-  for(int i=0;i<(int)mPoints.size();i++) {
-		mPoints[i].n = ntlVec3Gfx(0.);
-	}
-
+	// weighted triangle normals for each corner are computed in parallel, and
+	// summed per vertex in triangle order (same result for any thread count)
+	vector<ntlVec3Gfx> cornerNormals(mIndices.size());
+#if PARALLEL==1
+#pragma omp parallel for schedule(static) num_threads(mNumThreads)
+#endif // PARALLEL==1
   for(int i=0;i<(int)mIndices.size();i+=3) {
     const int t1 = mIndices[i];
     const int t2 = mIndices[i+1];
@@ -787,11 +911,21 @@ void IsoSurface::computeNormals() {
 		const gfxReal len2 = normNoSqrt(n2);
 		const gfxReal len3 = normNoSqrt(n3);
 		const ntlVec3Gfx norm = cross(n1,n2);
-		mPoints[t1].n += norm * (1./(len1*len3));
-		mPoints[t2].n += norm * (1./(len1*len2));
-		mPoints[t3].n += norm * (1./(len2*len3));
+		cornerNormals[i  ] = norm * (1./(len1*len3));
+		cornerNormals[i+1] = norm * (1./(len1*len2));
+		cornerNormals[i+2] = norm * (1./(len2*len3));
+	}
+
+  for(int i=0;i<(int)mPoints.size();i++) {
+		mPoints[i].n = ntlVec3Gfx(0.);
+	}
+  for(int i=0;i<(int)mIndices.size();i++) {
+		mPoints[mIndices[i]].n += cornerNormals[i];
 	}
 
+#if PARALLEL==1
+#pragma omp parallel for schedule(static) num_threads(mNumThreads)
+#endif // PARALLEL==1
   for(int i=0;i<(int)mPoints.size();i++) {
 		normalize(mPoints[i].n);
 	}
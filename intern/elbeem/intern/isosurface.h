@@ -26,6 +26,7 @@
 #define ISOLEVEL_INDEX(ii,ij,ik) ((mSizex*mSizey*(ik))+(mSizex*(ij))+((ii)))
 
 class ParticleTracer;
+class ParticleObject;
 
 /* struct for a small cube in the scalar field */
 typedef struct {
@@ -40,6 +41,21 @@ typedef struct {
   ntlVec3Gfx n; // vertex normal
 } IsoLevelVertex;
 
+/* marching cubes output of a range of z layers, see IsoSurface::triangulate */
+typedef struct {
+  // first and last+1 layer of the slab
+  int layerStart, layerEnd;
+  // vertices created in this slab
+  vector<IsoLevelVertex> points;
+  // triangle vertex indices local to the slab, values below -1 reference
+  // the vertex with edge key (-2-value) in the last plane of the previous slab
+  vector<int> indices;
+  // sorted edge keys and local vertex indices of the last plane of the slab
+  vector<int> lastPlaneKeys, lastPlaneVerts;
+  // index of the first slab vertex in mPoints
+  int pointOffset;
+} IsoSlab;
+
 //! class to triangulate a scalar field, e.g. for
 // the fluid surface, templated by scalar field access object 
 class IsoSurface : 
@@ -72,6 +88,8 @@ class IsoSurface :
 			mSubdivs = s;
 		}
 		int  getSubdivs() { return mSubdivs;}
+		/*! set number of threads used by triangulate */
+		void setNumThreads(int num) { mNumThreads = (num<1) ? 1 : num; }
 		/*! set full edge settings, this has to be done before init! */
 		void setUseFulledgeArrays(bool set) { 
 			if(mInitDone) errFatal("IsoSurface::setUseFulledgeArrays","Changing usefulledge after init!", SIMWORLD_INITERROR);
@@ -133,6 +151,12 @@ class IsoSurface :
 		float mPartSize;
 		//! no of subdivisions
 		int mSubdivs;
+		//! no of threads for triangulation
+		int mNumThreads;
+		//! triangulation slabs, kept to reuse allocations
+		vector<IsoSlab> mSlabs;
+		//! edge vertex arrays of threads other than the first (X,Y,Z)
+		vector< vector<int> > mThreadEdgeVertices;
 		
 		//! trimesh vars
 		vector<int> flags;
@@ -225,6 +249,8 @@ class IsoSurface :
 
 		//! compute normal
 		inline ntlVec3Gfx getNormal(int i, int j,int k);
+		//! march the cubes of one slab, see triangulate
+		void triangulateSlab(IsoSlab &slab, int *edgeVertsX, int *edgeVertsY, int *edgeVertsZ, ParticleObject **arppnt);
 		//! smoothing helper function
 		bool diffuseVertexField(ntlVec3Gfx *field, int pointerScale, int v, float invsigma2, ntlVec3Gfx &flt);
 		vector<int> mDboundary;
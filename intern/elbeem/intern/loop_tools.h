@@ -19,11 +19,13 @@
 	const int iend   = mLevel[mMaxRefine].lSizex-1-gridLoopBound; \
 	LbmFloat calcCurrentMass=0; \
 	LbmFloat calcCurrentVolume=0; \
+	LbmFloat calcInitialMass=0; \
 	int      calcCellsFilled=0; \
 	int      calcCellsEmptied=0; \
 	int      calcNumUsedCells=0; \
 	/* This is a generic macro, and now all it's users are using all variables. */ \
 	(void)calcCurrentMass; \
+	(void)calcInitialMass; \
 	(void)calcCellsFilled  \
 
 
@@ -37,6 +39,8 @@
 #define LIST_EMPTY(x) mListEmpty.push_back( x );
 #define LIST_FULL(x)  mListFull.push_back( x );
 #define FSGR_ADDPART(x)  mpParticles->addFullParticle( x );
+#define FSGR_ADDMASS(m,v)  calcCurrentMass += (m); calcCurrentVolume += (v);
+#define FSGR_ADDINITMASS(m)  calcInitialMass += (m);
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 #define  GRID_REGION_START()  \
@@ -69,6 +73,9 @@
 #define LIST_EMPTY(x)    calcListEmpty.push_back( x );
 #define LIST_FULL(x)     calcListFull.push_back( x );
 #define FSGR_ADDPART(x)  calcListParts.push_back( x );
+// sums of a row, added to the totals in row order at the end of the plane
+#define FSGR_ADDMASS(m,v)  calcRowMass += (m); calcRowVolume += (v);
+#define FSGR_ADDINITMASS(m)  calcRowInitialMass += (m);
 
 
 // parallel region
@@ -92,6 +99,9 @@
 	vector<LbmPoint> calcListFull; \
 	vector<LbmPoint> calcListEmpty; \
 	vector<ParticleObject> calcListParts; \
+	vector<LbmFloat> calcRowsMass, calcRowsVolume, calcRowsInitialMass; \
+	LbmFloat calcRowMass, calcRowVolume, calcRowInitialMass; \
+	calcRowMass = calcRowVolume = calcRowInitialMass = 0.0; \
 	LbmFloat calcMxvx, calcMxvy, calcMxvz, calcMaxVlen; \
 	calcMxvx = calcMxvy = calcMxvz = calcMaxVlen = 0.0; \
 	calcListEmpty.reserve(mListEmpty.capacity() / omp_get_num_threads() ); \
@@ -121,15 +131,10 @@
 	kstart = temp-1; \
 	} \
 	 \
-	const int Nj = mLevel[mMaxRefine].lSizey; \
-	int jstart = 0+( (id * Nj ) / Nthrds ); \
-	int jend   = 0+(((id+1) * Nj ) / Nthrds ); \
-	if( ((Nj/Nthrds) *Nthrds) != Nj) { \
-	errMsg("LbmFsgrSolver","Invalid domain size Nj="<<Nj<<" Nthrds="<<Nthrds); \
-	} \
-	 \
-	if(jstart<gridLoopBound) jstart = gridLoopBound; \
-	if(jend>mLevel[mMaxRefine].lSizey-gridLoopBound) jend = mLevel[mMaxRefine].lSizey-gridLoopBound; \
+	/* balanced chunks of the inner rows, any Nj works with any Nthrds */ \
+	const int Nj = mLevel[mMaxRefine].lSizey - 2*gridLoopBound; \
+	int jstart = gridLoopBound+( (id * Nj ) / Nthrds ); \
+	int jend   = gridLoopBound+(((id+1) * Nj ) / Nthrds ); \
 	 \
 	debMsgStd("ParaLoop::OMP",DM_MSG,"Thread:"<<id<<" i:"<<istart<<"-"<<iend<<" j:"<<jstart<<"-"<<jend<<", k:"<<kstart<<"-"<<kend<<"  ", 1); \
 	 \
@@ -7,12 +7,55 @@
 			} // i
 		int i=0; //dummy
 		ADVANCE_POINTERS(2*gridLoopBound);
+#	if COMPRESSGRIDS==1
+#	if PARALLEL==1
+		calcRowsMass.push_back(calcRowMass);
+		calcRowsVolume.push_back(calcRowVolume);
+		calcRowsInitialMass.push_back(calcRowInitialMass);
+		calcRowMass = calcRowVolume = calcRowInitialMass = 0.0;
+#	endif // PARALLEL==1
+#	endif // COMPRESSGRIDS==1
 	} // j
 
 #	if COMPRESSGRIDS==1
 #	if PARALLEL==1
 	//frintf(stderr," (id=%d k=%d) ",id,k);
-#pragma omp barrier
+	// merge the results of this plane in thread order (iteration t runs on
+	// thread t), which is the j order of the serial loop, so that the cell
+	// lists, particles and sums do not depend on the number of threads. The
+	// implicit barrier at the end of the loop separates the planes.
+#pragma omp for ordered schedule(static,1)
+	for(int t=0; t<Nthrds; t++) {
+#pragma omp ordered
+	{
+		if(doReduce) {
+			// synchronize global vars
+			for(size_t j=0; j<calcListFull.size() ; j++) mListFull.push_back( calcListFull[j] );
+			for(size_t j=0; j<calcListEmpty.size(); j++) mListEmpty.push_back( calcListEmpty[j] );
+			for(size_t j=0; j<calcListParts.size(); j++) mpParticles->addFullParticle( calcListParts[j] );
+			for(size_t j=0; j<calcRowsMass.size(); j++) {
+				calcCurrentMass   += calcRowsMass[j];
+				calcCurrentVolume += calcRowsVolume[j];
+				calcInitialMass   += calcRowsInitialMass[j];
+			}
+			if(calcMaxVlen>mMaxVlen) {
+				mMxvx = calcMxvx;
+				mMxvy = calcMxvy;
+				mMxvz = calcMxvz;
+				mMaxVlen = calcMaxVlen;
+			}
+			if(0) {debMsgStd("OMP_CRIT",DM_MSG,	"reduce id"<<id<<" curr: "<<mMaxVlen<<"|"<<mMxvx<<","<<mMxvy<<","<<mMxvz<<
+																					"      calc[ "<<calcMaxVlen<<"|"<<calcMxvx<<","<<calcMxvy<<","<<calcMxvz<<"]  " ,4 ); }
+		}
+	} // ordered
+	} // t
+	calcListFull.clear();
+	calcListEmpty.clear();
+	calcListParts.clear();
+	calcRowsMass.clear();
+	calcRowsVolume.clear();
+	calcRowsInitialMass.clear();
+	calcMxvx = calcMxvy = calcMxvz = calcMaxVlen = 0.0;
 #	endif // PARALLEL==1
 #	else // COMPRESSGRIDS==1
 	int i=0; //dummy
@@ -21,25 +64,6 @@
 
 } // all cell loop k,j,i
 
-#pragma omp critical
-{
-	if(doReduce) {
-		// synchronize global vars
-		for(size_t j=0; j<calcListFull.size() ; j++) mListFull.push_back( calcListFull[j] ); 
-		for(size_t j=0; j<calcListEmpty.size(); j++) mListEmpty.push_back( calcListEmpty[j] ); 
-		for(size_t j=0; j<calcListParts.size(); j++) mpParticles->addFullParticle( calcListParts[j] );
-		if(calcMaxVlen>mMaxVlen) {  
-			mMxvx = calcMxvx;  
-			mMxvy = calcMxvy;  
-			mMxvz = calcMxvz;  
-			mMaxVlen = calcMaxVlen;  
-		}  
-		if(0) {debMsgStd("OMP_CRIT",DM_MSG,	"reduce id"<<id<<" curr: "<<mMaxVlen<<"|"<<mMxvx<<","<<mMxvy<<","<<mMxvz<< 
-																				"      calc[ "<<calcMaxVlen<<"|"<<calcMxvx<<","<<calcMxvy<<","<<calcMxvz<<"]  " ,4 ); }
-	}
-} // critical
-
 
-} /* main_region */  
+} /* main_region */
 	//?lobOutstrForce = true;
-
@@ -802,11 +802,8 @@ bool LbmFsgrSolver::initializeSolverMemory()
 	}
 
 #if PARALLEL == 1
-	/*
-	// DG: this would be the correct sanity check, not the "hack below" */
-	// if(( mSizey / mNumOMPThreads) * mNumOMPThreads != mSizey) {
-		// setNumOMPThreads();
-	//}
+	// rows are split into balanced chunks per thread (see GRID_REGION_START),
+	// so only more threads than rows would leave threads without work
 	if( mSizey < mNumOMPThreads ) {
 		setNumOMPThreads(mSizey);
 	}
@@ -1014,6 +1011,9 @@ bool LbmFsgrSolver::initializeSolverMemory()
 		mpIso->setUseFulledgeArrays(true);
 	}
 	mpIso->setSubdivs(isosubs);
+#if PARALLEL==1
+	mpIso->setNumThreads(mNumOMPThreads);
+#endif // PARALLEL==1
 
 	mpIso->initializeIsosurface( isosx,isosy,isosz, vec2G(isodist) );
 
@@ -1058,6 +1058,9 @@ bool LbmFsgrSolver::initializeSolverMemory()
 		mpPreviewSurface->setIsolevel( mIsoValue );
 		// usually dont display for rendering
 		mpPreviewSurface->setVisible( false );
+#if PARALLEL==1
+		mpPreviewSurface->setNumThreads(mNumOMPThreads);
+#endif // PARALLEL==1
 
 		mpPreviewSurface->setStart( vec2G(isostart) );
 		mpPreviewSurface->setEnd(   vec2G(isoend) );
@@ -377,15 +377,13 @@ LbmFsgrSolver::mainLoop(const int lev)
 	const bool doReduce = true;
 	const int gridLoopBound=1;
 	int calcNumInvIfCells = 0;
-	LbmFloat calcInitialMass = 0;
 	GRID_REGION_INIT();
 #if PARALLEL==1
 	const int gDebugLevel = ::gDebugLevel;
-#pragma omp parallel default(none) num_threads(mNumOMPThreads) \
+#pragma omp parallel default(shared) num_threads(mNumOMPThreads) \
   reduction(+: \
-	  calcCurrentMass,calcCurrentVolume, \
 		calcCellsFilled,calcCellsEmptied, \
-		calcNumUsedCells,calcNumInvIfCells,calcInitialMass)
+		calcNumUsedCells,calcNumInvIfCells)
 	GRID_REGION_START();
 #else // PARALLEL==1
 	GRID_REGION_START();
@@ -468,10 +466,9 @@ LbmFsgrSolver::mainLoop(const int lev)
 				RAC(tcel, dMass) = RAC(tcel, dFfrac) = iniRho;
 				RAC(tcel, dFlux) = FLUX_INIT;
 				changeFlag(lev, i,j,k, TSET(lev), CFInter);
-				calcCurrentMass += iniRho; 
-				calcCurrentVolume += 1.0; 
+				FSGR_ADDMASS(iniRho, 1.0);
 				calcNumUsedCells++;
-				calcInitialMass += iniRho;
+				FSGR_ADDINITMASS(iniRho);
 				// dont treat cell until next step
 				continue;
 			} 
@@ -505,7 +502,7 @@ LbmFsgrSolver::mainLoop(const int lev)
 			OPTIMIZED_STREAMCOLLIDE; PERFORM_USQRMAXCHECK;
 			RAC(tcel,dFfrac) = 1.0; 
 			*pFlagDst = (CellFlagType)oldFlag; // newFlag;
-			calcCurrentMass += rho; calcCurrentVolume += 1.0;
+			FSGR_ADDMASS(rho, 1.0);
 			calcNumUsedCells++;
 			continue;
 		}// TEST ME FASTER? */
@@ -582,8 +579,7 @@ LbmFsgrSolver::mainLoop(const int lev)
 			// "normal" fluid cells
 			RAC(tcel,dFfrac) = 1.0; 
 			*pFlagDst = (CellFlagType)oldFlag; // newFlag;
-			calcCurrentMass += rho; 
-			calcCurrentVolume += 1.0;
+			FSGR_ADDMASS(rho, 1.0);
 			continue;
 		}
 		
@@ -1090,8 +1086,7 @@ LbmFsgrSolver::mainLoop(const int lev)
 		QCELL(lev, i,j,k,TSET(lev), dMass) = mass; // MASST
 		// set new flag 
 		*pFlagDst = (CellFlagType)newFlag;
-		calcCurrentMass += mass; 
-		calcCurrentVolume += RAC(tcel,dFfrac);
+		FSGR_ADDMASS(mass, RAC(tcel,dFfrac));
 
 		// interface cell handling done...
 
@@ -1126,9 +1121,8 @@ LbmFsgrSolver::preinitGrids()
 		GRID_REGION_INIT();
 #if PARALLEL==1
 	const int gDebugLevel = ::gDebugLevel;
-#pragma omp parallel default(none) num_threads(mNumOMPThreads) \
+#pragma omp parallel default(shared) num_threads(mNumOMPThreads) \
   reduction(+: \
-	  calcCurrentMass,calcCurrentVolume, \
 		calcCellsFilled,calcCellsEmptied, \
 		calcNumUsedCells )
 #endif // PARALLEL==1
@@ -1164,9 +1158,8 @@ LbmFsgrSolver::standingFluidPreinit()
 	GRID_REGION_INIT();
 #if PARALLEL==1
 	const int gDebugLevel = ::gDebugLevel;
-#pragma omp parallel default(none) num_threads(mNumOMPThreads) \
+#pragma omp parallel default(shared) num_threads(mNumOMPThreads) \
   reduction(+: \
-	  calcCurrentMass,calcCurrentVolume, \
 		calcCellsFilled,calcCellsEmptied, \
 		calcNumUsedCells )
 #endif // PARALLEL==1
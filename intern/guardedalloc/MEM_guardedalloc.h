@@ -220,6 +220,10 @@ extern const char *(*MEM_name_ptr)(void *vmemh);
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Cache small freed blocks per thread by size class and reuse them for
+ * following allocations, has no effect in fully guarded mode. */
+void MEM_use_pooled_allocator(void);
+
 #ifdef __cplusplus
 /* alloc funcs for C++ only */
 #define MEM_CXX_CLASS_ALLOC_FUNCS(_id)                                        \
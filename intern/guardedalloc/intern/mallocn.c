@@ -132,3 +132,10 @@ void MEM_use_guarded_allocator(void)
 	MEM_name_ptr = MEM_guarded_name_ptr;
 #endif
 }
+
+void MEM_use_pooled_allocator(void)
+{
+	/* Only affects the lock-free allocator, fully guarded mode keeps
+	 * every block in its list for debugging. */
+	MEM_lockfree_use_size_class_pool();
+}
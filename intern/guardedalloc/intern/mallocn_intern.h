@@ -82,6 +82,12 @@ size_t malloc_usable_size(void *ptr);
 
 #define SIZET_ALIGN_4(len) ((len + 3) & ~(size_t)3)
 
+/* Per-thread size-class caching in the lock-free allocator,
+ * relies on pthread keys to release caches of exiting threads. */
+#if !defined(WIN32)
+#  define USE_SIZE_CLASS_POOL
+#endif
+
 #ifdef __GNUC__
 #  define LIKELY(x)       __builtin_expect(!!(x), 1)
 #  define UNLIKELY(x)     __builtin_expect(!!(x), 0)
@@ -145,6 +151,7 @@ size_t MEM_lockfree_get_mapped_memory_in_use(void);
 unsigned int MEM_lockfree_get_memory_blocks_in_use(void);
 void MEM_lockfree_reset_peak_memory(void);
 size_t MEM_lockfree_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
+void MEM_lockfree_use_size_class_pool(void);
 #ifndef NDEBUG
 const char *MEM_lockfree_name_ptr(void *vmemh);
 #endif
@@ -41,6 +41,10 @@
 #include "atomic_ops.h"
 #include "mallocn_intern.h"
 
+#ifdef USE_SIZE_CLASS_POOL
+#  include <pthread.h>
+#endif
+
 typedef struct MemHead {
 	/* Length of allocated memory block. */
 	size_t len;
@@ -64,11 +68,19 @@ enum {
 	MEMHEAD_ALIGN_FLAG = 2,
 };
 
+/* Block was allocated with the capacity of its size class, see #USE_SIZE_CLASS_POOL.
+ * Lower bits are taken by the flags above, use the top bit which is never part of
+ * a real allocation length. */
+#define MEMHEAD_POOL_FLAG ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+#define MEMHEAD_FLAGS_MASK ((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG) | MEMHEAD_POOL_FLAG)
+
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead*) ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned*) ptr) - 1)
 #define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t) MEMHEAD_MMAP_FLAG)
 #define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t) MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_POOLED(memhead) ((memhead)->len & MEMHEAD_POOL_FLAG)
 
 /* Uncomment this to have proper peak counter. */
 #define USE_ATOMIC_MAX
@@ -114,10 +126,123 @@ static void mem_unlock_thread(void)
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/* Size-class pooling
+ *
+ * Small blocks are allocated with the capacity of their size class. When such
+ * a block is freed it is kept in a per-thread cache and handed out again by the
+ * next allocation of the same class on that thread, so short-lived allocations
+ * don't go through the system allocator every time.
+ *
+ * Cached blocks are not counted as blocks in use, so memory statistics and leak
+ * reporting behave exactly as without pooling. The cache is bounded per thread
+ * and released when the thread exits.
+ */
+
+#ifdef USE_SIZE_CLASS_POOL
+
+#define MEM_POOL_CLASS_SHIFT 4
+#define MEM_POOL_MAX_SIZE 1024
+#define MEM_POOL_NUM_CLASSES (MEM_POOL_MAX_SIZE >> MEM_POOL_CLASS_SHIFT)
+/* Upper limit of cached blocks per class and thread, keeps the cache bounded. */
+#define MEM_POOL_MAX_CACHED 64
+
+#define MEM_POOL_CLASS_INDEX(len) ((len) ? (unsigned int)(((len) - 1) >> MEM_POOL_CLASS_SHIFT) : 0u)
+#define MEM_POOL_CLASS_SIZE(index) ((size_t)((index) + 1) << MEM_POOL_CLASS_SHIFT)
+
+typedef struct MemPoolThreadCache {
+	/* Singly linked lists of free blocks, the link is stored in the block data. */
+	MemHead *free_list[MEM_POOL_NUM_CLASSES];
+	unsigned int num_free[MEM_POOL_NUM_CLASSES];
+} MemPoolThreadCache;
+
+#define MEM_POOL_NEXT_FREE(memh) (*(MemHead **)PTR_FROM_MEMHEAD(memh))
+
+static bool use_size_class_pool = false;
+static pthread_key_t pool_cache_key;
+static pthread_once_t pool_cache_key_once = PTHREAD_ONCE_INIT;
+
+static void mem_pool_thread_cache_free(void *cache_v)
+{
+	MemPoolThreadCache *cache = cache_v;
+	unsigned int i;
+
+	for (i = 0; i < MEM_POOL_NUM_CLASSES; i++) {
+		MemHead *memh = cache->free_list[i];
+		while (memh) {
+			MemHead *memh_next = MEM_POOL_NEXT_FREE(memh);
+			free(memh);
+			memh = memh_next;
+		}
+	}
+	free(cache);
+}
+
+static void mem_pool_key_create(void)
+{
+	/* Destructor releases cached blocks when a thread exits. */
+	pthread_key_create(&pool_cache_key, mem_pool_thread_cache_free);
+}
+
+static MemPoolThreadCache *mem_pool_thread_cache_get(void)
+{
+	MemPoolThreadCache *cache = pthread_getspecific(pool_cache_key);
+	if (UNLIKELY(cache == NULL)) {
+		cache = calloc(1, sizeof(*cache));
+		if (cache && pthread_setspecific(pool_cache_key, cache) != 0) {
+			free(cache);
+			cache = NULL;
+		}
+	}
+	return cache;
+}
+
+/* Returns a block with enough capacity for the size class of len. */
+static MemHead *mem_pool_alloc(size_t len)
+{
+	const unsigned int index = MEM_POOL_CLASS_INDEX(len);
+	MemPoolThreadCache *cache = mem_pool_thread_cache_get();
+
+	if (cache && cache->free_list[index]) {
+		MemHead *memh = cache->free_list[index];
+		cache->free_list[index] = MEM_POOL_NEXT_FREE(memh);
+		cache->num_free[index]--;
+		return memh;
+	}
+	return (MemHead *)malloc(MEM_POOL_CLASS_SIZE(index) + sizeof(MemHead));
+}
+
+static void mem_pool_free(MemHead *memh, size_t len)
+{
+	const unsigned int index = MEM_POOL_CLASS_INDEX(len);
+	MemPoolThreadCache *cache = mem_pool_thread_cache_get();
+
+	if (cache && cache->num_free[index] < MEM_POOL_MAX_CACHED) {
+		MEM_POOL_NEXT_FREE(memh) = cache->free_list[index];
+		cache->free_list[index] = memh;
+		cache->num_free[index]++;
+	}
+	else {
+		free(memh);
+	}
+}
+
+#define MEM_POOL_USE(len) (use_size_class_pool && (len) <= MEM_POOL_MAX_SIZE)
+
+#endif  /* USE_SIZE_CLASS_POOL */
+
+void MEM_lockfree_use_size_class_pool(void)
+{
+#ifdef USE_SIZE_CLASS_POOL
+	pthread_once(&pool_cache_key_once, mem_pool_key_create);
+	use_size_class_pool = true;
+#endif
+}
+
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
 	if (vmemh) {
-		return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG));
+		return MEMHEAD_FROM_PTR(vmemh)->len & ~MEMHEAD_FLAGS_MASK;
 	}
 	else {
 		return 0;
@@ -160,6 +285,11 @@ void MEM_lockfree_freeN(void *vmemh)
 			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
 			aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
 		}
+#ifdef USE_SIZE_CLASS_POOL
+		else if (MEMHEAD_IS_POOLED(memh)) {
+			mem_pool_free(memh, len);
+		}
+#endif
 		else {
 			free(memh);
 		}
@@ -276,12 +406,26 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 {
 	MemHead *memh;
 
+	size_t flag = 0;
+
 	len = SIZET_ALIGN_4(len);
 
-	memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+#ifdef USE_SIZE_CLASS_POOL
+	if (MEM_POOL_USE(len)) {
+		memh = mem_pool_alloc(len);
+		if (LIKELY(memh)) {
+			memset(memh + 1, 0, len);
+		}
+		flag = MEMHEAD_POOL_FLAG;
+	}
+	else
+#endif
+	{
+		memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+	}
 
 	if (LIKELY(memh)) {
-		memh->len = len;
+		memh->len = len | flag;
 		atomic_add_and_fetch_u(&totblock, 1);
 		atomic_add_and_fetch_z(&mem_in_use, len);
 		update_maximum(&peak_mem, mem_in_use);
@@ -312,16 +456,27 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 {
 	MemHead *memh;
 
+	size_t flag = 0;
+
 	len = SIZET_ALIGN_4(len);
 
-	memh = (MemHead *)malloc(len + sizeof(MemHead));
+#ifdef USE_SIZE_CLASS_POOL
+	if (MEM_POOL_USE(len)) {
+		memh = mem_pool_alloc(len);
+		flag = MEMHEAD_POOL_FLAG;
+	}
+	else
+#endif
+	{
+		memh = (MemHead *)malloc(len + sizeof(MemHead));
+	}
 
 	if (LIKELY(memh)) {
 		if (UNLIKELY(malloc_debug_memset && len)) {
 			memset(memh + 1, 255, len);
 		}
 
-		memh->len = len;
+		memh->len = len | flag;
 		atomic_add_and_fetch_u(&totblock, 1);
 		atomic_add_and_fetch_z(&mem_in_use, len);
 		update_maximum(&peak_mem, mem_in_use);
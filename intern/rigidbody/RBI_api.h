@@ -88,6 +88,8 @@ void RB_dworld_set_gravity(rbDynamicsWorld *world, const float g_in[3]);
 void RB_dworld_set_solver_iterations(rbDynamicsWorld *world, int num_solver_iterations);
 /* Split Impulse */
 void RB_dworld_set_split_impulse(rbDynamicsWorld *world, int split_impulse);
+/* Number of threads used to solve simulation islands in parallel, 1 to disable */
+void RB_dworld_set_num_threads(rbDynamicsWorld *world, int num_threads);
 
 /* Simulation ----------------------- */
 
@@ -59,6 +59,10 @@ subject to the following restrictions:
 #include <stdio.h>
 #include <errno.h>
 
+#if PARALLEL==1
+#include <omp.h>
+#endif
+
 #include "RBI_api.h"
 
 #include "btBulletDynamicsCommon.h"
@@ -72,9 +76,249 @@ subject to the following restrictions:
 #include "BulletCollision/Gimpact/btGImpactShape.h"
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+
+/* Dynamics world that solves simulation islands in parallel.
+ *
+ * Islands don't share any non-static bodies, so each one can be solved by its own
+ * constraint solver. Small islands are batched together the same way Bullet does
+ * (see btContactSolverInfo.m_minimumSolverBatchSize), and batches only depend on
+ * the islands, so results are the same for any number of threads.
+ *
+ * The solver writes to kinematic bodies (companion id, velocity) while setting up
+ * and finishing a group, and kinematic bodies may touch several islands, so islands
+ * with contacts or constraints on kinematic bodies are solved serially afterwards.
+ */
+class rbParallelDynamicsWorld : public btDiscreteDynamicsWorld
+{
+public:
+	rbParallelDynamicsWorld(btDispatcher *dispatcher, btBroadphaseInterface *pairCache,
+	                        btConstraintSolver *constraintSolver, btCollisionConfiguration *collisionConfiguration)
+	    : btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+	{
+	}
+
+	virtual ~rbParallelDynamicsWorld()
+	{
+		setNumThreads(1);
+	}
+
+	/* use a single thread to fall back to the regular btDiscreteDynamicsWorld solver */
+	void setNumThreads(int num_threads)
+	{
+#ifndef BT_NO_PROFILE
+		/* BT_PROFILE in the solver updates the global CProfileManager, which is not thread safe */
+		num_threads = 0;
+#endif
+		if (num_threads <= 1)
+			num_threads = 0;
+
+		for (int i = num_threads; i < m_threadSolvers.size(); i++)
+			delete m_threadSolvers[i];
+		for (int i = m_threadSolvers.size(); i < num_threads; i++)
+			m_threadSolvers.push_back(new btSequentialImpulseConstraintSolver());
+
+		m_threadSolvers.resize(num_threads);
+	}
+
+protected:
+	virtual void solveConstraints(btContactSolverInfo &solverInfo);
+
+private:
+	struct IslandGroup {
+		btAlignedObjectArray<btCollisionObject *> bodies;
+		btAlignedObjectArray<btPersistentManifold *> manifolds;
+		btAlignedObjectArray<btTypedConstraint *> constraints;
+
+		void clear()
+		{
+			bodies.resize(0);
+			manifolds.resize(0);
+			constraints.resize(0);
+		}
+	};
+
+	/* offsets of a batch of islands in the parallel group */
+	struct IslandBatch {
+		int body_start;
+		int manifold_start;
+		int constraint_start;
+	};
+
+	struct IslandCollector : public btSimulationIslandManager::IslandCallback
+	{
+		rbParallelDynamicsWorld *world;
+		int min_batch_size;
+
+		virtual void processIsland(btCollisionObject **bodies, int numBodies,
+		                           btPersistentManifold **manifolds, int numManifolds, int islandId)
+		{
+			world->collectIsland(bodies, numBodies, manifolds, numManifolds, islandId, min_batch_size);
+		}
+	};
+
+	btAlignedObjectArray<btConstraintSolver *> m_threadSolvers;
+
+	IslandGroup m_parallelIslands;
+	IslandGroup m_serialIslands;
+	btAlignedObjectArray<IslandBatch> m_batches;
+
+	void collectIsland(btCollisionObject **bodies, int numBodies,
+	                   btPersistentManifold **manifolds, int numManifolds, int islandId,
+	                   int min_batch_size);
+	void solveBatch(btConstraintSolver *solver, int batch, btContactSolverInfo &solverInfo);
+};
+
+static inline int constraint_island_id(const btTypedConstraint *constraint)
+{
+	int island_id = constraint->getRigidBodyA().getIslandTag();
+	return (island_id >= 0) ? island_id : constraint->getRigidBodyB().getIslandTag();
+}
+
+struct rbConstraintIslandCompare
+{
+	bool operator()(const btTypedConstraint *lhs, const btTypedConstraint *rhs) const
+	{
+		return constraint_island_id(lhs) < constraint_island_id(rhs);
+	}
+};
+
+void rbParallelDynamicsWorld::collectIsland(btCollisionObject **bodies, int numBodies,
+                                            btPersistentManifold **manifolds, int numManifolds, int islandId,
+                                            int min_batch_size)
+{
+	btTypedConstraint **constraints = NULL;
+	int num_constraints = 0;
+	bool serial = false;
+	int i;
+
+	if (islandId < 0) {
+		/* islands are not split, pass everything to the solver at once */
+		constraints = m_sortedConstraints.size() ? &m_sortedConstraints[0] : NULL;
+		num_constraints = m_sortedConstraints.size();
+		serial = true;
+	}
+	else {
+		/* constraints are sorted by island, find the range of this one */
+		int first = 0, last = m_sortedConstraints.size();
+		while (first < last) {
+			int mid = (first + last) / 2;
+			if (constraint_island_id(m_sortedConstraints[mid]) < islandId)
+				first = mid + 1;
+			else
+				last = mid;
+		}
+		for (last = first; last < m_sortedConstraints.size(); last++) {
+			if (constraint_island_id(m_sortedConstraints[last]) != islandId)
+				break;
+		}
+		constraints = (last > first) ? &m_sortedConstraints[first] : NULL;
+		num_constraints = last - first;
+
+		for (i = 0; i < numManifolds && !serial; i++) {
+			serial = (manifolds[i]->getBody0()->isKinematicObject() ||
+			          manifolds[i]->getBody1()->isKinematicObject());
+		}
+		for (i = 0; i < num_constraints && !serial; i++) {
+			serial = (constraints[i]->getRigidBodyA().isKinematicObject() ||
+			          constraints[i]->getRigidBodyB().isKinematicObject());
+		}
+	}
+
+	IslandGroup &group = serial ? m_serialIslands : m_parallelIslands;
+
+	for (i = 0; i < numBodies; i++)
+		group.bodies.push_back(bodies[i]);
+	for (i = 0; i < numManifolds; i++)
+		group.manifolds.push_back(manifolds[i]);
+	for (i = 0; i < num_constraints; i++)
+		group.constraints.push_back(constraints[i]);
+
+	if (!serial) {
+		/* close the current batch once it is large enough */
+		const IslandBatch &batch = m_batches[m_batches.size() - 1];
+		int batch_size = (group.manifolds.size() - batch.manifold_start) +
+		                 (group.constraints.size() - batch.constraint_start);
+
+		if (batch_size >= min_batch_size) {
+			IslandBatch next = {group.bodies.size(), group.manifolds.size(), group.constraints.size()};
+			m_batches.push_back(next);
+		}
+	}
+}
+
+void rbParallelDynamicsWorld::solveBatch(btConstraintSolver *solver, int batch, btContactSolverInfo &solverInfo)
+{
+	const IslandBatch &start = m_batches[batch];
+	const IslandBatch &end = m_batches[batch + 1];
+	int num_bodies = end.body_start - start.body_start;
+	int num_manifolds = end.manifold_start - start.manifold_start;
+	int num_constraints = end.constraint_start - start.constraint_start;
+
+	solver->solveGroup(num_bodies ? &m_parallelIslands.bodies[start.body_start] : NULL, num_bodies,
+	                   num_manifolds ? &m_parallelIslands.manifolds[start.manifold_start] : NULL, num_manifolds,
+	                   num_constraints ? &m_parallelIslands.constraints[start.constraint_start] : NULL, num_constraints,
+	                   solverInfo, getDebugDrawer(), getDispatcher());
+}
+
+void rbParallelDynamicsWorld::solveConstraints(btContactSolverInfo &solverInfo)
+{
+	if (m_threadSolvers.size() == 0) {
+		btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+		return;
+	}
+
+	m_sortedConstraints.copyFromArray(m_constraints);
+	m_sortedConstraints.quickSort(rbConstraintIslandCompare());
+
+	m_parallelIslands.clear();
+	m_serialIslands.clear();
+	m_batches.resize(0);
+	IslandBatch first = {0, 0, 0};
+	m_batches.push_back(first);
+
+	IslandCollector collector;
+	collector.world = this;
+	collector.min_batch_size = solverInfo.m_minimumSolverBatchSize;
+	m_constraintSolver->prepareSolve(getNumCollisionObjects(), getDispatcher()->getNumManifolds());
+	m_islandManager->buildAndProcessIslands(getDispatcher(), this, &collector);
+
+	/* close the last batch */
+	const IslandBatch &last = m_batches[m_batches.size() - 1];
+	if (m_parallelIslands.bodies.size() > last.body_start) {
+		IslandBatch end = {m_parallelIslands.bodies.size(),
+		                   m_parallelIslands.manifolds.size(),
+		                   m_parallelIslands.constraints.size()};
+		m_batches.push_back(end);
+	}
+
+	int num_batches = m_batches.size() - 1;
+
+#if PARALLEL==1
+#pragma omp parallel for schedule(dynamic) num_threads(m_threadSolvers.size()) if (num_batches > 1)
+#endif
+	for (int i = 0; i < num_batches; i++) {
+#if PARALLEL==1
+		btConstraintSolver *solver = m_threadSolvers[omp_get_thread_num()];
+#else
+		btConstraintSolver *solver = m_threadSolvers[0];
+#endif
+		solveBatch(solver, i, solverInfo);
+	}
+
+	if (m_serialIslands.bodies.size()) {
+		IslandGroup &group = m_serialIslands;
+		m_constraintSolver->solveGroup(&group.bodies[0], group.bodies.size(),
+		                               group.manifolds.size() ? &group.manifolds[0] : NULL, group.manifolds.size(),
+		                               group.constraints.size() ? &group.constraints[0] : NULL, group.constraints.size(),
+		                               solverInfo, getDebugDrawer(), getDispatcher());
+	}
+
+	m_constraintSolver->allSolved(solverInfo, getDebugDrawer());
+}
 
 struct rbDynamicsWorld {
-	btDiscreteDynamicsWorld *dynamicsWorld;
+	rbParallelDynamicsWorld *dynamicsWorld;
 	btDefaultCollisionConfiguration *collisionConfiguration;
 	btDispatcher *dispatcher;
 	btBroadphaseInterface *pairCache;
@@ -160,7 +404,7 @@ rbDynamicsWorld *RB_dworld_new(const float gravity[3])
 	world->constraintSolver = new btSequentialImpulseConstraintSolver();
 
 	/* world */
-	world->dynamicsWorld = new btDiscreteDynamicsWorld(world->dispatcher,
+	world->dynamicsWorld = new rbParallelDynamicsWorld(world->dispatcher,
 	                                                   world->pairCache,
 	                                                   world->constraintSolver,
 	                                                   world->collisionConfiguration);
@@ -211,6 +455,12 @@ void RB_dworld_set_split_impulse(rbDynamicsWorld *world, int split_impulse)
 	info.m_splitImpulse = split_impulse;
 }
 
+/* Threads */
+void RB_dworld_set_num_threads(rbDynamicsWorld *world, int num_threads)
+{
+	world->dynamicsWorld->setNumThreads(num_threads);
+}
+
 /* Simulation ----------------------- */
 
 void RB_dworld_step_simulation(rbDynamicsWorld *world, float timeStep, int maxSubSteps, float timeSubStep)
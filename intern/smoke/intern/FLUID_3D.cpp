@@ -307,7 +307,8 @@ FLUID_3D::~FLUID_3D()
 
 // init direct access functions from blender
 void FLUID_3D::initBlenderRNA(float *alpha, float *beta, float *dt_factor, float *vorticity, int *borderCollision, float *burning_rate,
-							  float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *flame_ignition_temp, float *flame_max_temp)
+							  float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *flame_ignition_temp, float *flame_max_temp,
+							  char *pressure_solver)
 {
 	_alpha = alpha;
 	_beta = beta;
@@ -320,6 +321,7 @@ void FLUID_3D::initBlenderRNA(float *alpha, float *beta, float *dt_factor, float
 	_flame_vorticity = flame_vorticity;
 	_ignition_temp = flame_ignition_temp;
 	_max_temp = flame_max_temp;
+	_pressureSolver = pressure_solver;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -400,30 +402,35 @@ void FLUID_3D::step(float dt, float gravity[3])
 	SWAP_POINTERS(_zVelocity, _zVelocityTemp);
 #if PARALLEL==1
 	}	// end of single
+	}	// end of parallel
 
-	#pragma omp barrier
-
-	#pragma omp for
-	for (int i=0; i<2; i++)
+	/*
+	* The multigrid solver is threaded itself, the Jacobi preconditioned
+	* one runs on a single thread while another one diffuses heat.
+	*/
+	if (*_pressureSolver != FLUID_3D_SOLVER_MGPCG)
 	{
-		if (i==0)
+		#pragma omp parallel for
+		for (int i=0; i<2; i++)
 		{
-#endif
-			project();
-#if PARALLEL==1
+			if (i==0)
+				project();
+			else if (_heat)
+				diffuseHeat();
 		}
-		else if (i==1)
-		{
+	}
+	else
+	{
 #endif
-			if (_heat) {
-				diffuseHeat();
-			}
-#if PARALLEL==1
+		project();
+		if (_heat) {
+			diffuseHeat();
 		}
+#if PARALLEL==1
 	}
 
-	#pragma omp barrier
-
+	#pragma omp parallel
+	{
 	#pragma omp single
 	{
 #endif
@@ -997,7 +1004,10 @@ void FLUID_3D::project()
 	fixObstacleCompression(_divergence);
 
 	// solve Poisson equation
-	solvePressurePre(_pressure, _divergence, _obstacles);
+	if (*_pressureSolver == FLUID_3D_SOLVER_MGPCG)
+		solvePressureMG(_pressure, _divergence, _obstacles);
+	else
+		solvePressurePre(_pressure, _divergence, _obstacles);
 
 	setObstaclePressure(_pressure, 0, _zRes);
 
@@ -43,6 +43,24 @@ using namespace std;
 using namespace BasicVector;
 struct WTURBULENCE;
 
+// Tiles of a grid which may hold non-zero values, cells of inactive
+// tiles are known to be zero and are skipped by the advection functions.
+struct ACTIVE_TILES
+{
+	int size;     // tile size in cells
+	int res[3];   // number of tiles along each axis
+	unsigned char *active;
+
+	// tile flags along x of the row of cells y, z
+	const unsigned char *row(int y, int z) const {
+		return active + (y / size) * res[0] + (z / size) * res[0] * res[1];
+	}
+};
+
+// pressure solvers, keep in sync with SM_PRESSURE_SOLVER_* in DNA_smoke_types.h
+#define FLUID_3D_SOLVER_PCG		0
+#define FLUID_3D_SOLVER_MGPCG	1
+
 struct FLUID_3D  
 {
 	public:
@@ -55,7 +73,8 @@ struct FLUID_3D
 		void initColors(float init_r, float init_g, float init_b);
 
 		void initBlenderRNA(float *alpha, float *beta, float *dt_factor, float *vorticity, int *border_colli, float *burning_rate,
-							float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *ignition_temp, float *max_temp);
+							float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *ignition_temp, float *max_temp,
+							char *pressure_solver);
 		
 		// create & allocate vector noise advection 
 		void initVectorNoise(int amplify);
@@ -143,6 +162,7 @@ struct FLUID_3D
 
 		// CG fields
 		int _iterations;
+		char *_pressureSolver; // FLUID_3D_SOLVER_* <-- as pointer to get blender RNA in here
 
 		// simulation constants
 		float _dt;
@@ -187,6 +207,7 @@ struct FLUID_3D
 		void diffuseColor();
 		void solvePressure(float* field, float* b, unsigned char* skip);
 		void solvePressurePre(float* field, float* b, unsigned char* skip);
+		void solvePressureMG(float* field, float* b, unsigned char* skip);
 		void solveHeat(float* field, float* b, unsigned char* skip);
 		void solveDiffusion(float* field, float* b, float* factor);
 
@@ -238,11 +259,12 @@ struct FLUID_3D
 
 		// static advection functions, also used by WTURBULENCE
 		static void advectFieldSemiLagrange(const float dt, const float* velx, const float* vely,  const float* velz,
-				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const ACTIVE_TILES *tiles = NULL);
 		static void advectFieldMacCormack1(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd, const ACTIVE_TILES *tiles = NULL);
 		static void advectFieldMacCormack2(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* newField, float* tempResult, float* temp1,Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd);
+				float* oldField, float* newField, float* tempResult, float* temp1,Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd,
+				const ACTIVE_TILES *tiles = NULL);
 
 
 		// temp ones for testing
@@ -253,9 +275,10 @@ struct FLUID_3D
 
 		// maccormack helper functions
 		static void clampExtrema(const float dt, const float* xVelocity, const float* yVelocity,  const float* zVelocity,
-				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const ACTIVE_TILES *tiles = NULL);
 		static void clampOutsideRays(const float dt, const float* xVelocity, const float* yVelocity,  const float* zVelocity,
-				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd,
+				const ACTIVE_TILES *tiles = NULL);
 
 
 
@@ -28,6 +28,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "FLUID_3D.h"
+#include "MULTIGRID.h"
 #include <cstring>
 #define SOLVER_ACCURACY 1e-06
 
@@ -326,3 +327,198 @@ void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
 	if (_direction) delete[] _direction;
 	if (_q)       delete[] _q;
 }
+
+//////////////////////////////////////////////////////////////////////
+// solve the poisson equation with CG, preconditioned by a multigrid V-cycle
+//
+// Converges to the same accuracy as solvePressurePre() in much fewer
+// iterations on large grids. Loops run in parallel over z slices, sums
+// are accumulated per slice and added in order, so results do not
+// depend on the number of threads.
+//////////////////////////////////////////////////////////////////////
+void FLUID_3D::solvePressureMG(float* field, float* b, unsigned char* skip)
+{
+	const int xRes = _xRes;
+	const int slabSize = _slabSize;
+	float *_q, *_h, *_residual, *_direction, *_sliceSum, *_sliceMax;
+
+	MULTIGRID multigrid(_xRes, _yRes, _zRes, skip);
+	const float *diag = multigrid.diagonal();
+
+	_residual     = new float[_totalCells]; // set 0
+	_direction    = new float[_totalCells]; // set 0
+	_q            = new float[_totalCells]; // set 0
+	_h            = new float[_totalCells]; // set 0
+	_sliceSum     = new float[_zRes];
+	_sliceMax     = new float[_zRes];
+
+	memset(_residual, 0, sizeof(float)*_totalCells);
+	memset(_q, 0, sizeof(float)*_totalCells);
+	memset(_direction, 0, sizeof(float)*_totalCells);
+	memset(_h, 0, sizeof(float)*_totalCells);
+	memset(_sliceSum, 0, sizeof(float)*_zRes);
+	memset(_sliceMax, 0, sizeof(float)*_zRes);
+
+	// r = b - Ax, border cells which are not obstacles hold Dirichlet values of field
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+		for (int y = 1; y < _yRes - 1; y++)
+		{
+			size_t index = 1 + y * xRes + (size_t)z * slabSize;
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				if (diag[index] == 0.0f)
+					continue;
+
+				_residual[index] = b[index] - (diag[index] * field[index] +
+				field[index - 1] * (skip[index - 1] ? 0.0f : -1.0f) +
+				field[index + 1] * (skip[index + 1] ? 0.0f : -1.0f) +
+				field[index - xRes] * (skip[index - xRes] ? 0.0f : -1.0f) +
+				field[index + xRes] * (skip[index + xRes] ? 0.0f : -1.0f) +
+				field[index - slabSize] * (skip[index - slabSize] ? 0.0f : -1.0f) +
+				field[index + slabSize] * (skip[index + slabSize] ? 0.0f : -1.0f));
+			}
+		}
+
+	// p = M^-1 * r
+	multigrid.vcycle(_residual, _h);
+
+	float deltaNew = 0.0f;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < _zRes - 1; z++)
+	{
+		float sum = 0.0f;
+		for (int y = 1; y < _yRes - 1; y++)
+		{
+			size_t index = 1 + y * xRes + (size_t)z * slabSize;
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				_direction[index] = _h[index];
+				sum += _residual[index] * _h[index];
+			}
+		}
+		_sliceSum[z] = sum;
+	}
+	for (int z = 1; z < _zRes - 1; z++)
+		deltaNew += _sliceSum[z];
+
+	// same stopping criterion as the Jacobi preconditioned solver
+	const float eps  = SOLVER_ACCURACY;
+	float maxR = 2.0f * eps;
+	int i = 0;
+	while ((i < _iterations) && (maxR > 0.001f * eps))
+	{
+		float alpha = 0.0f;
+
+		// q = Ad, d is zero outside of the unknowns
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int z = 1; z < _zRes - 1; z++)
+		{
+			float sum = 0.0f;
+			for (int y = 1; y < _yRes - 1; y++)
+			{
+				const size_t index = 1 + y * xRes + (size_t)z * slabSize;
+				const float *d = _direction + index;
+				const float *a = diag + index;
+				float *q = _q + index;
+
+				for (int x = 0; x < xRes - 2; x++)
+				{
+					const float Ad = a[x] * d[x] -
+					        (d[x - 1] + d[x + 1] +
+					         d[x - xRes] + d[x + xRes] +
+					         d[x - slabSize] + d[x + slabSize]);
+					q[x] = (a[x] > 0.0f) ? Ad : 0.0f;
+					sum += d[x] * q[x];
+				}
+			}
+			_sliceSum[z] = sum;
+		}
+		for (int z = 1; z < _zRes - 1; z++)
+			alpha += _sliceSum[z];
+
+		if (fabs(alpha) > 0.0f)
+			alpha = deltaNew / alpha;
+
+		// x = x + alpha * d, r = r - alpha * q
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int z = 1; z < _zRes - 1; z++)
+		{
+			float zMaxR = 0.0f;
+			for (int y = 1; y < _yRes - 1; y++)
+			{
+				size_t index = 1 + y * xRes + (size_t)z * slabSize;
+				for (int x = 1; x < xRes - 1; x++, index++)
+				{
+					field[index] += alpha * _direction[index];
+					_residual[index] -= alpha * _q[index];
+
+					const float tmp = (diag[index] > 0.0f) ? _residual[index] * _residual[index] / diag[index] : 0.0f;
+					zMaxR = (tmp > zMaxR) ? tmp : zMaxR;
+				}
+			}
+			_sliceMax[z] = zMaxR;
+		}
+		maxR = 0.0f;
+		for (int z = 1; z < _zRes - 1; z++)
+			maxR = (_sliceMax[z] > maxR) ? _sliceMax[z] : maxR;
+
+		i++;
+		if (maxR <= 0.001f * eps)
+			break;
+
+		// h = M^-1 * r
+		multigrid.vcycle(_residual, _h);
+
+		float deltaOld = deltaNew;
+		deltaNew = 0.0f;
+
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int z = 1; z < _zRes - 1; z++)
+		{
+			float sum = 0.0f;
+			for (int y = 1; y < _yRes - 1; y++)
+			{
+				size_t index = 1 + y * xRes + (size_t)z * slabSize;
+				for (int x = 1; x < xRes - 1; x++, index++)
+					sum += _residual[index] * _h[index];
+			}
+			_sliceSum[z] = sum;
+		}
+		for (int z = 1; z < _zRes - 1; z++)
+			deltaNew += _sliceSum[z];
+
+		// d = h + beta * d
+		float beta = (deltaOld != 0.0f) ? deltaNew / deltaOld : 0.0f;
+
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int z = 1; z < _zRes - 1; z++)
+			for (int y = 1; y < _yRes - 1; y++)
+			{
+				size_t index = 1 + y * xRes + (size_t)z * slabSize;
+				for (int x = 1; x < xRes - 1; x++, index++)
+					_direction[index] = _h[index] + beta * _direction[index];
+			}
+	}
+	// cout << i << " iterations converged to " << sqrt(maxR) << endl;
+
+	delete[] _h;
+	delete[] _residual;
+	delete[] _direction;
+	delete[] _q;
+	delete[] _sliceSum;
+	delete[] _sliceMax;
+}
@@ -0,0 +1,391 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file smoke/intern/MULTIGRID.cpp
+ *  \ingroup smoke
+ */
+
+#include "MULTIGRID.h"
+
+#include <cstring>
+
+#define MG_MAX_LEVELS 16
+// levels are coarsened until the largest inner resolution is this small
+#define MG_COARSEST_RES 8
+#define MG_SMOOTH_SWEEPS 2
+#define MG_COARSEST_SWEEPS 32
+#define MG_JACOBI_WEIGHT (2.0f / 3.0f)
+// levels with fewer cells are processed on one thread
+#define MG_PARALLEL_LIMIT 32768
+
+// trilinear weights of the fine cells 2X-2 .. 2X+1 for coarse cell X
+static const float mg_restrict_weights[4] = {0.25f, 0.75f, 0.75f, 0.25f};
+
+MULTIGRID::MULTIGRID(int xRes, int yRes, int zRes, const unsigned char *skip)
+{
+	_levels = new Level[MG_MAX_LEVELS];
+	_numLevels = 1;
+
+	// finest level, the border ring holds Dirichlet pressure unless it is an obstacle
+	Level &fine = _levels[0];
+	initLevel(fine, xRes, yRes, zRes);
+	size_t index = 0;
+	for (int z = 0; z < zRes; z++)
+		for (int y = 0; y < yRes; y++)
+			for (int x = 0; x < xRes; x++, index++)
+			{
+				const bool border = (x == 0 || y == 0 || z == 0 || x == xRes - 1 || y == yRes - 1 || z == zRes - 1);
+
+				if (skip[index])
+					fine.type[index] = CELL_SOLID;
+				else if (border)
+					fine.type[index] = CELL_DIRICHLET;
+				else
+					fine.type[index] = CELL_FLUID;
+			}
+	initDiagonal(fine);
+
+	int inner[3] = {xRes - 2, yRes - 2, zRes - 2};
+	while (_numLevels < MG_MAX_LEVELS) {
+		const int maxInner = (inner[0] > inner[1]) ? ((inner[0] > inner[2]) ? inner[0] : inner[2]) : ((inner[1] > inner[2]) ? inner[1] : inner[2]);
+		const int minInner = (inner[0] < inner[1]) ? ((inner[0] < inner[2]) ? inner[0] : inner[2]) : ((inner[1] < inner[2]) ? inner[1] : inner[2]);
+		if (maxInner <= MG_COARSEST_RES || minInner < 4)
+			break;
+
+		for (int i = 0; i < 3; i++)
+			inner[i] = (inner[i] + 1) / 2;
+
+		Level &coarse = _levels[_numLevels];
+		initLevel(coarse, inner[0] + 2, inner[1] + 2, inner[2] + 2);
+		coarsenTypes(_levels[_numLevels - 1], coarse);
+		initDiagonal(coarse);
+
+		coarse.x = new float[coarse.totalCells];
+		coarse.b = new float[coarse.totalCells];
+		memset(coarse.x, 0, sizeof(float) * coarse.totalCells);
+		memset(coarse.b, 0, sizeof(float) * coarse.totalCells);
+
+		_numLevels++;
+	}
+}
+
+MULTIGRID::~MULTIGRID()
+{
+	for (int l = 0; l < _numLevels; l++) {
+		Level &level = _levels[l];
+
+		delete[] level.diag;
+		delete[] level.invDiag;
+		delete[] level.type;
+		delete[] level.r;
+		delete[] level.tmp;
+		if (level.x) delete[] level.x;
+		if (level.b) delete[] level.b;
+	}
+	delete[] _levels;
+}
+
+void MULTIGRID::initLevel(Level &level, int xRes, int yRes, int zRes)
+{
+	level.res[0] = xRes;
+	level.res[1] = yRes;
+	level.res[2] = zRes;
+	level.slabSize = xRes * yRes;
+	level.totalCells = (size_t)level.slabSize * zRes;
+
+	level.diag = new float[level.totalCells];
+	level.invDiag = new float[level.totalCells];
+	level.type = new unsigned char[level.totalCells];
+	level.r = new float[level.totalCells];
+	level.tmp = new float[level.totalCells];
+
+	// vectors of the finest level are owned by the caller
+	level.x = NULL;
+	level.b = NULL;
+
+	memset(level.r, 0, sizeof(float) * level.totalCells);
+	memset(level.tmp, 0, sizeof(float) * level.totalCells);
+}
+
+// fine cells of coarse cell X along one axis, border cells only map to border cells
+static void mg_children(int X, int coarseRes, int fineRes, int *r_first, int *r_last)
+{
+	if (X == 0) {
+		*r_first = *r_last = 0;
+	}
+	else if (X == coarseRes - 1) {
+		*r_first = *r_last = fineRes - 1;
+	}
+	else {
+		*r_first = 2 * X - 1;
+		*r_last = (2 * X < fineRes - 1) ? 2 * X : 2 * X - 1;
+	}
+}
+
+// a coarse cell is Dirichlet if any of its children is, fluid if any child is fluid
+void MULTIGRID::coarsenTypes(const Level &fine, Level &coarse)
+{
+	size_t index = 0;
+	for (int z = 0; z < coarse.res[2]; z++) {
+		int z0, z1;
+		mg_children(z, coarse.res[2], fine.res[2], &z0, &z1);
+		for (int y = 0; y < coarse.res[1]; y++) {
+			int y0, y1;
+			mg_children(y, coarse.res[1], fine.res[1], &y0, &y1);
+			for (int x = 0; x < coarse.res[0]; x++, index++) {
+				int x0, x1;
+				mg_children(x, coarse.res[0], fine.res[0], &x0, &x1);
+
+				unsigned char type = CELL_SOLID;
+				for (int fz = z0; fz <= z1; fz++)
+					for (int fy = y0; fy <= y1; fy++)
+						for (int fx = x0; fx <= x1; fx++) {
+							const unsigned char fineType = fine.type[fx + fy * fine.res[0] + fz * fine.slabSize];
+							if (fineType == CELL_DIRICHLET)
+								type = CELL_DIRICHLET;
+							else if (fineType == CELL_FLUID && type == CELL_SOLID)
+								type = CELL_FLUID;
+						}
+				coarse.type[index] = type;
+			}
+		}
+	}
+}
+
+void MULTIGRID::initDiagonal(Level &level)
+{
+	const int xRes = level.res[0];
+	const int slabSize = level.slabSize;
+	const unsigned char *type = level.type;
+
+	memset(level.diag, 0, sizeof(float) * level.totalCells);
+	memset(level.invDiag, 0, sizeof(float) * level.totalCells);
+
+	for (int z = 1; z < level.res[2] - 1; z++)
+		for (int y = 1; y < level.res[1] - 1; y++) {
+			size_t index = 1 + y * xRes + (size_t)z * slabSize;
+			for (int x = 1; x < xRes - 1; x++, index++) {
+				if (type[index] != CELL_FLUID)
+					continue;
+
+				float diag = 0.0f;
+				if (type[index + 1] != CELL_SOLID) diag += 1.0f;
+				if (type[index - 1] != CELL_SOLID) diag += 1.0f;
+				if (type[index + xRes] != CELL_SOLID) diag += 1.0f;
+				if (type[index - xRes] != CELL_SOLID) diag += 1.0f;
+				if (type[index + slabSize] != CELL_SOLID) diag += 1.0f;
+				if (type[index - slabSize] != CELL_SOLID) diag += 1.0f;
+
+				// isolated cells are not unknowns
+				if (diag > 0.0f) {
+					level.diag[index] = diag;
+					level.invDiag[index] = MG_JACOBI_WEIGHT / diag;
+				}
+			}
+		}
+}
+
+//////////////////////////////////////////////////////////////////////
+// damped Jacobi, an even number of sweeps alternating between x and tmp
+//////////////////////////////////////////////////////////////////////
+void MULTIGRID::smooth(const Level &level, float *x, const float *b, int sweeps, bool zeroGuess)
+{
+	const int xRes = level.res[0];
+	const int yRes = level.res[1];
+	const int zRes = level.res[2];
+	const int slabSize = level.slabSize;
+	const float *diag = level.diag;
+	const float *invDiag = level.invDiag;
+
+	for (int sweep = 0; sweep < sweeps; sweep++) {
+		const float *src = (sweep & 1) ? level.tmp : x;
+		float *dst = (sweep & 1) ? x : level.tmp;
+
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static) if (level.totalCells > MG_PARALLEL_LIMIT)
+#endif
+		for (int z = 1; z < zRes - 1; z++)
+			for (int y = 1; y < yRes - 1; y++) {
+				const size_t index = 1 + y * xRes + (size_t)z * slabSize;
+				const float *s = src + index;
+				const float *bb = b + index;
+				const float *d = diag + index;
+				const float *id = invDiag + index;
+				float *o = dst + index;
+
+				if (sweep == 0 && zeroGuess) {
+					for (int x = 0; x < xRes - 2; x++)
+						o[x] = id[x] * bb[x];
+				}
+				else {
+					for (int x = 0; x < xRes - 2; x++) {
+						const float Ax = d[x] * s[x] -
+						        (s[x - 1] + s[x + 1] +
+						         s[x - xRes] + s[x + xRes] +
+						         s[x - slabSize] + s[x + slabSize]);
+						o[x] = s[x] + id[x] * (bb[x] - Ax);
+					}
+				}
+			}
+	}
+}
+
+void MULTIGRID::residual(const Level &level, const float *x, const float *b, float *r)
+{
+	const int xRes = level.res[0];
+	const int yRes = level.res[1];
+	const int zRes = level.res[2];
+	const int slabSize = level.slabSize;
+	const float *diag = level.diag;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (level.totalCells > MG_PARALLEL_LIMIT)
+#endif
+	for (int z = 1; z < zRes - 1; z++)
+		for (int y = 1; y < yRes - 1; y++) {
+			const size_t index = 1 + y * xRes + (size_t)z * slabSize;
+			const float *s = x + index;
+			const float *bb = b + index;
+			const float *d = diag + index;
+			float *o = r + index;
+
+			for (int x = 0; x < xRes - 2; x++) {
+				const float Ax = d[x] * s[x] -
+				        (s[x - 1] + s[x + 1] +
+				         s[x - xRes] + s[x + xRes] +
+				         s[x - slabSize] + s[x + slabSize]);
+				o[x] = (d[x] > 0.0f) ? bb[x] - Ax : 0.0f;
+			}
+		}
+}
+
+//////////////////////////////////////////////////////////////////////
+// transpose of prolongate(), scaled by 1/2: averaging over the eight
+// children gives 1/8, the unscaled operator of the coarse level 4
+//////////////////////////////////////////////////////////////////////
+void MULTIGRID::restrictResidual(const Level &fine, const float *r, Level &coarse)
+{
+	const int xRes = coarse.res[0];
+	const int yRes = coarse.res[1];
+	const int zRes = coarse.res[2];
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (fine.totalCells > MG_PARALLEL_LIMIT)
+#endif
+	for (int z = 1; z < zRes - 1; z++)
+		for (int y = 1; y < yRes - 1; y++) {
+			size_t index = 1 + y * xRes + (size_t)z * coarse.slabSize;
+			for (int x = 1; x < xRes - 1; x++, index++) {
+				if (coarse.diag[index] == 0.0f) {
+					coarse.b[index] = 0.0f;
+					continue;
+				}
+
+				float sum = 0.0f;
+				for (int k = 0; k < 4; k++) {
+					const int fz = 2 * z - 2 + k;
+					if (fz >= fine.res[2])
+						break;
+					for (int j = 0; j < 4; j++) {
+						const int fy = 2 * y - 2 + j;
+						if (fy >= fine.res[1])
+							break;
+						const float *row = r + (size_t)fz * fine.slabSize + fy * fine.res[0];
+						const float wzy = mg_restrict_weights[k] * mg_restrict_weights[j];
+						for (int i = 0; i < 4; i++) {
+							const int fx = 2 * x - 2 + i;
+							if (fx >= fine.res[0])
+								break;
+							sum += wzy * mg_restrict_weights[i] * row[fx];
+						}
+					}
+				}
+				coarse.b[index] = 0.5f * sum;
+			}
+		}
+}
+
+// trilinear interpolation of cell centered values, added to xFine
+void MULTIGRID::prolongate(const Level &coarse, const float *x, const Level &fine, float *xFine)
+{
+	const int xRes = fine.res[0];
+	const int yRes = fine.res[1];
+	const int zRes = fine.res[2];
+	const int cx = coarse.res[0];
+	const int cslab = coarse.slabSize;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (fine.totalCells > MG_PARALLEL_LIMIT)
+#endif
+	for (int z = 1; z < zRes - 1; z++) {
+		const int Z = (z + 1) / 2;
+		const int Zn = (z & 1) ? Z - 1 : Z + 1;
+		for (int y = 1; y < yRes - 1; y++) {
+			const int Y = (y + 1) / 2;
+			const int Yn = (y & 1) ? Y - 1 : Y + 1;
+			const float *c00 = x + (size_t)Z * cslab + Y * cx;
+			const float *c01 = x + (size_t)Z * cslab + Yn * cx;
+			const float *c10 = x + (size_t)Zn * cslab + Y * cx;
+			const float *c11 = x + (size_t)Zn * cslab + Yn * cx;
+			size_t index = 1 + y * xRes + (size_t)z * fine.slabSize;
+
+			for (int fx = 1; fx < xRes - 1; fx++, index++) {
+				if (fine.diag[index] == 0.0f)
+					continue;
+
+				const int X = (fx + 1) / 2;
+				const int Xn = (fx & 1) ? X - 1 : X + 1;
+				const float v00 = 0.75f * c00[X] + 0.25f * c00[Xn];
+				const float v01 = 0.75f * c01[X] + 0.25f * c01[Xn];
+				const float v10 = 0.75f * c10[X] + 0.25f * c10[Xn];
+				const float v11 = 0.75f * c11[X] + 0.25f * c11[Xn];
+
+				xFine[index] += 0.75f * (0.75f * v00 + 0.25f * v01) + 0.25f * (0.75f * v10 + 0.25f * v11);
+			}
+		}
+	}
+}
+
+void MULTIGRID::cycle(int l, const float *b, float *x)
+{
+	const Level &level = _levels[l];
+
+	if (l == _numLevels - 1) {
+		smooth(level, x, b, MG_COARSEST_SWEEPS, true);
+		return;
+	}
+
+	Level &coarse = _levels[l + 1];
+
+	smooth(level, x, b, MG_SMOOTH_SWEEPS, true);
+	residual(level, x, b, level.r);
+	restrictResidual(level, level.r, coarse);
+	cycle(l + 1, coarse.b, coarse.x);
+	prolongate(coarse, coarse.x, level, x);
+	smooth(level, x, b, MG_SMOOTH_SWEEPS, false);
+}
+
+void MULTIGRID::vcycle(const float *b, float *x)
+{
+	cycle(0, b, x);
+}
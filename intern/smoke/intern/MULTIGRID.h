@@ -0,0 +1,90 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file smoke/intern/MULTIGRID.h
+ *  \ingroup smoke
+ */
+
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <cstddef>
+
+// Geometric multigrid V-cycle for the pressure Poisson matrix of FLUID_3D,
+// used as preconditioner of the conjugate gradient solver.
+//
+// Cells of every level are either fluid (unknowns), solid (Neumann boundary)
+// or Dirichlet (pressure fixed to zero). The outermost ring of cells of every
+// level is never fluid, so stencils need no bounds checks. Vectors are kept
+// zero in all non-fluid cells, which makes the stencil branch free.
+//
+// Jacobi smoothing and trilinear restriction and prolongation (restriction
+// being the scaled transpose of prolongation) keep the V-cycle symmetric, as
+// required by CG. All loops are parallel over z slices and deterministic.
+class MULTIGRID
+{
+	public:
+		MULTIGRID(int xRes, int yRes, int zRes, const unsigned char *skip);
+		~MULTIGRID();
+
+		// x = M^-1 b, x and b are full fine grid arrays
+		void vcycle(const float *b, float *x);
+
+		// diagonal of the fine matrix, 0 for cells which are not unknowns
+		const float *diagonal() const { return _levels[0].diag; }
+
+	private:
+		struct Level {
+			int res[3];
+			int slabSize;
+			size_t totalCells;
+			float *diag;     // number of non-solid neighbors, 0 for non-fluid cells
+			float *invDiag;  // weighted inverse of diag, 0 for non-fluid cells
+			unsigned char *type;
+			float *x;
+			float *b;
+			float *r;
+			float *tmp;
+		};
+
+		enum {
+			CELL_SOLID = 0,
+			CELL_FLUID = 1,
+			CELL_DIRICHLET = 2
+		};
+
+		Level *_levels;
+		int _numLevels;
+
+		void initLevel(Level &level, int xRes, int yRes, int zRes);
+		void coarsenTypes(const Level &fine, Level &coarse);
+		void initDiagonal(Level &level);
+
+		void smooth(const Level &level, float *x, const float *b, int sweeps, bool zeroGuess);
+		void residual(const Level &level, const float *x, const float *b, float *r);
+		void restrictResidual(const Level &fine, const float *r, Level &coarse);
+		void prolongate(const Level &coarse, const float *x, const Level &fine, float *xFine);
+		void cycle(int l, const float *b, float *x);
+};
+
+#endif
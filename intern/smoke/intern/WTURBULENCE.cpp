@@ -48,6 +48,14 @@
 // 2^ {-5/6}
 static const float persistence = 0.56123f;
 
+// size of active tiles in cells of the small grid
+#define WT_TILE_SIZE 4
+
+// substep when values move more than WT_SUBSTEP_CELLS cells of the big grid
+// in a step, with at most WT_MAX_SUBSTEPS substeps
+#define WT_SUBSTEP_CELLS 5
+#define WT_MAX_SUBSTEPS 25
+
 //////////////////////////////////////////////////////////////////////
 // constructor
 //////////////////////////////////////////////////////////////////////
@@ -132,6 +140,13 @@ WTURBULENCE::WTURBULENCE(int xResSm, int yResSm, int zResSm, int amplify, int no
 	// noise tiles
 	_noiseTile = new float[noiseTileSize * noiseTileSize * noiseTileSize];
 	setNoise(noisetype, noisefile_path);
+
+	// active tiles, sized in cells of the big grid
+	_tiles.size = WT_TILE_SIZE * _amplify;
+	_tiles.res[0] = (_xResSm + WT_TILE_SIZE - 1) / WT_TILE_SIZE;
+	_tiles.res[1] = (_yResSm + WT_TILE_SIZE - 1) / WT_TILE_SIZE;
+	_tiles.res[2] = (_zResSm + WT_TILE_SIZE - 1) / WT_TILE_SIZE;
+	_tiles.active = new unsigned char[_tiles.res[0] * _tiles.res[1] * _tiles.res[2]];
 }
 
 void WTURBULENCE::initFire()
@@ -199,6 +214,202 @@ WTURBULENCE::~WTURBULENCE() {
   delete[] _tcTemp;
 
   delete[] _noiseTile;
+  delete[] _tiles.active;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Find the tiles which hold any density, fuel or color, and grow them
+// by the distance the velocity can move values during this step. Only
+// these tiles get noise and are advected, everything else stays zero.
+//////////////////////////////////////////////////////////////////////
+static void markActiveTiles(const float *field, unsigned char *active, const int *tileRes, int tileSize, Vec3Int res, int tz)
+{
+	const int zBegin = tz * tileSize;
+	const int zEnd = (zBegin + tileSize < res[2]) ? zBegin + tileSize : res[2];
+
+	for (int z = zBegin; z < zEnd; z++)
+		for (int y = 0; y < res[1]; y++) {
+			unsigned char *tileRow = active + (y / tileSize) * tileRes[0] + tz * tileRes[0] * tileRes[1];
+			const float *row = field + (size_t)z * res[0] * res[1] + (size_t)y * res[0];
+
+			for (int tx = 0; tx < tileRes[0]; tx++) {
+				if (tileRow[tx])
+					continue;
+
+				const int xEnd = ((tx + 1) * tileSize < res[0]) ? (tx + 1) * tileSize : res[0];
+				for (int x = tx * tileSize; x < xEnd; x++) {
+					if (row[x] != 0.0f) {
+						tileRow[tx] = 1;
+						break;
+					}
+				}
+			}
+		}
+}
+
+// number of substeps for moving values with the squared velocity maxVelMag,
+// capped to WT_MAX_SUBSTEPS
+static int turbulenceSubsteps(float maxVelMag, float dt)
+{
+	maxVelMag = sqrt(maxVelMag) * dt;
+	int totalSubsteps = (int)(maxVelMag / (float)WT_SUBSTEP_CELLS);
+	totalSubsteps = (totalSubsteps < 1) ? 1 : totalSubsteps;
+	totalSubsteps = (totalSubsteps > WT_MAX_SUBSTEPS) ? WT_MAX_SUBSTEPS : totalSubsteps;
+	return totalSubsteps;
+}
+
+// activate the tiles within margin[tile] tiles of an active tile
+static void growActiveTiles(unsigned char *active, const int *margin, const int *tileRes)
+{
+	// summed volume table of the active tiles, for counting them in boxes
+	const int sx = tileRes[0] + 1, sy = tileRes[1] + 1, sz = tileRes[2] + 1;
+	int *sum = new int[sx * sy * sz];
+	memset(sum, 0, sizeof(int) * sx * sy * sz);
+
+	int index = 0;
+	for (int z = 1; z < sz; z++)
+		for (int y = 1; y < sy; y++)
+			for (int x = 1; x < sx; x++, index++) {
+				const int i = x + y * sx + z * sx * sy;
+				sum[i] = active[index] +
+				         sum[i - 1] + sum[i - sx] + sum[i - sx * sy] -
+				         sum[i - 1 - sx] - sum[i - 1 - sx * sy] - sum[i - sx - sx * sy] +
+				         sum[i - 1 - sx - sx * sy];
+			}
+
+	index = 0;
+	for (int z = 0; z < tileRes[2]; z++)
+		for (int y = 0; y < tileRes[1]; y++)
+			for (int x = 0; x < tileRes[0]; x++, index++) {
+				if (active[index] || margin[index] <= 0)
+					continue;
+
+				// box of tiles, as begin and end in the table
+				const int m = margin[index];
+				const int x0 = MAX(x - m, 0), x1 = MIN(x + m + 1, tileRes[0]);
+				const int y0 = MAX(y - m, 0), y1 = MIN(y + m + 1, tileRes[1]);
+				const int z0 = MAX(z - m, 0), z1 = MIN(z + m + 1, tileRes[2]);
+				const int count =
+				        sum[x1 + y1 * sx + z1 * sx * sy] - sum[x0 + y1 * sx + z1 * sx * sy] -
+				        sum[x1 + y0 * sx + z1 * sx * sy] - sum[x1 + y1 * sx + z0 * sx * sy] +
+				        sum[x0 + y0 * sx + z1 * sx * sy] + sum[x0 + y1 * sx + z0 * sx * sy] +
+				        sum[x1 + y0 * sx + z0 * sx * sy] - sum[x0 + y0 * sx + z0 * sx * sy];
+				if (count > 0)
+					active[index] = 1;
+			}
+
+	delete[] sum;
+}
+
+// flag the tiles which hold density, fuel or color
+void WTURBULENCE::markFilledTiles(unsigned char *filled)
+{
+	const float *fields[6] = {_densityBig, _fuelBig, _reactBig, _color_rBig, _color_gBig, _color_bBig};
+
+	memset(filled, 0, _tiles.res[0] * _tiles.res[1] * _tiles.res[2]);
+
+	// every thread marks its own layers of tiles
+#if PARALLEL==1
+#pragma omp parallel for schedule(static,1)
+#endif
+	for (int tz = 0; tz < _tiles.res[2]; tz++)
+		for (int i = 0; i < 6; i++)
+			if (fields[i])
+				markActiveTiles(fields[i], filled, _tiles.res, _tiles.size, _resBig, tz);
+}
+
+// Upper bound of the velocity with noise in the big grid cells of every tile.
+// The velocity interpolates the coarse velocity and energy of the neighboring
+// coarse cells. The noise derivatives blend differences of neighboring noise
+// tile values with weights between 0 and 1, so they are bounded by the largest
+// difference, and the noise velocity combines them with the unwarped vectors
+// of the coarse cell.
+void WTURBULENCE::computeTileVelocityBounds(float *tileVelBound, const float *xvel, const float *yvel, const float *zvel,
+		const float *highFreqEnergy, const float *eigMin, const float *eigMax, const float *unwarped)
+{
+	float octaveSum = 0.0f, octaveAmplitude = 1.0f;
+	for (int octave = 0; octave < _octaves; octave++) {
+		octaveSum += octaveAmplitude;
+		octaveAmplitude *= persistence;
+	}
+
+	memset(tileVelBound, 0, sizeof(float) * _tiles.res[0] * _tiles.res[1] * _tiles.res[2]);
+
+	for (int z = 0; z < _zResSm; z++)
+		for (int y = 0; y < _yResSm; y++)
+			for (int x = 0; x < _xResSm; x++) {
+				const int indexSmall = x + y * _xResSm + z * _slabSizeSm;
+				float maxVelMag = 0.0f, maxEnergy = 0.0f;
+
+				for (int k = MAX(z - 1, 0); k <= MIN(z + 1, _zResSm - 1); k++)
+					for (int j = MAX(y - 1, 0); j <= MIN(y + 1, _yResSm - 1); j++)
+						for (int i = MAX(x - 1, 0); i <= MIN(x + 1, _xResSm - 1); i++) {
+							const int index = i + j * _xResSm + k * _slabSizeSm;
+							const float velMag = xvel[index] * xvel[index] + yvel[index] * yvel[index] + zvel[index] * zvel[index];
+							maxVelMag = MAX(maxVelMag, velMag);
+							maxEnergy = MAX(maxEnergy, fabsf(highFreqEnergy[index]));
+						}
+
+				float bound = sqrtf(maxVelMag);
+				if (eigMax[indexSmall] < 2.0f && eigMin[indexSmall] > 0.5f) {
+					const float *cellUnwarped = unwarped + 9 * (size_t)indexSmall;
+					float norm[3];
+					for (int i = 0; i < 3; i++)
+						norm[i] = fabsf(cellUnwarped[3 * i]) + fabsf(cellUnwarped[3 * i + 1]) + fabsf(cellUnwarped[3 * i + 2]);
+					const float curl = sqrtf((norm[1] + norm[2]) * (norm[1] + norm[2]) +
+					                         (norm[2] + norm[0]) * (norm[2] + norm[0]) +
+					                         (norm[0] + norm[1]) * (norm[0] + norm[1]));
+					const float amplitude = fabsf(*_strength) * 0.5f * sqrtf(2.0f * maxEnergy) * persistence;
+					bound += amplitude * octaveSum * curl * _noiseTileMaxDiff;
+				}
+				// room for rounding errors
+				bound = bound * 1.001f + 1e-6f;
+
+				const int indexTile = x / WT_TILE_SIZE + (y / WT_TILE_SIZE) * _tiles.res[0] +
+				                      (z / WT_TILE_SIZE) * _tiles.res[0] * _tiles.res[1];
+				tileVelBound[indexTile] = MAX(tileVelBound[indexTile], bound);
+			}
+}
+
+// Activate the tiles values can reach from the filled tiles in the substeps.
+// A cell takes its value from the cells around its backtrace, one cell more
+// than its velocity times dt away, with one more cell for rounding. Cells next
+// to the border of the grid are copied from the cell next to them before
+// clamping, which also uses the forward trace, so tiles at the border use the
+// largest velocity twice.
+void WTURBULENCE::updateActiveTiles(const unsigned char *filledTiles, const float *tileVelBound, float dt, int substeps)
+{
+	const int totalTiles = _tiles.res[0] * _tiles.res[1] * _tiles.res[2];
+	const int maxMargin = MAX3(_tiles.res[0], _tiles.res[1], _tiles.res[2]);
+	int *margin = new int[totalTiles];
+
+	float maxVelBound = 0.0f;
+	for (int i = 0; i < totalTiles; i++)
+		maxVelBound = MAX(maxVelBound, tileVelBound[i]);
+
+	int index = 0;
+	for (int z = 0; z < _tiles.res[2]; z++)
+		for (int y = 0; y < _tiles.res[1]; y++)
+			for (int x = 0; x < _tiles.res[0]; x++, index++) {
+				const int tile[3] = {x, y, z};
+				bool border = false;
+				for (int i = 0; i < 3; i++) {
+					const int begin = tile[i] * _tiles.size;
+					const int end = MIN(begin + _tiles.size, _resBig[i]);
+					border |= (begin < 2) || (end > _resBig[i] - 2);
+				}
+
+				const float reach = border ? (tileVelBound[index] + maxVelBound) * dt + 4.0f :
+				                             tileVelBound[index] * dt + 2.0f;
+				const float marginTiles = ceilf(reach / _tiles.size);
+				margin[index] = (marginTiles < (float)maxMargin) ? (int)marginTiles : maxMargin;
+			}
+
+	memcpy(_tiles.active, filledTiles, totalTiles);
+	for (int substep = 0; substep < substeps; substep++)
+		growActiveTiles(_tiles.active, margin, _tiles.res);
+
+	delete[] margin;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -216,6 +427,7 @@ void WTURBULENCE::setNoise(int type, const char *noisefile_path)
 		// needs fft
 		std::string noiseTileFilename = std::string(noisefile_path) + std::string("noise.fft");
 		generatTile_FFT(_noiseTile, noiseTileFilename);
+		updateNoiseTileMaxDiff();
 		return;
 #else
 		fprintf(stderr, "FFTW not enabled, falling back to wavelet noise.\n");
@@ -231,6 +443,26 @@ void WTURBULENCE::setNoise(int type, const char *noisefile_path)
 
 	std::string noiseTileFilename = std::string(noisefile_path) + std::string("noise.wavelets");
 	generateTile_WAVELET(_noiseTile, noiseTileFilename);
+	updateNoiseTileMaxDiff();
+}
+
+// the noise derivatives blend differences of neighboring tile values, so
+// the largest difference bounds them and the noise added to the velocity
+void WTURBULENCE::updateNoiseTileMaxDiff()
+{
+	const int n = noiseTileSize;
+
+	_noiseTileMaxDiff = 0.0f;
+	for (int z = 0; z < n; z++)
+		for (int y = 0; y < n; y++)
+			for (int x = 0; x < n; x++) {
+				const float value = _noiseTile[x + y * n + z * n * n];
+				const float diff[3] = {
+					fabsf(_noiseTile[modFast128(x + 1) + y * n + z * n * n] - value),
+					fabsf(_noiseTile[x + modFast128(y + 1) * n + z * n * n] - value),
+					fabsf(_noiseTile[x + y * n + modFast128(z + 1) * n * n] - value)};
+				_noiseTileMaxDiff = MAX3(_noiseTileMaxDiff, MAX(diff[0], diff[1]), diff[2]);
+			}
 }
 
 // init direct access functions from blender
@@ -811,66 +1043,19 @@ Vec3 WTURBULENCE::WVelocityWithJacobian(const Vec3& orgPos, float* xUnwarped, fl
 //struct
 
 //////////////////////////////////////////////////////////////////////
-// perform the full turbulence algorithm, including OpenMP 
-// if available
+// add noise to the coarse velocity in the big grid cells of the tiles
+// flagged in tiles, returns the largest squared velocity of these cells
 //////////////////////////////////////////////////////////////////////
-void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, float* zvel, unsigned char *obstacles)
+float WTURBULENCE::computeBigVelocity(const unsigned char *tiles, float* xvel, float* yvel, float* zvel, unsigned char *obstacles,
+		float *highFreqEnergy, float *eigMin, float *eigMax, float *unwarped, float *bigUx, float *bigUy, float *bigUz)
 {
-	// enlarge timestep to match grid
-	const float dt = dtOrg * _amplify;
-	const float invAmp = 1.0f / _amplify;
-	float *tempFuelBig = NULL, *tempReactBig = NULL;
-	float *tempColor_rBig = NULL, *tempColor_gBig = NULL, *tempColor_bBig = NULL;
-	float *tempDensityBig = (float *)calloc(_totalCellsBig, sizeof(float));
-	float *tempBig = (float *)calloc(_totalCellsBig, sizeof(float));
-	float *bigUx = (float *)calloc(_totalCellsBig, sizeof(float));
-	float *bigUy = (float *)calloc(_totalCellsBig, sizeof(float));
-	float *bigUz = (float *)calloc(_totalCellsBig, sizeof(float)); 
-	float *_energy = (float *)calloc(_totalCellsSm, sizeof(float));
-	float *highFreqEnergy = (float *)calloc(_totalCellsSm, sizeof(float));
-	float *eigMin  = (float *)calloc(_totalCellsSm, sizeof(float));
-	float *eigMax  = (float *)calloc(_totalCellsSm, sizeof(float));
-
-	if (_fuelBig) {
-		tempFuelBig = (float *)calloc(_totalCellsBig, sizeof(float));
-		tempReactBig = (float *)calloc(_totalCellsBig, sizeof(float));
-	}
-	if (_color_rBig) {
-		tempColor_rBig = (float *)calloc(_totalCellsBig, sizeof(float));
-		tempColor_gBig = (float *)calloc(_totalCellsBig, sizeof(float));
-		tempColor_bBig = (float *)calloc(_totalCellsBig, sizeof(float));
-	}
-
-	memset(_tcTemp, 0, sizeof(float)*_totalCellsSm);
-
-
-	// prepare textures
-	advectTextureCoordinates(dtOrg, xvel,yvel,zvel, tempDensityBig, tempBig);
-
-	// do wavelet decomposition of energy
-	computeEnergy(_energy, xvel, yvel, zvel, obstacles);
-
-	for (int x = 0; x < _totalCellsSm; x++)
-		if (obstacles[x]) _energy[x] = 0.f;
-
-	decomposeEnergy(_energy, highFreqEnergy);
-
-	// zero out coefficients inside of the obstacle
-	for (int x = 0; x < _totalCellsSm; x++)
-		if (obstacles[x]) highFreqEnergy[x] = 0.f;
-
-	Vec3Int ressm(_xResSm, _yResSm, _zResSm);
-	FLUID_3D::setNeumannX(highFreqEnergy, ressm, 0 , ressm[2]);
-	FLUID_3D::setNeumannY(highFreqEnergy, ressm, 0 , ressm[2]);
-	FLUID_3D::setNeumannZ(highFreqEnergy, ressm, 0 , ressm[2]);
-
+  const float invAmp = 1.0f / _amplify;
 
    int threadval = 1;
 #if PARALLEL==1
   threadval = omp_get_max_threads();
 #endif
 
-
   // parallel region setup
   // Uses omp_get_max_trheads to get number of required cells.
   float* maxVelMagThreads = new float[threadval];
@@ -896,47 +1081,16 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
   for (int xSmall = 0; xSmall < _xResSm; xSmall++)
   {
     const int indexSmall = xSmall + ySmall * _xResSm + zSmall * _slabSizeSm;
+    const int indexTile = xSmall / WT_TILE_SIZE + (ySmall / WT_TILE_SIZE) * _tiles.res[0] +
+                          (zSmall / WT_TILE_SIZE) * _tiles.res[0] * _tiles.res[1];
 
-    // compute jacobian
-    float jacobian[3][3] = {
-      { minDx(xSmall, ySmall, zSmall, _tcU, _resSm), minDx(xSmall, ySmall, zSmall, _tcV, _resSm), minDx(xSmall, ySmall, zSmall, _tcW, _resSm) } ,
-      { minDy(xSmall, ySmall, zSmall, _tcU, _resSm), minDy(xSmall, ySmall, zSmall, _tcV, _resSm), minDy(xSmall, ySmall, zSmall, _tcW, _resSm) } ,
-      { minDz(xSmall, ySmall, zSmall, _tcU, _resSm), minDz(xSmall, ySmall, zSmall, _tcV, _resSm), minDz(xSmall, ySmall, zSmall, _tcW, _resSm) }
-    };
-
-    // get LU factorization of texture jacobian and apply 
-    // it to unit vectors
-    sLU LU = computeLU(jacobian);
-    float xUnwarped[3], yUnwarped[3], zUnwarped[3];
-    float xWarped[3], yWarped[3], zWarped[3];
-    bool nonSingular = isNonsingular(LU);
+    if (!tiles[indexTile])
+      continue;
 
-	xUnwarped[0] = 1.0f; xUnwarped[1] = 0.0f; xUnwarped[2] = 0.0f;
-	yUnwarped[0] = 0.0f; yUnwarped[1] = 1.0f; yUnwarped[2] = 0.0f;
-	zUnwarped[0] = 0.0f; zUnwarped[1] = 0.0f; zUnwarped[2] = 1.0f;
-
-	xWarped[0] = 1.0f; xWarped[1] = 0.0f; xWarped[2] = 0.0f;
-	yWarped[0] = 0.0f; yWarped[1] = 1.0f; yWarped[2] = 0.0f;
-	zWarped[0] = 0.0f; zWarped[1] = 0.0f; zWarped[2] = 1.0f;
+    float *xUnwarped = unwarped + 9 * (size_t)indexSmall;
+    float *yUnwarped = xUnwarped + 3;
+    float *zUnwarped = xUnwarped + 6;
 
-#if 0
-	// UNUSED
-    float eigMax = 10.0f;
-    float eigMin = 0.1f;
-#endif
-    if (nonSingular)
-    {
-      solveLU3x3(LU, xUnwarped, xWarped);
-      solveLU3x3(LU, yUnwarped, yWarped);
-      solveLU3x3(LU, zUnwarped, zWarped);
-
-      // compute the eigenvalues while we have the Jacobian available
-      Vec3 eigenvalues = Vec3(1.);
-      computeEigenvalues3x3( &eigenvalues[0], jacobian);
-      eigMax[indexSmall] = MAX3V(eigenvalues);
-      eigMin[indexSmall] = MIN3V(eigenvalues);
-    }
-    
     // make sure to skip one on the beginning and end
     int xStart = (xSmall == 0) ? 1 : 0;
     int xEnd   = (xSmall == _xResSm - 1) ? _amplify - 1 : _amplify;
@@ -1043,6 +1197,183 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 #endif
   delete [] maxVelMagThreads;
 
+  return (maxVelMag > 0.0f) ? maxVelMag : 0.0f;
+}
+
+//////////////////////////////////////////////////////////////////////
+// perform the full turbulence algorithm, including OpenMP 
+// if available
+//////////////////////////////////////////////////////////////////////
+void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, float* zvel, unsigned char *obstacles)
+{
+	// enlarge timestep to match grid
+	const float dt = dtOrg * _amplify;
+	float *tempFuelBig = NULL, *tempReactBig = NULL;
+	float *tempColor_rBig = NULL, *tempColor_gBig = NULL, *tempColor_bBig = NULL;
+	float *tempDensityBig = (float *)calloc(_totalCellsBig, sizeof(float));
+	float *tempBig = (float *)calloc(_totalCellsBig, sizeof(float));
+	float *bigUx = (float *)calloc(_totalCellsBig, sizeof(float));
+	float *bigUy = (float *)calloc(_totalCellsBig, sizeof(float));
+	float *bigUz = (float *)calloc(_totalCellsBig, sizeof(float)); 
+	float *_energy = (float *)calloc(_totalCellsSm, sizeof(float));
+	float *highFreqEnergy = (float *)calloc(_totalCellsSm, sizeof(float));
+	float *eigMin  = (float *)calloc(_totalCellsSm, sizeof(float));
+	float *eigMax  = (float *)calloc(_totalCellsSm, sizeof(float));
+
+	if (_fuelBig) {
+		tempFuelBig = (float *)calloc(_totalCellsBig, sizeof(float));
+		tempReactBig = (float *)calloc(_totalCellsBig, sizeof(float));
+	}
+	if (_color_rBig) {
+		tempColor_rBig = (float *)calloc(_totalCellsBig, sizeof(float));
+		tempColor_gBig = (float *)calloc(_totalCellsBig, sizeof(float));
+		tempColor_bBig = (float *)calloc(_totalCellsBig, sizeof(float));
+	}
+
+	memset(_tcTemp, 0, sizeof(float)*_totalCellsSm);
+
+	// prepare textures
+	advectTextureCoordinates(dtOrg, xvel,yvel,zvel, tempDensityBig, tempBig);
+
+	// do wavelet decomposition of energy
+	computeEnergy(_energy, xvel, yvel, zvel, obstacles);
+
+	for (int x = 0; x < _totalCellsSm; x++)
+		if (obstacles[x]) _energy[x] = 0.f;
+
+	decomposeEnergy(_energy, highFreqEnergy);
+
+	// zero out coefficients inside of the obstacle
+	for (int x = 0; x < _totalCellsSm; x++)
+		if (obstacles[x]) highFreqEnergy[x] = 0.f;
+
+	Vec3Int ressm(_xResSm, _yResSm, _zResSm);
+	FLUID_3D::setNeumannX(highFreqEnergy, ressm, 0 , ressm[2]);
+	FLUID_3D::setNeumannY(highFreqEnergy, ressm, 0 , ressm[2]);
+	FLUID_3D::setNeumannZ(highFreqEnergy, ressm, 0 , ressm[2]);
+
+
+   int threadval = 1;
+#if PARALLEL==1
+  threadval = omp_get_max_threads();
+#endif
+
+  // unwarped unit vectors and eigenvalues of the texture jacobian, for all
+  // coarse cells, resetting the texture coordinates needs the eigenvalues of
+  // cells outside of the active tiles too
+  float *unwarped = (float *)calloc(9 * (size_t)_totalCellsSm, sizeof(float));
+
+#if PARALLEL==1
+#pragma omp parallel for schedule(static,1)
+#endif
+  for (int zSmall = 0; zSmall < _zResSm; zSmall++)
+  for (int ySmall = 0; ySmall < _yResSm; ySmall++) 
+  for (int xSmall = 0; xSmall < _xResSm; xSmall++)
+  {
+    const int indexSmall = xSmall + ySmall * _xResSm + zSmall * _slabSizeSm;
+
+    // compute jacobian
+    float jacobian[3][3] = {
+      { minDx(xSmall, ySmall, zSmall, _tcU, _resSm), minDx(xSmall, ySmall, zSmall, _tcV, _resSm), minDx(xSmall, ySmall, zSmall, _tcW, _resSm) } ,
+      { minDy(xSmall, ySmall, zSmall, _tcU, _resSm), minDy(xSmall, ySmall, zSmall, _tcV, _resSm), minDy(xSmall, ySmall, zSmall, _tcW, _resSm) } ,
+      { minDz(xSmall, ySmall, zSmall, _tcU, _resSm), minDz(xSmall, ySmall, zSmall, _tcV, _resSm), minDz(xSmall, ySmall, zSmall, _tcW, _resSm) }
+    };
+
+    // get LU factorization of texture jacobian and apply 
+    // it to unit vectors
+    sLU LU = computeLU(jacobian);
+    float xUnwarped[3], yUnwarped[3], zUnwarped[3];
+    float xWarped[3], yWarped[3], zWarped[3];
+    bool nonSingular = isNonsingular(LU);
+
+	xUnwarped[0] = 1.0f; xUnwarped[1] = 0.0f; xUnwarped[2] = 0.0f;
+	yUnwarped[0] = 0.0f; yUnwarped[1] = 1.0f; yUnwarped[2] = 0.0f;
+	zUnwarped[0] = 0.0f; zUnwarped[1] = 0.0f; zUnwarped[2] = 1.0f;
+
+	xWarped[0] = 1.0f; xWarped[1] = 0.0f; xWarped[2] = 0.0f;
+	yWarped[0] = 0.0f; yWarped[1] = 1.0f; yWarped[2] = 0.0f;
+	zWarped[0] = 0.0f; zWarped[1] = 0.0f; zWarped[2] = 1.0f;
+
+#if 0
+	// UNUSED
+    float eigMax = 10.0f;
+    float eigMin = 0.1f;
+#endif
+    if (nonSingular)
+    {
+      solveLU3x3(LU, xUnwarped, xWarped);
+      solveLU3x3(LU, yUnwarped, yWarped);
+      solveLU3x3(LU, zUnwarped, zWarped);
+
+      // compute the eigenvalues while we have the Jacobian available
+      Vec3 eigenvalues = Vec3(1.);
+      computeEigenvalues3x3( &eigenvalues[0], jacobian);
+      eigMax[indexSmall] = MAX3V(eigenvalues);
+      eigMin[indexSmall] = MIN3V(eigenvalues);
+    }
+
+    float *cellUnwarped = unwarped + 9 * (size_t)indexSmall;
+    for (int i = 0; i < 3; i++) {
+      cellUnwarped[i] = xUnwarped[i];
+      cellUnwarped[i + 3] = yUnwarped[i];
+      cellUnwarped[i + 6] = zUnwarped[i];
+    }
+  }
+
+  // upper bounds of the big grid velocity, for finding the tiles values can
+  // reach in this step without computing the noise everywhere
+  const int totalTiles = _tiles.res[0] * _tiles.res[1] * _tiles.res[2];
+  float *tileVelBound = new float[totalTiles];
+  computeTileVelocityBounds(tileVelBound, xvel, yvel, zvel, highFreqEnergy, eigMin, eigMax, unwarped);
+
+  // tiles with values, and tiles with computed velocity
+  unsigned char *filledTiles = new unsigned char[totalTiles];
+  unsigned char *velTiles = new unsigned char[totalTiles];
+  unsigned char *newTiles = new unsigned char[totalTiles];
+  markFilledTiles(filledTiles);
+  memset(velTiles, 0, totalTiles);
+
+  // first guess of the active tiles, as reached in a single substep
+  updateActiveTiles(filledTiles, tileVelBound, dt, 1);
+  float maxVelMag = computeBigVelocity(_tiles.active, xvel, yvel, zvel, obstacles,
+      highFreqEnergy, eigMin, eigMax, unwarped, bigUx, bigUy, bigUz);
+  memcpy(velTiles, _tiles.active, totalTiles);
+
+  // the number of substeps follows from the largest velocity of the whole
+  // grid, so also compute the velocity of tiles which may be faster
+  int totalSubsteps = turbulenceSubsteps(maxVelMag, dt);
+  bool newVelTiles = false;
+  for (int i = 0; i < totalTiles; i++) {
+    newTiles[i] = !velTiles[i] &&
+                  turbulenceSubsteps(tileVelBound[i] * tileVelBound[i], dt) > totalSubsteps;
+    newVelTiles |= newTiles[i];
+  }
+  if (newVelTiles) {
+    maxVelMag = MAX(maxVelMag, computeBigVelocity(newTiles, xvel, yvel, zvel, obstacles,
+        highFreqEnergy, eigMin, eigMax, unwarped, bigUx, bigUy, bigUz));
+    for (int i = 0; i < totalTiles; i++)
+      velTiles[i] |= newTiles[i];
+    totalSubsteps = turbulenceSubsteps(maxVelMag, dt);
+  }
+  const float dtSubdiv = dt / (float)totalSubsteps;
+
+  // the tiles values can reach in all substeps, everything outside of them
+  // stays zero, as it would when advecting the whole grid
+  updateActiveTiles(filledTiles, tileVelBound, dtSubdiv, totalSubsteps);
+  for (int i = 0; i < totalTiles; i++)
+    newTiles[i] = _tiles.active[i] && !velTiles[i];
+  computeBigVelocity(newTiles, xvel, yvel, zvel, obstacles,
+      highFreqEnergy, eigMin, eigMax, unwarped, bigUx, bigUy, bigUz);
+
+  // without inactive tiles the advection can skip the tile lookups
+  const ACTIVE_TILES *tiles = NULL;
+  for (int i = 0; i < totalTiles && !tiles; i++)
+    if (!_tiles.active[i]) tiles = &_tiles;
+
+  delete[] tileVelBound;
+  delete[] filledTiles;
+  delete[] velTiles;
+  delete[] newTiles;
 
   // prepare density for an advection
   SWAP_POINTERS(_densityBig, _densityBigOld);
@@ -1052,17 +1383,6 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
   SWAP_POINTERS(_color_gBig, _color_gBigOld);
   SWAP_POINTERS(_color_bBig, _color_bBigOld);
 
-  // based on the maximum velocity present, see if we need to substep,
-  // but cap the maximum number of substeps to 5
-  const int maxSubSteps = 25;
-  const int maxVel = 5;
-  maxVelMag = sqrt(maxVelMag) * dt;
-  int totalSubsteps = (int)(maxVelMag / (float)maxVel);
-  totalSubsteps = (totalSubsteps < 1) ? 1 : totalSubsteps;
-  // printf("totalSubsteps: %d\n", totalSubsteps);
-  totalSubsteps = (totalSubsteps > maxSubSteps) ? maxSubSteps : totalSubsteps;
-  const float dtSubdiv = dt / (float)totalSubsteps;
-
   // set boundaries of big velocity grid
   FLUID_3D::setZeroX(bigUx, _resBig, 0 , _resBig[2]); 
   FLUID_3D::setZeroY(bigUy, _resBig, 0 , _resBig[2]); 
@@ -1096,20 +1416,20 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 		int zEnd = (int)((float)(i+1)*partSize + 0.5f);
 #endif
 		FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-		    _densityBigOld, tempDensityBig, _resBig, zBegin, zEnd);
+		    _densityBigOld, tempDensityBig, _resBig, zBegin, zEnd, tiles);
 		if (_fuelBig) {
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_fuelBigOld, tempFuelBig, _resBig, zBegin, zEnd);
+				_fuelBigOld, tempFuelBig, _resBig, zBegin, zEnd, tiles);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_reactBigOld, tempReactBig, _resBig, zBegin, zEnd);
+				_reactBigOld, tempReactBig, _resBig, zBegin, zEnd, tiles);
 		}
 		if (_color_rBig) {
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_rBigOld, tempColor_rBig, _resBig, zBegin, zEnd);
+				_color_rBigOld, tempColor_rBig, _resBig, zBegin, zEnd, tiles);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_gBigOld, tempColor_gBig, _resBig, zBegin, zEnd);
+				_color_gBigOld, tempColor_gBig, _resBig, zBegin, zEnd, tiles);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_bBigOld, tempColor_bBig, _resBig, zBegin, zEnd);
+				_color_bBigOld, tempColor_bBig, _resBig, zBegin, zEnd, tiles);
 		}
 #if PARALLEL==1
 	}
@@ -1123,20 +1443,20 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 		int zEnd = (int)((float)(i+1)*partSize + 0.5f);
 #endif
 		FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-		    _densityBigOld, _densityBig, tempDensityBig, tempBig, _resBig, NULL, zBegin, zEnd);
+		    _densityBigOld, _densityBig, tempDensityBig, tempBig, _resBig, NULL, zBegin, zEnd, tiles);
 		if (_fuelBig) {
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_fuelBigOld, _fuelBig, tempFuelBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_fuelBigOld, _fuelBig, tempFuelBig, tempBig, _resBig, NULL, zBegin, zEnd, tiles);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_reactBigOld, _reactBig, tempReactBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_reactBigOld, _reactBig, tempReactBig, tempBig, _resBig, NULL, zBegin, zEnd, tiles);
 		}
 		if (_color_rBig) {
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_rBigOld, _color_rBig, tempColor_rBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_rBigOld, _color_rBig, tempColor_rBig, tempBig, _resBig, NULL, zBegin, zEnd, tiles);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_gBigOld, _color_gBig, tempColor_gBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_gBigOld, _color_gBig, tempColor_gBig, tempBig, _resBig, NULL, zBegin, zEnd, tiles);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_bBigOld, _color_bBig, tempColor_bBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_bBigOld, _color_bBig, tempColor_bBig, tempBig, _resBig, NULL, zBegin, zEnd, tiles);
 		}
 #if PARALLEL==1
 	}
@@ -1165,6 +1485,7 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
   free(bigUz);
   free(_energy);
   free(highFreqEnergy);
+  free(unwarped);
   
   // wipe the density borders
   FLUID_3D::setZeroBorder(_densityBig, _resBig, 0 , _resBig[2]);
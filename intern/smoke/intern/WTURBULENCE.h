@@ -25,6 +25,7 @@
 #ifndef WTURBULENCE_H
 #define WTURBULENCE_H
 
+#include "FLUID_3D.h"
 #include "VEC3.h"
 using namespace BasicVector;
 class SIMPLE_PARSER;
@@ -137,10 +138,22 @@ struct WTURBULENCE
 
 		// noise data
 		float* _noiseTile;
+		// largest difference of neighboring values in the noise tile
+		float _noiseTileMaxDiff;
 		//float* _noiseTileExt;
 
 		// step counter
 		int _totalStepsBig;
+
+		// tiles of the big grid which may hold density, the rest is skipped
+		ACTIVE_TILES _tiles;
+		void updateNoiseTileMaxDiff();
+		void markFilledTiles(unsigned char *filled);
+		void computeTileVelocityBounds(float *tileVelBound, const float *xvel, const float *yvel, const float *zvel,
+				const float *highFreqEnergy, const float *eigMin, const float *eigMax, const float *unwarped);
+		void updateActiveTiles(const unsigned char *filledTiles, const float *tileVelBound, float dt, int substeps);
+		float computeBigVelocity(const unsigned char *tiles, float* xvel, float* yvel, float* zvel, unsigned char *obstacles,
+				float *highFreqEnergy, float *eigMin, float *eigMax, float *unwarped, float *bigUx, float *bigUy, float *bigUz);
 		
 		void computeEigenvalues(float *_eigMin, float *_eigMax);
 		void decomposeEnergy(float *energy, float *_highFreqEnergy);
@@ -160,6 +160,9 @@ def point_cache_ui(self, context, cache, enabled, cachetype):
 
             col = split.column()
             col.prop(cache, "use_disk_cache")
+            sub = col.column()
+            sub.active = cache.use_disk_cache
+            sub.prop(cache, "use_single_file")
 
             col = split.column()
             col.active = cache.use_disk_cache
@@ -179,6 +182,11 @@ def point_cache_ui(self, context, cache, enabled, cachetype):
                 col = layout.column(align=True)
                 col.label(text="Linked object baking requires Disk Cache to be enabled", icon='INFO')
         else:
+            if cachetype in {'SMOKE', 'DYNAMIC_PAINT'}:
+                row = layout.row()
+                row.enabled = enabled and bpy.data.is_saved
+                row.prop(cache, "use_single_file")
+
             layout.separator()
 
         split = layout.split()
@@ -75,6 +75,9 @@ struct AlembicExportParams {
 	int quad_method;
 	int ngon_method;
 
+	/* Evaluate frames in parallel on copies of the scene, when possible. */
+	bool frame_parallel;
+
 	float global_scale;
 };
 
@@ -45,6 +45,8 @@ extern "C" {
 #include "DNA_scene_types.h"
 #include "DNA_space_types.h"  /* for FILE_MAX */
 
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
 #include "BLI_string.h"
 
 #ifdef WIN32
@@ -97,6 +99,7 @@ ExportSettings::ExportSettings()
     , quad_method(0)
     , ngon_method(0)
     , do_convert_axis(false)
+    , frame_parallel(false)
 {}
 
 static bool object_is_smoke_sim(Object *ob)
@@ -311,6 +314,13 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 
 	/* Export all frames. */
 
+	if (m_settings.frame_parallel &&
+	    exportFramesParallel(bmain, frames, xform_frames, shape_frames,
+	                         archive_bounds_prop, progress, was_canceled))
+	{
+		return;
+	}
+
 	std::set<double>::const_iterator begin = frames.begin();
 	std::set<double>::const_iterator end = frames.end();
 
@@ -330,31 +340,164 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 		/* 'frame' is offset by start frame, so need to cancel the offset. */
 		setCurrentFrame(bmain, frame);
 
-		if (shape_frames.count(frame) != 0) {
-			for (int i = 0, e = m_shapes.size(); i != e; ++i) {
-				m_shapes[i]->write();
-			}
-		}
+		writeFrame(frame, xform_frames, shape_frames, archive_bounds_prop);
+	}
+}
 
-		if (xform_frames.count(frame) == 0) {
-			continue;
+void AbcExporter::writeFrame(double frame,
+                             const std::set<double> &xform_frames,
+                             const std::set<double> &shape_frames,
+                             OBox3dProperty &archive_bounds_prop)
+{
+	if (shape_frames.count(frame) != 0) {
+		for (int i = 0, e = m_shapes.size(); i != e; ++i) {
+			m_shapes[i]->write();
 		}
+	}
+
+	if (xform_frames.count(frame) == 0) {
+		return;
+	}
+
+	m_xforms_type::iterator xit, xe;
+	for (xit = m_xforms.begin(), xe = m_xforms.end(); xit != xe; ++xit) {
+		xit->second->write();
+	}
+
+	/* Save the archive 's bounding box. */
+	Imath::Box3d bounds;
+
+	for (xit = m_xforms.begin(), xe = m_xforms.end(); xit != xe; ++xit) {
+		Imath::Box3d box = xit->second->bounds();
+		bounds.extendBy(box);
+	}
+
+	archive_bounds_prop.set(bounds);
+}
+
+/* ************************************************************************** */
+
+namespace {
+
+struct ParallelTarget {
+	AbcObjectWriter *writer;
+	Object *object;
+	/* Only used by transform writers of dupli-objects. */
+	Object *proxy_from;
+};
+
+struct ParallelExportData {
+	AbcExporter *exporter;
+	std::vector<ParallelTarget> targets;
+
+	const std::set<double> *xform_frames;
+	const std::set<double> *shape_frames;
+	OBox3dProperty *archive_bounds_prop;
+
+	float *progress;
+	bool *was_canceled;
+	float size;
+	size_t i;
+};
+
+}  /* namespace */
+
+/* Frames are evaluated on copies of the database, while the writers keep
+ * writing one frame after another from this thread. Returns false when the
+ * scene does not support it, frames are to be exported one by one then. */
+bool AbcExporter::exportFramesParallel(Main *bmain,
+                                       const std::set<double> &frames,
+                                       const std::set<double> &xform_frames,
+                                       const std::set<double> &shape_frames,
+                                       OBox3dProperty &archive_bounds_prop,
+                                       float &progress,
+                                       bool &was_canceled)
+{
+	ParallelExportData data;
+
+	if (frames.size() < 2) {
+		return false;
+	}
+
+	/* These writers hold on to data which is not remapped to the copies. */
+	for (int i = 0, e = m_shapes.size(); i != e; ++i) {
+		AbcObjectWriter *writer = m_shapes[i];
 
-		m_xforms_type::iterator xit, xe;
-		for (xit = m_xforms.begin(), xe = m_xforms.end(); xit != xe; ++xit) {
-			xit->second->write();
+		if (dynamic_cast<AbcMBallWriter *>(writer) ||
+		    dynamic_cast<AbcHairWriter *>(writer) ||
+		    dynamic_cast<AbcPointsWriter *>(writer))
+		{
+			return false;
 		}
 
-		/* Save the archive 's bounding box. */
-		Imath::Box3d bounds;
+		ParallelTarget target = {writer, writer->object(), NULL};
+		data.targets.push_back(target);
+	}
+
+	m_xforms_type::iterator xit, xe;
+	for (xit = m_xforms.begin(), xe = m_xforms.end(); xit != xe; ++xit) {
+		AbcTransformWriter *writer = xit->second;
+		ParallelTarget target = {writer, writer->object(), writer->m_proxy_from};
+		data.targets.push_back(target);
+	}
+
+	std::vector<double> frames_vec(frames.begin(), frames.end());
+
+	data.exporter = this;
+	data.xform_frames = &xform_frames;
+	data.shape_frames = &shape_frames;
+	data.archive_bounds_prop = &archive_bounds_prop;
+	data.progress = &progress;
+	data.was_canceled = &was_canceled;
+	data.size = static_cast<float>(frames.size());
+	data.i = 0;
+
+	const bool ok = BKE_scene_frames_evaluate_parallel(
+	                    bmain, m_scene, m_scene->lay,
+	                    &frames_vec[0], frames_vec.size(),
+	                    BKE_scene_num_threads(m_scene),
+	                    exportFrameParallel, &data);
+
+	/* Copies are freed by now, point the writers back to the originals. */
+	for (int i = 0, e = data.targets.size(); i != e; ++i) {
+		ParallelTarget &target = data.targets[i];
+		target.writer->retarget(m_scene, target.object);
 
-		for (xit = m_xforms.begin(), xe = m_xforms.end(); xit != xe; ++xit) {
-			Imath::Box3d box = xit->second->bounds();
-			bounds.extendBy(box);
+		if (target.proxy_from) {
+			static_cast<AbcTransformWriter *>(target.writer)->m_proxy_from = target.proxy_from;
 		}
+	}
+
+	return ok;
+}
 
-		archive_bounds_prop.set(bounds);
+bool AbcExporter::exportFrameParallel(void *userdata, Main * /*bmain*/, Scene *scene,
+                                      GHash *object_map, double frame)
+{
+	ParallelExportData *data = static_cast<ParallelExportData *>(userdata);
+
+	*data->progress = (++data->i / data->size);
+
+	if (G.is_break) {
+		*data->was_canceled = true;
+		return false;
 	}
+
+	for (int i = 0, e = data->targets.size(); i != e; ++i) {
+		ParallelTarget &target = data->targets[i];
+		Object *ob = static_cast<Object *>(BLI_ghash_lookup(object_map, target.object));
+		BLI_assert(ob != NULL);
+		target.writer->retarget(scene, ob);
+
+		if (target.proxy_from) {
+			static_cast<AbcTransformWriter *>(target.writer)->m_proxy_from =
+			        static_cast<Object *>(BLI_ghash_lookup(object_map, target.proxy_from));
+		}
+	}
+
+	data->exporter->writeFrame(frame, *data->xform_frames, *data->shape_frames,
+	                           *data->archive_bounds_prop);
+	return true;
 }
 
 void AbcExporter::createTransformWritersHierarchy(EvaluationContext *eval_ctx)
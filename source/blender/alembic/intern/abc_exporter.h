@@ -35,6 +35,7 @@ class AbcTransformWriter;
 class ArchiveWriter;
 
 struct EvaluationContext;
+struct GHash;
 struct Main;
 struct Object;
 struct Scene;
@@ -78,6 +79,9 @@ struct ExportSettings {
 
 	bool do_convert_axis;
 	float convert_matrix[3][3];
+
+	/* Evaluate frames in parallel on copies of the scene, when possible. */
+	bool frame_parallel;
 };
 
 class AbcExporter {
@@ -124,6 +128,21 @@ private:
 	AbcTransformWriter *getXForm(const std::string &name);
 
 	void setCurrentFrame(Main *bmain, double t);
+
+	void writeFrame(double frame,
+	                const std::set<double> &xform_frames,
+	                const std::set<double> &shape_frames,
+	                Alembic::Abc::OBox3dProperty &archive_bounds_prop);
+
+	bool exportFramesParallel(Main *bmain,
+	                          const std::set<double> &frames,
+	                          const std::set<double> &xform_frames,
+	                          const std::set<double> &shape_frames,
+	                          Alembic::Abc::OBox3dProperty &archive_bounds_prop,
+	                          float &progress,
+	                          bool &was_canceled);
+	static bool exportFrameParallel(void *userdata, Main *bmain, Scene *scene,
+	                                GHash *object_map, double frame);
 };
 
 #endif  /* __ABC_EXPORTER_H__ */
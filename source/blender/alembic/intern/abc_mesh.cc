@@ -34,6 +34,7 @@ extern "C" {
 #include "DNA_object_fluidsim_types.h"
 #include "DNA_object_types.h"
 
+#include "BLI_listbase.h"
 #include "BLI_math_geom.h"
 #include "BLI_string.h"
 
@@ -296,6 +297,7 @@ AbcMeshWriter::AbcMeshWriter(Scene *scene,
 {
 	m_is_animated = isAnimated();
 	m_subsurf_mod = NULL;
+	m_subsurf_mod_index = -1;
 	m_is_subd = false;
 
 	/* If the object is static, use the default static time sampling. */
@@ -305,6 +307,7 @@ AbcMeshWriter::AbcMeshWriter(Scene *scene,
 
 	if (!m_settings.apply_subdiv) {
 		m_subsurf_mod = get_subsurf_modifier(m_scene, m_object);
+		m_subsurf_mod_index = BLI_findindex(&m_object->modifiers, m_subsurf_mod);
 		m_is_subd = (m_subsurf_mod != NULL);
 	}
 
@@ -335,6 +338,18 @@ AbcMeshWriter::~AbcMeshWriter()
 	}
 }
 
+void AbcMeshWriter::retarget(Scene *scene, Object *ob)
+{
+	if (m_subsurf_mod) {
+		/* Modifier stack of the copy is the same as the one of the original,
+		 * the previous target may already be freed. */
+		m_subsurf_mod = static_cast<ModifierData *>(BLI_findlink(&ob->modifiers, m_subsurf_mod_index));
+		BLI_assert(m_subsurf_mod != NULL);
+	}
+
+	AbcObjectWriter::retarget(scene, ob);
+}
+
 bool AbcMeshWriter::isAnimated() const
 {
 	/* Check if object has shape keys. */
@@ -43,6 +43,8 @@ class AbcMeshWriter : public AbcObjectWriter {
 
 	bool m_is_animated;
 	ModifierData *m_subsurf_mod;
+	/* index of m_subsurf_mod in the modifier stack, to find it on copies of the object */
+	int m_subsurf_mod_index;
 
 	CDStreamConfig m_custom_data_config;
 
@@ -59,6 +61,8 @@ public:
 	~AbcMeshWriter();
 	void setIsAnimated(bool is_animated);
 
+	virtual void retarget(Scene *scene, Object *ob);
+
 private:
 	virtual void do_write();
 
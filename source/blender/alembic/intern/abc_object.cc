@@ -85,6 +85,16 @@ void AbcObjectWriter::addChild(AbcObjectWriter *child)
 	m_children.push_back(child);
 }
 
+void AbcObjectWriter::retarget(Scene *scene, Object *ob)
+{
+	m_object = ob;
+
+	/* Transform writers do not use the scene. */
+	if (m_scene) {
+		m_scene = scene;
+	}
+}
+
 Imath::Box3d AbcObjectWriter::bounds()
 {
 	BoundBox *bb = BKE_object_boundbox_get(this->m_object);
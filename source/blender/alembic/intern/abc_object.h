@@ -66,6 +66,12 @@ public:
 
 	void addChild(AbcObjectWriter *child);
 
+	Object *object() const { return m_object; }
+
+	/* Point the writer to the given object, which is a copy of the object it
+	 * was created for, living in the database of the given scene. */
+	virtual void retarget(Scene *scene, Object *ob);
+
 	virtual Imath::Box3d bounds();
 
 	void write();
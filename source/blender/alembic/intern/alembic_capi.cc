@@ -354,6 +354,7 @@ bool ABC_export(
 	job->settings.triangulate = params->triangulate;
 	job->settings.quad_method = params->quad_method;
 	job->settings.ngon_method = params->ngon_method;
+	job->settings.frame_parallel = params->frame_parallel;
 
 	if (job->settings.frame_start > job->settings.frame_end) {
 		std::swap(job->settings.frame_start, job->settings.frame_end);
@@ -50,12 +50,20 @@ typedef struct BoidBrainData {
 	float goal_nor[3];
 	float goal_priority;
 
+	/* Decisions of the brain that affect other boids or the state read by
+	 * them, applied once the brains of all boids are evaluated. */
+	struct BoidParticle *enemy;
+	float enemy_damage;
+	float jump_vel[3];
+	bool jump;
+
 	struct RNG *rng;
 } BoidBrainData;
 
 void boids_precalc_rules(struct ParticleSettings *part, float cfra);
 void boid_brain(BoidBrainData *bbd, int p, struct ParticleData *pa);
 void boid_body(BoidBrainData *bbd, struct ParticleData *pa);
+void boid_apply_damage(BoidBrainData *bbd);
 void boid_default_settings(BoidSettings *boids);
 BoidRule *boid_new_rule(int type);
 BoidState *boid_new_state(BoidSettings *boids);
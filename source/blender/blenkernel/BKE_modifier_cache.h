@@ -0,0 +1,63 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BKE_MODIFIER_CACHE_H__
+#define __BKE_MODIFIER_CACHE_H__
+
+/** \file BKE_modifier_cache.h
+ *  \ingroup bke
+ *  \section aboutmodifiercache Modifier result cache
+ *   Results of constructive modifiers, keyed by the modifier, its settings and
+ *   a hash of its input mesh. Memory is limited by the memory cache limit from
+ *   the user preferences, least recently used results are freed first.
+ */
+
+#include "BLI_sys_types.h"
+
+#include "BKE_modifier.h"
+
+struct DerivedMesh;
+struct ModifierData;
+struct Object;
+
+typedef struct ModifierCacheKey {
+	struct ModifierData *md;
+	ModifierApplyFlag flag;
+	/* Two hashes of the input and settings, calculated with different seeds. */
+	uint32_t hash[2];
+	int totvert, totedge, totloop, totpoly;
+} ModifierCacheKey;
+
+bool BKE_modifier_cache_key(
+        struct ModifierData *md, struct Object *ob, struct DerivedMesh *dm,
+        ModifierApplyFlag flag, ModifierCacheKey *r_key);
+
+struct DerivedMesh *BKE_modifier_cache_get(const ModifierCacheKey *key);
+void BKE_modifier_cache_put(const ModifierCacheKey *key, struct DerivedMesh *dm);
+
+void BKE_modifier_cache_free_modifier(const struct ModifierData *md);
+void BKE_modifier_cache_free(void);
+
+void BKE_modifier_cache_stats(size_t *r_mem_in_use, unsigned int *r_hits, unsigned int *r_misses);
+
+#endif  /* __BKE_MODIFIER_CACHE_H__ */
@@ -58,7 +58,9 @@ struct MVert;
 struct LatticeDeformData;
 struct LinkNode;
 struct KDTree;
+struct ParticleSpatialHash;
 struct RNG;
+struct BVHTree;
 struct BVHTreeRay;
 struct BVHTreeRayHit; 
 struct EdgeHash;
@@ -101,6 +103,11 @@ typedef struct SPHData {
 	float element_size;
 	float flow[3];
 
+	/* Springs created while forces are evaluated in parallel, they are added
+	 * to the particle system afterwards, sorted by particle index. */
+	struct ParticleSpring *new_springs;
+	int tot_new_springs, alloc_new_springs;
+
 	/* Integrator callbacks. This allows different SPH implementations. */
 	void (*force_cb) (void *sphdata_v, ParticleKey *state, float *force, float *impulse);
 	void (*density_cb) (void *rangedata_v, int index, const float co[3], float squared_dist);
@@ -376,6 +383,7 @@ void psys_apply_hair_lattice(struct Scene *scene, struct Object *ob, struct Part
 struct ParticleSystem *psys_get_target_system(struct Object *ob, struct ParticleTarget *pt);
 void psys_count_keyed_targets(struct ParticleSimulationData *sim);
 void psys_update_particle_tree(struct ParticleSystem *psys, float cfra);
+void psys_spatial_hash_free(struct ParticleSpatialHash *hash);
 void psys_changed_type(struct Object *ob, struct ParticleSystem *psys);
 
 void psys_make_temp_pointcache(struct Object *ob, struct ParticleSystem *psys);
@@ -53,6 +53,7 @@
 
 /* Add the blendfile name after blendcache_ */
 #define PTCACHE_EXT ".bphys"
+#define PTCACHE_CONTAINER_EXT ".bpack"
 #define PTCACHE_PATH "blendcache_"
 
 /* File open options, for BKE_ptcache_file_open */
@@ -111,6 +112,15 @@ typedef struct PTCacheData {
 
 typedef struct PTCacheFile {
 	FILE *fp;
+	/* Frame file written by the background writer, used instead of fp. */
+	struct PTCacheWriteJob *write_job;
+	/* Frame read from a single file cache, used instead of fp. */
+	const unsigned char *mem;
+	size_t mem_size, mem_pos;
+	/* Frame data owned by the file, when the cache file is not memory mapped. */
+	void *mem_alloc;
+	/* Memory map of the cache file the frame is read from. */
+	struct PTCacheContainerMap *mem_map;
 
 	int frame, old_format;
 	unsigned int totpoint, type;
@@ -194,6 +204,9 @@ typedef struct PTCacheBaker {
 
 	void (*update_progress)(void *data, float progress, int *cancel);
 	void *bake_job;
+
+	/* Set by the bake, frames which could not be written to disk. */
+	int failed_frames;
 } PTCacheBaker;
 
 /* PTCacheEditKey->flag */
@@ -309,6 +322,12 @@ int     BKE_ptcache_read(PTCacheID *pid, float cfra, bool no_extrapolate_old);
 /* Main cache writing call. */
 int     BKE_ptcache_write(PTCacheID *pid, unsigned int cfra);
 
+/* Wait for disk cache frames which are written in the background. */
+int     BKE_ptcache_write_flush(void);
+
+/* Write pending frames and close single file caches, on exit. */
+void    BKE_ptcache_exit(void);
+
 /******************* Allocate & free ***************/
 struct PointCache *BKE_ptcache_add(struct ListBase *ptcaches);
 void BKE_ptcache_free_mem(struct ListBase *mem_cache);
@@ -333,6 +352,9 @@ void BKE_ptcache_mem_to_disk(struct PTCacheID *pid);
 /* Convert disk cache to memory cache and vice versa. Clears the cache that was converted. */
 void BKE_ptcache_toggle_disk_cache(struct PTCacheID *pid);
 
+/* Convert between single file and per frame files after PTCACHE_SINGLE_FILE changed. */
+void BKE_ptcache_toggle_single_file(struct PTCacheID *pid);
+
 /* Rename all disk cache files with a new name. Doesn't touch the actual content of the files. */
 void BKE_ptcache_disk_cache_rename(struct PTCacheID *pid, const char *name_src, const char *name_dst);
 
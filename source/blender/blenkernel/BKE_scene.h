@@ -39,7 +39,9 @@ extern "C" {
 
 struct AviCodecData;
 struct Base;
+struct DEGEvalTarget;
 struct EvaluationContext;
+struct GHash;
 struct Main;
 struct Object;
 struct RenderData;
@@ -122,6 +124,19 @@ void  BKE_scene_frame_set(struct Scene *scene, double cfra);
 void BKE_scene_update_tagged(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce);
 void BKE_scene_update_for_newframe(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce, unsigned int lay);
 void BKE_scene_update_for_newframe_ex(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce, unsigned int lay, bool do_invisible_flush);
+void BKE_scene_update_for_newframe_isolated(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce, unsigned int lay);
+void BKE_scene_update_targets_for_newframe(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce, unsigned int lay,
+                                           const struct DEGEvalTarget *targets, int num_targets);
+
+/* Frame-parallel evaluation (scene_frames.c) */
+typedef bool (*SceneFramesEvalFunc)(void *userdata, struct Main *bmain, struct Scene *scene,
+                                    struct GHash *object_map, double frame);
+
+bool BKE_scene_frames_parallel_check(struct Main *bmain, struct Scene *scene);
+bool BKE_scene_frames_evaluate_parallel(
+        struct Main *bmain, struct Scene *scene, unsigned int lay,
+        const double *frames, int num_frames, int num_threads,
+        SceneFramesEvalFunc frame_func, void *userdata);
 
 struct SceneRenderLayer *BKE_scene_add_render_layer(struct Scene *sce, const char *name);
 bool BKE_scene_remove_render_layer(struct Main *main, struct Scene *scene, struct SceneRenderLayer *srl);
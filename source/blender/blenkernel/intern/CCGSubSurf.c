@@ -75,6 +75,9 @@ static CCGVert *_vert_new(CCGVertHDL vHDL, CCGSubSurf *ss)
 	v->faces = NULL;
 	v->numEdges = v->numFaces = 0;
 	v->flags = 0;
+#ifdef WITH_OPENSUBDIV
+	ss->osd_evaluator_invalid = true;
+#endif
 
 	userData = ccgSubSurf_getVertUserData(ss, v);
 	memset(userData, 0, ss->meshIFC.vertUserSize);
@@ -157,6 +160,9 @@ static CCGEdge *_edge_new(CCGEdgeHDL eHDL, CCGVert *v0, CCGVert *v1, float creas
 	e->numFaces = 0;
 	e->flags = 0;
 	_vert_addEdge(v0, e, ss);
+#ifdef WITH_OPENSUBDIV
+	ss->osd_evaluator_invalid = true;
+#endif
 	_vert_addEdge(v1, e, ss);
 
 	userData = ccgSubSurf_getEdgeUserData(ss, e);
@@ -205,6 +211,9 @@ static void _edge_unlinkMarkAndFree(CCGEdge *e, CCGSubSurf *ss)
 	_vert_remEdge(e->v1, e);
 	e->v0->flags |= Vert_eEffected;
 	e->v1->flags |= Vert_eEffected;
+#ifdef WITH_OPENSUBDIV
+	ss->osd_evaluator_invalid = true;
+#endif
 	_edge_free(e, ss);
 }
 
@@ -225,6 +234,9 @@ static CCGFace *_face_new(CCGFaceHDL fHDL, CCGVert **verts, CCGEdge **edges, int
 	f->numVerts = numVerts;
 	f->fHDL = fHDL;
 	f->flags = 0;
+#ifdef WITH_OPENSUBDIV
+	ss->osd_evaluator_invalid = true;
+#endif
 
 	for (i = 0; i < numVerts; i++) {
 		FACE_getVerts(f)[i] = verts[i];
@@ -251,6 +263,9 @@ static void _face_unlinkMarkAndFree(CCGFace *f, CCGSubSurf *ss)
 		_edge_remFace(FACE_getEdges(f)[j], f);
 		FACE_getVerts(f)[j]->flags |= Vert_eEffected;
 	}
+#ifdef WITH_OPENSUBDIV
+	ss->osd_evaluator_invalid = true;
+#endif
 	_face_free(f, ss);
 }
 
@@ -305,7 +320,9 @@ CCGSubSurf *ccgSubSurf_new(CCGMeshIFC *ifc, int subdivLevels, CCGAllocatorIFC *a
 		ss->tempEdges = NULL;
 
 #ifdef WITH_OPENSUBDIV
+		ss->osd_cpu_grids = false;
 		ss->osd_evaluator = NULL;
+		ss->osd_evaluator_invalid = false;
 		ss->osd_mesh = NULL;
 		ss->osd_topology_refiner = NULL;
 		ss->osd_mesh_invalid = false;
@@ -397,25 +414,43 @@ void ccgSubSurf_getAllowEdgeCreation(CCGSubSurf *ss, int *allowEdgeCreation_r, f
 	}
 }
 
+static void ccgSubSurf__freeElements(CCGSubSurf *ss)
+{
+	ss->numGrids = 0;
+	ccg_ehash_free(ss->vMap, (EHEntryFreeFP) _vert_free, ss);
+	ccg_ehash_free(ss->eMap, (EHEntryFreeFP) _edge_free, ss);
+	ccg_ehash_free(ss->fMap, (EHEntryFreeFP) _face_free, ss);
+	ss->vMap = ccg_ehash_new(0, &ss->allocatorIFC, ss->allocator);
+	ss->eMap = ccg_ehash_new(0, &ss->allocatorIFC, ss->allocator);
+	ss->fMap = ccg_ehash_new(0, &ss->allocatorIFC, ss->allocator);
+}
+
 CCGError ccgSubSurf_setSubdivisionLevels(CCGSubSurf *ss, int subdivisionLevels)
 {
 	if (subdivisionLevels <= 0) {
 		return eCCGError_InvalidValue;
 	}
 	else if (subdivisionLevels != ss->subdivLevels) {
-		ss->numGrids = 0;
 		ss->subdivLevels = subdivisionLevels;
-		ccg_ehash_free(ss->vMap, (EHEntryFreeFP) _vert_free, ss);
-		ccg_ehash_free(ss->eMap, (EHEntryFreeFP) _edge_free, ss);
-		ccg_ehash_free(ss->fMap, (EHEntryFreeFP) _face_free, ss);
-		ss->vMap = ccg_ehash_new(0, &ss->allocatorIFC, ss->allocator);
-		ss->eMap = ccg_ehash_new(0, &ss->allocatorIFC, ss->allocator);
-		ss->fMap = ccg_ehash_new(0, &ss->allocatorIFC, ss->allocator);
+		ccgSubSurf__freeElements(ss);
 	}
 
 	return eCCGError_None;
 }
 
+#ifdef WITH_OPENSUBDIV
+void ccgSubSurf_setUseOpenSubdivGrids(CCGSubSurf *ss, bool use_osd_grids)
+{
+	if (ss->osd_cpu_grids != use_osd_grids) {
+		ss->osd_cpu_grids = use_osd_grids;
+		/* Both code paths only update what changed since the previous sync,
+		 * start from scratch so grids of the other one are not re-used.
+		 */
+		ccgSubSurf__freeElements(ss);
+	}
+}
+#endif
+
 void ccgSubSurf_getUseAgeCounts(CCGSubSurf *ss, int *useAgeCounts_r, int *vertUserOffset_r, int *edgeUserOffset_r, int *faceUserOffset_r)
 {
 	*useAgeCounts_r = ss->useAgeCounts;
@@ -539,6 +574,9 @@ CCGError ccgSubSurf_syncVertDel(CCGSubSurf *ss, CCGVertHDL vHDL)
 		else {
 			*prevp = v->next;
 			_vert_free(v, ss);
+#ifdef WITH_OPENSUBDIV
+			ss->osd_evaluator_invalid = true;
+#endif
 		}
 	}
 
@@ -850,7 +888,7 @@ CCGError ccgSubSurf_syncFace(CCGSubSurf *ss, CCGFaceHDL fHDL, int numVerts, CCGV
 static void ccgSubSurf__sync(CCGSubSurf *ss)
 {
 #ifdef WITH_OPENSUBDIV
-	if (ss->skip_grids) {
+	if (ss->skip_grids || ss->osd_cpu_grids) {
 		ccgSubSurf__sync_opensubdiv(ss);
 	}
 	else
@@ -868,6 +906,12 @@ CCGError ccgSubSurf_processSync(CCGSubSurf *ss)
 		ccgSubSurf__sync(ss);
 	}
 	else if (ss->syncState) {
+#ifdef WITH_OPENSUBDIV
+		/* Loose vertices which are gone change indices of the evaluator. */
+		if (ss->oldVMap->numEntries != 0) {
+			ss->osd_evaluator_invalid = true;
+		}
+#endif
 		ccg_ehash_free(ss->oldFMap, (EHEntryFreeFP) _face_unlinkMarkAndFree, ss);
 		ccg_ehash_free(ss->oldEMap, (EHEntryFreeFP) _edge_unlinkMarkAndFree, ss);
 		ccg_ehash_free(ss->oldVMap, (EHEntryFreeFP) _vert_free, ss);
@@ -230,6 +230,12 @@ int ccgSubSurf_getNumGLMeshBaseFaceVerts(CCGSubSurf *ss, int face);
 void ccgSubSurf_setSkipGrids(CCGSubSurf *ss, bool skip_grids);
 bool ccgSubSurf_needGrids(CCGSubSurf *ss);
 
+/* Controls whether CCG grids are evaluated by OpenSubdiv's CPU limit
+ * evaluator. Topology refiner of the evaluator is kept until topology
+ * changes, so only stencils are evaluated when just coordinates change.
+ */
+void ccgSubSurf_setUseOpenSubdivGrids(CCGSubSurf *ss, bool use_osd_grids);
+
 /* Set evaluator's face varying data from UV coordinates.
  * Used for CPU evaluation.
  */
@@ -248,8 +248,17 @@ struct CCGSubSurf {
 
 	/* ** CPU backend. ** */
 
+	/* Evaluate grids with the limit evaluator instead of the legacy
+	 * subdivision code. Only supported together with full synchronization.
+	 */
+	bool osd_cpu_grids;
 	/* Limit evaluator, used to evaluate CCG. */
 	struct OpenSubdiv_EvaluatorDescr *osd_evaluator;
+	/* Denotes whether topology changed since the evaluator was created.
+	 * Evaluator (and topology refiner it owns) is kept across syncs
+	 * otherwise, so only coarse positions are to be updated.
+	 */
+	bool osd_evaluator_invalid;
 	/* Next PTex face index, used while CCG synchronization
 	 * to fill in PTex index of CCGFace.
 	 */
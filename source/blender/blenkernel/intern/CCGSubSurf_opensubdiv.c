@@ -30,6 +30,7 @@
 #include "BLI_utildefines.h" /* for BLI_assert */
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "CCGSubSurf.h"
@@ -534,9 +535,8 @@ static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
 	int edgeSize = ccg_edgesize(subdivLevels);
 	int vertDataSize = ss->meshIFC.vertDataSize;
 	int S;
-	bool do_normals = ss->meshIFC.numLayers == 3;
+	bool do_normals = ss->calcVertNormals;
 
-#pragma omp parallel for
 	for (S = 0; S < face->numVerts; S++) {
 		int x, y, k;
 		CCGEdge *edge = NULL;
@@ -569,7 +569,13 @@ static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
 					normalize_v3(no);
 				}
 
-				if (x == gridSize - 1 && y == gridSize - 1) {
+				/* Vertices and edges are shared with other faces, which
+				 * might be evaluated from other threads, only the first
+				 * face of them writes their data.
+				 */
+				if (x == gridSize - 1 && y == gridSize - 1 &&
+				    FACE_getVerts(face)[S]->faces[0] == face)
+				{
 					float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
 					VertDataCopy(vert_co, co, ss);
 					if (do_normals) {
@@ -618,6 +624,10 @@ static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
 
 		BLI_assert(edge != NULL);
 
+		if (edge->faces[0] != face) {
+			continue;
+		}
+
 		for (x = 0; x < edgeSize; x++) {
 			float u = 0, v = 0;
 			float *co = EDGE_getCo(edge, subdivLevels, x);
@@ -653,7 +663,7 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 	int edgeSize = ccg_edgesize(subdivLevels);
 	int vertDataSize = ss->meshIFC.vertDataSize;
 	int S;
-	bool do_normals = ss->meshIFC.numLayers == 3;
+	bool do_normals = ss->calcVertNormals;
 
 	/* Note about handling non-quad faces.
 	 *
@@ -684,7 +694,6 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 	 */
 
 	/* Evaluate face grids. */
-#pragma omp parallel for
 	for (S = 0; S < face->numVerts; S++) {
 		int x, y;
 		for (x = 0; x < gridSize; x++) {
@@ -708,7 +717,9 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 				}
 
 				/* TODO(sergey): De-dpuplicate with the quad case. */
-				if (x == gridSize - 1 && y == gridSize - 1) {
+				if (x == gridSize - 1 && y == gridSize - 1 &&
+				    FACE_getVerts(face)[S]->faces[0] == face)
+				{
 					float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
 					VertDataCopy(vert_co, co, ss);
 					if (do_normals) {
@@ -742,6 +753,10 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 		int x, S0, S1;
 		bool flip;
 
+		if (edge->faces[0] != face) {
+			continue;
+		}
+
 		for (x = 0; x < face->numVerts; ++x) {
 			if (all_verts[x] == edge->v0) {
 				S0 = x;
@@ -796,26 +811,84 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 	}
 }
 
+typedef struct OpenSubdivEvaluateGridsData {
+	CCGSubSurf *ss;
+	CCGFace **faces;
+} OpenSubdivEvaluateGridsData;
+
+static void opensubdiv_evaluateGrids_cb(void *__restrict userdata,
+                                        const int face_index,
+                                        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	OpenSubdivEvaluateGridsData *data = userdata;
+	CCGFace *face = data->faces[face_index];
+	if (face->numVerts == 4) {
+		/* For quads we do special magic with converting face coords
+		 * into corner coords and interpolating grids from it.
+		 */
+		opensubdiv_evaluateQuadFaceGrids(data->ss, face, face->osd_index);
+	}
+	else {
+		/* NGons and tris are split into separate osd faces which
+		 * evaluates onto grids directly.
+		 */
+		opensubdiv_evaluateNGonFaceGrids(data->ss, face, face->osd_index);
+	}
+}
+
 static void opensubdiv_evaluateGrids(CCGSubSurf *ss)
 {
+	OpenSubdivEvaluateGridsData data;
+	CCGFace **faces = NULL;
+	int num_faces, free_faces;
+	ParallelRangeSettings settings;
+
+	ccgSubSurf__allFaces(ss, &faces, &num_faces, &free_faces);
+
+	data.ss = ss;
+	data.faces = faces;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = CCG_TASK_LIMIT;
+	BLI_task_parallel_range(0, num_faces,
+	                        &data,
+	                        opensubdiv_evaluateGrids_cb,
+	                        &settings);
+
+	if (free_faces) {
+		MEM_freeN(faces);
+	}
+}
+
+/* Check whether any of the coarse vertices moved since the last sync and
+ * clear the flags set by the synchronization.
+ */
+static bool opensubdiv_clearEffectedFlags(CCGSubSurf *ss)
+{
+	bool has_effected = false;
 	int i;
-	for (i = 0; i < ss->fMap->curSize; i++) {
-		CCGFace *face = (CCGFace *) ss->fMap->buckets[i];
-		for (; face; face = face->next) {
-			if (face->numVerts == 4) {
-				/* For quads we do special magic with converting face coords
-				 * into corner coords and interpolating grids from it.
-				 */
-				opensubdiv_evaluateQuadFaceGrids(ss, face, face->osd_index);
-			}
-			else {
-				/* NGons and tris are split into separate osd faces which
-				 * evaluates onto grids directly.
-				 */
-				opensubdiv_evaluateNGonFaceGrids(ss, face, face->osd_index);
+	for (i = 0; i < ss->vMap->curSize; i++) {
+		CCGVert *v = (CCGVert *) ss->vMap->buckets[i];
+		for (; v; v = v->next) {
+			if (v->flags & Vert_eEffected) {
+				has_effected = true;
 			}
+			v->flags = 0;
+		}
+	}
+	for (i = 0; i < ss->eMap->curSize; i++) {
+		CCGEdge *e = (CCGEdge *) ss->eMap->buckets[i];
+		for (; e; e = e->next) {
+			e->flags = 0;
+		}
+	}
+	for (i = 0; i < ss->fMap->curSize; i++) {
+		CCGFace *f = (CCGFace *) ss->fMap->buckets[i];
+		for (; f; f = f->next) {
+			f->flags = 0;
 		}
 	}
+	return has_effected;
 }
 
 CCGError ccgSubSurf_initOpenSubdivSync(CCGSubSurf *ss)
@@ -882,13 +955,28 @@ void ccgSubSurf__sync_opensubdiv(CCGSubSurf *ss)
 	ss->osd_compute = U.opensubdiv_compute_type;
 
 	if (ss->skip_grids == false) {
-		/* Make sure OSD evaluator is up-to-date. */
-		if (opensubdiv_ensureEvaluator(ss)) {
-			/* Update coarse points in the OpenSubdiv evaluator. */
-			opensubdiv_updateEvaluatorCoarsePositions(ss);
+		const bool topology_changed = ss->osd_evaluator_invalid;
+		const bool coords_changed = opensubdiv_clearEffectedFlags(ss);
 
-			/* Evaluate opensubdiv mesh into the CCG grids. */
-			opensubdiv_evaluateGrids(ss);
+		/* Topology refiner and stencils are only re-created when topology
+		 * changed, otherwise evaluator is re-used with new coarse positions.
+		 */
+		if (topology_changed && ss->osd_evaluator != NULL) {
+			openSubdiv_deleteEvaluatorDescr(ss->osd_evaluator);
+			ss->osd_evaluator = NULL;
+		}
+		ss->osd_evaluator_invalid = false;
+
+		/* Grids are still valid from the previous sync otherwise. */
+		if (topology_changed || coords_changed || ss->osd_evaluator == NULL) {
+			/* Make sure OSD evaluator is up-to-date. */
+			if (opensubdiv_ensureEvaluator(ss)) {
+				/* Update coarse points in the OpenSubdiv evaluator. */
+				opensubdiv_updateEvaluatorCoarsePositions(ss);
+
+				/* Evaluate opensubdiv mesh into the CCG grids. */
+				opensubdiv_evaluateGrids(ss);
+			}
 		}
 	}
 	else {
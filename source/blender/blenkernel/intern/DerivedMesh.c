@@ -58,6 +58,7 @@
 #include "BKE_library.h"
 #include "BKE_material.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_mapping.h"
 #include "BKE_object.h"
@@ -1744,6 +1745,29 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 	}
 }
 
+/* Apply a constructive modifier, reusing the cached result when its input
+ * did not change since it was last evaluated. */
+static DerivedMesh *mesh_apply_modifier_cached(
+        ModifierData *md, Object *ob, DerivedMesh *dm,
+        ModifierApplyFlag flag, const bool use_result_cache)
+{
+	ModifierCacheKey key;
+	DerivedMesh *ndm;
+
+	if (!use_result_cache || !BKE_modifier_cache_key(md, ob, dm, flag, &key)) {
+		return modwrap_applyModifier(md, ob, dm, flag);
+	}
+
+	ndm = BKE_modifier_cache_get(&key);
+	if (ndm == NULL) {
+		ndm = modwrap_applyModifier(md, ob, dm, flag);
+		if (ndm && ndm != dm) {
+			BKE_modifier_cache_put(&key, ndm);
+		}
+	}
+	return ndm;
+}
+
 /**
  * new value for useDeform -1  (hack for the gameengine):
  *
@@ -1791,6 +1815,10 @@ static void mesh_calc_modifiers(
 	const bool do_loop_normals = (me->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = me->smoothresh;
 
+	/* Reuse results of modifiers whose input and settings did not change.
+	 * Sculpt mode needs the original DerivedMesh types of multires and subsurf. */
+	const bool use_result_cache = useCache && !useRenderParams && !sculpt_mode;
+
 	VirtualModifierData virtualModifierData;
 
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
@@ -2079,7 +2107,7 @@ static void mesh_calc_modifiers(
 				}
 			}
 
-			ndm = modwrap_applyModifier(md, ob, dm, app_flags);
+			ndm = mesh_apply_modifier_cached(md, ob, dm, app_flags, use_result_cache);
 			ASSERT_IS_VALID_DM(ndm);
 
 			if (ndm) {
@@ -2106,7 +2134,8 @@ static void mesh_calc_modifiers(
 				                 (mti->requiredDataMask ?
 				                  mti->requiredDataMask(ob, md) : 0));
 
-				ndm = modwrap_applyModifier(md, ob, orcodm, (app_flags & ~MOD_APPLY_USECACHE) | MOD_APPLY_ORCO);
+				ndm = mesh_apply_modifier_cached(
+				        md, ob, orcodm, (app_flags & ~MOD_APPLY_USECACHE) | MOD_APPLY_ORCO, use_result_cache);
 				ASSERT_IS_VALID_DM(ndm);
 
 				if (ndm) {
@@ -2124,7 +2153,8 @@ static void mesh_calc_modifiers(
 				nextmask &= ~CD_MASK_CLOTH_ORCO;
 				DM_set_only_copy(clothorcodm, nextmask | CD_MASK_ORIGINDEX);
 
-				ndm = modwrap_applyModifier(md, ob, clothorcodm, (app_flags & ~MOD_APPLY_USECACHE) | MOD_APPLY_ORCO);
+				ndm = mesh_apply_modifier_cached(
+				        md, ob, clothorcodm, (app_flags & ~MOD_APPLY_USECACHE) | MOD_APPLY_ORCO, use_result_cache);
 				ASSERT_IS_VALID_DM(ndm);
 
 				if (ndm) {
@@ -54,6 +54,9 @@
 #include "BKE_anim.h"
 #include "BKE_report.h"
 
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
 // XXX bad level call...
 
 /* --------------------- */
@@ -311,8 +314,10 @@ static void motionpaths_calc_optimise_depsgraph(Scene *scene, ListBase *targets)
 	DAG_scene_relations_rebuild(G.main, scene);
 }
 
-/* update scene for current frame */
-static void motionpaths_calc_update_scene(Scene *scene)
+/* update scene for current frame
+ * - deg_targets: objects and poses the paths are baked from, NULL to update everything
+ */
+static void motionpaths_calc_update_scene(Scene *scene, const DEGEvalTarget *deg_targets, int num_deg_targets)
 {
 #if 1 // 'production' optimizations always on
 	/* rigid body simulation needs complete update to work correctly for now */
@@ -320,6 +325,16 @@ static void motionpaths_calc_update_scene(Scene *scene)
 	if (BKE_scene_check_rigidbody_active(scene)) {
 		BKE_scene_update_for_newframe(G.main->eval_ctx, G.main, scene, scene->lay);
 	}
+	else if (!DEG_depsgraph_use_legacy()) {
+		/* the new depsgraph evaluates exactly what the targets depend on */
+		if (deg_targets) {
+			BKE_scene_update_targets_for_newframe(G.main->eval_ctx, G.main, scene, scene->lay,
+			                                      deg_targets, num_deg_targets);
+		}
+		else {
+			BKE_scene_update_for_newframe(G.main->eval_ctx, G.main, scene, scene->lay);
+		}
+	}
 	else { /* otherwise we can optimize by restricting updates */
 		Base *base, *last = NULL;
 		
@@ -348,6 +363,7 @@ static void motionpaths_calc_update_scene(Scene *scene)
 		}
 	}
 #else // original, 'always correct' version
+	UNUSED_VARS(deg_targets, num_deg_targets);
 	/* do all updates
 	 *  - if this is too slow, resort to using a more efficient way
 	 *    that doesn't force complete update, but for now, this is the
@@ -407,6 +423,8 @@ static void motionpaths_calc_bake_targets(Scene *scene, ListBase *targets)
 void animviz_calc_motionpaths(Scene *scene, ListBase *targets)
 {
 	MPathTarget *mpt;
+	DEGEvalTarget *deg_targets;
+	int num_deg_targets;
 	int sfra, efra;
 	int cfra;
 	
@@ -432,18 +450,28 @@ void animviz_calc_motionpaths(Scene *scene, ListBase *targets)
 	/* TODO: whether this is used should depend on some setting for the level of optimizations used */
 	motionpaths_calc_optimise_depsgraph(scene, targets);
 	
+	/* bone paths need the pose, object paths the object transform */
+	num_deg_targets = BLI_listbase_count(targets);
+	deg_targets = MEM_mallocN(sizeof(DEGEvalTarget) * num_deg_targets, "motionpaths deg targets");
+	for (mpt = targets->first, num_deg_targets = 0; mpt; mpt = mpt->next, num_deg_targets++) {
+		deg_targets[num_deg_targets].id = &mpt->ob->id;
+		deg_targets[num_deg_targets].component = (mpt->pchan) ? DEG_OB_COMP_EVAL_POSE : DEG_OB_COMP_TRANSFORM;
+	}
+	
 	/* calculate path over requested range */
 	for (CFRA = sfra; CFRA <= efra; CFRA++) {
 		/* update relevant data for new frame */
-		motionpaths_calc_update_scene(scene);
+		motionpaths_calc_update_scene(scene, deg_targets, num_deg_targets);
 		
 		/* perform baking for targets */
 		motionpaths_calc_bake_targets(scene, targets);
 	}
 	
-	/* reset original environment */
+	MEM_freeN(deg_targets);
+	
+	/* reset original environment, everything is updated again */
 	CFRA = cfra;
-	motionpaths_calc_update_scene(scene);
+	motionpaths_calc_update_scene(scene, NULL, 0);
 	
 	/* clear recalc flags from targets */
 	for (mpt = targets->first; mpt; mpt = mpt->next) {
@@ -973,6 +973,187 @@ static void armature_bbone_defmats_cb(void *userdata, Link *iter, int index)
 	}
 }
 
+typedef struct ArmatureVertDeformData {
+	bPoseChanDeform *pdef_info_array;
+	ListBase *chanbase;
+	/* Deform group index -> pose channel, NULL for groups without a deforming bone. */
+	bPoseChannel **defnr_to_pchan;
+	bPoseChanDeform **defnr_to_pdef_info;
+	int defbase_tot;
+
+	/* Deform verts from the derived mesh or the original data, only one of them is set. */
+	MDeformVert *dm_dverts;
+	MDeformVert *dverts;
+	int target_totvert;
+
+	float (*vertexCos)[3];
+	float (*defMats)[3][3];
+	float (*prevCos)[3];
+	float premat[4][4];
+	float postmat[4][4];
+
+	int armature_def_nr;
+	bool use_envelope;
+	bool use_quaternion;
+	bool use_dverts;
+	bool invert_vgroup;
+} ArmatureVertDeformData;
+
+static void armature_vert_deform_envelope(
+        const ArmatureVertDeformData *data, float vec[3], DualQuat *dq, float mat[3][3], const float co[3],
+        float *contrib)
+{
+	bPoseChanDeform *pdef_info = data->pdef_info_array;
+	bPoseChannel *pchan;
+
+	for (pchan = data->chanbase->first; pchan; pchan = pchan->next, pdef_info++) {
+		if (!(pchan->bone->flag & BONE_NO_DEFORM))
+			*contrib += dist_bone_deform(pchan, pdef_info, vec, dq, mat, co);
+	}
+}
+
+static void armature_vert_deform_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ArmatureVertDeformData *data = userdata;
+	float (*vertexCos)[3] = data->vertexCos;
+	float (*defMats)[3][3] = data->defMats;
+	float (*prevCos)[3] = data->prevCos;
+	const bool use_quaternion = data->use_quaternion;
+	MDeformVert *dvert;
+	DualQuat sumdq, *dq = NULL;
+	float *co, dco[3];
+	float sumvec[3], summat[3][3];
+	float *vec = NULL, (*smat)[3] = NULL;
+	float contrib = 0.0f;
+	float armature_weight = 1.0f; /* default to 1 if no overall def group */
+	float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
+
+	if (use_quaternion) {
+		memset(&sumdq, 0, sizeof(DualQuat));
+		dq = &sumdq;
+	}
+	else {
+		sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+		vec = sumvec;
+
+		if (defMats) {
+			zero_m3(summat);
+			smat = summat;
+		}
+	}
+
+	if (data->dm_dverts)
+		dvert = data->dm_dverts + i;
+	else if (data->dverts && i < data->target_totvert)
+		dvert = data->dverts + i;
+	else
+		dvert = NULL;
+
+	if (data->armature_def_nr != -1 && dvert) {
+		armature_weight = defvert_find_weight(dvert, data->armature_def_nr);
+
+		if (data->invert_vgroup)
+			armature_weight = 1.0f - armature_weight;
+
+		/* hackish: the blending factor can be used for blending with prevCos too */
+		if (prevCos) {
+			prevco_weight = armature_weight;
+			armature_weight = 1.0f;
+		}
+	}
+
+	/* check if there's any  point in calculating for this vert */
+	if (armature_weight == 0.0f)
+		return;
+
+	/* get the coord we work on */
+	co = prevCos ? prevCos[i] : vertexCos[i];
+
+	/* Apply the object's matrix */
+	mul_m4_v3(data->premat, co);
+
+	if (data->use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
+		const MDeformWeight *dw = dvert->dw;
+		int deformed = 0;
+		unsigned int j;
+
+		for (j = dvert->totweight; j != 0; j--, dw++) {
+			const int index = dw->def_nr;
+			bPoseChannel *pchan;
+			if (index >= 0 && index < data->defbase_tot && (pchan = data->defnr_to_pchan[index])) {
+				float weight = dw->weight;
+				Bone *bone = pchan->bone;
+
+				deformed = 1;
+
+				if (bone && bone->flag & BONE_MULT_VG_ENV) {
+					weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
+					                             bone->rad_head, bone->rad_tail, bone->dist);
+				}
+				pchan_bone_deform(pchan, data->defnr_to_pdef_info[index], weight, vec, dq, smat, co, &contrib);
+			}
+		}
+		/* if there are vertexgroups but not groups with bones
+		 * (like for softbody groups) */
+		if (deformed == 0 && data->use_envelope) {
+			armature_vert_deform_envelope(data, vec, dq, smat, co, &contrib);
+		}
+	}
+	else if (data->use_envelope) {
+		armature_vert_deform_envelope(data, vec, dq, smat, co, &contrib);
+	}
+
+	/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+	if (contrib > 0.0001f) {
+		if (use_quaternion) {
+			normalize_dq(dq, contrib);
+
+			if (armature_weight != 1.0f) {
+				copy_v3_v3(dco, co);
+				mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
+				sub_v3_v3(dco, co);
+				mul_v3_fl(dco, armature_weight);
+				add_v3_v3(co, dco);
+			}
+			else
+				mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
+
+			smat = summat;
+		}
+		else {
+			mul_v3_fl(vec, armature_weight / contrib);
+			add_v3_v3v3(co, vec, co);
+		}
+
+		if (defMats) {
+			float pre[3][3], post[3][3], tmpmat[3][3];
+
+			copy_m3_m4(pre, data->premat);
+			copy_m3_m4(post, data->postmat);
+			copy_m3_m3(tmpmat, defMats[i]);
+
+			if (!use_quaternion) /* quaternion already is scale corrected */
+				mul_m3_fl(smat, armature_weight / contrib);
+
+			mul_m3_series(defMats[i], post, smat, pre, tmpmat);
+		}
+	}
+
+	/* always, check above code */
+	mul_m4_v3(data->postmat, co);
+
+	/* interpolate with previous modifier position using weight group */
+	if (prevCos) {
+		float mw = 1.0f - prevco_weight;
+		vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
+		vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
+		vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
+	}
+}
+
 void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
                            float (*prevCos)[3], const char *defgrp_name)
@@ -981,7 +1162,7 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	bPoseChanDeform *pdef_info = NULL;
 	bArmature *arm = armOb->data;
 	bPoseChannel *pchan, **defnrToPC = NULL;
-	int *defnrToPCIndex = NULL;
+	bPoseChanDeform **defnrToPDefInfo = NULL;
 	MDeformVert *dverts = NULL;
 	bDeformGroup *dg;
 	DualQuat *dualquats = NULL;
@@ -1059,7 +1240,7 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 
 			if (use_dverts) {
 				defnrToPC = MEM_callocN(sizeof(*defnrToPC) * defbase_tot, "defnrToBone");
-				defnrToPCIndex = MEM_callocN(sizeof(*defnrToPCIndex) * defbase_tot, "defnrToIndex");
+				defnrToPDefInfo = MEM_callocN(sizeof(*defnrToPDefInfo) * defbase_tot, "defnrToPDefInfo");
 				/* TODO(sergey): Some considerations here:
 				 *
 				 * - Make it more generic function, maybe even keep together with chanhash.
@@ -1079,7 +1260,8 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 							defnrToPC[i] = NULL;
 						}
 						else {
-							defnrToPCIndex[i] = GET_INT_FROM_POINTER(BLI_ghash_lookup(idx_hash, defnrToPC[i]));
+							defnrToPDefInfo[i] = pdef_info_array +
+							                     GET_INT_FROM_POINTER(BLI_ghash_lookup(idx_hash, defnrToPC[i]));
 						}
 					}
 				}
@@ -1088,157 +1270,43 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		}
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		MDeformVert *dvert;
-		DualQuat sumdq, *dq = NULL;
-		float *co, dco[3];
-		float sumvec[3], summat[3][3];
-		float *vec = NULL, (*smat)[3] = NULL;
-		float contrib = 0.0f;
-		float armature_weight = 1.0f; /* default to 1 if no overall def group */
-		float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
-
-		if (use_quaternion) {
-			memset(&sumdq, 0, sizeof(DualQuat));
-			dq = &sumdq;
-		}
-		else {
-			sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
-			vec = sumvec;
-
-			if (defMats) {
-				zero_m3(summat);
-				smat = summat;
-			}
-		}
-
+	{
+		ArmatureVertDeformData vert_data = {
+		    .pdef_info_array = pdef_info_array, .chanbase = &armOb->pose->chanbase,
+		    .defnr_to_pchan = defnrToPC, .defnr_to_pdef_info = defnrToPDefInfo, .defbase_tot = defbase_tot,
+		    .vertexCos = vertexCos, .defMats = defMats, .prevCos = prevCos,
+		    .armature_def_nr = armature_def_nr,
+		    .use_envelope = use_envelope, .use_quaternion = use_quaternion,
+		    .use_dverts = use_dverts, .invert_vgroup = invert_vgroup,
+		};
+		ParallelRangeSettings settings;
+
+		copy_m4_m4(vert_data.premat, premat);
+		copy_m4_m4(vert_data.postmat, postmat);
+
+		/* Deform verts are read directly from the layer array, this avoids a layer
+		 * lookup for every vertex and is safe to do from multiple threads. */
 		if (use_dverts || armature_def_nr != -1) {
-			if (dm)
-				dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
-			else if (dverts && i < target_totvert)
-				dvert = dverts + i;
-			else
-				dvert = NULL;
-		}
-		else
-			dvert = NULL;
-
-		if (armature_def_nr != -1 && dvert) {
-			armature_weight = defvert_find_weight(dvert, armature_def_nr);
-
-			if (invert_vgroup)
-				armature_weight = 1.0f - armature_weight;
-
-			/* hackish: the blending factor can be used for blending with prevCos too */
-			if (prevCos) {
-				prevco_weight = armature_weight;
-				armature_weight = 1.0f;
-			}
-		}
-
-		/* check if there's any  point in calculating for this vert */
-		if (armature_weight == 0.0f)
-			continue;
-
-		/* get the coord we work on */
-		co = prevCos ? prevCos[i] : vertexCos[i];
-
-		/* Apply the object's matrix */
-		mul_m4_v3(premat, co);
-
-		if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-			MDeformWeight *dw = dvert->dw;
-			int deformed = 0;
-			unsigned int j;
-
-			for (j = dvert->totweight; j != 0; j--, dw++) {
-				const int index = dw->def_nr;
-				if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
-					float weight = dw->weight;
-					Bone *bone = pchan->bone;
-					pdef_info = pdef_info_array + defnrToPCIndex[index];
-
-					deformed = 1;
-
-					if (bone && bone->flag & BONE_MULT_VG_ENV) {
-						weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
-						                             bone->rad_head, bone->rad_tail, bone->dist);
-					}
-					pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
-				}
-			}
-			/* if there are vertexgroups but not groups with bones
-			 * (like for softbody groups) */
-			if (deformed == 0 && use_envelope) {
-				pdef_info = pdef_info_array;
-				for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-					if (!(pchan->bone->flag & BONE_NO_DEFORM))
-						contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-				}
-			}
-		}
-		else if (use_envelope) {
-			pdef_info = pdef_info_array;
-			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-				if (!(pchan->bone->flag & BONE_NO_DEFORM))
-					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-			}
-		}
-
-		/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-		if (contrib > 0.0001f) {
-			if (use_quaternion) {
-				normalize_dq(dq, contrib);
-
-				if (armature_weight != 1.0f) {
-					copy_v3_v3(dco, co);
-					mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
-					sub_v3_v3(dco, co);
-					mul_v3_fl(dco, armature_weight);
-					add_v3_v3(co, dco);
-				}
-				else
-					mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
-
-				smat = summat;
+			if (dm) {
+				vert_data.dm_dverts = dm->getVertDataArray(dm, CD_MDEFORMVERT);
 			}
 			else {
-				mul_v3_fl(vec, armature_weight / contrib);
-				add_v3_v3v3(co, vec, co);
-			}
-
-			if (defMats) {
-				float pre[3][3], post[3][3], tmpmat[3][3];
-
-				copy_m3_m4(pre, premat);
-				copy_m3_m4(post, postmat);
-				copy_m3_m3(tmpmat, defMats[i]);
-
-				if (!use_quaternion) /* quaternion already is scale corrected */
-					mul_m3_fl(smat, armature_weight / contrib);
-
-				mul_m3_series(defMats[i], post, smat, pre, tmpmat);
+				vert_data.dverts = dverts;
+				vert_data.target_totvert = target_totvert;
 			}
 		}
 
-		/* always, check above code */
-		mul_m4_v3(postmat, co);
-
-		/* interpolate with previous modifier position using weight group */
-		if (prevCos) {
-			float mw = 1.0f - prevco_weight;
-			vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
-			vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
-			vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
-		}
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.min_iter_per_thread = 1024;
+		BLI_task_parallel_range(0, numVerts, &vert_data, armature_vert_deform_cb, &settings);
 	}
 
 	if (dualquats)
 		MEM_freeN(dualquats);
 	if (defnrToPC)
 		MEM_freeN(defnrToPC);
-	if (defnrToPCIndex)
-		MEM_freeN(defnrToPCIndex);
+	if (defnrToPDefInfo)
+		MEM_freeN(defnrToPDefInfo);
 
 	/* free B_bone matrices */
 	pdef_info = pdef_info_array;
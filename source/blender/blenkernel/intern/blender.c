@@ -57,7 +57,9 @@
 #include "BKE_idprop.h"
 #include "BKE_image.h"
 #include "BKE_library.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_node.h"
+#include "BKE_pointcache.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
@@ -97,6 +99,8 @@ void BKE_blender_free(void)
 
 	BKE_sequencer_cache_destruct();
 	IMB_moviecache_destruct();
+	BKE_modifier_cache_free();
+	BKE_ptcache_exit();
 	
 	free_nodesystem();
 }
@@ -375,7 +375,7 @@ static int rule_separate(BoidRule *UNUSED(rule), BoidBrainData *bbd, BoidValues
 	int ret = 0;
 
 	if (neighbors > 1 && ptn[1].dist!=0.0f) {
-		sub_v3_v3v3(vec, pa->prev_state.co, bbd->sim->psys->particles[ptn[1].index].state.co);
+		sub_v3_v3v3(vec, pa->prev_state.co, ptn[1].co);
 		mul_v3_fl(vec, (2.0f * val->personal_space * pa->size - ptn[1].dist) / ptn[1].dist);
 		add_v3_v3(bbd->wanted_co, vec);
 		bbd->wanted_speed = val->max_speed;
@@ -694,10 +694,13 @@ static int rule_fight(BoidRule *rule, BoidBrainData *bbd, BoidValues *val, Parti
 			/* fight mode */
 			bbd->wanted_speed = 0.0f;
 
-			/* must face enemy to fight */
+			/* must face enemy to fight, damage is done after all boids decided */
 			if (dot_v3v3(pa->prev_state.ave, enemy_dir)>0.5f) {
-				bpa = enemy_pa->boid;
-				bpa->data.health -= bbd->part->boids->strength * bbd->timestep * ((1.0f-bbd->part->boids->accuracy)*damage + bbd->part->boids->accuracy);
+				if (bbd->enemy != enemy_pa->boid) {
+					bbd->enemy = enemy_pa->boid;
+					bbd->enemy_damage = 0.0f;
+				}
+				bbd->enemy_damage += bbd->part->boids->strength * bbd->timestep * ((1.0f-bbd->part->boids->accuracy)*damage + bbd->part->boids->accuracy);
 			}
 		}
 		else {
@@ -972,6 +975,10 @@ void boid_brain(BoidBrainData *bbd, int p, ParticleData *pa)
 	int rand;
 	//BoidCondition *cond;
 
+	bbd->enemy = NULL;
+	bbd->enemy_damage = 0.0f;
+	bbd->jump = false;
+
 	if (bpa->data.health <= 0.0f) {
 		pa->alive = PARS_DYING;
 		pa->dietime = bbd->cfra;
@@ -1110,7 +1117,9 @@ void boid_brain(BoidBrainData *bbd, int p, ParticleData *pa)
 			}
 
 			if (jump) {
-				copy_v3_v3(pa->prev_state.vel, jump_v);
+				/* other boids still read the velocity, it's changed by boid_body() */
+				copy_v3_v3(bbd->jump_vel, jump_v);
+				bbd->jump = true;
 				bpa->data.mode = eBoidMode_Falling;
 			}
 		}
@@ -1135,6 +1144,10 @@ void boid_body(BoidBrainData *bbd, ParticleData *pa)
 
 	set_boid_values(&val, boids, pa);
 
+	/* jump decided by the brain */
+	if (bbd->jump)
+		copy_v3_v3(pa->prev_state.vel, bbd->jump_vel);
+
 	/* make sure there's something in new velocity, location & rotation */
 	copy_particle_key(&pa->state, &pa->prev_state, 0);
 
@@ -1471,6 +1484,14 @@ void boid_body(BoidBrainData *bbd, ParticleData *pa)
 	copy_qt_qt(pa->state.rot, q);
 }
 
+/* damage done to an enemy by the fight rule */
+void boid_apply_damage(BoidBrainData *bbd)
+{
+	if (bbd->enemy) {
+		bbd->enemy->data.health -= bbd->enemy_damage;
+		bbd->enemy = NULL;
+	}
+}
 BoidRule *boid_new_rule(int type)
 {
 	BoidRule *rule = NULL;
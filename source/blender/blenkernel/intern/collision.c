@@ -44,6 +44,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_edgehash.h"
+#include "BLI_task.h"
 
 #include "BKE_cloth.h"
 #include "BKE_effect.h"
@@ -60,6 +61,9 @@
 #include "eltopo-capi.h"
 #endif
 
+/* Number of collision pairs above which they are processed in parallel. */
+#define CLOTH_COLLISION_PARALLEL_LIMIT 64
+
 
 /***********************************
 Collision modifier code start
@@ -226,151 +230,199 @@ DO_INLINE void collision_interpolateOnTriangle ( float to[3], float v1[3], float
 	VECADDMUL(to, v3, w3);
 }
 
-static int cloth_collision_response_static ( ClothModifierData *clmd, CollisionModifierData *collmd, CollPair *collpair, CollPair *collision_end )
+/* Impulses of a single collision pair, apply is false when the pair doesn't affect the cloth. */
+typedef struct CollPairImpulse {
+	float i1[3], i2[3], i3[3];
+	bool apply;
+} CollPairImpulse;
+
+/* Only reads the cloth and collider state, so pairs can be processed in parallel. */
+static void cloth_collision_impulse(
+        ClothModifierData *clmd, CollisionModifierData *collmd, CollPair *collpair, CollPairImpulse *r_impulse)
 {
-	int result = 0;
-	Cloth *cloth1;
+	Cloth *cloth1 = clmd->clothObject;
 	float w1, w2, w3, u1, u2, u3;
 	float v1[3], v2[3], relativeVelocity[3];
 	float magrelVel;
 	float epsilon2 = BLI_bvhtree_get_epsilon ( collmd->bvhtree );
+	float *i1 = r_impulse->i1, *i2 = r_impulse->i2, *i3 = r_impulse->i3;
 
-	cloth1 = clmd->clothObject;
+	zero_v3(i1);
+	zero_v3(i2);
+	zero_v3(i3);
+	r_impulse->apply = false;
 
-	for ( ; collpair != collision_end; collpair++ ) {
-		float i1[3], i2[3], i3[3];
+	/* only handle static collisions here */
+	if ( collpair->flag & COLLISION_IN_FUTURE )
+		return;
 
-		zero_v3(i1);
-		zero_v3(i2);
-		zero_v3(i3);
+	/* compute barycentric coordinates for both collision points */
+	collision_compute_barycentric ( collpair->pa,
+		cloth1->verts[collpair->ap1].txold,
+		cloth1->verts[collpair->ap2].txold,
+		cloth1->verts[collpair->ap3].txold,
+		&w1, &w2, &w3 );
 
-		/* only handle static collisions here */
-		if ( collpair->flag & COLLISION_IN_FUTURE )
-			continue;
+	/* was: txold */
+	collision_compute_barycentric ( collpair->pb,
+		collmd->current_x[collpair->bp1].co,
+		collmd->current_x[collpair->bp2].co,
+		collmd->current_x[collpair->bp3].co,
+		&u1, &u2, &u3 );
 
-		/* compute barycentric coordinates for both collision points */
-		collision_compute_barycentric ( collpair->pa,
-			cloth1->verts[collpair->ap1].txold,
-			cloth1->verts[collpair->ap2].txold,
-			cloth1->verts[collpair->ap3].txold,
-			&w1, &w2, &w3 );
+	/* Calculate relative "velocity". */
+	collision_interpolateOnTriangle ( v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3 );
 
-		/* was: txold */
-		collision_compute_barycentric ( collpair->pb,
-			collmd->current_x[collpair->bp1].co,
-			collmd->current_x[collpair->bp2].co,
-			collmd->current_x[collpair->bp3].co,
-			&u1, &u2, &u3 );
+	collision_interpolateOnTriangle ( v2, collmd->current_v[collpair->bp1].co, collmd->current_v[collpair->bp2].co, collmd->current_v[collpair->bp3].co, u1, u2, u3 );
 
-		/* Calculate relative "velocity". */
-		collision_interpolateOnTriangle ( v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3 );
+	sub_v3_v3v3(relativeVelocity, v2, v1);
 
-		collision_interpolateOnTriangle ( v2, collmd->current_v[collpair->bp1].co, collmd->current_v[collpair->bp2].co, collmd->current_v[collpair->bp3].co, u1, u2, u3 );
+	/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
+	magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
 
-		sub_v3_v3v3(relativeVelocity, v2, v1);
+	/* printf("magrelVel: %f\n", magrelVel); */
 
-		/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
-		magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
+	/* Calculate masses of points.
+	 * TODO */
 
-		/* printf("magrelVel: %f\n", magrelVel); */
+	/* If v_n_mag < 0 the edges are approaching each other. */
+	if ( magrelVel > ALMOST_ZERO ) {
+		/* Calculate Impulse magnitude to stop all motion in normal direction. */
+		float magtangent = 0, repulse = 0, d = 0;
+		double impulse = 0.0;
+		float vrel_t_pre[3];
+		float temp[3], spf;
 
-		/* Calculate masses of points.
-		 * TODO */
+		/* calculate tangential velocity */
+		copy_v3_v3 ( temp, collpair->normal );
+		mul_v3_fl(temp, magrelVel);
+		sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
 
-		/* If v_n_mag < 0 the edges are approaching each other. */
-		if ( magrelVel > ALMOST_ZERO ) {
-			/* Calculate Impulse magnitude to stop all motion in normal direction. */
-			float magtangent = 0, repulse = 0, d = 0;
-			double impulse = 0.0;
-			float vrel_t_pre[3];
-			float temp[3], spf;
+		/* Decrease in magnitude of relative tangential velocity due to coulomb friction
+		 * in original formula "magrelVel" should be the "change of relative velocity in normal direction" */
+		magtangent = min_ff(clmd->coll_parms->friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
 
-			/* calculate tangential velocity */
-			copy_v3_v3 ( temp, collpair->normal );
-			mul_v3_fl(temp, magrelVel);
-			sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
+		/* Apply friction impulse. */
+		if ( magtangent > ALMOST_ZERO ) {
+			normalize_v3(vrel_t_pre);
 
-			/* Decrease in magnitude of relative tangential velocity due to coulomb friction
-			 * in original formula "magrelVel" should be the "change of relative velocity in normal direction" */
-			magtangent = min_ff(clmd->coll_parms->friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
+			impulse = magtangent / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* 2.0 * */
+			VECADDMUL ( i1, vrel_t_pre, w1 * impulse );
+			VECADDMUL ( i2, vrel_t_pre, w2 * impulse );
+			VECADDMUL ( i3, vrel_t_pre, w3 * impulse );
+		}
 
-			/* Apply friction impulse. */
-			if ( magtangent > ALMOST_ZERO ) {
-				normalize_v3(vrel_t_pre);
+		/* Apply velocity stopping impulse
+		 * I_c = m * v_N / 2.0
+		 * no 2.0 * magrelVel normally, but looks nicer DG */
+		impulse =  magrelVel / ( 1.0 + w1*w1 + w2*w2 + w3*w3 );
+
+		VECADDMUL ( i1, collpair->normal, w1 * impulse );
+		VECADDMUL ( i2, collpair->normal, w2 * impulse );
+		VECADDMUL ( i3, collpair->normal, w3 * impulse );
+
+		/* Apply repulse impulse if distance too short
+		 * I_r = -min(dt*kd, m(0, 1d/dt - v_n))
+		 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
+		 * v += impulse; x_new = x + v;
+		 * We don't use dt!!
+		 * DG TODO: Fix usage of dt here! */
+		spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
+
+		d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
+		if ( ( magrelVel < 0.1f*d*spf ) && ( d > ALMOST_ZERO ) ) {
+			repulse = MIN2 ( d*1.0f/spf, 0.1f*d*spf - magrelVel );
+
+			/* stay on the safe side and clamp repulse */
+			if ( impulse > ALMOST_ZERO )
+				repulse = min_ff( repulse, 5.0*impulse );
+			repulse = max_ff(impulse, repulse);
+
+			impulse = repulse / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* original 2.0 / 0.25 */
+			VECADDMUL ( i1, collpair->normal,  impulse );
+			VECADDMUL ( i2, collpair->normal,  impulse );
+			VECADDMUL ( i3, collpair->normal,  impulse );
+		}
 
-				impulse = magtangent / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* 2.0 * */
-				VECADDMUL ( i1, vrel_t_pre, w1 * impulse );
-				VECADDMUL ( i2, vrel_t_pre, w2 * impulse );
-				VECADDMUL ( i3, vrel_t_pre, w3 * impulse );
-			}
+		r_impulse->apply = true;
+	}
+	else {
+		/* Apply repulse impulse if distance too short
+		 * I_r = -min(dt*kd, max(0, 1d/dt - v_n))
+		 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
+		 * v += impulse; x_new = x + v;
+		 * We don't use dt!! */
+		float spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
 
-			/* Apply velocity stopping impulse
-			 * I_c = m * v_N / 2.0
-			 * no 2.0 * magrelVel normally, but looks nicer DG */
-			impulse =  magrelVel / ( 1.0 + w1*w1 + w2*w2 + w3*w3 );
+		float d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - (float)collpair->distance;
+		if ( d > ALMOST_ZERO) {
+			/* stay on the safe side and clamp repulse */
+			float repulse = d*1.0f/spf;
 
-			VECADDMUL ( i1, collpair->normal, w1 * impulse );
-			cloth1->verts[collpair->ap1].impulse_count++;
+			float impulse = repulse / ( 3.0f * ( 1.0f + w1*w1 + w2*w2 + w3*w3 )); /* original 2.0 / 0.25 */
 
-			VECADDMUL ( i2, collpair->normal, w2 * impulse );
-			cloth1->verts[collpair->ap2].impulse_count++;
+			VECADDMUL ( i1, collpair->normal,  impulse );
+			VECADDMUL ( i2, collpair->normal,  impulse );
+			VECADDMUL ( i3, collpair->normal,  impulse );
 
-			VECADDMUL ( i3, collpair->normal, w3 * impulse );
-			cloth1->verts[collpair->ap3].impulse_count++;
+			r_impulse->apply = true;
+		}
+	}
+}
 
-			/* Apply repulse impulse if distance too short
-			 * I_r = -min(dt*kd, m(0, 1d/dt - v_n))
-			 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
-			 * v += impulse; x_new = x + v;
-			 * We don't use dt!!
-			 * DG TODO: Fix usage of dt here! */
-			spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
-
-			d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
-			if ( ( magrelVel < 0.1f*d*spf ) && ( d > ALMOST_ZERO ) ) {
-				repulse = MIN2 ( d*1.0f/spf, 0.1f*d*spf - magrelVel );
-
-				/* stay on the safe side and clamp repulse */
-				if ( impulse > ALMOST_ZERO )
-					repulse = min_ff( repulse, 5.0*impulse );
-				repulse = max_ff(impulse, repulse);
-
-				impulse = repulse / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* original 2.0 / 0.25 */
-				VECADDMUL ( i1, collpair->normal,  impulse );
-				VECADDMUL ( i2, collpair->normal,  impulse );
-				VECADDMUL ( i3, collpair->normal,  impulse );
-			}
+typedef struct ClothCollisionImpulseData {
+	ClothModifierData *clmd;
+	CollisionModifierData *collmd;
+	CollPair *collisions;
+	CollPairImpulse *impulses;
+} ClothCollisionImpulseData;
+
+static void cloth_collision_impulse_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ClothCollisionImpulseData *data = userdata;
 
-			result = 1;
-		}
-		else {
-			/* Apply repulse impulse if distance too short
-			 * I_r = -min(dt*kd, max(0, 1d/dt - v_n))
-			 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
-			 * v += impulse; x_new = x + v;
-			 * We don't use dt!! */
-			float spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
+	cloth_collision_impulse(data->clmd, data->collmd, &data->collisions[index], &data->impulses[index]);
+}
+
+static int cloth_collision_response_static ( ClothModifierData *clmd, CollisionModifierData *collmd, CollPair *collpair, CollPair *collision_end )
+{
+	int result = 0;
+	Cloth *cloth1 = clmd->clothObject;
+	const int totcollisions = (int)(collision_end - collpair);
+	CollPairImpulse *impulses, *impulse;
+	ClothCollisionImpulseData data;
+	ParallelRangeSettings settings;
 
-			float d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - (float)collpair->distance;
-			if ( d > ALMOST_ZERO) {
-				/* stay on the safe side and clamp repulse */
-				float repulse = d*1.0f/spf;
+	if (totcollisions == 0)
+		return 0;
 
-				float impulse = repulse / ( 3.0f * ( 1.0f + w1*w1 + w2*w2 + w3*w3 )); /* original 2.0 / 0.25 */
+	/* Impulses are calculated in parallel, but applied in the order of the pairs,
+	 * so the result is the same as handling pairs one by one. */
+	impulses = MEM_mallocN(sizeof(*impulses) * totcollisions, "collision impulses");
 
-				VECADDMUL ( i1, collpair->normal,  impulse );
-				VECADDMUL ( i2, collpair->normal,  impulse );
-				VECADDMUL ( i3, collpair->normal,  impulse );
+	data.clmd = clmd;
+	data.collmd = collmd;
+	data.collisions = collpair;
+	data.impulses = impulses;
 
-				cloth1->verts[collpair->ap1].impulse_count++;
-				cloth1->verts[collpair->ap2].impulse_count++;
-				cloth1->verts[collpair->ap3].impulse_count++;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (totcollisions > CLOTH_COLLISION_PARALLEL_LIMIT);
+	BLI_task_parallel_range(0, totcollisions, &data, cloth_collision_impulse_cb, &settings);
 
-				result = 1;
-			}
+	for (impulse = impulses; collpair != collision_end; collpair++, impulse++) {
+		if (impulse->apply) {
+			cloth1->verts[collpair->ap1].impulse_count++;
+			cloth1->verts[collpair->ap2].impulse_count++;
+			cloth1->verts[collpair->ap3].impulse_count++;
+
+			result = 1;
 		}
 
 		if (result) {
+			const float *i1 = impulse->i1, *i2 = impulse->i2, *i3 = impulse->i3;
 			int i = 0;
 
 			for (i = 0; i < 3; i++) {
@@ -385,6 +437,9 @@ static int cloth_collision_response_static ( ClothModifierData *clmd, CollisionM
 			}
 		}
 	}
+
+	MEM_freeN(impulses);
+
 	return result;
 }
 
@@ -619,18 +674,70 @@ void free_collider_cache(ListBase **colliders)
 }
 
 
-static void cloth_bvh_objcollisions_nearcheck ( ClothModifierData * clmd, CollisionModifierData *collmd,
-	CollPair **collisions, CollPair **collisions_index, int numresult, BVHTreeOverlap *overlap, double dt)
+typedef struct ClothNearcheckData {
+	ClothModifierData *clmd;
+	CollisionModifierData *collmd;
+	BVHTreeOverlap *overlap;
+	/* One slot per overlap, hits tells which ones are filled in. */
+	CollPair *collisions;
+	bool *hits;
+	float epsilon;
+	double dt;
+} ClothNearcheckData;
+
+static void cloth_collision_nearcheck_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ClothNearcheckData *data = userdata;
+	CollPair *collpair = &data->collisions[index];
+
+	data->hits[index] = cloth_collision((ModifierData *)data->clmd, (ModifierData *)data->collmd,
+	                                    data->overlap + index, collpair, data->dt) != collpair;
+}
+
+/* Run the near check for every overlap in parallel, then move the found collisions to the
+ * start of the array, keeping them in the order of the overlaps.
+ * Returns the end of the found collisions. */
+static CollPair *cloth_collisions_nearcheck_parallel(
+        ClothNearcheckData *data, int numresult, TaskParallelRangeFunc func)
 {
+	CollPair *collisions_index = data->collisions;
+	ParallelRangeSettings settings;
 	int i;
-	
-	*collisions = (CollPair *) MEM_mallocN(sizeof(CollPair) * numresult * 4, "collision array" ); // * 4 since cloth_collision_static can return more than 1 collision
-	*collisions_index = *collisions;
 
-	for ( i = 0; i < numresult; i++ ) {
-		*collisions_index = cloth_collision((ModifierData *)clmd, (ModifierData *)collmd,
-		                                    overlap+i, *collisions_index, dt);
+	data->hits = MEM_mallocN(sizeof(bool) * numresult, "collision hits");
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (numresult > CLOTH_COLLISION_PARALLEL_LIMIT);
+	BLI_task_parallel_range(0, numresult, data, func, &settings);
+
+	for (i = 0; i < numresult; i++) {
+		if (data->hits[i]) {
+			if (collisions_index != &data->collisions[i]) {
+				*collisions_index = data->collisions[i];
+			}
+			collisions_index++;
+		}
 	}
+
+	MEM_freeN(data->hits);
+	data->hits = NULL;
+
+	return collisions_index;
+}
+
+static void cloth_bvh_objcollisions_nearcheck ( ClothModifierData * clmd, CollisionModifierData *collmd,
+	CollPair **collisions, CollPair **collisions_index, int numresult, BVHTreeOverlap *overlap, double dt)
+{
+	ClothNearcheckData data = {clmd, collmd, overlap, NULL, NULL, 0.0f, dt};
+
+	/* cloth_collision() finds at most one collision per overlap */
+	*collisions = (CollPair *) MEM_mallocN(sizeof(CollPair) * numresult, "collision array" );
+
+	data.collisions = *collisions;
+	*collisions_index = cloth_collisions_nearcheck_parallel(&data, numresult, cloth_collision_nearcheck_cb);
 }
 
 static int cloth_bvh_objcollisions_resolve ( ClothModifierData * clmd, CollisionModifierData *collmd, CollPair *collisions, CollPair *collisions_index)
@@ -675,6 +782,31 @@ static int cloth_bvh_objcollisions_resolve ( ClothModifierData * clmd, Collision
 	return ret;
 }
 
+/* Filter out pairs which self collisions never correct, while the overlaps are searched in parallel.
+ * This only depends on vertex flags and topology, not on positions changed by the corrections. */
+static bool cloth_selfcollision_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	ClothModifierData *clmd = userdata;
+	Cloth *cloth = clmd->clothObject;
+	const ClothVertex *vert_a = &cloth->verts[index_a], *vert_b = &cloth->verts[index_b];
+
+	if (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL) {
+		if ((vert_a->flags & CLOTH_VERT_FLAG_PINNED) &&
+		    (vert_b->flags & CLOTH_VERT_FLAG_PINNED))
+		{
+			return false;
+		}
+	}
+
+	if ((vert_a->flags & CLOTH_VERT_FLAG_NOSELFCOLL) ||
+	    (vert_b->flags & CLOTH_VERT_FLAG_NOSELFCOLL))
+	{
+		return false;
+	}
+
+	return !BLI_edgeset_haskey(cloth->edgeset, index_a, index_b);
+}
+
 // cloth - object collisions
 int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, float dt )
 {
@@ -800,9 +932,9 @@ int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, floa
 	
 				if ( cloth->bvhselftree ) {
 					// search for overlapping collision pairs
-					overlap = BLI_bvhtree_overlap(cloth->bvhselftree, cloth->bvhselftree, &result, NULL, NULL);
+					overlap = BLI_bvhtree_overlap(cloth->bvhselftree, cloth->bvhselftree, &result,
+					                              cloth_selfcollision_overlap_cb, clmd);
 
-					/* Could be parallelized (using BLI_task)... */
 					for ( k = 0; k < result; k++ ) {
 						float temp[3];
 						float length = 0;
@@ -813,28 +945,11 @@ int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, floa
 	
 						mindistance = clmd->coll_parms->selfepsilon* ( cloth->verts[i].avg_spring_len + cloth->verts[j].avg_spring_len );
 	
-						if ( clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL ) {
-							if ( ( cloth->verts [i].flags & CLOTH_VERT_FLAG_PINNED ) &&
-							     ( cloth->verts [j].flags & CLOTH_VERT_FLAG_PINNED ) )
-							{
-								continue;
-							}
-						}
-
-						if ((cloth->verts[i].flags & CLOTH_VERT_FLAG_NOSELFCOLL) ||
-						    (cloth->verts[j].flags & CLOTH_VERT_FLAG_NOSELFCOLL))
-						{
-							continue;
-						}
-	
+						/* pinned, excluded and connected pairs are skipped by cloth_selfcollision_overlap_cb() */
 						sub_v3_v3v3(temp, verts[i].tx, verts[j].tx);
 	
 						if ( ( ABS ( temp[0] ) > mindistance ) || ( ABS ( temp[1] ) > mindistance ) || ( ABS ( temp[2] ) > mindistance ) ) continue;
 	
-						if (BLI_edgeset_haskey(cloth->edgeset, i, j)) {
-							continue;
-						}
-	
 						length = normalize_v3(temp );
 	
 						if ( length < mindistance ) {
@@ -1147,21 +1262,30 @@ static CollPair *cloth_point_collision(
 	return collpair;
 }
 
+static void cloth_point_collision_nearcheck_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ClothNearcheckData *data = userdata;
+	CollPair *collpair = &data->collisions[index];
+
+	data->hits[index] = cloth_point_collision((ModifierData *)data->clmd, (ModifierData *)data->collmd,
+	                                          data->overlap + index, data->epsilon, collpair, data->dt) != collpair;
+}
+
 static void cloth_points_objcollisions_nearcheck(
         ClothModifierData *clmd, CollisionModifierData *collmd,
         CollPair **collisions, CollPair **collisions_index,
         int numresult, BVHTreeOverlap *overlap, float epsilon, double dt)
 {
-	int i;
-	
-	/* can return 2 collisions in total */
-	*collisions = (CollPair *) MEM_mallocN(sizeof(CollPair) * numresult * 2, "collision array" );
-	*collisions_index = *collisions;
+	ClothNearcheckData data = {clmd, collmd, overlap, NULL, NULL, epsilon, dt};
 
-	for ( i = 0; i < numresult; i++ ) {
-		*collisions_index = cloth_point_collision((ModifierData *)clmd, (ModifierData *)collmd,
-		                                          overlap+i, epsilon, *collisions_index, dt);
-	}
+	/* cloth_point_collision() finds at most one collision per overlap */
+	*collisions = (CollPair *) MEM_mallocN(sizeof(CollPair) * numresult, "collision array" );
+
+	data.collisions = *collisions;
+	*collisions_index = cloth_collisions_nearcheck_parallel(&data, numresult, cloth_point_collision_nearcheck_cb);
 }
 
 static int cloth_points_objcollisions_resolve(
@@ -1757,6 +1757,18 @@ void DAG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* clear dependency graph relations of a single ID */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	if (DEG_depsgraph_use_legacy()) {
+		/* Legacy graph is always rebuilt from scratch. */
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		DEG_id_relations_tag_update(bmain, id);
+	}
+}
+
 /* rebuild dependency graph only for a given scene */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *sce)
 {
@@ -3660,6 +3672,12 @@ void DAG_relations_tag_update(Main *bmain)
 	DEG_relations_tag_update(bmain);
 }
 
+/* Tag relations of a single ID for update. */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	DEG_id_relations_tag_update(bmain, id);
+}
+
 /* Rebuild dependency graph only for a given scene. */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *scene)
 {
@@ -168,6 +168,13 @@ typedef struct BakeAdjPoint {
 	float dist;     /* distance to */
 } BakeAdjPoint;
 
+/* Compact copy of neighbor target and distance, read by effect steps
+ * that don't need the direction */
+typedef struct BakeAdjTarget {
+	int index;      /* neighbor point index */
+	float dist;     /* distance to */
+} BakeAdjTarget;
+
 /* Surface data used while processing a frame	*/
 typedef struct PaintBakeNormal {
 	float invNorm[3];  /* current pixel world-space inverted normal */
@@ -186,6 +193,7 @@ typedef struct PaintBakeData {
 
 	/* adjacency info */
 	BakeAdjPoint *bNeighs;  /* current global neighbor distances and directions, if required */
+	BakeAdjTarget *bTargets;  /* same order as bNeighs */
 	double average_dist;
 	/* space partitioning */
 	VolumeGrid *grid;       /* space partitioning grid to optimize brush checks */
@@ -226,6 +234,12 @@ typedef struct PaintAdjData {
 	int total_targets; /* size of n_target */
 	int *border;    /* indices of border pixels (only for texture paint) */
 	int total_border; /* size of border */
+
+	/* reverse adjacency, created on demand for effects that gather from neighbors */
+	int *r_source;  /* points that have this point as neighbor, ordered by index (r_index + r_num) */
+	int *r_link;    /* index of that neighbor link in n_target */
+	int *r_index;   /* index to start reading r_source and r_link for each point */
+	int *r_num;     /* num of points that have this point as neighbor */
 } PaintAdjData;
 
 /***************************** General Utils ******************************/
@@ -702,17 +716,18 @@ static void surfaceGenerateGrid(struct DynamicPaintSurface *surface)
 	int *temp_t_index = NULL;
 	int *temp_s_num = NULL;
 
-	if (bData->grid)
-		freeGrid(sData);
-
-	bData->grid = MEM_callocN(sizeof(VolumeGrid), "Surface Grid");
+	/* keep grid arrays of previous frame while grid size doesn't change */
+	if (!bData->grid)
+		bData->grid = MEM_callocN(sizeof(VolumeGrid), "Surface Grid");
 	grid = bData->grid;
+	grid->grid_bounds.valid = false;
 
 	{
 		int i, error = 0;
 		float dim_factor, volume, dim[3];
 		float td[3];
 		float min_dim;
+		int grid_dim[3];
 
 		/* calculate canvas dimensions */
 		/* Important to init correctly our ref grid_bound... */
@@ -745,8 +760,7 @@ static void surfaceGenerateGrid(struct DynamicPaintSurface *surface)
 		}
 
 		if (axis == 0 || max_fff(td[0], td[1], td[2]) < 0.0001f) {
-			MEM_freeN(bData->grid);
-			bData->grid = NULL;
+			freeGrid(sData);
 			return;
 		}
 
@@ -758,18 +772,29 @@ static void surfaceGenerateGrid(struct DynamicPaintSurface *surface)
 
 		/* define final grid size using dim_factor, use min 3 for active axises */
 		for (i = 0; i < 3; i++) {
-			grid->dim[i] = (int)floor(td[i] / dim_factor);
-			CLAMP(grid->dim[i], (dim[i] >= min_dim) ? 3 : 1, 100);
+			grid_dim[i] = (int)floor(td[i] / dim_factor);
+			CLAMP(grid_dim[i], (dim[i] >= min_dim) ? 3 : 1, 100);
 		}
-		grid_cells = grid->dim[0] * grid->dim[1] * grid->dim[2];
+		grid_cells = grid_dim[0] * grid_dim[1] * grid_dim[2];
 
 		/* allocate memory for grids */
-		grid->bounds = MEM_callocN(sizeof(Bounds3D) * grid_cells, "Surface Grid Bounds");
-		grid->s_pos = MEM_callocN(sizeof(int) * grid_cells, "Surface Grid Position");
+		if (grid->s_num && grid->t_index && memcmp(grid->dim, grid_dim, sizeof(grid_dim)) == 0) {
+			memset(grid->s_num, 0, sizeof(int) * grid_cells);
+		}
+		else {
+			MEM_SAFE_FREE(grid->bounds);
+			MEM_SAFE_FREE(grid->s_pos);
+			MEM_SAFE_FREE(grid->s_num);
+			MEM_SAFE_FREE(grid->t_index);
+
+			copy_v3_v3_int(grid->dim, grid_dim);
+			grid->bounds = MEM_callocN(sizeof(Bounds3D) * grid_cells, "Surface Grid Bounds");
+			grid->s_pos = MEM_callocN(sizeof(int) * grid_cells, "Surface Grid Position");
+			grid->s_num = MEM_callocN(sizeof(int) * grid_cells, "Surface Grid Points");
+			grid->t_index = MEM_callocN(sizeof(int) * sData->total_points, "Surface Grid Target Ids");
+		}
 
-		grid->s_num = MEM_callocN(sizeof(int) * grid_cells, "Surface Grid Points");
 		temp_s_num = MEM_callocN(sizeof(int) * grid_cells, "Temp Surface Grid Points");
-		grid->t_index = MEM_callocN(sizeof(int) * sData->total_points, "Surface Grid Target Ids");
 		grid->temp_t_index = temp_t_index = MEM_callocN(sizeof(int) * sData->total_points, "Temp Surface Grid Target Ids");
 
 		/* in case of an allocation failure abort here */
@@ -863,6 +888,14 @@ static void dynamicPaint_freeAdjData(PaintSurfaceData *data)
 			MEM_freeN(data->adj_data->flags);
 		if (data->adj_data->border)
 			MEM_freeN(data->adj_data->border);
+		if (data->adj_data->r_source)
+			MEM_freeN(data->adj_data->r_source);
+		if (data->adj_data->r_link)
+			MEM_freeN(data->adj_data->r_link);
+		if (data->adj_data->r_index)
+			MEM_freeN(data->adj_data->r_index);
+		if (data->adj_data->r_num)
+			MEM_freeN(data->adj_data->r_num);
 		MEM_freeN(data->adj_data);
 		data->adj_data = NULL;
 	}
@@ -882,6 +915,8 @@ static void free_bakeData(PaintSurfaceData *data)
 			MEM_freeN(bData->realCoord);
 		if (bData->bNeighs)
 			MEM_freeN(bData->bNeighs);
+		if (bData->bTargets)
+			MEM_freeN(bData->bTargets);
 		if (bData->grid)
 			freeGrid(data);
 		if (bData->prev_verts)
@@ -4760,6 +4795,7 @@ static void dynamic_paint_prepare_adjacency_cb(
 	PaintSurfaceData *sData = userdata;
 	PaintBakeData *bData = sData->bData;
 	BakeAdjPoint *bNeighs = bData->bNeighs;
+	BakeAdjTarget *bTargets = bData->bTargets;
 	PaintAdjData *adj_data = sData->adj_data;
 	Vec3f *realCoord = bData->realCoord;
 
@@ -4773,6 +4809,9 @@ static void dynamic_paint_prepare_adjacency_cb(
 		sub_v3_v3v3(bNeighs[n_index].dir, realCoord[bData->s_pos[t_index]].v, realCoord[bData->s_pos[index]].v);
 		/* dist */
 		bNeighs[n_index].dist = normalize_v3(bNeighs[n_index].dir);
+
+		bTargets[n_index].index = t_index;
+		bTargets[n_index].dist = bNeighs[n_index].dist;
 	}
 }
 
@@ -4788,11 +4827,18 @@ static void dynamicPaint_prepareAdjacencyData(DynamicPaintSurface *surface, cons
 	if ((!surface_usesAdjDistance(surface) && !force_init) || !sData->adj_data)
 		return;
 
-	if (bData->bNeighs)
-		MEM_freeN(bData->bNeighs);
-	bNeighs = bData->bNeighs = MEM_mallocN(sData->adj_data->total_targets * sizeof(*bNeighs), "PaintEffectBake");
-	if (!bNeighs)
-		return;
+	/* adjacency doesn't change while the canvas deforms, reuse previous frame arrays */
+	if (!bData->bNeighs) {
+		bData->bNeighs = MEM_mallocN(adj_data->total_targets * sizeof(*bData->bNeighs), "PaintEffectBake");
+		bData->bTargets = MEM_mallocN(adj_data->total_targets * sizeof(*bData->bTargets), "PaintEffectBakeTargets");
+
+		if (!bData->bNeighs || !bData->bTargets) {
+			MEM_SAFE_FREE(bData->bNeighs);
+			MEM_SAFE_FREE(bData->bTargets);
+			return;
+		}
+	}
+	bNeighs = bData->bNeighs;
 
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
@@ -4971,7 +5017,7 @@ typedef struct DynamicPaintEffectData {
 	const void *prevPoint;
 	const float eff_scale;
 
-	uint8_t *point_locks;
+	float *link_drip;
 
 	const float wave_speed;
 	const float wave_scale;
@@ -5097,6 +5143,68 @@ static int dynamicPaint_prepareEffectStep(
 	return steps;
 }
 
+/*
+ *	Create reverse adjacency data, so effects that push paint to their neighbors
+ *	can gather it from the receiving point instead.
+ */
+static bool dynamicPaint_prepareReverseAdjacency(PaintSurfaceData *sData)
+{
+	PaintAdjData *ad = sData->adj_data;
+	int *r_fill;
+
+	if (ad->r_source)
+		return true;
+
+	ad->r_source = MEM_mallocN(sizeof(int) * ad->total_targets, "Dynamic Paint reverse adj sources");
+	ad->r_link = MEM_mallocN(sizeof(int) * ad->total_targets, "Dynamic Paint reverse adj links");
+	ad->r_index = MEM_mallocN(sizeof(int) * sData->total_points, "Dynamic Paint reverse adj index");
+	ad->r_num = MEM_callocN(sizeof(int) * sData->total_points, "Dynamic Paint reverse adj counts");
+	r_fill = MEM_callocN(sizeof(int) * sData->total_points, "Dynamic Paint reverse adj temp");
+
+	if (!ad->r_source || !ad->r_link || !ad->r_index || !ad->r_num || !r_fill) {
+		MEM_SAFE_FREE(ad->r_source);
+		MEM_SAFE_FREE(ad->r_link);
+		MEM_SAFE_FREE(ad->r_index);
+		MEM_SAFE_FREE(ad->r_num);
+		MEM_SAFE_FREE(r_fill);
+		return false;
+	}
+
+	for (int n_idx = 0; n_idx < ad->total_targets; n_idx++) {
+		ad->r_num[ad->n_target[n_idx]]++;
+	}
+
+	for (int index = 0, pos = 0; index < sData->total_points; index++) {
+		ad->r_index[index] = pos;
+		pos += ad->r_num[index];
+	}
+
+	/* fill in point order, so gathering is done in the same order for any number of threads */
+	for (int index = 0; index < sData->total_points; index++) {
+		for (int i = 0; i < ad->n_num[index]; i++) {
+			const int n_idx = ad->n_index[index] + i;
+			const int target = ad->n_target[n_idx];
+			const int pos = ad->r_index[target] + r_fill[target]++;
+
+			ad->r_source[pos] = index;
+			ad->r_link[pos] = n_idx;
+		}
+	}
+
+	MEM_freeN(r_fill);
+	return true;
+}
+
+/* Swap current and previous surface points, so previous points contain the
+ * latest values. Effect callbacks write every current point. */
+static void dynamic_paint_effect_swap_points(PaintSurfaceData *sData, PaintPoint **prevPoint)
+{
+	PaintPoint *point = sData->type_data;
+
+	sData->type_data = *prevPoint;
+	*prevPoint = point;
+}
+
 /**
  *	Processes active effect step.
  */
@@ -5110,24 +5218,23 @@ static void dynamic_paint_effect_spread_cb(
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
 
+	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
+	const PaintPoint *prevPoint = data->prevPoint;
+
+	*pPoint = prevPoint[index];
+
 	if (sData->adj_data->flags[index] & ADJ_BORDER_PIXEL)
 		return;
 
 	const int numOfNeighs = sData->adj_data->n_num[index];
-	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
-	const PaintPoint *prevPoint = data->prevPoint;
+	const BakeAdjTarget *bTargets = &sData->bData->bTargets[sData->adj_data->n_index[index]];
 	const float eff_scale = data->eff_scale;
 
-	const int *n_index = sData->adj_data->n_index;
-	const int *n_target = sData->adj_data->n_target;
-
 	/*	Loop through neighboring points	*/
 	for (int i = 0; i < numOfNeighs; i++) {
-		const int n_idx = n_index[index] + i;
 		float w_factor;
-		const PaintPoint *pPoint_prev = &prevPoint[n_target[n_idx]];
-		const float speed_scale = (bNeighs[n_idx].dist < eff_scale) ? 1.0f : eff_scale / bNeighs[n_idx].dist;
+		const PaintPoint *pPoint_prev = &prevPoint[bTargets[i].index];
+		const float speed_scale = (bTargets[i].dist < eff_scale) ? 1.0f : eff_scale / bTargets[i].dist;
 		const float color_mix = min_fff(pPoint_prev->wetness, pPoint->wetness, 1.0f) * 0.25f * surface->color_spread_speed;
 
 		/* do color mixing */
@@ -5158,24 +5265,23 @@ static void dynamic_paint_effect_shrink_cb(
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
 
+	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
+	const PaintPoint *prevPoint = data->prevPoint;
+
+	*pPoint = prevPoint[index];
+
 	if (sData->adj_data->flags[index] & ADJ_BORDER_PIXEL)
 		return;
 
 	const int numOfNeighs = sData->adj_data->n_num[index];
-	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
-	const PaintPoint *prevPoint = data->prevPoint;
+	const BakeAdjTarget *bTargets = &sData->bData->bTargets[sData->adj_data->n_index[index]];
 	const float eff_scale = data->eff_scale;
 	float totalAlpha = 0.0f;
 
-	const int *n_index = sData->adj_data->n_index;
-	const int *n_target = sData->adj_data->n_target;
-
 	/*	Loop through neighboring points	*/
 	for (int i = 0; i < numOfNeighs; i++) {
-		const int n_idx = n_index[index] + i;
-		const float speed_scale = (bNeighs[n_idx].dist < eff_scale) ? 1.0f : eff_scale / bNeighs[n_idx].dist;
-		const PaintPoint *pPoint_prev = &prevPoint[n_target[n_idx]];
+		const float speed_scale = (bTargets[i].dist < eff_scale) ? 1.0f : eff_scale / bTargets[i].dist;
+		const PaintPoint *pPoint_prev = &prevPoint[bTargets[i].index];
 		float a_factor, ea_factor, w_factor;
 
 		totalAlpha += pPoint_prev->e_color[3];
@@ -5201,7 +5307,10 @@ static void dynamic_paint_effect_shrink_cb(
 	}
 }
 
-static void dynamic_paint_effect_drip_cb(
+/* Drip is done in three passes so no point is written by more than one thread:
+ * each point stores how much it drips along its neighbor links, every point then
+ * gathers the drips it receives, and finally removes the wetness it gave away. */
+static void dynamic_paint_effect_drip_links_cb(
         void *__restrict userdata,
         const int index,
         const ParallelRangeTLS *__restrict UNUSED(tls))
@@ -5211,31 +5320,29 @@ static void dynamic_paint_effect_drip_cb(
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
 
-	if (sData->adj_data->flags[index] & ADJ_BORDER_PIXEL)
-		return;
-
 	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
 	const PaintPoint *prevPoint = data->prevPoint;
 	const PaintPoint *pPoint_prev = &prevPoint[index];
 	const float *force = data->force;
 	const float eff_scale = data->eff_scale;
-
-	const int *n_target = sData->adj_data->n_target;
-
-	uint8_t *point_locks = data->point_locks;
+	float *link_drip = data->link_drip;
 
 	int closest_id[2];
 	float closest_d[2];
 
+	for (int i = 0; i < sData->adj_data->n_num[index]; i++) {
+		link_drip[sData->adj_data->n_index[index] + i] = 0.0f;
+	}
+
+	if (sData->adj_data->flags[index] & ADJ_BORDER_PIXEL)
+		return;
+
 	/* adjust drip speed depending on wetness */
 	float w_factor = pPoint_prev->wetness - 0.025f;
 	if (w_factor <= 0)
 		return;
 	CLAMP(w_factor, 0.0f, 1.0f);
 
-	float ppoint_wetness_diff = 0.0f;
-
 	/* get force affect points */
 	surface_determineForceTargetPoints(sData, index, &force[index * 4], closest_d, closest_id);
 
@@ -5244,78 +5351,87 @@ static void dynamic_paint_effect_drip_cb(
 		const int n_idx = closest_id[i];
 		if (n_idx != -1 && closest_d[i] > 0.0f) {
 			const float dir_dot = closest_d[i];
+			const float speed_scale = eff_scale * force[index * 4 + 3] / bNeighs[n_idx].dist;
 
-			/* just skip if angle is too extreme */
-			if (dir_dot <= 0.0f)
-				continue;
+			link_drip[n_idx] = min_ff(0.5f, dir_dot * min_ff(speed_scale, 1.0f) * w_factor);
+		}
+	}
+}
 
-			float dir_factor, a_factor;
-			const float speed_scale = eff_scale * force[index * 4 + 3] / bNeighs[n_idx].dist;
+static void dynamic_paint_effect_drip_gather_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const DynamicPaintEffectData *data = userdata;
 
-			const unsigned int n_trgt = (unsigned int)n_target[n_idx];
+	const DynamicPaintSurface *surface = data->surface;
+	const PaintSurfaceData *sData = surface->data;
+	const PaintAdjData *adj_data = sData->adj_data;
 
-			/* Sort of spinlock, but only for given ePoint.
-			 * Since the odds a same ePoint is modified at the same time by several threads is very low, this is
-			 * much more efficient than a global spin lock. */
-			const unsigned int epointlock_idx = n_trgt / 8;
-			const uint8_t epointlock_bitmask = 1 << (n_trgt & 7);  /* 7 == 0b111 */
-			while (atomic_fetch_and_or_uint8(&point_locks[epointlock_idx], epointlock_bitmask) & epointlock_bitmask);
+	PaintPoint *ePoint = &((PaintPoint *)sData->type_data)[index];
+	const PaintPoint *prevPoint = data->prevPoint;
+	float *link_drip = data->link_drip;
 
-			PaintPoint *ePoint = &((PaintPoint *)sData->type_data)[n_trgt];
-			const float e_wet = ePoint->wetness;
+	*ePoint = prevPoint[index];
 
-			dir_factor = min_ff(0.5f, dir_dot * min_ff(speed_scale, 1.0f) * w_factor);
+	for (int i = 0; i < adj_data->r_num[index]; i++) {
+		const int r_idx = adj_data->r_index[index] + i;
+		const int n_idx = adj_data->r_link[r_idx];
+		const float dir_factor = link_drip[n_idx];
 
-			/* mix new wetness */
-			ePoint->wetness += dir_factor;
-			CLAMP(ePoint->wetness, 0.0f, MAX_WETNESS);
+		if (dir_factor <= 0.0f)
+			continue;
 
-			/* mix new color */
-			a_factor = dir_factor / pPoint_prev->wetness;
-			CLAMP(a_factor, 0.0f, 1.0f);
-			mixColors(ePoint->e_color, ePoint->e_color[3], pPoint_prev->e_color, pPoint_prev->e_color[3], a_factor);
-			/* dripping is supposed to preserve alpha level */
-			if (pPoint_prev->e_color[3] > ePoint->e_color[3]) {
-				ePoint->e_color[3] += a_factor * pPoint_prev->e_color[3];
-				CLAMP_MAX(ePoint->e_color[3], pPoint_prev->e_color[3]);
-			}
+		const PaintPoint *pPoint_prev = &prevPoint[adj_data->r_source[r_idx]];
+		const float e_wet = ePoint->wetness;
+		float a_factor;
 
-			/* Decrease paint wetness on current point
-			 * (just store diff here, that way we can only lock current point once at the end to apply it). */
-			ppoint_wetness_diff += (ePoint->wetness - e_wet);
+		/* mix new wetness */
+		ePoint->wetness += dir_factor;
+		CLAMP(ePoint->wetness, 0.0f, MAX_WETNESS);
 
-#ifndef NDEBUG
-			{
-				uint8_t ret = atomic_fetch_and_and_uint8(&point_locks[epointlock_idx], ~epointlock_bitmask);
-				BLI_assert(ret & epointlock_bitmask);
-			}
-#else
-			atomic_fetch_and_and_uint8(&point_locks[epointlock_idx], ~epointlock_bitmask);
-#endif
+		/* mix new color */
+		a_factor = dir_factor / pPoint_prev->wetness;
+		CLAMP(a_factor, 0.0f, 1.0f);
+		mixColors(ePoint->e_color, ePoint->e_color[3], pPoint_prev->e_color, pPoint_prev->e_color[3], a_factor);
+		/* dripping is supposed to preserve alpha level */
+		if (pPoint_prev->e_color[3] > ePoint->e_color[3]) {
+			ePoint->e_color[3] += a_factor * pPoint_prev->e_color[3];
+			CLAMP_MAX(ePoint->e_color[3], pPoint_prev->e_color[3]);
 		}
+
+		/* store actually received wetness, to be removed from the dripping point */
+		link_drip[n_idx] = ePoint->wetness - e_wet;
 	}
+}
 
-	{
-		const unsigned int ppointlock_idx = index / 8;
-		const uint8_t ppointlock_bitmask = 1 << (index & 7);  /* 7 == 0b111 */
-		while (atomic_fetch_and_or_uint8(&point_locks[ppointlock_idx], ppointlock_bitmask) & ppointlock_bitmask);
+static void dynamic_paint_effect_drip_remove_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const DynamicPaintEffectData *data = userdata;
+
+	const DynamicPaintSurface *surface = data->surface;
+	const PaintSurfaceData *sData = surface->data;
+
+	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
+	const float *link_drip = &data->link_drip[sData->adj_data->n_index[index]];
+	float ppoint_wetness_diff = 0.0f;
+
+	for (int i = 0; i < sData->adj_data->n_num[index]; i++) {
+		ppoint_wetness_diff += link_drip[i];
+	}
 
+	if (ppoint_wetness_diff != 0.0f) {
 		pPoint->wetness -= ppoint_wetness_diff;
 		CLAMP(pPoint->wetness, 0.0f, MAX_WETNESS);
-
-#ifndef NDEBUG
-		{
-			uint8_t ret = atomic_fetch_and_and_uint8(&point_locks[ppointlock_idx], ~ppointlock_bitmask);
-			BLI_assert(ret & ppointlock_bitmask);
-		}
-#else
-		atomic_fetch_and_and_uint8(&point_locks[ppointlock_idx], ~ppointlock_bitmask);
-#endif
 	}
 }
 
 static void dynamicPaint_doEffectStep(
-        DynamicPaintSurface *surface, float *force, PaintPoint *prevPoint, float timescale, float steps)
+        DynamicPaintSurface *surface, float *force, PaintPoint **prevPoint, float timescale, float steps)
 {
 	PaintSurfaceData *sData = surface->data;
 
@@ -5331,11 +5447,11 @@ static void dynamicPaint_doEffectStep(
 	if (surface->effect & MOD_DPAINT_EFFECT_DO_SPREAD) {
 		const float eff_scale = distance_scale * EFF_MOVEMENT_PER_FRAME * surface->spread_speed * timescale;
 
-		/* Copy current surface to the previous points array to read unmodified values	*/
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
+		/* Read unmodified values from previous points */
+		dynamic_paint_effect_swap_points(sData, prevPoint);
 
 		DynamicPaintEffectData data = {
-			.surface = surface, .prevPoint = prevPoint, .eff_scale = eff_scale,
+			.surface = surface, .prevPoint = *prevPoint, .eff_scale = eff_scale,
 		};
 		ParallelRangeSettings settings;
 		BLI_parallel_range_settings_defaults(&settings);
@@ -5352,11 +5468,11 @@ static void dynamicPaint_doEffectStep(
 	if (surface->effect & MOD_DPAINT_EFFECT_DO_SHRINK) {
 		const float eff_scale = distance_scale * EFF_MOVEMENT_PER_FRAME * surface->shrink_speed * timescale;
 
-		/* Copy current surface to the previous points array to read unmodified values	*/
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
+		/* Read unmodified values from previous points */
+		dynamic_paint_effect_swap_points(sData, prevPoint);
 
 		DynamicPaintEffectData data = {
-			.surface = surface, .prevPoint = prevPoint, .eff_scale = eff_scale,
+			.surface = surface, .prevPoint = *prevPoint, .eff_scale = eff_scale,
 		};
 		ParallelRangeSettings settings;
 		BLI_parallel_range_settings_defaults(&settings);
@@ -5370,30 +5486,37 @@ static void dynamicPaint_doEffectStep(
 	/*
 	 *	Drip Effect
 	 */
-	if (surface->effect & MOD_DPAINT_EFFECT_DO_DRIP && force) {
+	if (surface->effect & MOD_DPAINT_EFFECT_DO_DRIP && force && dynamicPaint_prepareReverseAdjacency(sData)) {
 		const float eff_scale = distance_scale * EFF_MOVEMENT_PER_FRAME * timescale / 2.0f;
 
-		/* Same as BLI_bitmask, but handled atomicaly as 'ePoint' locks. */
-		const size_t point_locks_size = (sData->total_points / 8) + 1;
-		uint8_t *point_locks = MEM_callocN(sizeof(*point_locks) * point_locks_size, __func__);
+		/* drip amount for each neighbor link */
+		float *link_drip = MEM_mallocN(sizeof(*link_drip) * sData->adj_data->total_targets, __func__);
 
-		/* Copy current surface to the previous points array to read unmodified values	*/
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
+		/* Read unmodified values from previous points */
+		dynamic_paint_effect_swap_points(sData, prevPoint);
 
 		DynamicPaintEffectData data = {
-		    .surface = surface, .prevPoint = prevPoint,
+		    .surface = surface, .prevPoint = *prevPoint,
 		    .eff_scale = eff_scale, .force = force,
-		    .point_locks = point_locks,
+		    .link_drip = link_drip,
 		};
 		ParallelRangeSettings settings;
 		BLI_parallel_range_settings_defaults(&settings);
 		settings.use_threading = (sData->total_points > 1000);
 		BLI_task_parallel_range(0, sData->total_points,
 		                        &data,
-		                        dynamic_paint_effect_drip_cb,
+		                        dynamic_paint_effect_drip_links_cb,
+		                        &settings);
+		BLI_task_parallel_range(0, sData->total_points,
+		                        &data,
+		                        dynamic_paint_effect_drip_gather_cb,
+		                        &settings);
+		BLI_task_parallel_range(0, sData->total_points,
+		                        &data,
+		                        dynamic_paint_effect_drip_remove_cb,
 		                        &settings);
 
-		MEM_freeN(point_locks);
+		MEM_freeN(link_drip);
 	}
 }
 
@@ -5488,7 +5611,6 @@ static void dynamic_paint_wave_step_cb(
 
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
-	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
 	const PaintWavePoint *prevPoint = data->prevPoint;
 
 	const float wave_speed = data->wave_speed;
@@ -5504,18 +5626,18 @@ static void dynamic_paint_wave_step_cb(
 	float force = 0.0f, avg_dist = 0.0f, avg_height = 0.0f, avg_n_height = 0.0f;
 	int numOfN = 0, numOfRN = 0;
 
+	*wPoint = prevPoint[index];
+
 	if (wPoint->state > 0)
 		return;
 
-	const int *n_index = sData->adj_data->n_index;
-	const int *n_target = sData->adj_data->n_target;
+	const BakeAdjTarget *bTargets = &sData->bData->bTargets[sData->adj_data->n_index[index]];
 	const int *adj_flags = sData->adj_data->flags;
 
 	/* calculate force from surrounding points */
 	for (int i = 0; i < numOfNeighs; i++) {
-		const int n_idx = n_index[index] + i;
-		float dist = bNeighs[n_idx].dist * wave_scale;
-		const PaintWavePoint *tPoint = &prevPoint[n_target[n_idx]];
+		float dist = bTargets[i].dist * wave_scale;
+		const PaintWavePoint *tPoint = &prevPoint[bTargets[i].index];
 
 		if (!dist || tPoint->state > 0)
 			continue;
@@ -5525,7 +5647,7 @@ static void dynamic_paint_wave_step_cb(
 		numOfN++;
 
 		/* count average height for edge points for open borders */
-		if (!(adj_flags[n_target[n_idx]] & ADJ_ON_MESH_EDGE)) {
+		if (!(adj_flags[bTargets[i].index] & ADJ_ON_MESH_EDGE)) {
 			avg_n_height += tPoint->height;
 			numOfRN++;
 		}
@@ -5577,15 +5699,14 @@ static void dynamic_paint_wave_step_cb(
 static void dynamicPaint_doWaveStep(DynamicPaintSurface *surface, float timescale)
 {
 	PaintSurfaceData *sData = surface->data;
-	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	int index;
 	int steps, ss;
 	float dt, min_dist, damp_factor;
 	const float wave_speed = surface->wave_speed;
 	const float wave_max_slope = (surface->wave_smoothness >= 0.01f) ? (0.5f / surface->wave_smoothness) : 0.0f;
-	double average_dist = 0.0f;
 	const float canvas_size = getSurfaceDimension(sData);
 	const float wave_scale = CANVAS_REL_SIZE / canvas_size;
+	/* average neigh distance, already calculated with adjacency data */
+	const double average_dist = sData->bData->average_dist * (double)wave_scale;
 
 	/* allocate memory */
 	PaintWavePoint *prevPoint = MEM_mallocN(
@@ -5593,17 +5714,6 @@ static void dynamicPaint_doWaveStep(DynamicPaintSurface *surface, float timescal
 	if (!prevPoint)
 		return;
 
-	/* calculate average neigh distance (single thread) */
-	for (index = 0; index < sData->total_points; index++) {
-		int i;
-		int numOfNeighs = sData->adj_data->n_num[index];
-
-		for (i = 0; i < numOfNeighs; i++) {
-			average_dist += (double)bNeighs[sData->adj_data->n_index[index] + i].dist;
-		}
-	}
-	average_dist  *= (double)wave_scale / sData->adj_data->total_targets;
-
 	/* determine number of required steps */
 	steps = (int)ceil((double)(WAVE_TIME_FAC * timescale * surface->wave_timescale) /
 	                  (average_dist / (double)wave_speed / 3));
@@ -5616,8 +5726,10 @@ static void dynamicPaint_doWaveStep(DynamicPaintSurface *surface, float timescal
 	damp_factor = pow((1.0f - surface->wave_damping), timescale * surface->wave_timescale);
 
 	for (ss = 0; ss < steps; ss++) {
-		/* copy previous frame data */
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(PaintWavePoint));
+		/* swap with previous step data, every point is written by the step */
+		PaintWavePoint *wPoint = sData->type_data;
+		sData->type_data = prevPoint;
+		prevPoint = wPoint;
 
 		DynamicPaintEffectData data = {
 		    .surface = surface, .prevPoint = prevPoint,
@@ -6165,7 +6277,7 @@ static int dynamicPaint_doStep(Scene *scene, Object *ob, DynamicPaintSurface *su
 			/* Prepare effects and get number of required steps */
 			steps = dynamicPaint_prepareEffectStep(surface, scene, ob, &force, timescale);
 			for (s = 0; s < steps; s++) {
-				dynamicPaint_doEffectStep(surface, force, prevPoint, timescale, (float)steps);
+				dynamicPaint_doEffectStep(surface, force, &prevPoint, timescale, (float)steps);
 			}
 
 			/* Free temporary effect data	*/
@@ -40,6 +40,7 @@
 #include "BLI_listbase.h"
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -342,6 +343,8 @@ void BKE_lattice_make_local(Main *bmain, Lattice *lt, const bool lib_local)
 typedef struct LatticeDeformData {
 	Object *object;
 	float *latticedata;
+	/* Weights of the lattice vertex group for every lattice point, NULL when not used. */
+	float *vgroup_weights;
 	float latmat[4][4];
 } LatticeDeformData;
 
@@ -358,6 +361,7 @@ LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
 	float *latticedata;
 	float latmat[4][4];
 	LatticeDeformData *lattice_deform_data;
+	MDeformVert *dvert = BKE_lattice_deform_verts_get(oblatt);
 
 	if (lt->editlatt) lt = lt->editlatt->latt;
 	bp = lt->def;
@@ -402,6 +406,25 @@ LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
 
 	lattice_deform_data = MEM_mallocN(sizeof(LatticeDeformData), "Lattice Deform Data");
 	lattice_deform_data->latticedata = latticedata;
+	lattice_deform_data->vgroup_weights = NULL;
+
+	/* Look up vertex group weights once here, instead of for every deformed point.
+	 * This is redone for every evaluation, one lookup per lattice point, so weight
+	 * edits don't need to invalidate anything. */
+	if (lt->vgroup[0] && dvert) {
+		const int defgrp_index = defgroup_name_index(oblatt, lt->vgroup);
+
+		if (defgrp_index != -1) {
+			const int tot = lt->pntsu * lt->pntsv * lt->pntsw;
+			float *vgroup_weights = MEM_mallocN(sizeof(float) * tot, "lattice vgroup weights");
+			int a;
+
+			for (a = 0; a < tot; a++) {
+				vgroup_weights[a] = defvert_find_weight(dvert + a, defgrp_index);
+			}
+			lattice_deform_data->vgroup_weights = vgroup_weights;
+		}
+	}
 	lattice_deform_data->object = oblatt;
 	copy_m4_m4(lattice_deform_data->latmat, latmat);
 
@@ -418,16 +441,14 @@ void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float
 	int ui, vi, wi, uu, vv, ww;
 
 	/* vgroup influence */
-	int defgrp_index = -1;
+	const float *vgroup_weights = lattice_deform_data->vgroup_weights;
 	float co_prev[3], weight_blend = 0.0f;
-	MDeformVert *dvert = BKE_lattice_deform_verts_get(ob);
 
 
 	if (lt->editlatt) lt = lt->editlatt->latt;
 	if (lattice_deform_data->latticedata == NULL) return;
 
-	if (lt->vgroup[0] && dvert) {
-		defgrp_index = defgroup_name_index(ob, lt->vgroup);
+	if (vgroup_weights) {
 		copy_v3_v3(co_prev, co);
 	}
 
@@ -507,8 +528,8 @@ void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float
 
 							madd_v3_v3fl(co, &lattice_deform_data->latticedata[idx_u * 3], u);
 
-							if (defgrp_index != -1)
-								weight_blend += (u * defvert_find_weight(dvert + idx_u, defgrp_index));
+							if (vgroup_weights)
+								weight_blend += (u * vgroup_weights[idx_u]);
 						}
 					}
 				}
@@ -516,7 +537,7 @@ void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float
 		}
 	}
 
-	if (defgrp_index != -1)
+	if (vgroup_weights)
 		interp_v3_v3v3(co, co_prev, co, weight_blend);
 
 }
@@ -525,6 +546,8 @@ void end_latt_deform(LatticeDeformData *lattice_deform_data)
 {
 	if (lattice_deform_data->latticedata)
 		MEM_freeN(lattice_deform_data->latticedata);
+	if (lattice_deform_data->vgroup_weights)
+		MEM_freeN(lattice_deform_data->vgroup_weights);
 
 	MEM_freeN(lattice_deform_data);
 }
@@ -856,11 +879,38 @@ void curve_deform_vector(Scene *scene, Object *cuOb, Object *target,
 
 }
 
+typedef struct LatticeDeformUserdata {
+	LatticeDeformData *lattice_deform_data;
+	float (*vertexCos)[3];
+	MDeformVert *dvert;
+	int defgrp_index;
+	float fac;
+} LatticeDeformUserdata;
+
+static void lattice_deform_vert_task(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const LatticeDeformUserdata *data = userdata;
+
+	if (data->dvert) {
+		const float weight = defvert_find_weight(data->dvert + index, data->defgrp_index);
+
+		if (weight > 0.0f)
+			calc_latt_deform(data->lattice_deform_data, data->vertexCos[index], weight * data->fac);
+	}
+	else {
+		calc_latt_deform(data->lattice_deform_data, data->vertexCos[index], data->fac);
+	}
+}
+
 void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
                           float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
 {
 	LatticeDeformData *lattice_deform_data;
-	int a;
+	LatticeDeformUserdata data = {NULL};
+	ParallelRangeSettings settings;
 	bool use_vgroups;
 
 	if (laOb->type != OB_LATTICE)
@@ -886,29 +936,26 @@ void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
 		use_vgroups = false;
 	}
 	
+	data.lattice_deform_data = lattice_deform_data;
+	data.vertexCos = vertexCos;
+	data.fac = fac;
+
 	if (vgroup && vgroup[0] && use_vgroups) {
 		Mesh *me = target->data;
-		const int defgrp_index = defgroup_name_index(target, vgroup);
-		float weight;
-
-		if (defgrp_index >= 0 && (me->dvert || dm)) {
-			MDeformVert *dvert = me->dvert;
-			
-			for (a = 0; a < numVerts; a++, dvert++) {
-				if (dm) dvert = dm->getVertData(dm, a, CD_MDEFORMVERT);
 
-				weight = defvert_find_weight(dvert, defgrp_index);
-
-				if (weight > 0.0f)
-					calc_latt_deform(lattice_deform_data, vertexCos[a], weight * fac);
-			}
-		}
-	}
-	else {
-		for (a = 0; a < numVerts; a++) {
-			calc_latt_deform(lattice_deform_data, vertexCos[a], fac);
+		data.defgrp_index = defgroup_name_index(target, vgroup);
+		if (data.defgrp_index < 0) {
+			/* Named vertex group does not exist, nothing is deformed. */
+			end_latt_deform(lattice_deform_data);
+			return;
 		}
+		data.dvert = dm ? dm->getVertDataArray(dm, CD_MDEFORMVERT) : me->dvert;
 	}
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 1024;
+	BLI_task_parallel_range(0, numVerts, &data, lattice_deform_vert_task, &settings);
+
 	end_latt_deform(lattice_deform_data);
 }
 
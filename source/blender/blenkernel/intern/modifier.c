@@ -61,6 +61,7 @@
 #include "BKE_key.h"
 #include "BKE_library.h"
 #include "BKE_library_query.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_multires.h"
 #include "BKE_DerivedMesh.h"
 
@@ -143,6 +144,8 @@ void modifier_free(ModifierData *md)
 	if (mti->freeData) mti->freeData(md);
 	if (md->error) MEM_freeN(md->error);
 
+	BKE_modifier_cache_free_modifier(md);
+
 	MEM_freeN(md);
 }
 
@@ -0,0 +1,577 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/modifier_cache.c
+ *  \ingroup bke
+ *
+ * Cache of constructive modifier results for the viewport modifier stack.
+ *
+ * The key covers everything the result depends on: the input DerivedMesh
+ * (elements and all custom data layers), the non-pointer settings of the
+ * modifier (found with SDNA) and the few object, mesh and scene settings
+ * modifiers read. Modifiers which depend on time, other IDs or have run-time
+ * state are not cached.
+ *
+ * A result is only stored when the modifier had the same key on its previous
+ * evaluation, so inputs which change on every evaluation (animation) are
+ * hashed but never copied into the cache.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_sdna_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
+
+typedef struct ModifierCacheItem {
+	ModifierCacheKey key;
+	DerivedMesh *dm;
+	/* Error set by the modifier while evaluating the result, or NULL. */
+	char *error;
+	MEM_CacheLimiterHandleC *c_handle;
+} ModifierCacheItem;
+
+static MEM_CacheLimiterC *limitor = NULL;
+static GHash *cache_items = NULL;
+/* Key of the last miss of each modifier and apply flag. */
+static GHash *last_keys = NULL;
+static ThreadMutex cache_lock = BLI_MUTEX_INITIALIZER;
+static unsigned int cache_hits = 0;
+static unsigned int cache_misses = 0;
+
+/* ************************************************************************** */
+/* Key */
+
+typedef struct ModifierCacheHash {
+	BLI_HashMurmur2A mm2[2];
+} ModifierCacheHash;
+
+static void modifier_cache_hash_init(ModifierCacheHash *hash)
+{
+	BLI_hash_mm2a_init(&hash->mm2[0], 0);
+	BLI_hash_mm2a_init(&hash->mm2[1], 0x9e3779b9);
+}
+
+static void modifier_cache_hash_add(ModifierCacheHash *hash, const void *data, size_t len)
+{
+	BLI_hash_mm2a_add(&hash->mm2[0], data, len);
+	BLI_hash_mm2a_add(&hash->mm2[1], data, len);
+}
+
+static void modifier_cache_hash_add_int(ModifierCacheHash *hash, int data)
+{
+	BLI_hash_mm2a_add_int(&hash->mm2[0], data);
+	BLI_hash_mm2a_add_int(&hash->mm2[1], data);
+}
+
+static bool modifier_cache_type_supported(ModifierData *md, ModifierApplyFlag flag)
+{
+	if (ELEM(md->type,
+	         /* Have run-time state, or read data outside of the input mesh. */
+	         eModifierType_ParticleSystem, eModifierType_Explode, eModifierType_Fluidsim,
+	         eModifierType_Smoke, eModifierType_DynamicPaint, eModifierType_Ocean,
+	         eModifierType_Multires, eModifierType_MeshSequenceCache,
+	         /* Settings stored outside of the modifier (curve mapping). */
+	         eModifierType_WeightVGEdit))
+	{
+		return false;
+	}
+	if (md->type == eModifierType_Subsurf) {
+		/* The final viewport result is a CCGDM, which keeps the subdivision
+		 * grids and is drawn through them, only orco results are CDDM. */
+		if ((flag & MOD_APPLY_USECACHE) && !(flag & MOD_APPLY_RENDER)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void modifier_cache_id_walk(void *userData, Object *UNUSED(ob), ID **idpoin, int UNUSED(cb_flag))
+{
+	bool *has_ids = userData;
+
+	if (*idpoin) {
+		*has_ids = true;
+	}
+}
+
+static bool modifier_cache_has_ids(ModifierData *md, Object *ob)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	bool has_ids = false;
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_cache_id_walk, &has_ids);
+	}
+	else if (mti->foreachObjectLink) {
+		/* Same cast as in modifiers_foreachIDLink(). */
+		mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_cache_id_walk, &has_ids);
+	}
+	return has_ids;
+}
+
+/* Hash all non-pointer members of a DNA struct, pointers are either IDs
+ * (checked separately) or run-time data. */
+static void modifier_cache_hash_struct(
+        ModifierCacheHash *hash, const SDNA *sdna, int struct_nr, const char *data, int first_member)
+{
+	const short *sp = sdna->structs[struct_nr];
+	const int members = sp[1];
+	int i;
+
+	sp += 2;
+	for (i = 0; i < members; i++, sp += 2) {
+		const char *name = sdna->names[sp[1]];
+		const int array_len = DNA_elem_array_size(name);
+		int size;
+
+		if (name[0] == '*' || (name[0] == '(' && name[1] == '*')) {
+			size = sdna->pointerlen * array_len;
+		}
+		else {
+			const int type_size = sdna->typelens[sp[0]];
+			const int sub_nr = DNA_struct_find_nr(sdna, sdna->types[sp[0]]);
+
+			size = type_size * array_len;
+			if (i < first_member) {
+				/* pass */
+			}
+			else if (sub_nr != -1) {
+				int a;
+				for (a = 0; a < array_len; a++) {
+					modifier_cache_hash_struct(hash, sdna, sub_nr, data + a * type_size, 0);
+				}
+			}
+			else {
+				modifier_cache_hash_add(hash, data, size);
+			}
+		}
+		data += size;
+	}
+}
+
+static bool modifier_cache_hash_customdata(ModifierCacheHash *hash, const CustomData *data, int count)
+{
+	int i;
+
+	modifier_cache_hash_add_int(hash, count);
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		/* Type, flags, active layers and name. */
+		modifier_cache_hash_add(hash, layer, offsetof(CustomDataLayer, data));
+
+		if (layer->data == NULL || ELEM(layer->type, CD_MVERT, CD_MEDGE, CD_MLOOP, CD_MPOLY)) {
+			/* Elements are hashed through the DerivedMesh callbacks. */
+			continue;
+		}
+		else if (layer->type == CD_MDEFORMVERT) {
+			const MDeformVert *dvert = layer->data;
+			int j;
+			for (j = 0; j < count; j++) {
+				modifier_cache_hash_add_int(hash, dvert[j].totweight);
+				if (dvert[j].totweight) {
+					modifier_cache_hash_add(hash, dvert[j].dw, sizeof(*dvert[j].dw) * dvert[j].totweight);
+				}
+			}
+		}
+		else if (ELEM(layer->type, CD_MDISPS, CD_GRID_PAINT_MASK, CD_BM_ELEM_PYPTR)) {
+			/* Layers pointing to other data. */
+			return false;
+		}
+		else {
+			modifier_cache_hash_add(hash, layer->data, (size_t)CustomData_sizeof(layer->type) * count);
+		}
+	}
+	return true;
+}
+
+/**
+ * Calculate the key of the modifier result for given input.
+ *
+ * Returns false when the result can not be cached.
+ */
+bool BKE_modifier_cache_key(
+        ModifierData *md, Object *ob, DerivedMesh *dm,
+        ModifierApplyFlag flag, ModifierCacheKey *r_key)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	const SDNA *sdna = DNA_sdna_current_get();
+	ModifierCacheHash hash;
+	bDeformGroup *defgroup;
+	int struct_nr;
+
+	if (mti->type == eModifierTypeType_OnlyDeform ||
+	    (mti->dependsOnTime && mti->dependsOnTime(md)) ||
+	    !modifier_cache_type_supported(md, flag) ||
+	    modifier_cache_has_ids(md, ob))
+	{
+		return false;
+	}
+
+	struct_nr = (sdna != NULL) ? DNA_struct_find_nr(sdna, mti->structName) : -1;
+	if (struct_nr == -1) {
+		return false;
+	}
+
+	modifier_cache_hash_init(&hash);
+
+	/* Settings, skipping the ModifierData header. */
+	modifier_cache_hash_add_int(&hash, md->type);
+	modifier_cache_hash_add_int(&hash, flag);
+	modifier_cache_hash_struct(&hash, sdna, struct_nr, (const char *)md, 1);
+
+	/* Object, mesh and scene settings used by modifiers. */
+	modifier_cache_hash_add_int(&hash, ob->totcol);
+	for (defgroup = ob->defbase.first; defgroup; defgroup = defgroup->next) {
+		modifier_cache_hash_add(&hash, defgroup->name, strlen(defgroup->name) + 1);
+	}
+	if (ob->type == OB_MESH) {
+		const Mesh *me = ob->data;
+		/* Auto smooth, used for custom normals (normal edit). */
+		modifier_cache_hash_add_int(&hash, me->flag & ME_AUTOSMOOTH);
+		modifier_cache_hash_add(&hash, &me->smoothresh, sizeof(me->smoothresh));
+	}
+	if (md->scene) {
+		modifier_cache_hash_add_int(&hash, md->scene->r.mode & R_SIMPLIFY);
+		modifier_cache_hash_add_int(&hash, md->scene->r.simplify_subsurf);
+		modifier_cache_hash_add_int(&hash, md->scene->r.simplify_subsurf_render);
+	}
+
+	/* Input mesh. */
+	modifier_cache_hash_add_int(&hash, dm->cd_flag);
+	modifier_cache_hash_add(&hash, dm->getVertArray(dm), sizeof(MVert) * dm->getNumVerts(dm));
+	modifier_cache_hash_add(&hash, dm->getEdgeArray(dm), sizeof(MEdge) * dm->getNumEdges(dm));
+	modifier_cache_hash_add(&hash, dm->getLoopArray(dm), sizeof(MLoop) * dm->getNumLoops(dm));
+	modifier_cache_hash_add(&hash, dm->getPolyArray(dm), sizeof(MPoly) * dm->getNumPolys(dm));
+
+	if (!modifier_cache_hash_customdata(&hash, &dm->vertData, dm->numVertData) ||
+	    !modifier_cache_hash_customdata(&hash, &dm->edgeData, dm->numEdgeData) ||
+	    !modifier_cache_hash_customdata(&hash, &dm->loopData, dm->numLoopData) ||
+	    !modifier_cache_hash_customdata(&hash, &dm->polyData, dm->numPolyData))
+	{
+		return false;
+	}
+
+	r_key->md = md;
+	r_key->flag = flag;
+	r_key->hash[0] = BLI_hash_mm2a_end(&hash.mm2[0]);
+	r_key->hash[1] = BLI_hash_mm2a_end(&hash.mm2[1]);
+	r_key->totvert = dm->getNumVerts(dm);
+	r_key->totedge = dm->getNumEdges(dm);
+	r_key->totloop = dm->getNumLoops(dm);
+	r_key->totpoly = dm->getNumPolys(dm);
+	return true;
+}
+
+/* ************************************************************************** */
+/* Storage */
+
+static unsigned int modifier_cache_hashhash(const void *key_v)
+{
+	const ModifierCacheKey *key = key_v;
+
+	return key->hash[0] ^ BLI_ghashutil_ptrhash(key->md);
+}
+
+static bool modifier_cache_hashcmp(const void *a_v, const void *b_v)
+{
+	const ModifierCacheKey *a = a_v;
+	const ModifierCacheKey *b = b_v;
+
+	return (a->md != b->md ||
+	        a->flag != b->flag ||
+	        a->hash[0] != b->hash[0] ||
+	        a->hash[1] != b->hash[1] ||
+	        a->totvert != b->totvert ||
+	        a->totedge != b->totedge ||
+	        a->totloop != b->totloop ||
+	        a->totpoly != b->totpoly);
+}
+
+/* Last keys are looked up by modifier and apply flag only. */
+static unsigned int modifier_cache_last_hashhash(const void *key_v)
+{
+	const ModifierCacheKey *key = key_v;
+
+	return BLI_ghashutil_ptrhash(key->md) ^ (unsigned int)key->flag;
+}
+
+static bool modifier_cache_last_hashcmp(const void *a_v, const void *b_v)
+{
+	const ModifierCacheKey *a = a_v;
+	const ModifierCacheKey *b = b_v;
+
+	return (a->md != b->md || a->flag != b->flag);
+}
+
+static void modifier_cache_item_free(ModifierCacheItem *item)
+{
+	item->dm->needsFree = 1;
+	item->dm->release(item->dm);
+	if (item->error) {
+		MEM_freeN(item->error);
+	}
+	MEM_freeN(item);
+}
+
+/* Called by the cache limiter, with the lock held. */
+static void modifier_cache_destructor(void *p)
+{
+	ModifierCacheItem *item = p;
+
+	BLI_ghash_remove(cache_items, &item->key, NULL, NULL);
+	modifier_cache_item_free(item);
+}
+
+static size_t modifier_cache_customdata_size(const CustomData *data, int count)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		size += (size_t)CustomData_sizeof(data->layers[i].type) * count;
+	}
+	return size;
+}
+
+/* Approximate size of the cached mesh in memory. */
+static size_t modifier_cache_item_size(void *p)
+{
+	ModifierCacheItem *item = p;
+	DerivedMesh *dm = item->dm;
+
+	return (sizeof(ModifierCacheItem) +
+	        modifier_cache_customdata_size(&dm->vertData, dm->numVertData) +
+	        modifier_cache_customdata_size(&dm->edgeData, dm->numEdgeData) +
+	        modifier_cache_customdata_size(&dm->loopData, dm->numLoopData) +
+	        modifier_cache_customdata_size(&dm->polyData, dm->numPolyData));
+}
+
+/**
+ * Get a copy of the cached result, or NULL when there is none. The error the
+ * modifier set when evaluating the result is set again.
+ */
+DerivedMesh *BKE_modifier_cache_get(const ModifierCacheKey *key)
+{
+	ModifierCacheItem *item = NULL;
+	DerivedMesh *dm = NULL;
+
+	BLI_mutex_lock(&cache_lock);
+	if (cache_items) {
+		item = BLI_ghash_lookup(cache_items, key);
+	}
+	if (item) {
+		cache_hits++;
+		MEM_CacheLimiter_touch(item->c_handle);
+		MEM_CacheLimiter_ref(item->c_handle);
+	}
+	else {
+		cache_misses++;
+	}
+	BLI_mutex_unlock(&cache_lock);
+
+	if (item) {
+		/* Referenced items are not freed, copying can happen without the lock. */
+		dm = CDDM_copy(item->dm);
+		if (item->error) {
+			modifier_setError(key->md, "%s", item->error);
+		}
+
+		BLI_mutex_lock(&cache_lock);
+		MEM_CacheLimiter_unref(item->c_handle);
+		BLI_mutex_unlock(&cache_lock);
+	}
+
+	return dm;
+}
+
+/**
+ * Called with the result of a cache miss. A copy of \a dm is stored when the
+ * previous miss of the modifier had the same key, the cache does not take
+ * ownership of \a dm. Only CDDM results are stored, so that a cache hit
+ * returns the same type of DerivedMesh as the modifier.
+ */
+void BKE_modifier_cache_put(const ModifierCacheKey *key, DerivedMesh *dm)
+{
+	ModifierCacheKey *last_key;
+	ModifierCacheItem *item;
+	void **key_p, **val_p;
+
+	if (dm->type != DM_TYPE_CDDM) {
+		return;
+	}
+
+	BLI_mutex_lock(&cache_lock);
+
+	if (limitor == NULL) {
+		limitor = new_MEM_CacheLimiter(modifier_cache_destructor, modifier_cache_item_size);
+		cache_items = BLI_ghash_new(modifier_cache_hashhash, modifier_cache_hashcmp, "Modifier cache hash");
+		last_keys = BLI_ghash_new(modifier_cache_last_hashhash, modifier_cache_last_hashcmp, "Modifier cache last keys");
+	}
+
+	if (!BLI_ghash_ensure_p_ex(last_keys, key, &key_p, &val_p)) {
+		last_key = *key_p = *val_p = MEM_mallocN(sizeof(*last_key), "ModifierCacheKey");
+		*last_key = *key;
+		BLI_mutex_unlock(&cache_lock);
+		return;
+	}
+
+	last_key = *val_p;
+	if (modifier_cache_hashcmp(last_key, key)) {
+		/* Input changed since the last evaluation, wait for it to settle. */
+		*last_key = *key;
+		BLI_mutex_unlock(&cache_lock);
+		return;
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+
+	item = MEM_callocN(sizeof(*item), "ModifierCacheItem");
+	item->key = *key;
+	item->dm = CDDM_copy(dm);
+	/* Owned by the cache, not by whoever releases it first. */
+	item->dm->needsFree = 0;
+	if (key->md->error) {
+		item->error = BLI_strdup(key->md->error);
+	}
+
+	BLI_mutex_lock(&cache_lock);
+
+	if (BLI_ghash_haskey(cache_items, &item->key)) {
+		/* Another thread evaluated the same input meanwhile. */
+		BLI_mutex_unlock(&cache_lock);
+		modifier_cache_item_free(item);
+		return;
+	}
+
+	BLI_ghash_insert(cache_items, &item->key, item);
+	item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+
+	MEM_CacheLimiter_ref(item->c_handle);
+	MEM_CacheLimiter_enforce_limits(limitor);
+	MEM_CacheLimiter_unref(item->c_handle);
+
+	BLI_mutex_unlock(&cache_lock);
+}
+
+/**
+ * Free results of a modifier, called when the modifier itself is freed.
+ */
+void BKE_modifier_cache_free_modifier(const ModifierData *md)
+{
+	GHashIterator gh_iter;
+
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_items) {
+		BLI_ghashIterator_init(&gh_iter, cache_items);
+		while (!BLI_ghashIterator_done(&gh_iter)) {
+			ModifierCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+
+			BLI_ghashIterator_step(&gh_iter);
+
+			if (item->key.md == md) {
+				BLI_ghash_remove(cache_items, &item->key, NULL, NULL);
+				MEM_CacheLimiter_unmanage(item->c_handle);
+				modifier_cache_item_free(item);
+			}
+		}
+	}
+
+	if (last_keys) {
+		BLI_ghashIterator_init(&gh_iter, last_keys);
+		while (!BLI_ghashIterator_done(&gh_iter)) {
+			ModifierCacheKey *last_key = BLI_ghashIterator_getKey(&gh_iter);
+
+			BLI_ghashIterator_step(&gh_iter);
+
+			if (last_key->md == md) {
+				BLI_ghash_remove(last_keys, last_key, MEM_freeN, NULL);
+			}
+		}
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+}
+
+static void modifier_cache_valfree(void *val)
+{
+	ModifierCacheItem *item = val;
+
+	MEM_CacheLimiter_unmanage(item->c_handle);
+	modifier_cache_item_free(item);
+}
+
+void BKE_modifier_cache_free(void)
+{
+	BLI_mutex_lock(&cache_lock);
+
+	if (cache_items) {
+		BLI_ghash_free(cache_items, NULL, modifier_cache_valfree);
+		cache_items = NULL;
+	}
+	if (last_keys) {
+		/* Keys are their own values. */
+		BLI_ghash_free(last_keys, MEM_freeN, NULL);
+		last_keys = NULL;
+	}
+	if (limitor) {
+		delete_MEM_CacheLimiter(limitor);
+		limitor = NULL;
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+}
+
+void BKE_modifier_cache_stats(size_t *r_mem_in_use, unsigned int *r_hits, unsigned int *r_misses)
+{
+	BLI_mutex_lock(&cache_lock);
+
+	*r_mem_in_use = limitor ? MEM_CacheLimiter_get_memory_in_use(limitor) : 0;
+	*r_hits = cache_hits;
+	*r_misses = cache_misses;
+
+	BLI_mutex_unlock(&cache_lock);
+}
@@ -594,7 +594,7 @@ void psys_free(Object *ob, ParticleSystem *psys)
 		
 		BLI_freelistN(&psys->targets);
 
-		BLI_bvhtree_free(psys->bvhtree);
+		psys_spatial_hash_free(psys->spatial_hash);
 		BLI_kdtree_free(psys->tree);
 
 		if (psys->fluid_springs)
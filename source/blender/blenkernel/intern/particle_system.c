@@ -57,6 +57,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_edgehash.h"
+#include "BLI_hash.h"
 #include "BLI_rand.h"
 #include "BLI_jitter.h"
 #include "BLI_math.h"
@@ -94,6 +95,8 @@
 
 #include "RE_shader_ext.h"
 
+#include "atomic_ops.h"
+
 /* fluid sim particle import */
 #ifdef WITH_MOD_FLUID
 #include "DNA_object_fluidsim_types.h"
@@ -103,7 +106,7 @@
 
 #endif // WITH_MOD_FLUID
 
-static ThreadRWMutex psys_bvhtree_rwlock = BLI_RWLOCK_INITIALIZER;
+static ThreadRWMutex psys_spatial_hash_rwlock = BLI_RWLOCK_INITIALIZER;
 
 /************************************************/
 /*			Reacting to system events			*/
@@ -1225,43 +1228,299 @@ void psys_get_pointcache_start_end(Scene *scene, ParticleSystem *psys, int *sfra
 /************************************************/
 /*			Effectors							*/
 /************************************************/
-static void psys_update_particle_bvhtree(ParticleSystem *psys, float cfra)
+/* Uniform grid of fluid particle locations, with the cells hashed into a fixed
+ * number of buckets. Particles of a bucket are sorted by index, so neighbors
+ * are always visited in the same order, independent of the number of threads
+ * used to build the grid or to query it. */
+typedef struct ParticleSpatialHash {
+	float cell_size, inv_cell_size;
+	unsigned int bucket_mask;
+	/* First entry of every bucket, bucket_mask + 2 items. */
+	unsigned int *bucket_start;
+	/* Particle indices and locations, grouped by bucket. */
+	int *index;
+	float (*co)[3];
+	int totpoint;
+} ParticleSpatialHash;
+
+#define SPATIAL_HASH_NONE UINT_MAX
+#define SPATIAL_HASH_COORD_MAX 1000000000
+
+BLI_INLINE int spatial_hash_coord(const ParticleSpatialHash *hash, float f)
+{
+	f = floorf(f * hash->inv_cell_size);
+
+	/* stay in integer range, NaN ends up in cell 0 */
+	if (f >= -SPATIAL_HASH_COORD_MAX && f <= SPATIAL_HASH_COORD_MAX)
+		return (int)f;
+	else if (f > 0.0f)
+		return SPATIAL_HASH_COORD_MAX;
+	else if (f < 0.0f)
+		return -SPATIAL_HASH_COORD_MAX;
+	return 0;
+}
+
+BLI_INLINE unsigned int spatial_hash_bucket(const ParticleSpatialHash *hash, int x, int y, int z)
+{
+	return (((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u)) &
+	       hash->bucket_mask;
+}
+
+BLI_INLINE void spatial_hash_cell(const ParticleSpatialHash *hash, const float co[3], int r_cell[3])
+{
+	r_cell[0] = spatial_hash_coord(hash, co[0]);
+	r_cell[1] = spatial_hash_coord(hash, co[1]);
+	r_cell[2] = spatial_hash_coord(hash, co[2]);
+}
+
+typedef struct SpatialHashBuildData {
+	ParticleSystem *psys;
+	ParticleSpatialHash *hash;
+	float cfra;
+
+	/* Bucket of every particle, SPATIAL_HASH_NONE if it's not in the grid. */
+	unsigned int *particle_bucket;
+	unsigned int *bucket_fill;
+} SpatialHashBuildData;
+
+BLI_INLINE const float *spatial_hash_particle_co(const ParticleData *pa, float cfra)
+{
+	return (pa->state.time == cfra) ? pa->prev_state.co : pa->state.co;
+}
+
+static void spatial_hash_radius_task_cb_ex(
+        void *__restrict userdata,
+        const int p,
+        const ParallelRangeTLS *__restrict tls)
+{
+	SpatialHashBuildData *data = userdata;
+	ParticleData *pa = data->psys->particles + p;
+	float *max_size = tls->userdata_chunk;
+
+	if (!(pa->flag & (PARS_UNEXIST | PARS_NO_DISP)) && pa->alive == PARS_ALIVE) {
+		*max_size = max_ff(*max_size, pa->size);
+	}
+}
+
+static void spatial_hash_radius_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	SpatialHashBuildData *data = userdata;
+	const float *max_size = userdata_chunk;
+
+	data->hash->cell_size = max_ff(data->hash->cell_size, *max_size);
+}
+
+static void spatial_hash_count_task_cb_ex(
+        void *__restrict userdata,
+        const int p,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SpatialHashBuildData *data = userdata;
+	ParticleSpatialHash *hash = data->hash;
+	ParticleData *pa = data->psys->particles + p;
+	unsigned int bucket = SPATIAL_HASH_NONE;
+
+	if (!(pa->flag & (PARS_UNEXIST | PARS_NO_DISP)) && pa->alive == PARS_ALIVE) {
+		int cell[3];
+
+		spatial_hash_cell(hash, spatial_hash_particle_co(pa, data->cfra), cell);
+		bucket = spatial_hash_bucket(hash, cell[0], cell[1], cell[2]);
+		atomic_add_and_fetch_uint32(&hash->bucket_start[bucket + 1], 1);
+	}
+
+	data->particle_bucket[p] = bucket;
+}
+
+static void spatial_hash_insert_task_cb_ex(
+        void *__restrict userdata,
+        const int p,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SpatialHashBuildData *data = userdata;
+	const unsigned int bucket = data->particle_bucket[p];
+
+	if (bucket != SPATIAL_HASH_NONE) {
+		data->hash->index[atomic_fetch_and_add_uint32(&data->bucket_fill[bucket], 1)] = p;
+	}
+}
+
+static void spatial_hash_sort_task_cb_ex(
+        void *__restrict userdata,
+        const int bucket,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SpatialHashBuildData *data = userdata;
+	ParticleSpatialHash *hash = data->hash;
+	const unsigned int start = hash->bucket_start[bucket], end = hash->bucket_start[bucket + 1];
+	unsigned int i, j;
+
+	/* buckets are small, insertion sort is fine */
+	for (i = start + 1; i < end; i++) {
+		const int p = hash->index[i];
+
+		for (j = i; j > start && hash->index[j - 1] > p; j--) {
+			hash->index[j] = hash->index[j - 1];
+		}
+		hash->index[j] = p;
+	}
+
+	for (i = start; i < end; i++) {
+		copy_v3_v3(hash->co[i], spatial_hash_particle_co(data->psys->particles + hash->index[i], data->cfra));
+	}
+}
+
+static ParticleSpatialHash *spatial_hash_build(ParticleSystem *psys, float cfra)
+{
+	ParticleSpatialHash *hash = MEM_callocN(sizeof(ParticleSpatialHash), "ParticleSpatialHash");
+	SPHFluidSettings *fluid = psys->part->fluid;
+	const bool use_threading = (psys->totpart > 1000);
+	const unsigned int totbucket = power_of_2_max_u((unsigned int)max_ii(psys->totpart, 64));
+	ParallelRangeSettings settings;
+	SpatialHashBuildData data = {.psys = psys, .hash = hash, .cfra = cfra};
+	unsigned int i;
+
+	/* Cell size is the largest interaction radius of the fluid particles, so
+	 * that lookups mostly visit the 27 cells around a particle. Lookups with
+	 * other radii give the same results, only slower. */
+	if (fluid && (fluid->flag & SPH_FAC_RADIUS)) {
+		float max_size = psys->part->size;
+
+		hash->cell_size = 0.0f;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = use_threading;
+		settings.userdata_chunk = &max_size;
+		settings.userdata_chunk_size = sizeof(max_size);
+		settings.func_finalize = spatial_hash_radius_finalize;
+		BLI_task_parallel_range(0, psys->totpart, &data, spatial_hash_radius_task_cb_ex, &settings);
+
+		hash->cell_size = fluid->radius * 4.0f * max_ff(hash->cell_size, psys->part->size);
+	}
+	else if (fluid) {
+		hash->cell_size = fluid->radius;
+	}
+
+	if (!(hash->cell_size > FLT_EPSILON)) {
+		hash->cell_size = 1.0f;
+	}
+	hash->inv_cell_size = 1.0f / hash->cell_size;
+
+	hash->bucket_mask = totbucket - 1;
+	hash->bucket_start = MEM_callocN(sizeof(unsigned int) * (totbucket + 1), "spatial hash buckets");
+	data.particle_bucket = MEM_mallocN(sizeof(unsigned int) * max_ii(psys->totpart, 1), "spatial hash particles");
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading;
+	BLI_task_parallel_range(0, psys->totpart, &data, spatial_hash_count_task_cb_ex, &settings);
+
+	for (i = 0; i < totbucket; i++) {
+		hash->bucket_start[i + 1] += hash->bucket_start[i];
+	}
+	hash->totpoint = (int)hash->bucket_start[totbucket];
+
+	hash->index = MEM_mallocN(sizeof(int) * max_ii(hash->totpoint, 1), "spatial hash index");
+	hash->co = MEM_mallocN(sizeof(float[3]) * max_ii(hash->totpoint, 1), "spatial hash co");
+	data.bucket_fill = MEM_dupallocN(hash->bucket_start);
+
+	BLI_task_parallel_range(0, psys->totpart, &data, spatial_hash_insert_task_cb_ex, &settings);
+
+	settings.min_iter_per_thread = 1024;
+	BLI_task_parallel_range(0, (int)totbucket, &data, spatial_hash_sort_task_cb_ex, &settings);
+
+	MEM_freeN(data.bucket_fill);
+	MEM_freeN(data.particle_bucket);
+
+	return hash;
+}
+
+void psys_spatial_hash_free(ParticleSpatialHash *hash)
+{
+	if (hash) {
+		MEM_freeN(hash->bucket_start);
+		MEM_freeN(hash->index);
+		MEM_freeN(hash->co);
+		MEM_freeN(hash);
+	}
+}
+
+static void spatial_hash_bucket_query(
+        const ParticleSpatialHash *hash, unsigned int bucket, const int cell[3],
+        const float co[3], float radius_sq, BVHTree_RangeQuery callback, void *userdata)
+{
+	unsigned int i;
+
+	for (i = hash->bucket_start[bucket]; i < hash->bucket_start[bucket + 1]; i++) {
+		const float dist_sq = len_squared_v3v3(co, hash->co[i]);
+
+		if (dist_sq < radius_sq) {
+			if (cell) {
+				/* other cells can share the bucket */
+				int pcell[3];
+				spatial_hash_cell(hash, hash->co[i], pcell);
+				if (pcell[0] != cell[0] || pcell[1] != cell[1] || pcell[2] != cell[2])
+					continue;
+			}
+			callback(userdata, hash->index[i], co, dist_sq);
+		}
+	}
+}
+
+/* Same as BLI_bvhtree_range_query(), particles are visited in a fixed order. */
+static void spatial_hash_range_query(
+        const ParticleSpatialHash *hash, const float co[3], float radius,
+        BVHTree_RangeQuery callback, void *userdata)
+{
+	const float radius_sq = radius * radius;
+	int min[3], max[3], cell[3];
+	uint64_t totcell = 1;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		min[i] = spatial_hash_coord(hash, co[i] - radius);
+		max[i] = spatial_hash_coord(hash, co[i] + radius);
+		totcell *= (uint64_t)((int64_t)max[i] - min[i] + 1);
+	}
+
+	if (totcell > (uint64_t)hash->bucket_mask + 1) {
+		/* visiting all particles is cheaper */
+		unsigned int bucket;
+		for (bucket = 0; bucket <= hash->bucket_mask; bucket++)
+			spatial_hash_bucket_query(hash, bucket, NULL, co, radius_sq, callback, userdata);
+		return;
+	}
+
+	for (cell[2] = min[2]; cell[2] <= max[2]; cell[2]++) {
+		for (cell[1] = min[1]; cell[1] <= max[1]; cell[1]++) {
+			for (cell[0] = min[0]; cell[0] <= max[0]; cell[0]++) {
+				const unsigned int bucket = spatial_hash_bucket(hash, cell[0], cell[1], cell[2]);
+				spatial_hash_bucket_query(hash, bucket, cell, co, radius_sq, callback, userdata);
+			}
+		}
+	}
+}
+
+static void psys_update_particle_spatial_hash(ParticleSystem *psys, float cfra)
 {
 	if (psys) {
-		PARTICLE_P;
-		int totpart = 0;
 		bool need_rebuild;
 
-		BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-		need_rebuild = !psys->bvhtree || psys->bvhtree_frame != cfra;
-		BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-		
+		BLI_rw_mutex_lock(&psys_spatial_hash_rwlock, THREAD_LOCK_READ);
+		need_rebuild = !psys->spatial_hash || psys->spatial_hash_frame != cfra;
+		BLI_rw_mutex_unlock(&psys_spatial_hash_rwlock);
+
 		if (need_rebuild) {
-			LOOP_SHOWN_PARTICLES {
-				totpart++;
-			}
-			
-			BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_WRITE);
-			
-			BLI_bvhtree_free(psys->bvhtree);
-			psys->bvhtree = BLI_bvhtree_new(totpart, 0.0, 4, 6);
-			
-			LOOP_SHOWN_PARTICLES {
-				if (pa->alive == PARS_ALIVE) {
-					if (pa->state.time == cfra)
-						BLI_bvhtree_insert(psys->bvhtree, p, pa->prev_state.co, 1);
-					else
-						BLI_bvhtree_insert(psys->bvhtree, p, pa->state.co, 1);
-				}
-			}
-			BLI_bvhtree_balance(psys->bvhtree);
-			
-			psys->bvhtree_frame = cfra;
-			
-			BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+			ParticleSpatialHash *hash = spatial_hash_build(psys, cfra);
+
+			BLI_rw_mutex_lock(&psys_spatial_hash_rwlock, THREAD_LOCK_WRITE);
+
+			psys_spatial_hash_free(psys->spatial_hash);
+			psys->spatial_hash = hash;
+			psys->spatial_hash_frame = cfra;
+
+			BLI_rw_mutex_unlock(&psys_spatial_hash_rwlock);
 		}
 	}
 }
+
 void psys_update_particle_tree(ParticleSystem *psys, float cfra)
 {
 	if (psys) {
@@ -1467,6 +1726,42 @@ static ParticleSpring *sph_spring_add(ParticleSystem *psys, ParticleSpring *spri
 
 	return psys->fluid_springs + psys->tot_fluidsprings - 1;
 }
+static void sph_spring_queue(SPHData *sphdata, const ParticleSpring *spring)
+{
+	if (sphdata->tot_new_springs == sphdata->alloc_new_springs) {
+		sphdata->alloc_new_springs = max_ii(sphdata->alloc_new_springs * 2, PSYS_FLUID_SPRINGS_INITIAL_SIZE);
+		sphdata->new_springs = MEM_reallocN_id(
+		        sphdata->new_springs, sphdata->alloc_new_springs * sizeof(ParticleSpring), "Particle New Fluid Springs");
+	}
+
+	sphdata->new_springs[sphdata->tot_new_springs++] = *spring;
+}
+static int sph_spring_cmp(const void *a_v, const void *b_v)
+{
+	const ParticleSpring *a = a_v, *b = b_v;
+
+	if (a->particle_index[0] != b->particle_index[0])
+		return (a->particle_index[0] < b->particle_index[0]) ? -1 : 1;
+	if (a->particle_index[1] != b->particle_index[1])
+		return (a->particle_index[1] < b->particle_index[1]) ? -1 : 1;
+	return 0;
+}
+/* Add queued springs in a fixed order, independent of the threads that created them. */
+static void sph_springs_add_queued(ParticleSystem *psys, SPHData *sphdata)
+{
+	int i;
+
+	if (sphdata->tot_new_springs == 0)
+		return;
+
+	qsort(sphdata->new_springs, sphdata->tot_new_springs, sizeof(ParticleSpring), sph_spring_cmp);
+
+	for (i = 0; i < sphdata->tot_new_springs; i++)
+		sph_spring_add(psys, &sphdata->new_springs[i]);
+
+	MEM_SAFE_FREE(sphdata->new_springs);
+	sphdata->tot_new_springs = sphdata->alloc_new_springs = 0;
+}
 static void sph_spring_delete(ParticleSystem *psys, int j)
 {
 	if (j != psys->tot_fluidsprings - 1)
@@ -1576,11 +1871,12 @@ static void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, float co[3],
 			break;
 		}
 		else {
-			BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-			
-			BLI_bvhtree_range_query(psys[i]->bvhtree, co, interaction_radius, callback, pfr);
-			
-			BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+			BLI_rw_mutex_lock(&psys_spatial_hash_rwlock, THREAD_LOCK_READ);
+
+			if (psys[i]->spatial_hash)
+				spatial_hash_range_query(psys[i]->spatial_hash, co, interaction_radius, callback, pfr);
+
+			BLI_rw_mutex_unlock(&psys_spatial_hash_rwlock);
 		}
 	}
 }
@@ -1750,8 +2046,8 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
 					temp_spring.rest_length = (fluid->flag & SPH_CURRENT_REST_LENGTH) ? rij : rest_length;
 					temp_spring.delete_flag = 0;
 
-					/* sph_spring_add is not thread-safe. - z0r */
-					sph_spring_add(psys[0], &temp_spring);
+					/* sph_spring_add is not thread-safe, queue it for after the step. */
+					sph_spring_queue(sphdata, &temp_spring);
 				}
 			}
 			else {/* PART_SPRING_HOOKES - Hooke's spring force */
@@ -1967,6 +2263,9 @@ void psys_sph_init(ParticleSimulationData *sim, SPHData *sphdata)
 	sphdata->pa = NULL;
 	sphdata->mass = 1.0f;
 
+	sphdata->new_springs = NULL;
+	sphdata->tot_new_springs = sphdata->alloc_new_springs = 0;
+
 	if (sim->psys->part->fluid->solver == SPH_SOLVER_DDR) {
 		sphdata->force_cb = sph_force_cb;
 		sphdata->density_cb = sph_density_accum_cb;
@@ -1987,6 +2286,8 @@ void psys_sph_finalise(SPHData *sphdata)
 		BLI_edgehash_free(sphdata->eh, NULL);
 		sphdata->eh = NULL;
 	}
+
+	MEM_SAFE_FREE(sphdata->new_springs);
 }
 /* Sample the density field at a point in space. */
 void psys_sph_density(BVHTree *tree, SPHData *sphdata, float co[3], float vars[2])
@@ -2635,7 +2936,12 @@ static int collision_detect(ParticleData *pa, ParticleCollision *col, BVHTreeRay
 
 	return hit->index >= 0;
 }
-static int collision_response(ParticleData *pa, ParticleCollision *col, BVHTreeRayHit *hit, int kill, int dynamic_rotation)
+/* rng is used by threads which can't use the global random numbers, NULL otherwise */
+static float collision_frand(RNG *rng)
+{
+	return (rng) ? BLI_rng_get_float(rng) : BLI_frand();
+}
+static int collision_response(ParticleData *pa, ParticleCollision *col, BVHTreeRayHit *hit, int kill, int dynamic_rotation, RNG *rng)
 {
 	ParticleCollisionElement *pce = &col->pce;
 	PartDeflect *pd = col->hit->pd;
@@ -2644,7 +2950,7 @@ static int collision_response(ParticleData *pa, ParticleCollision *col, BVHTreeR
 	float f = col->f + x * (1.0f - col->f);				/* time factor of collision between timestep */
 	float dt1 = (f - col->f) * col->total_time;			/* time since previous collision (in seconds) */
 	float dt2 = (1.0f - f) * col->total_time;			/* time left after collision (in seconds) */
-	int through = (BLI_frand() < pd->pdef_perm) ? 1 : 0; /* did particle pass through the collision surface? */
+	int through = (collision_frand(rng) < pd->pdef_perm) ? 1 : 0; /* did particle pass through the collision surface? */
 
 	/* calculate exact collision location */
 	interp_v3_v3v3(co, col->co1, col->co2, x);
@@ -2669,8 +2975,8 @@ static int collision_response(ParticleData *pa, ParticleCollision *col, BVHTreeR
 		float v0_tan[3];/* tangential component of v0 */
 		float vc_tan[3];/* tangential component of collision surface velocity */
 		float v0_dot, vc_dot;
-		float damp = pd->pdef_damp + pd->pdef_rdamp * 2 * (BLI_frand() - 0.5f);
-		float frict = pd->pdef_frict + pd->pdef_rfrict * 2 * (BLI_frand() - 0.5f);
+		float damp = pd->pdef_damp + pd->pdef_rdamp * 2 * (collision_frand(rng) - 0.5f);
+		float frict = pd->pdef_frict + pd->pdef_rfrict * 2 * (collision_frand(rng) - 0.5f);
 		float distance, nor[3], dot;
 
 		CLAMP(damp,0.0f, 1.0f);
@@ -2833,7 +3139,7 @@ static void collision_fail(ParticleData *pa, ParticleCollision *col)
  * -uses Newton-Rhapson iteration to find the collisions
  * -handles spherical particles and (nearly) point like particles
  */
-static void collision_check(ParticleSimulationData *sim, int p, float dfra, float cfra)
+static void collision_check(ParticleSimulationData *sim, int p, float dfra, float cfra, RNG *rng)
 {
 	ParticleSettings *part = sim->psys->part;
 	ParticleData *pa = sim->psys->particles + p;
@@ -2880,7 +3186,7 @@ static void collision_check(ParticleSimulationData *sim, int p, float dfra, floa
 
 			if (collision_count == PARTICLE_COLLISION_MAX_COLLISIONS)
 				collision_fail(pa, &col);
-			else if (collision_response(pa, &col, &hit, part->flag & PART_DIE_ON_COL, part->flag & PART_ROT_DYN)==0)
+			else if (collision_response(pa, &col, &hit, part->flag & PART_DIE_ON_COL, part->flag & PART_ROT_DYN, rng)==0)
 				return;
 		}
 		else
@@ -3367,6 +3673,9 @@ typedef struct DynamicStepSolverTaskData {
 	float timestep;
 	float dtime;
 
+	/* Collects springs queued on all threads. */
+	SPHData *sphdata;
+
 	SpinLock spin;
 } DynamicStepSolverTaskData;
 
@@ -3395,7 +3704,7 @@ static void dynamics_step_sph_ddr_task_cb_ex(
 	sph_integrate(sim, pa, pa->state.time, sphdata);
 
 	if (sim->colliders)
-		collision_check(sim, p, pa->state.time, data->cfra);
+		collision_check(sim, p, pa->state.time, data->cfra, NULL);
 
 	/* SPH particles are not physical particles, just interpolation
 	 * particles,  thus rotation has not a direct sense for them */
@@ -3406,6 +3715,18 @@ static void dynamics_step_sph_ddr_task_cb_ex(
 	}
 }
 
+static void dynamics_step_sph_ddr_task_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	DynamicStepSolverTaskData *data = userdata;
+	SPHData *sphdata = userdata_chunk;
+	int i;
+
+	for (i = 0; i < sphdata->tot_new_springs; i++)
+		sph_spring_queue(data->sphdata, &sphdata->new_springs[i]);
+
+	MEM_SAFE_FREE(sphdata->new_springs);
+}
+
 static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
         void *__restrict userdata, 
         const int p,
@@ -3466,7 +3787,7 @@ static void dynamics_step_sph_classical_integrate_task_cb_ex(
 	sph_integrate(sim, pa, pa->state.time, sphdata);
 
 	if (sim->colliders)
-		collision_check(sim, p, pa->state.time, data->cfra);
+		collision_check(sim, p, pa->state.time, data->cfra, NULL);
 
 	/* SPH particles are not physical particles, just interpolation
 	 * particles,  thus rotation has not a direct sense for them */
@@ -3477,12 +3798,122 @@ static void dynamics_step_sph_classical_integrate_task_cb_ex(
 	}
 }
 
+/* Brain decisions used by the body pass, see BoidBrainData. */
+typedef struct BoidBrainDecision {
+	float wanted_co[3], wanted_speed;
+	struct Object *goal_ob;
+	float goal_co[3];
+	float goal_nor[3];
+	struct BoidParticle *enemy;
+	float enemy_damage;
+	float jump_vel[3];
+	bool jump;
+} BoidBrainDecision;
+
+static void boid_brain_decision_store(BoidBrainDecision *dec, const BoidBrainData *bbd)
+{
+	copy_v3_v3(dec->wanted_co, bbd->wanted_co);
+	dec->wanted_speed = bbd->wanted_speed;
+	dec->goal_ob = bbd->goal_ob;
+	copy_v3_v3(dec->goal_co, bbd->goal_co);
+	copy_v3_v3(dec->goal_nor, bbd->goal_nor);
+	dec->enemy = bbd->enemy;
+	dec->enemy_damage = bbd->enemy_damage;
+	copy_v3_v3(dec->jump_vel, bbd->jump_vel);
+	dec->jump = bbd->jump;
+}
+
+static void boid_brain_decision_restore(BoidBrainData *bbd, const BoidBrainDecision *dec)
+{
+	copy_v3_v3(bbd->wanted_co, dec->wanted_co);
+	bbd->wanted_speed = dec->wanted_speed;
+	bbd->goal_ob = dec->goal_ob;
+	copy_v3_v3(bbd->goal_co, dec->goal_co);
+	copy_v3_v3(bbd->goal_nor, dec->goal_nor);
+	bbd->enemy = dec->enemy;
+	bbd->enemy_damage = dec->enemy_damage;
+	copy_v3_v3(bbd->jump_vel, dec->jump_vel);
+	bbd->jump = dec->jump;
+}
+
+typedef struct DynamicStepBoidsTaskData {
+	ParticleSimulationData *sim;
+	/* Decisions of every brain, kept for the body pass. */
+	BoidBrainDecision *decisions;
+
+	float cfra;
+	unsigned int seed;
+} DynamicStepBoidsTaskData;
+
+/* Every particle gets its own random sequence, so results don't depend on the
+ * number of threads or the order in which particles are evaluated. The brain
+ * data of the task chunk owns the generator. */
+static void dynamics_step_boids_rng_seed(BoidBrainData *bbd, unsigned int seed)
+{
+	if (bbd->rng == NULL)
+		bbd->rng = BLI_rng_new_srandom(seed);
+	else
+		BLI_rng_srandom(bbd->rng, seed);
+}
+
+static void dynamics_step_boids_brain_task_cb_ex(
+        void *__restrict userdata,
+        const int p,
+        const ParallelRangeTLS *__restrict tls)
+{
+	DynamicStepBoidsTaskData *data = userdata;
+	ParticleData *pa = data->sim->psys->particles + p;
+	BoidBrainData *bbd = tls->userdata_chunk;
+
+	if (pa->state.time <= 0.0f) {
+		return;
+	}
+
+	bbd->goal_ob = NULL;
+	dynamics_step_boids_rng_seed(bbd, BLI_hash_int_2d((unsigned int)p, data->seed));
+
+	boid_brain(bbd, p, pa);
+
+	boid_brain_decision_store(&data->decisions[p], bbd);
+}
+
+static void dynamics_step_boids_body_task_cb_ex(
+        void *__restrict userdata,
+        const int p,
+        const ParallelRangeTLS *__restrict tls)
+{
+	DynamicStepBoidsTaskData *data = userdata;
+	ParticleSimulationData *sim = data->sim;
+	ParticleData *pa = sim->psys->particles + p;
+	BoidBrainData *bbd = tls->userdata_chunk;
+
+	if (pa->state.time <= 0.0f || pa->alive == PARS_DYING) {
+		return;
+	}
+
+	boid_brain_decision_restore(bbd, &data->decisions[p]);
+	dynamics_step_boids_rng_seed(bbd, BLI_hash_int_2d((unsigned int)p, ~data->seed));
+
+	boid_body(bbd, pa);
+
+	/* deflection */
+	if (sim->colliders)
+		collision_check(sim, p, pa->state.time, data->cfra, bbd->rng);
+}
+
+static void dynamics_step_boids_task_finalize(void *__restrict UNUSED(userdata), void *__restrict userdata_chunk)
+{
+	BoidBrainData *bbd = userdata_chunk;
+
+	if (bbd->rng)
+		BLI_rng_free(bbd->rng);
+}
+
 /* unbaked particles are calculated dynamically */
 static void dynamics_step(ParticleSimulationData *sim, float cfra)
 {
 	ParticleSystem *psys = sim->psys;
 	ParticleSettings *part=psys->part;
-	RNG *rng;
 	BoidBrainData bbd;
 	ParticleTexture ptex;
 	PARTICLE_P;
@@ -3510,8 +3941,6 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 	}
 
 	BLI_srandom(31415926 + (int)cfra + psys->seed);
-	/* for now do both, boids us 'rng' */
-	rng = BLI_rng_new_srandom(31415926 + (int)cfra + psys->seed);
 
 	psys_update_effectors(sim);
 
@@ -3528,7 +3957,8 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 			bbd.cfra = cfra;
 			bbd.dfra = dfra;
 			bbd.timestep = timestep;
-			bbd.rng = rng;
+			bbd.goal_ob = NULL;
+			bbd.rng = NULL;
 
 			psys_update_particle_tree(psys, cfra);
 
@@ -3545,11 +3975,11 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 		case PART_PHYS_FLUID:
 		{
 			ParticleTarget *pt = psys->targets.first;
-			psys_update_particle_bvhtree(psys, cfra);
+			psys_update_particle_spatial_hash(psys, cfra);
 			
 			for (; pt; pt=pt->next) {  /* Updating others systems particle tree for fluid-fluid interaction */
 				if (pt->ob)
-					psys_update_particle_bvhtree(BLI_findlink(&pt->ob->particlesystem, pt->psys-1), cfra);
+					psys_update_particle_spatial_hash(BLI_findlink(&pt->ob->particlesystem, pt->psys-1), cfra);
 			}
 			break;
 		}
@@ -3606,7 +4036,7 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 	
 				/* deflection */
 				if (sim->colliders)
-					collision_check(sim, p, pa->state.time, cfra);
+					collision_check(sim, p, pa->state.time, cfra, NULL);
 
 				/* rotations */
 				basic_rotate(part, pa, pa->state.time, timestep);
@@ -3615,19 +4045,41 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 		}
 		case PART_PHYS_BOIDS:
 		{
-			LOOP_DYNAMIC_PARTICLES {
-				bbd.goal_ob = NULL;
-				
-				boid_brain(&bbd, p, pa);
+			DynamicStepBoidsTaskData task_data = {
+			    .sim = sim, .cfra = cfra,
+			    .seed = (unsigned int)(31415926 + (int)cfra + psys->seed),
+			};
 
-				if (pa->alive != PARS_DYING) {
-					boid_body(&bbd, pa);
+			/* every task chunk works on its own copy of the brain data */
+			ParallelRangeSettings settings;
+			BLI_parallel_range_settings_defaults(&settings);
+			settings.use_threading = (psys->totpart > 100);
+			settings.userdata_chunk = &bbd;
+			settings.userdata_chunk_size = sizeof(bbd);
+			settings.func_finalize = dynamics_step_boids_task_finalize;
 
-					/* deflection */
-					if (sim->colliders)
-						collision_check(sim, p, pa->state.time, cfra);
-				}
+			task_data.decisions = MEM_mallocN(sizeof(BoidBrainDecision) * psys->totpart, "BoidBrainDecision");
+
+			/* All brains see the boids as they were at the start of the step,
+			 * damage and jumps are applied afterwards. */
+			BLI_task_parallel_range(
+			        0, psys->totpart,
+			        &task_data,
+			        dynamics_step_boids_brain_task_cb_ex,
+			        &settings);
+
+			LOOP_DYNAMIC_PARTICLES {
+				boid_brain_decision_restore(&bbd, &task_data.decisions[p]);
+				boid_apply_damage(&bbd);
 			}
+
+			BLI_task_parallel_range(
+			        0, psys->totpart,
+			        &task_data,
+			        dynamics_step_boids_body_task_cb_ex,
+			        &settings);
+
+			MEM_freeN(task_data.decisions);
 			break;
 		}
 		case PART_PHYS_FLUID:
@@ -3636,7 +4088,7 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 			psys_sph_init(sim, &sphdata);
 
 			DynamicStepSolverTaskData task_data = {
-			    .sim = sim, .cfra = cfra, .timestep = timestep, .dtime = dtime,
+			    .sim = sim, .cfra = cfra, .timestep = timestep, .dtime = dtime, .sphdata = &sphdata,
 			};
 
 			BLI_spin_init(&task_data.spin);
@@ -3650,12 +4102,14 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 				settings.use_threading = (psys->totpart > 100);
 				settings.userdata_chunk = &sphdata;
 				settings.userdata_chunk_size = sizeof(sphdata);
+				settings.func_finalize = dynamics_step_sph_ddr_task_finalize;
 				BLI_task_parallel_range(
 				        0, psys->totpart,
 				        &task_data,
 				        dynamics_step_sph_ddr_task_cb_ex,
 				        &settings);
 
+				sph_springs_add_queued(psys, &sphdata);
 				sph_springs_modify(psys, timestep);
 			}
 			else {
@@ -3724,7 +4178,6 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 	}
 
 	free_collider_cache(&sim->colliders);
-	BLI_rng_free(rng);
 }
 static void update_children(ParticleSimulationData *sim)
 {
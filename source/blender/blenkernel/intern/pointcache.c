@@ -47,6 +47,7 @@
 #include "DNA_smoke_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_threads.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
@@ -71,10 +72,6 @@
 
 #include "BIK_api.h"
 
-#ifdef WITH_BULLET
-#  include "RBI_api.h"
-#endif
-
 /* both in intern */
 #ifdef WITH_SMOKE
 #include "smoke_API.h"
@@ -105,6 +102,18 @@
 #  include <dirent.h>
 #else
 #  include "BLI_winstuff.h"
+#  include <io.h>  /* _chsize_s */
+#endif
+
+/* single file caches are read through memory maps */
+#ifndef WIN32
+#  define USE_PTCACHE_MMAP
+#endif
+
+#ifdef USE_PTCACHE_MMAP
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
 #endif
 
 #define PTCACHE_DATA_FROM(data, type, from)  \
@@ -141,6 +150,7 @@ static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result,
 static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode);
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size);
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size);
+static void ptcache_file_seek(PTCacheFile *pf, long offset, int origin);
 
 /* Common functions */
 static int ptcache_basic_header_read(PTCacheFile *pf)
@@ -148,10 +158,10 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
 	int error=0;
 
 	/* Custom functions should read these basic elements too! */
-	if (!error && !fread(&pf->totpoint, sizeof(unsigned int), 1, pf->fp))
+	if (!error && !ptcache_file_read(pf, &pf->totpoint, 1, sizeof(unsigned int)))
 		error = 1;
 	
-	if (!error && !fread(&pf->data_types, sizeof(unsigned int), 1, pf->fp))
+	if (!error && !ptcache_file_read(pf, &pf->data_types, 1, sizeof(unsigned int)))
 		error = 1;
 
 	return !error;
@@ -159,10 +169,10 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
 static int ptcache_basic_header_write(PTCacheFile *pf)
 {
 	/* Custom functions should write these basic elements too! */
-	if (!fwrite(&pf->totpoint, sizeof(unsigned int), 1, pf->fp))
+	if (!ptcache_file_write(pf, &pf->totpoint, 1, sizeof(unsigned int)))
 		return 0;
 	
-	if (!fwrite(&pf->data_types, sizeof(unsigned int), 1, pf->fp))
+	if (!ptcache_file_write(pf, &pf->data_types, 1, sizeof(unsigned int)))
 		return 0;
 
 	return 1;
@@ -777,7 +787,7 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 	if (!STREQLEN(version, SMOKE_CACHE_VERSION, 4))
 	{
 		/* reset file pointer */
-		fseek(pf->fp, -4, SEEK_CUR);
+		ptcache_file_seek(pf, -4, SEEK_CUR);
 		return ptcache_smoke_read_old(pf, smoke_v);
 	}
 
@@ -1287,11 +1297,8 @@ static int  ptcache_rigidbody_write(int index, void *rb_v, void **data, int UNUS
 	if (ob && ob->rigidbody_object) {
 		RigidBodyOb *rbo = ob->rigidbody_object;
 		
+		/* transforms are read back from the simulation after every step */
 		if (rbo->type == RBO_TYPE_ACTIVE) {
-#ifdef WITH_BULLET
-			RB_body_get_position(rbo->physics_object, rbo->pos);
-			RB_body_get_orientation(rbo->physics_object, rbo->orn);
-#endif
 			PTCACHE_DATA_FROM(data, BPHYS_DATA_LOCATION, rbo->pos);
 			PTCACHE_DATA_FROM(data, BPHYS_DATA_ROTATION, rbo->orn);
 		}
@@ -1866,12 +1873,787 @@ static int ptcache_filename(PTCacheID *pid, char *filename, int cfra, short do_p
 	return len; /* make sure the above string is always 16 chars */
 }
 
+/* Single file caches.
+ *
+ * All frames of a cache are stored in one file: a header followed by records
+ * of frame number, flag and size, each followed by the frame data in the same
+ * format as files of single frames. Records are only appended, removing a
+ * frame appends a record with the removed flag.
+ *
+ * The frame index is built when the file is first used and updated on writes,
+ * frames are read through a memory map of the file afterwards, without
+ * directory listings or opening of files. */
+
+#define PTCACHE_CONTAINER_VERSION 1
+#define PTCACHE_CONTAINER_REMOVED 1
+
+typedef struct PTCacheContainerRecord {
+	int frame;
+	unsigned int flag;
+	uint64_t size;
+} PTCacheContainerRecord;
+
+typedef struct PTCacheContainerFrame {
+	size_t offset, size;
+} PTCacheContainerFrame;
+
+#ifdef USE_PTCACHE_MMAP
+typedef struct PTCacheContainerMap {
+	struct PTCacheContainerMap *next, *prev;
+	/* NULL once the container is freed while frames are still read from the map. */
+	struct PTCacheContainer *container;
+	void *mem;
+	size_t size;
+	/* Number of open files reading from the map. */
+	int users;
+} PTCacheContainerMap;
+#endif
+
+typedef struct PTCacheContainer {
+	char filename[MAX_PTCACHE_FILE];
+	/* Frame number -> PTCacheContainerFrame. */
+	GHash *index;
+	/* Size of the file covered by the index. */
+	size_t file_size;
+#ifdef USE_PTCACHE_MMAP
+	int file;
+	/* Maps of the file, the last one is the largest. Previous maps are kept
+	 * while frames are still read from them. */
+	ListBase maps;
+#endif
+} PTCacheContainer;
+
+static const char ptcache_container_magic[8] = {'B', 'P', 'H', 'Y', 'S', 'P', 'A', 'K'};
+#define PTCACHE_CONTAINER_HEADER_SIZE (sizeof(ptcache_container_magic) + sizeof(unsigned int))
+
+/* Filename -> PTCacheContainer, for all single file caches in use. */
+static GHash *ptcache_containers = NULL;
+static ThreadMutex ptcache_containers_mutex = BLI_MUTEX_INITIALIZER;
+
+static int ptcache_container_filename(PTCacheID *pid, char *filename)
+{
+	int len;
+
+	if (pid->cache->index < 0)
+		pid->cache->index = pid->stack_index = BKE_object_insert_ptcache(pid->ob);
+
+	len = ptcache_filename(pid, filename, 0, 1, 0);
+	if (len == 0)
+		return 0;
+
+	return len + BLI_snprintf(filename + len, MAX_PTCACHE_FILE - len, "_%02u" PTCACHE_CONTAINER_EXT, pid->stack_index);
+}
+
+static bool ptcache_use_container(PTCacheID *pid)
+{
+	return (pid->file_type == PTCACHE_FILE_PTCACHE) &&
+	       (pid->cache->flag & (PTCACHE_DISK_CACHE | PTCACHE_SINGLE_FILE | PTCACHE_EXTERNAL)) ==
+	       (PTCACHE_DISK_CACHE | PTCACHE_SINGLE_FILE);
+}
+
+static void ptcache_container_free(void *c_v)
+{
+	PTCacheContainer *c = c_v;
+
+#ifdef USE_PTCACHE_MMAP
+	PTCacheContainerMap *map, *map_next;
+
+	for (map = c->maps.first; map; map = map_next) {
+		map_next = map->next;
+
+		if (map->users == 0) {
+			munmap(map->mem, map->size);
+			MEM_freeN(map);
+		}
+		else {
+			/* freed when the last file reading from it is closed */
+			map->container = NULL;
+			map->next = map->prev = NULL;
+		}
+	}
+	BLI_listbase_clear(&c->maps);
+
+	if (c->file != -1)
+		close(c->file);
+#endif
+
+	BLI_ghash_free(c->index, NULL, MEM_freeN);
+	MEM_freeN(c);
+}
+
+#ifdef USE_PTCACHE_MMAP
+/* Unmap maps superseded by a larger one which are not read from anymore. Lock must be held. */
+static void ptcache_container_maps_trim(PTCacheContainer *c)
+{
+	PTCacheContainerMap *map, *map_next;
+
+	for (map = c->maps.first; map && map != c->maps.last; map = map_next) {
+		map_next = map->next;
+
+		if (map->users == 0) {
+			munmap(map->mem, map->size);
+			BLI_freelinkN(&c->maps, map);
+		}
+	}
+}
+
+static void ptcache_container_map_release(PTCacheContainerMap *map)
+{
+	BLI_mutex_lock(&ptcache_containers_mutex);
+
+	map->users--;
+
+	if (map->container) {
+		ptcache_container_maps_trim(map->container);
+	}
+	else if (map->users == 0) {
+		munmap(map->mem, map->size);
+		MEM_freeN(map);
+	}
+
+	BLI_mutex_unlock(&ptcache_containers_mutex);
+}
+#endif
+
+static void ptcache_container_index_record(PTCacheContainer *c, const PTCacheContainerRecord *rec, size_t offset)
+{
+	void *key = SET_INT_IN_POINTER(rec->frame);
+
+	if (rec->flag & PTCACHE_CONTAINER_REMOVED) {
+		BLI_ghash_remove(c->index, key, NULL, MEM_freeN);
+	}
+	else {
+		PTCacheContainerFrame *frame = BLI_ghash_lookup(c->index, key);
+
+		if (frame == NULL) {
+			frame = MEM_mallocN(sizeof(PTCacheContainerFrame), "PTCacheContainerFrame");
+			BLI_ghash_insert(c->index, key, frame);
+		}
+		frame->offset = offset;
+		frame->size = (size_t)rec->size;
+	}
+}
+
+/* Add records written since the last scan to the index. */
+static bool ptcache_container_scan(PTCacheContainer *c, size_t file_size)
+{
+	PTCacheContainerRecord rec;
+	size_t offset = c->file_size;
+	bool ok = true;
+	FILE *fp;
+
+	if (file_size == c->file_size)
+		return true;
+
+	fp = BLI_fopen(c->filename, "rb");
+	if (fp == NULL)
+		return false;
+
+	if (offset == 0) {
+		char magic[sizeof(ptcache_container_magic)];
+		unsigned int version;
+
+		ok = (fread(magic, sizeof(magic), 1, fp) == 1 &&
+		      fread(&version, sizeof(unsigned int), 1, fp) == 1 &&
+		      memcmp(magic, ptcache_container_magic, sizeof(magic)) == 0 &&
+		      version == PTCACHE_CONTAINER_VERSION);
+		offset = PTCACHE_CONTAINER_HEADER_SIZE;
+	}
+	else {
+		ok = (fseek(fp, offset, SEEK_SET) == 0);
+	}
+
+	while (ok && offset + sizeof(rec) <= file_size && fread(&rec, sizeof(rec), 1, fp) == 1) {
+		const size_t data_offset = offset + sizeof(rec);
+
+		/* incomplete record of a write in progress */
+		if (rec.size > file_size - data_offset)
+			break;
+
+		ptcache_container_index_record(c, &rec, data_offset);
+		offset = data_offset + (size_t)rec.size;
+
+		if (fseek(fp, offset, SEEK_SET) != 0)
+			break;
+	}
+
+	fclose(fp);
+
+	c->file_size = offset;
+
+	return ok;
+}
+
+/* Get the up to date container of a file, NULL if the file doesn't exist
+ * (unless it's created) or is not a cache file. Lock must be held. */
+static PTCacheContainer *ptcache_container_get(const char *filename, bool create)
+{
+	PTCacheContainer *c = (ptcache_containers) ? BLI_ghash_lookup(ptcache_containers, filename) : NULL;
+	size_t file_size = BLI_file_size(filename);
+	const bool exists = (file_size != (size_t)-1);
+
+	if (c && (!exists || file_size < c->file_size)) {
+		/* removed or replaced outside of the point cache */
+		BLI_ghash_remove(ptcache_containers, filename, NULL, ptcache_container_free);
+		c = NULL;
+	}
+
+	if (!exists) {
+		const unsigned int version = PTCACHE_CONTAINER_VERSION;
+		FILE *fp;
+
+		if (!create)
+			return NULL;
+
+		BLI_make_existing_file(filename);
+		fp = BLI_fopen(filename, "wb");
+		if (fp == NULL)
+			return NULL;
+
+		fwrite(ptcache_container_magic, sizeof(ptcache_container_magic), 1, fp);
+		fwrite(&version, sizeof(unsigned int), 1, fp);
+		if (fclose(fp) != 0)
+			return NULL;
+
+		file_size = PTCACHE_CONTAINER_HEADER_SIZE;
+	}
+
+	if (c == NULL) {
+		c = MEM_callocN(sizeof(PTCacheContainer), "PTCacheContainer");
+		BLI_strncpy(c->filename, filename, sizeof(c->filename));
+		c->index = BLI_ghash_int_new(__func__);
+#ifdef USE_PTCACHE_MMAP
+		c->file = -1;
+#endif
+
+		if (ptcache_containers == NULL)
+			ptcache_containers = BLI_ghash_str_new(__func__);
+		BLI_ghash_insert(ptcache_containers, c->filename, c);
+	}
+
+	if (!ptcache_container_scan(c, file_size)) {
+		BLI_ghash_remove(ptcache_containers, filename, NULL, ptcache_container_free);
+		return NULL;
+	}
+
+	return c;
+}
+
+/* Point the file to the frame data, returns false if the frame is not cached. */
+static bool ptcache_container_read(const char *filename, int frame, PTCacheFile *pf)
+{
+	PTCacheContainer *c;
+	PTCacheContainerFrame *fra = NULL;
+	bool ok = false;
+
+	BLI_mutex_lock(&ptcache_containers_mutex);
+
+	c = ptcache_container_get(filename, false);
+	if (c)
+		fra = BLI_ghash_lookup(c->index, SET_INT_IN_POINTER(frame));
+
+	if (fra) {
+#ifdef USE_PTCACHE_MMAP
+		PTCacheContainerMap *map = c->maps.last;
+
+		if (map == NULL || map->size < fra->offset + fra->size) {
+			void *mem = MAP_FAILED;
+
+			if (c->file == -1)
+				c->file = BLI_open(c->filename, O_BINARY | O_RDONLY, 0);
+			if (c->file != -1)
+				mem = mmap(NULL, c->file_size, PROT_READ, MAP_SHARED, c->file, 0);
+
+			if (mem != MAP_FAILED) {
+				map = MEM_callocN(sizeof(PTCacheContainerMap), "PTCacheContainerMap");
+				map->container = c;
+				map->mem = mem;
+				map->size = c->file_size;
+				BLI_addtail(&c->maps, map);
+				ptcache_container_maps_trim(c);
+			}
+			else {
+				map = NULL;
+			}
+		}
+
+		if (map) {
+			map->users++;
+			pf->mem_map = map;
+			pf->mem = (unsigned char *)map->mem + fra->offset;
+			pf->mem_size = fra->size;
+			ok = true;
+		}
+#else
+		FILE *fp = BLI_fopen(c->filename, "rb");
+
+		if (fp) {
+			pf->mem_alloc = MEM_mallocN(fra->size, "PTCacheFile data");
+
+			if (fseek(fp, fra->offset, SEEK_SET) == 0 && fread(pf->mem_alloc, 1, fra->size, fp) == fra->size) {
+				pf->mem = pf->mem_alloc;
+				pf->mem_size = fra->size;
+				ok = true;
+			}
+			else {
+				MEM_SAFE_FREE(pf->mem_alloc);
+			}
+			fclose(fp);
+		}
+#endif
+	}
+
+	BLI_mutex_unlock(&ptcache_containers_mutex);
+
+	return ok;
+}
+
+static bool ptcache_container_file_truncate(FILE *fp, size_t size)
+{
+	if (fflush(fp) != 0)
+		return false;
+#ifdef WIN32
+	return (_chsize_s(_fileno(fp), (__int64)size) == 0);
+#else
+	return (ftruncate(fileno(fp), (off_t)size) == 0);
+#endif
+}
+
+static bool ptcache_container_append(const char *filename, int frame, const void *data, size_t size, unsigned int flag)
+{
+	PTCacheContainer *c;
+	bool ok = false;
+
+	BLI_mutex_lock(&ptcache_containers_mutex);
+
+	c = ptcache_container_get(filename, true);
+
+	if (c && (flag & PTCACHE_CONTAINER_REMOVED) && !BLI_ghash_haskey(c->index, SET_INT_IN_POINTER(frame))) {
+		/* nothing to remove */
+		ok = true;
+	}
+	else if (c) {
+		PTCacheContainerRecord rec;
+		FILE *fp = BLI_fopen(filename, "r+b");
+
+		rec.frame = frame;
+		rec.flag = flag;
+		rec.size = size;
+
+		if (fp) {
+			/* write after the indexed records, over an incomplete record of an
+			 * interrupted write, and cut off what is left of that record */
+			ok = (fseek(fp, c->file_size, SEEK_SET) == 0) &&
+			     (fwrite(&rec, sizeof(rec), 1, fp) == 1) &&
+			     (size == 0 || fwrite(data, size, 1, fp) == 1) &&
+			     ptcache_container_file_truncate(fp, c->file_size + sizeof(rec) + size);
+			ok = (fclose(fp) == 0) && ok;
+		}
+
+		if (ok) {
+			ptcache_container_index_record(c, &rec, c->file_size + sizeof(rec));
+			c->file_size += sizeof(rec) + size;
+		}
+		else {
+			/* file is in an unknown state, read it again next time */
+			BLI_ghash_remove(ptcache_containers, filename, NULL, ptcache_container_free);
+		}
+	}
+
+	BLI_mutex_unlock(&ptcache_containers_mutex);
+
+	return ok;
+}
+
+static bool ptcache_container_has_frame(const char *filename, int frame)
+{
+	PTCacheContainer *c;
+	bool has_frame;
+
+	BLI_mutex_lock(&ptcache_containers_mutex);
+	c = ptcache_container_get(filename, false);
+	has_frame = (c && BLI_ghash_haskey(c->index, SET_INT_IN_POINTER(frame)));
+	BLI_mutex_unlock(&ptcache_containers_mutex);
+
+	return has_frame;
+}
+
+/* Array of all cached frames, in no particular order. */
+static int *ptcache_container_frames(const char *filename, int *r_totframe)
+{
+	PTCacheContainer *c;
+	int *frames = NULL;
+
+	*r_totframe = 0;
+
+	BLI_mutex_lock(&ptcache_containers_mutex);
+	c = ptcache_container_get(filename, false);
+
+	if (c && BLI_ghash_size(c->index)) {
+		GHashIterator gh_iter;
+		int i = 0;
+
+		frames = MEM_mallocN(sizeof(int) * BLI_ghash_size(c->index), "ptcache container frames");
+		GHASH_ITER (gh_iter, c->index) {
+			frames[i++] = GET_INT_FROM_POINTER(BLI_ghashIterator_getKey(&gh_iter));
+		}
+		*r_totframe = i;
+	}
+	BLI_mutex_unlock(&ptcache_containers_mutex);
+
+	return frames;
+}
+
+/* Close the file, all of them if filename is NULL. */
+static void ptcache_container_close(const char *filename)
+{
+	BLI_mutex_lock(&ptcache_containers_mutex);
+	if (ptcache_containers) {
+		if (filename) {
+			BLI_ghash_remove(ptcache_containers, filename, NULL, ptcache_container_free);
+		}
+		else {
+			BLI_ghash_free(ptcache_containers, NULL, ptcache_container_free);
+			ptcache_containers = NULL;
+		}
+	}
+	BLI_mutex_unlock(&ptcache_containers_mutex);
+}
+
+/* Background writing of disk cache frames.
+ *
+ * Files written through ptcache_file_open() are recorded in memory and handed
+ * to writer threads on close, which compress and write them in the same format
+ * as synchronous writes. Memory of waiting frames is limited, frames over the
+ * limit are written by the simulation thread itself.
+ *
+ * Reading a frame, checking for its existence or clearing it waits for pending
+ * writes of that file, directory scans wait for all pending writes.
+ *
+ * Frames which could not be written are counted, BKE_ptcache_write_flush()
+ * returns the count so the bake can fail. */
+
+#define PTCACHE_WRITE_MAX_THREADS 4
+#define PTCACHE_WRITE_MAX_MEM     ((size_t)256 * 1024 * 1024)
+
+typedef struct PTCacheWriteChunk {
+	struct PTCacheWriteChunk *next, *prev;
+	unsigned char *data;
+	size_t len, alloc_len;
+	/* Written with ptcache_file_compressed_write() in given mode. */
+	bool compress;
+	int mode;
+} PTCacheWriteChunk;
+
+typedef struct PTCacheWriteJob {
+	struct PTCacheWriteJob *next, *prev;
+	char filename[MAX_PTCACHE_FILE];
+	int frame;
+	/* Frame of a single file cache. */
+	bool container;
+	/* Compression is done when the job is written. */
+	bool deferred;
+	ListBase chunks;
+	size_t mem;
+} PTCacheWriteJob;
+
+static struct {
+	ThreadMutex mutex;
+	ThreadCondition cond;
+	bool cond_initialized;
+
+	ListBase threads;
+	bool threads_started, stop;
+
+	/* Jobs waiting for a writer thread and jobs being written. */
+	ListBase queue, running;
+	/* Memory used by jobs of both lists. */
+	size_t mem;
+	/* Frames which failed to write since the last flush. */
+	int failed;
+} ptcache_writer = {BLI_MUTEX_INITIALIZER};
+
+static void ptcache_write_job_append(PTCacheWriteJob *job, const void *data, size_t len, bool compress, int mode)
+{
+	PTCacheWriteChunk *chunk = job->chunks.last;
+
+	/* consecutive uncompressed writes go into the same chunk */
+	if (compress || chunk == NULL || chunk->compress) {
+		chunk = MEM_callocN(sizeof(PTCacheWriteChunk), "PTCacheWriteChunk");
+		chunk->compress = compress;
+		chunk->mode = mode;
+		BLI_addtail(&job->chunks, chunk);
+	}
+
+	if (chunk->len + len > chunk->alloc_len) {
+		size_t alloc_len = chunk->len + len;
+
+		if (!compress) {
+			alloc_len = max_zz(max_zz(alloc_len, chunk->alloc_len * 2), 4096);
+		}
+
+		job->mem += alloc_len - chunk->alloc_len;
+		chunk->alloc_len = alloc_len;
+		chunk->data = (chunk->data) ?
+		              MEM_reallocN(chunk->data, alloc_len) :
+		              MEM_mallocN(alloc_len, "PTCacheWriteChunk data");
+	}
+
+	memcpy(chunk->data + chunk->len, data, len);
+	chunk->len += len;
+}
+
+static void ptcache_write_job_free_chunks(PTCacheWriteJob *job)
+{
+	PTCacheWriteChunk *chunk;
+
+	for (chunk = job->chunks.first; chunk; chunk = chunk->next) {
+		MEM_SAFE_FREE(chunk->data);
+	}
+	BLI_freelistN(&job->chunks);
+}
+
+static void ptcache_write_job_free(PTCacheWriteJob *job)
+{
+	ptcache_write_job_free_chunks(job);
+	MEM_freeN(job);
+}
+
+static void ptcache_write_job_exec(PTCacheWriteJob *job)
+{
+	PTCacheFile pf = {NULL};
+	PTCacheWriteJob data = {NULL};
+	PTCacheWriteChunk *chunk;
+	int error = 0;
+
+	if (job->container) {
+		/* encode the frame in memory, then append it to the cache file */
+		pf.write_job = &data;
+	}
+	else {
+		pf.fp = BLI_fopen(job->filename, "wb");
+		error = (pf.fp == NULL);
+	}
+
+	if (!error) {
+		for (chunk = job->chunks.first; chunk; chunk = chunk->next) {
+			if (chunk->compress) {
+				unsigned char *out = MEM_mallocN(LZO_OUT_LEN(chunk->len), "pointcache_lzo_buffer");
+				ptcache_file_compressed_write(&pf, chunk->data, (unsigned int)chunk->len, out, chunk->mode);
+				MEM_freeN(out);
+			}
+			else if (!ptcache_file_write(&pf, chunk->data, (unsigned int)chunk->len, sizeof(unsigned char))) {
+				error = 1;
+			}
+		}
+	}
+
+	if (job->container) {
+		chunk = data.chunks.first;
+		if (!ptcache_container_append(job->filename, job->frame, chunk->data, chunk->len, 0))
+			error = 1;
+		ptcache_write_job_free_chunks(&data);
+	}
+	else if (pf.fp) {
+		/* catches failed writes of compressed chunks too */
+		if (ferror(pf.fp))
+			error = 1;
+		if (fclose(pf.fp) != 0)
+			error = 1;
+	}
+
+	if (error) {
+		printf("Error writing frame %d to disk cache '%s'\n", job->frame, job->filename);
+
+		BLI_mutex_lock(&ptcache_writer.mutex);
+		ptcache_writer.failed++;
+		BLI_mutex_unlock(&ptcache_writer.mutex);
+	}
+}
+
+static void *ptcache_writer_thread(void *UNUSED(data))
+{
+	PTCacheWriteJob *job;
+
+	BLI_mutex_lock(&ptcache_writer.mutex);
+	while (true) {
+		job = ptcache_writer.queue.first;
+
+		if (job == NULL) {
+			if (ptcache_writer.stop)
+				break;
+
+			BLI_condition_wait(&ptcache_writer.cond, &ptcache_writer.mutex);
+			continue;
+		}
+
+		BLI_remlink(&ptcache_writer.queue, job);
+		BLI_addtail(&ptcache_writer.running, job);
+		BLI_mutex_unlock(&ptcache_writer.mutex);
+
+		ptcache_write_job_exec(job);
+
+		BLI_mutex_lock(&ptcache_writer.mutex);
+		BLI_remlink(&ptcache_writer.running, job);
+		ptcache_writer.mem -= job->mem;
+		ptcache_write_job_free(job);
+		BLI_condition_notify_all(&ptcache_writer.cond);
+	}
+	BLI_mutex_unlock(&ptcache_writer.mutex);
+
+	return NULL;
+}
+
+static void ptcache_writer_push(PTCacheWriteJob *job)
+{
+	bool async;
+
+	BLI_mutex_lock(&ptcache_writer.mutex);
+
+	/* always allow one frame, so big frames are written in the background too */
+	async = !ptcache_writer.stop &&
+	        (ptcache_writer.mem == 0 || ptcache_writer.mem + job->mem <= PTCACHE_WRITE_MAX_MEM);
+
+	if (async) {
+		if (!ptcache_writer.cond_initialized) {
+			BLI_condition_init(&ptcache_writer.cond);
+			ptcache_writer.cond_initialized = true;
+		}
+
+		if (!ptcache_writer.threads_started) {
+			int tot_thread = min_ii(max_ii(BLI_system_thread_count() - 1, 1), PTCACHE_WRITE_MAX_THREADS);
+			int i;
+
+			BLI_init_threads(&ptcache_writer.threads, ptcache_writer_thread, tot_thread);
+			for (i = 0; i < tot_thread; i++) {
+				BLI_insert_thread(&ptcache_writer.threads, NULL);
+			}
+			ptcache_writer.threads_started = true;
+		}
+
+		BLI_addtail(&ptcache_writer.queue, job);
+		ptcache_writer.mem += job->mem;
+		BLI_condition_notify_all(&ptcache_writer.cond);
+	}
+
+	BLI_mutex_unlock(&ptcache_writer.mutex);
+
+	if (!async) {
+		ptcache_write_job_exec(job);
+		ptcache_write_job_free(job);
+	}
+}
+
+static PTCacheWriteJob *ptcache_writer_find(ListBase *lb, const char *filename, int frame)
+{
+	PTCacheWriteJob *job;
+
+	if (filename == NULL)
+		return lb->first;
+
+	for (job = lb->first; job; job = job->next) {
+		if (job->frame == frame && STREQ(job->filename, filename))
+			return job;
+	}
+	return NULL;
+}
+
+/* Wait until the frame is written, or all frames if filename is NULL. Waiting
+ * jobs are taken over by the calling thread, so this never depends on writer
+ * threads being available. With discard waiting jobs are dropped instead. */
+static void ptcache_writer_wait(const char *filename, int frame, bool discard)
+{
+	PTCacheWriteJob *job;
+
+	BLI_mutex_lock(&ptcache_writer.mutex);
+	while (true) {
+		if ((job = ptcache_writer_find(&ptcache_writer.queue, filename, frame))) {
+			BLI_remlink(&ptcache_writer.queue, job);
+			ptcache_writer.mem -= job->mem;
+			BLI_mutex_unlock(&ptcache_writer.mutex);
+
+			if (!discard)
+				ptcache_write_job_exec(job);
+			ptcache_write_job_free(job);
+
+			BLI_mutex_lock(&ptcache_writer.mutex);
+			BLI_condition_notify_all(&ptcache_writer.cond);
+		}
+		else if (ptcache_writer_find(&ptcache_writer.running, filename, frame)) {
+			BLI_condition_wait(&ptcache_writer.cond, &ptcache_writer.mutex);
+		}
+		else {
+			break;
+		}
+	}
+	BLI_mutex_unlock(&ptcache_writer.mutex);
+}
+
+static bool ptcache_writer_pending(const char *filename, int frame)
+{
+	bool pending;
+
+	BLI_mutex_lock(&ptcache_writer.mutex);
+	pending = (ptcache_writer_find(&ptcache_writer.queue, filename, frame) ||
+	           ptcache_writer_find(&ptcache_writer.running, filename, frame));
+	BLI_mutex_unlock(&ptcache_writer.mutex);
+
+	return pending;
+}
+
+/**
+ * Write all pending frames and stop the writer threads, called when baking
+ * is done and on exit.
+ *
+ * \return The number of frames which failed to write since the last flush.
+ */
+int BKE_ptcache_write_flush(void)
+{
+	ListBase threads = {NULL, NULL};
+	bool threads_started;
+	int failed;
+
+	ptcache_writer_wait(NULL, 0, false);
+
+	/* jobs pushed meanwhile are still written by the threads before they exit */
+	BLI_mutex_lock(&ptcache_writer.mutex);
+	threads_started = ptcache_writer.threads_started;
+	if (threads_started) {
+		threads = ptcache_writer.threads;
+		BLI_listbase_clear(&ptcache_writer.threads);
+		ptcache_writer.threads_started = false;
+		ptcache_writer.stop = true;
+		BLI_condition_notify_all(&ptcache_writer.cond);
+	}
+	BLI_mutex_unlock(&ptcache_writer.mutex);
+
+	if (threads_started) {
+		BLI_end_threads(&threads);
+	}
+
+	BLI_mutex_lock(&ptcache_writer.mutex);
+	ptcache_writer.stop = false;
+	failed = ptcache_writer.failed;
+	ptcache_writer.failed = 0;
+	BLI_mutex_unlock(&ptcache_writer.mutex);
+
+	return failed;
+}
+
+void BKE_ptcache_exit(void)
+{
+	BKE_ptcache_write_flush();
+	ptcache_container_close(NULL);
+}
+
 /* youll need to close yourself after! */
 static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
 {
 	PTCacheFile *pf;
+	PTCacheWriteJob *job = NULL;
 	FILE *fp = NULL;
 	char filename[FILE_MAX * 2];
+	const bool use_container = ptcache_use_container(pid);
 
 #ifndef DURIAN_POINTCACHE_LIB_OK
 	/* don't allow writing for linked objects */
@@ -1880,34 +2662,59 @@ static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
 #endif
 	if (!G.relbase_valid && (pid->cache->flag & PTCACHE_EXTERNAL)==0) return NULL; /* save blend file before using disk pointcache */
 	
-	ptcache_filename(pid, filename, cfra, 1, 1);
+	if (use_container)
+		ptcache_container_filename(pid, filename);
+	else
+		ptcache_filename(pid, filename, cfra, 1, 1);
+
+	pf= MEM_callocN(sizeof(PTCacheFile), "PTCacheFile");
+	pf->old_format = 0;
+	pf->frame = cfra;
 
 	if (mode==PTCACHE_FILE_READ) {
-		fp = BLI_fopen(filename, "rb");
+		ptcache_writer_wait(filename, cfra, false);
+		if (use_container)
+			ptcache_container_read(filename, cfra, pf);
+		else
+			fp = BLI_fopen(filename, "rb");
 	}
 	else if (mode==PTCACHE_FILE_WRITE) {
 		BLI_make_existing_file(filename); /* will create the dir if needs be, same as //textures is created */
-		fp = BLI_fopen(filename, "wb");
-	}
-	else if (mode==PTCACHE_FILE_UPDATE) {
+		ptcache_writer_wait(filename, cfra, true);
+		job = MEM_callocN(sizeof(PTCacheWriteJob), "PTCacheWriteJob");
+		BLI_strncpy(job->filename, filename, sizeof(job->filename));
+		job->frame = cfra;
+		job->container = use_container;
+		job->deferred = true;
+	}
+	else if (mode==PTCACHE_FILE_UPDATE && !use_container) {
 		BLI_make_existing_file(filename);
+		ptcache_writer_wait(filename, cfra, false);
 		fp = BLI_fopen(filename, "rb+");
 	}
 
-	if (!fp)
+	if (!fp && !job && !pf->mem) {
+		MEM_freeN(pf);
 		return NULL;
+	}
 
-	pf= MEM_mallocN(sizeof(PTCacheFile), "PTCacheFile");
 	pf->fp= fp;
-	pf->old_format = 0;
-	pf->frame = cfra;
+	pf->write_job = job;
 
 	return pf;
 }
 static void ptcache_file_close(PTCacheFile *pf)
 {
 	if (pf) {
-		fclose(pf->fp);
+		if (pf->write_job)
+			ptcache_writer_push(pf->write_job);
+		else if (pf->fp)
+			fclose(pf->fp);
+		MEM_SAFE_FREE(pf->mem_alloc);
+#ifdef USE_PTCACHE_MMAP
+		if (pf->mem_map)
+			ptcache_container_map_release(pf->mem_map);
+#endif
 		MEM_freeN(pf);
 	}
 }
@@ -1964,11 +2771,19 @@ static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, uns
 	int r = 0;
 	unsigned char compressed = 0;
 	size_t out_len= 0;
-	unsigned char *props = MEM_callocN(16 * sizeof(char), "tmp");
+	unsigned char *props;
 	size_t sizeOfIt = 5;
 
 	(void)mode; /* unused when building w/o compression */
 
+	if (pf->write_job && pf->write_job->deferred) {
+		/* compressed by the writer thread */
+		ptcache_write_job_append(pf->write_job, in, in_len, true, mode);
+		return 0;
+	}
+
+	props = MEM_callocN(16 * sizeof(char), "tmp");
+
 #ifdef WITH_LZO
 	out_len= LZO_OUT_LEN(in_len);
 	if (mode == 1) {
@@ -1982,7 +2797,7 @@ static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, uns
 	}
 #endif
 #ifdef WITH_LZMA
-	if (mode == 2) {
+	if (mode == PTCACHE_COMPRESS_LZMA) {
 		
 		r = LzmaCompress(out, &out_len, in, in_len, //assume sizeof(char)==1....
 		                 props, &sizeOfIt, 5, 1 << 24, 3, 0, 2, 32, 2);
@@ -1992,6 +2807,16 @@ static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, uns
 		else
 			compressed = 2;
 	}
+	else if (mode == PTCACHE_COMPRESS_LZMA_FAST) {
+		/* fast mode of the lowest level, the stream is read back the same way */
+		r = LzmaCompress(out, &out_len, in, in_len,
+		                 props, &sizeOfIt, 1, 1 << 20, 3, 0, 2, 32, 1);
+
+		if (!(r == SZ_OK) || (out_len >= in_len))
+			compressed = 0;
+		else
+			compressed = 2;
+	}
 #endif
 	
 	ptcache_file_write(pf, &compressed, 1, sizeof(unsigned char));
@@ -2015,10 +2840,36 @@ static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, uns
 }
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size)
 {
+	if (pf->mem) {
+		const size_t len = (size_t)tot * size;
+
+		if (len > pf->mem_size - pf->mem_pos) {
+			pf->mem_pos = pf->mem_size;
+			return 0;
+		}
+
+		memcpy(f, pf->mem + pf->mem_pos, len);
+		pf->mem_pos += len;
+		return 1;
+	}
 	return (fread(f, size, tot, pf->fp) == tot);
 }
+static void ptcache_file_seek(PTCacheFile *pf, long offset, int origin)
+{
+	if (pf->mem) {
+		const size_t pos = (origin == SEEK_SET) ? 0 : pf->mem_pos;
+		pf->mem_pos = min_zz(pos + offset, pf->mem_size);
+	}
+	else {
+		fseek(pf->fp, offset, origin);
+	}
+}
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size)
 {
+	if (pf->write_job) {
+		ptcache_write_job_append(pf->write_job, f, (size_t)tot * size, false, 0);
+		return 1;
+	}
 	return (fwrite(f, size, tot, pf->fp) == tot);
 }
 static int ptcache_file_data_read(PTCacheFile *pf)
@@ -2051,13 +2902,13 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 	
 	pf->data_types = 0;
 	
-	if (fread(bphysics, sizeof(char), 8, pf->fp) != 8)
+	if (!ptcache_file_read(pf, bphysics, 8, sizeof(char)))
 		error = 1;
 	
 	if (!error && !STREQLEN(bphysics, "BPHYSICS", 8))
 		error = 1;
 
-	if (!error && !fread(&typeflag, sizeof(unsigned int), 1, pf->fp))
+	if (!error && !ptcache_file_read(pf, &typeflag, 1, sizeof(unsigned int)))
 		error = 1;
 
 	pf->type = (typeflag & PTCACHE_TYPEFLAG_TYPEMASK);
@@ -2065,7 +2916,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 	
 	/* if there was an error set file as it was */
 	if (error)
-		fseek(pf->fp, 0, SEEK_SET);
+		ptcache_file_seek(pf, 0, SEEK_SET);
 
 	return !error;
 }
@@ -2074,10 +2925,10 @@ static int ptcache_file_header_begin_write(PTCacheFile *pf)
 	const char *bphysics = "BPHYSICS";
 	unsigned int typeflag = pf->type + pf->flag;
 	
-	if (fwrite(bphysics, sizeof(char), 8, pf->fp) != 8)
+	if (!ptcache_file_write(pf, bphysics, 8, sizeof(char)))
 		return 0;
 
-	if (!fwrite(&typeflag, sizeof(unsigned int), 1, pf->fp))
+	if (!ptcache_file_write(pf, &typeflag, 1, sizeof(unsigned int)))
 		return 0;
 	
 	return 1;
@@ -2936,6 +3787,48 @@ int BKE_ptcache_write(PTCacheID *pid, unsigned int cfra)
 
 	return !error;
 }
+static void ptcache_container_clear(PTCacheID *pid, int mode, unsigned int cfra)
+{
+	PointCache *cache = pid->cache;
+	unsigned int sta = cache->startframe;
+	unsigned int end = cache->endframe;
+	char filename[MAX_PTCACHE_FILE];
+	int *frames, totframe, i;
+
+	if (ptcache_container_filename(pid, filename) == 0)
+		return;
+
+	ptcache_writer_wait(NULL, 0, false);
+
+	if (mode == PTCACHE_CLEAR_ALL) {
+		cache->last_exact = MIN2(cache->startframe, 0);
+
+		ptcache_container_close(filename);
+		if (BLI_exists(filename))
+			BLI_delete(filename, false, false);
+
+		if (cache->cached_frames)
+			memset(cache->cached_frames, 0, MEM_allocN_len(cache->cached_frames));
+		return;
+	}
+
+	frames = ptcache_container_frames(filename, &totframe);
+
+	for (i = 0; i < totframe; i++) {
+		const int frame = frames[i];
+
+		if ((mode == PTCACHE_CLEAR_BEFORE && frame < cfra) ||
+		    (mode == PTCACHE_CLEAR_AFTER && frame > cfra))
+		{
+			ptcache_container_append(filename, frame, NULL, 0, PTCACHE_CONTAINER_REMOVED);
+			if (cache->cached_frames && frame >= sta && frame <= end)
+				cache->cached_frames[frame - sta] = 0;
+		}
+	}
+
+	MEM_SAFE_FREE(frames);
+}
+
 /* youll need to close yourself after!
  * mode - PTCACHE_CLEAR_ALL, 
  */
@@ -2978,9 +3871,13 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, unsigned int cfra)
 	case PTCACHE_CLEAR_ALL:
 	case PTCACHE_CLEAR_BEFORE:
 	case PTCACHE_CLEAR_AFTER:
-		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+		if (ptcache_use_container(pid)) {
+			ptcache_container_clear(pid, mode, cfra);
+		}
+		else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 			ptcache_path(pid, path);
 			
+			ptcache_writer_wait(NULL, 0, false);
 			dir = opendir(path);
 			if (dir==NULL)
 				return;
@@ -3066,8 +3963,17 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, unsigned int cfra)
 		
 	case PTCACHE_CLEAR_FRAME:
 		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
-			if (BKE_ptcache_id_exist(pid, cfra)) {
+			if (!BKE_ptcache_id_exist(pid, cfra)) {
+				/* pass */
+			}
+			else if (ptcache_use_container(pid)) {
+				ptcache_container_filename(pid, filename);
+				ptcache_writer_wait(filename, cfra, true);
+				ptcache_container_append(filename, cfra, NULL, 0, PTCACHE_CONTAINER_REMOVED);
+			}
+			else {
 				ptcache_filename(pid, filename, cfra, 1, 1); /* no path */
+				ptcache_writer_wait(filename, cfra, true);
 				BLI_delete(filename, false, false);
 			}
 		}
@@ -3103,10 +4009,16 @@ int  BKE_ptcache_id_exist(PTCacheID *pid, int cfra)
 	
 	if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 		char filename[MAX_PTCACHE_FILE];
+
+		if (ptcache_use_container(pid)) {
+			ptcache_container_filename(pid, filename);
+
+			return ptcache_writer_pending(filename, cfra) || ptcache_container_has_frame(filename, cfra);
+		}
 		
 		ptcache_filename(pid, filename, cfra, 1, 1);
 
-		return BLI_exists(filename);
+		return ptcache_writer_pending(filename, cfra) || BLI_exists(filename);
 	}
 	else {
 		PTCacheMem *pm = pid->cache->mem_cache.first;
@@ -3179,7 +4091,22 @@ void BKE_ptcache_id_time(PTCacheID *pid, Scene *scene, float cfra, int *startfra
 
 		cache->cached_frames = MEM_callocN(sizeof(char) * (cache->endframe-cache->startframe+1), "cached frames array");
 
-		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+		if (ptcache_use_container(pid)) {
+			char filename[MAX_PTCACHE_FILE];
+			int *frames, totframe, i;
+
+			ptcache_writer_wait(NULL, 0, false);
+			ptcache_container_filename(pid, filename);
+			frames = ptcache_container_frames(filename, &totframe);
+
+			for (i = 0; i < totframe; i++) {
+				if (frames[i] >= sta && frames[i] <= end)
+					cache->cached_frames[frames[i] - sta] = 1;
+			}
+
+			MEM_SAFE_FREE(frames);
+		}
+		else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 			/* mode is same as fopen's modes */
 			DIR *dir; 
 			struct dirent *de;
@@ -3192,6 +4119,7 @@ void BKE_ptcache_id_time(PTCacheID *pid, Scene *scene, float cfra, int *startfra
 			
 			len = ptcache_filename(pid, filename, (int)cfra, 0, 0); /* no path */
 			
+			ptcache_writer_wait(NULL, 0, false);
 			dir = opendir(path);
 			if (dir==NULL)
 				return;
@@ -3373,6 +4301,8 @@ void BKE_ptcache_remove(void)
 		DIR *dir; 
 		struct dirent *de;
 
+		ptcache_writer_wait(NULL, 0, false);
+		ptcache_container_close(NULL);
 		dir = opendir(path);
 		if (dir==NULL)
 			return;
@@ -3381,7 +4311,7 @@ void BKE_ptcache_remove(void)
 			if (FILENAME_IS_CURRPAR(de->d_name)) {
 				/* do nothing */
 			}
-			else if (strstr(de->d_name, PTCACHE_EXT)) { /* do we have the right extension?*/
+			else if (strstr(de->d_name, PTCACHE_EXT) || strstr(de->d_name, PTCACHE_CONTAINER_EXT)) { /* do we have the right extension?*/
 				BLI_join_dirfile(path_full, sizeof(path_full), path, de->d_name);
 				BLI_delete(path_full, false, false);
 			}
@@ -3696,6 +4626,12 @@ void BKE_ptcache_bake(PTCacheBaker *baker)
 		CFRA += 1;
 	}
 
+	/* frames are written in the background */
+	baker->failed_frames = BKE_ptcache_write_flush();
+	if (baker->failed_frames) {
+		printf("Bake: %d frames could not be written to the disk cache\n", baker->failed_frames);
+	}
+
 	if (use_timer) {
 		/* start with newline because of \r above */
 		ptcache_dt_to_str(run, PIL_check_seconds_timer()-stime);
@@ -3706,7 +4642,11 @@ void BKE_ptcache_bake(PTCacheBaker *baker)
 	if (pid) {
 		cache->flag &= ~(PTCACHE_BAKING|PTCACHE_REDO_NEEDED);
 		cache->flag |= PTCACHE_SIMULATION_VALID;
-		if (bake) {
+		if (baker->failed_frames && (cache->flag & PTCACHE_DISK_CACHE)) {
+			/* frames are missing on disk, they have to be simulated again */
+			cache->flag |= PTCACHE_OUTDATED;
+		}
+		else if (bake) {
 			cache->flag |= PTCACHE_BAKED;
 			/* write info file */
 			if (cache->flag & PTCACHE_DISK_CACHE)
@@ -3731,7 +4671,10 @@ void BKE_ptcache_bake(PTCacheBaker *baker)
 
 				cache->flag |= PTCACHE_SIMULATION_VALID;
 
-				if (bake) {
+				if (baker->failed_frames && (cache->flag & PTCACHE_DISK_CACHE)) {
+					cache->flag |= PTCACHE_OUTDATED;
+				}
+				else if (bake) {
 					cache->flag |= PTCACHE_BAKED;
 					if (cache->flag & PTCACHE_DISK_CACHE)
 						BKE_ptcache_write(pid, 0);
@@ -3840,6 +4783,80 @@ void BKE_ptcache_toggle_disk_cache(PTCacheID *pid)
 	}
 }
 
+static void ptcache_toggle_single_file_frame(PTCacheID *pid, int cfra)
+{
+	PointCache *cache = pid->cache;
+	PTCacheFile *pf;
+	unsigned char *data = NULL;
+	size_t size = 0;
+
+	/* read frame data from the previous layout as is */
+	cache->flag ^= PTCACHE_SINGLE_FILE;
+	pf = ptcache_file_open(pid, PTCACHE_FILE_READ, cfra);
+	cache->flag ^= PTCACHE_SINGLE_FILE;
+
+	if (pf == NULL)
+		return;
+
+	if (pf->mem) {
+		size = pf->mem_size;
+		data = MEM_mallocN(size, __func__);
+		memcpy(data, pf->mem, size);
+	}
+	else if (fseek(pf->fp, 0, SEEK_END) == 0) {
+		size = (size_t)ftell(pf->fp);
+		data = MEM_mallocN(size, __func__);
+		fseek(pf->fp, 0, SEEK_SET);
+		if (fread(data, 1, size, pf->fp) != size)
+			MEM_SAFE_FREE(data);
+	}
+	ptcache_file_close(pf);
+
+	if (data) {
+		pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, cfra);
+		if (pf) {
+			ptcache_file_write(pf, data, (unsigned int)size, sizeof(unsigned char));
+			ptcache_file_close(pf);
+		}
+		MEM_freeN(data);
+	}
+}
+
+void BKE_ptcache_toggle_single_file(PTCacheID *pid)
+{
+	PointCache *cache = pid->cache;
+	int baked = cache->flag & PTCACHE_BAKED;
+	int last_exact = cache->last_exact;
+	int cfra;
+
+	if ((cache->flag & PTCACHE_DISK_CACHE) == 0 || (cache->flag & PTCACHE_EXTERNAL) || !G.relbase_valid)
+		return;
+
+	if (pid->file_type != PTCACHE_FILE_PTCACHE)
+		return;
+
+	/* copy frames to the new layout, including the info frame */
+	ptcache_toggle_single_file_frame(pid, 0);
+	for (cfra = cache->startframe; cfra <= cache->endframe; cfra++) {
+		if (cfra != 0)
+			ptcache_toggle_single_file_frame(pid, cfra);
+	}
+
+	/* remove the previous layout, bake flag is removed to allow clear */
+	cache->flag &= ~PTCACHE_BAKED;
+	cache->flag ^= PTCACHE_SINGLE_FILE;
+	BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_ALL, 0);
+	cache->flag ^= PTCACHE_SINGLE_FILE;
+	cache->flag |= baked;
+
+	cache->last_exact = last_exact;
+
+	MEM_SAFE_FREE(cache->cached_frames);
+	BKE_ptcache_id_time(pid, NULL, 0.0f, NULL, NULL, NULL);
+
+	BKE_ptcache_update_info(pid);
+}
+
 void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const char *name_dst)
 {
 	char old_name[80];
@@ -3862,6 +4879,7 @@ void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const c
 	len = ptcache_filename(pid, old_filename, 0, 0, 0); /* no path */
 
 	ptcache_path(pid, path);
+	ptcache_writer_wait(NULL, 0, false);
 	dir = opendir(path);
 	if (dir==NULL) {
 		BLI_strncpy(pid->cache->name, old_name, sizeof(pid->cache->name));
@@ -3891,6 +4909,17 @@ void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const c
 	}
 	closedir(dir);
 
+	/* single file cache */
+	ptcache_container_filename(pid, new_path_full);
+	BLI_strncpy(pid->cache->name, name_src, sizeof(pid->cache->name));
+	ptcache_container_filename(pid, old_path_full);
+
+	if (BLI_exists(old_path_full)) {
+		ptcache_container_close(old_path_full);
+		ptcache_container_close(new_path_full);
+		BLI_rename(old_path_full, new_path_full);
+	}
+
 	BLI_strncpy(pid->cache->name, old_name, sizeof(pid->cache->name));
 }
 
@@ -3917,6 +4946,7 @@ void BKE_ptcache_load_external(PTCacheID *pid)
 	
 	len = ptcache_filename(pid, filename, 1, 0, 0); /* no path */
 	
+	ptcache_writer_wait(NULL, 0, false);
 	dir = opendir(path);
 	if (dir==NULL)
 		return;
@@ -41,6 +41,8 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #ifdef WITH_BULLET
 #  include "RBI_api.h"
@@ -901,6 +903,8 @@ void BKE_rigidbody_validate_sim_world(Scene *scene, RigidBodyWorld *rbw, bool re
 
 	RB_dworld_set_solver_iterations(rbw->physics_world, rbw->num_solver_iterations);
 	RB_dworld_set_split_impulse(rbw->physics_world, rbw->flag & RBW_FLAG_USE_SPLIT_IMPULSE);
+	RB_dworld_set_num_threads(rbw->physics_world,
+	                          (rbw->flag & RBW_FLAG_USE_PARALLEL_SOLVER) ? BLI_system_thread_count() : 1);
 }
 
 /* ************************************** */
@@ -1444,6 +1448,35 @@ static void rigidbody_update_simulation_post_step(RigidBodyWorld *rbw)
 	}
 }
 
+static void rigidbody_update_transforms_from_sim_task(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	RigidBodyWorld *rbw = userdata;
+	Object *ob = rbw->objects[i];
+
+	if (ob && ob->rigidbody_object) {
+		RigidBodyOb *rbo = ob->rigidbody_object;
+
+		if (rbo->type == RBO_TYPE_ACTIVE && rbo->physics_object) {
+			RB_body_get_position(rbo->physics_object, rbo->pos);
+			RB_body_get_orientation(rbo->physics_object, rbo->orn);
+		}
+	}
+}
+
+/* Read back transforms of all active bodies in one pass, so the cache and object
+ * sync only have to read rbo->pos and rbo->orn */
+static void rigidbody_update_transforms_from_sim(RigidBodyWorld *rbw)
+{
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 1024;
+
+	BLI_task_parallel_range(0, rbw->numbodies, rbw, rigidbody_update_transforms_from_sim_task, &settings);
+}
+
 bool BKE_rigidbody_check_sim_running(RigidBodyWorld *rbw, float ctime)
 {
 	return (rbw && (rbw->flag & RBW_FLAG_MUTED) == 0 && ctime > rbw->pointcache->startframe);
@@ -1625,6 +1658,7 @@ void BKE_rigidbody_do_simulation(Scene *scene, float ctime)
 	if (can_simulate) {
 		/* write cache for first frame when on second frame */
 		if (rbw->ltime == startframe && (cache->flag & PTCACHE_OUTDATED || cache->last_exact == 0)) {
+			rigidbody_update_transforms_from_sim(rbw);
 			BKE_ptcache_write(&pid, startframe);
 		}
 
@@ -1637,6 +1671,7 @@ void BKE_rigidbody_do_simulation(Scene *scene, float ctime)
 		RB_dworld_step_simulation(rbw->physics_world, timestep, INT_MAX, 1.0f / (float)rbw->steps_per_second * min_ff(rbw->time_scale, 1.0f));
 
 		rigidbody_update_simulation_post_step(rbw);
+		rigidbody_update_transforms_from_sim(rbw);
 
 		/* write cache for current frame */
 		BKE_ptcache_validate(cache, (int)ctime);
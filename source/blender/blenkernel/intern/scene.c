@@ -2099,6 +2099,91 @@ void BKE_scene_update_for_newframe_ex(EvaluationContext *eval_ctx, Main *bmain,
 #endif
 }
 
+/* Frame change update of a private copy of the database, used by frame-parallel
+ * evaluation (see BKE_scene_frames_evaluate_parallel()).
+ *
+ * Safe to be called from a non-main thread as long as nothing else accesses
+ * bmain: no handlers are run and neither sound nor editors are updated.
+ */
+void BKE_scene_update_for_newframe_isolated(EvaluationContext *eval_ctx, Main *bmain, Scene *sce, unsigned int lay)
+{
+	float ctime = BKE_scene_frame_get(sce);
+	Scene *sce_iter;
+#ifdef WITH_LEGACY_DEPSGRAPH
+	bool use_new_eval = !DEG_depsgraph_use_legacy();
+#endif
+
+	BKE_image_update_frame(bmain, sce->r.cfra);
+
+	for (sce_iter = sce; sce_iter; sce_iter = sce_iter->set)
+		DAG_scene_relations_update(bmain, sce_iter);
+
+#ifdef WITH_LEGACY_DEPSGRAPH
+	if (!use_new_eval) {
+		DAG_scene_update_flags(bmain, sce, lay, true, false);
+		BKE_mask_evaluate_all_masks(bmain, ctime, true);
+	}
+#endif
+
+#ifdef POSE_ANIMATION_WORKAROUND
+	scene_armature_depsgraph_workaround(bmain);
+#endif
+
+#ifdef WITH_LEGACY_DEPSGRAPH
+	if (!use_new_eval) {
+		BKE_animsys_evaluate_all_animation(bmain, sce, ctime);
+	}
+#endif
+
+	BKE_main_id_tag_idcode(bmain, ID_MA, LIB_TAG_DOIT, false);
+	BKE_main_id_tag_idcode(bmain, ID_LA, LIB_TAG_DOIT, false);
+
+#ifdef WITH_LEGACY_DEPSGRAPH
+	if (use_new_eval) {
+		DEG_evaluate_on_framechange(eval_ctx, bmain, sce->depsgraph, ctime, lay);
+	}
+	else {
+		scene_update_tagged_recursive(eval_ctx, bmain, sce, sce);
+		scene_depsgraph_hack(eval_ctx, sce, sce);
+	}
+#else
+	DEG_evaluate_on_framechange(eval_ctx, bmain, sce->depsgraph, ctime, lay);
+#endif
+
+	DAG_ids_clear_recalc(bmain);
+}
+
+/* Frame change update of the given targets and everything they depend on, for
+ * tools which need a few evaluated objects on many frames. Only available with
+ * the new dependency graph. The rest of the scene is left as it is, and brought
+ * up to date by the next regular update.
+ */
+void BKE_scene_update_targets_for_newframe(EvaluationContext *eval_ctx, Main *bmain, Scene *sce, unsigned int lay,
+                                           const DEGEvalTarget *targets, int num_targets)
+{
+	float ctime = BKE_scene_frame_get(sce);
+	Scene *sce_iter;
+
+	BLI_assert(!DEG_depsgraph_use_legacy());
+
+	BKE_image_update_frame(bmain, sce->r.cfra);
+
+	for (sce_iter = sce; sce_iter; sce_iter = sce_iter->set)
+		DAG_scene_relations_update(bmain, sce_iter);
+
+	/* Update animated cache files for modifiers. */
+	BKE_cachefile_update_frame(bmain, sce, ctime, (((double)sce->r.frs_sec) / (double)sce->r.frs_sec_base));
+
+#ifdef POSE_ANIMATION_WORKAROUND
+	scene_armature_depsgraph_workaround(bmain);
+#endif
+
+	BKE_main_id_tag_idcode(bmain, ID_MA, LIB_TAG_DOIT, false);
+	BKE_main_id_tag_idcode(bmain, ID_LA, LIB_TAG_DOIT, false);
+
+	DEG_evaluate_targets_on_framechange(eval_ctx, bmain, sce->depsgraph, ctime, lay, targets, num_targets);
+}
+
 /* return default layer, also used to patch old files */
 SceneRenderLayer *BKE_scene_add_render_layer(Scene *sce, const char *name)
 {
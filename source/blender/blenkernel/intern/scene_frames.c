@@ -0,0 +1,360 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 by Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/scene_frames.c
+ *  \ingroup bke
+ *
+ * Frame-parallel evaluation of scenes without simulations, used by exporters.
+ *
+ * The database is copied once per thread (through an in-memory .blend file,
+ * same as undo does), every copy evaluates its own share of the frames and
+ * the results are handed to the caller on its own thread in frame order.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+
+#include "BKE_animsys.h"
+#include "BKE_depsgraph.h"
+#include "BKE_global.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_modifier.h"
+#include "BKE_pointcache.h"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+typedef struct SceneFramesState {
+	const double *frames;
+	int num_frames;
+	int num_copies;
+	unsigned int lay;
+
+	ThreadMutex mutex;
+	ThreadCondition cond;
+	bool stop;
+} SceneFramesState;
+
+typedef struct SceneFramesCopy {
+	SceneFramesState *state;
+	Main *bmain;
+	Scene *scene;
+	/* Original object -> object in this copy. */
+	GHash *object_map;
+	/* Index of the first frame evaluated by this copy, then every
+	 * num_copies'th frame. */
+	int first_frame;
+	/* Frame was evaluated and is waiting for the caller. */
+	bool ready;
+} SceneFramesCopy;
+
+/* ************************************************************************** */
+/* Checks */
+
+static void scene_frames_check_drivers_cb(ID *UNUSED(id), AnimData *adt, void *user_data)
+{
+	bool *has_python_drivers = user_data;
+	FCurve *fcu;
+
+	for (fcu = adt->drivers.first; fcu; fcu = fcu->next) {
+		if (fcu->driver && fcu->driver->type == DRIVER_TYPE_PYTHON) {
+			*has_python_drivers = true;
+		}
+	}
+}
+
+static bool scene_frames_check_object(Scene *scene, Object *ob)
+{
+	ListBase pidlist;
+	ModifierData *md;
+	bool has_cache;
+
+	/* Text uses the font library, which is not thread safe. */
+	if (ob->type == OB_FONT) {
+		return false;
+	}
+	if (ob->rigidbody_object || ob->rigidbody_constraint) {
+		return false;
+	}
+
+	/* Simulations depend on previous frames. */
+	BKE_ptcache_ids_from_object(&pidlist, ob, scene, 0);
+	has_cache = !BLI_listbase_is_empty(&pidlist);
+	BLI_freelistN(&pidlist);
+	if (has_cache) {
+		return false;
+	}
+
+	for (md = ob->modifiers.first; md; md = md->next) {
+		if (ELEM(md->type,
+		         /* Keep state of the previous frame. */
+		         eModifierType_Collision, eModifierType_Surface,
+		         /* Read external files, or have global state. */
+		         eModifierType_Fluidsim, eModifierType_Ocean,
+		         eModifierType_MeshCache, eModifierType_MeshSequenceCache))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Check whether frames of the scene can be evaluated independently of each
+ * other, on copies of the database.
+ */
+bool BKE_scene_frames_parallel_check(Main *bmain, Scene *scene)
+{
+	Scene *sce_iter;
+	Object *ob;
+	bool has_python_drivers = false;
+
+	/* Linked data is not part of the in-memory copy. */
+	if (!BLI_listbase_is_empty(&bmain->library) ||
+	    !BLI_listbase_is_empty(&bmain->cachefiles))
+	{
+		return false;
+	}
+
+	for (sce_iter = scene; sce_iter; sce_iter = sce_iter->set) {
+		if (sce_iter->rigidbody_world) {
+			return false;
+		}
+	}
+
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		if (!scene_frames_check_object(scene, ob)) {
+			return false;
+		}
+	}
+
+	/* Python is bound to the original database. */
+	BKE_animdata_main_cb(bmain, scene_frames_check_drivers_cb, &has_python_drivers);
+	return !has_python_drivers;
+}
+
+/* ************************************************************************** */
+/* Database copies */
+
+static bool scene_frames_copy_init(SceneFramesCopy *copy, Main *bmain, Scene *scene, MemFile *memfile)
+{
+	Main *oldmain = BKE_main_new();
+	BlendFileData *bfd = BLO_read_from_memfile(oldmain, bmain->name, memfile, NULL, BLO_READ_SKIP_USERDEF);
+	Object *ob, *ob_copy;
+	Scene *sce_iter;
+
+	BKE_main_free(oldmain);
+
+	if (bfd == NULL) {
+		return false;
+	}
+
+	copy->bmain = bfd->main;
+	if (bfd->user) {
+		MEM_freeN(bfd->user);
+	}
+	MEM_freeN(bfd);
+
+	copy->bmain->eval_ctx->mode = bmain->eval_ctx->mode;
+	copy->scene = BLI_findstring(&copy->bmain->scene, scene->id.name, offsetof(ID, name));
+	if (copy->scene == NULL) {
+		return false;
+	}
+
+	/* Objects are written and read in the same order. */
+	copy->object_map = BLI_ghash_ptr_new_ex(__func__, BLI_listbase_count(&bmain->object));
+	for (ob = bmain->object.first, ob_copy = copy->bmain->object.first;
+	     ob && ob_copy;
+	     ob = ob->id.next, ob_copy = ob_copy->id.next)
+	{
+		if (!STREQ(ob->id.name, ob_copy->id.name)) {
+			return false;
+		}
+		BLI_ghash_insert(copy->object_map, ob, ob_copy);
+	}
+	if (ob || ob_copy) {
+		return false;
+	}
+
+	/* Relations are built here, before any evaluation thread starts. */
+	for (sce_iter = copy->scene; sce_iter; sce_iter = sce_iter->set) {
+		DAG_scene_relations_update(copy->bmain, sce_iter);
+	}
+
+	return true;
+}
+
+static void scene_frames_copy_free(SceneFramesCopy *copy)
+{
+	if (copy->object_map) {
+		BLI_ghash_free(copy->object_map, NULL, NULL);
+	}
+	if (copy->bmain) {
+		BKE_main_free(copy->bmain);
+	}
+}
+
+/* ************************************************************************** */
+/* Evaluation */
+
+static void *scene_frames_thread(void *data)
+{
+	SceneFramesCopy *copy = data;
+	SceneFramesState *state = copy->state;
+	int i;
+
+	for (i = copy->first_frame; i < state->num_frames; i += state->num_copies) {
+		bool stop;
+
+		/* Wait for the previous frame of this copy to be consumed. */
+		BLI_mutex_lock(&state->mutex);
+		while (copy->ready && !state->stop) {
+			BLI_condition_wait(&state->cond, &state->mutex);
+		}
+		stop = state->stop;
+		BLI_mutex_unlock(&state->mutex);
+
+		if (stop) {
+			break;
+		}
+
+		BKE_scene_frame_set(copy->scene, state->frames[i]);
+		BKE_scene_update_for_newframe_isolated(copy->bmain->eval_ctx, copy->bmain, copy->scene, state->lay);
+
+		BLI_mutex_lock(&state->mutex);
+		copy->ready = true;
+		BLI_condition_notify_all(&state->cond);
+		BLI_mutex_unlock(&state->mutex);
+	}
+
+	return NULL;
+}
+
+/**
+ * Evaluate given frames of the scene in parallel, on copies of the database.
+ *
+ * \a frame_func is called from the calling thread for every frame, in the order
+ * of \a frames, with the database copy which was evaluated to that frame and
+ * the map from original objects to objects of the copy. Returning false from
+ * it cancels the evaluation of remaining frames.
+ *
+ * Returns false without evaluating anything when frame-parallel evaluation
+ * is not possible, caller is to evaluate frames one by one then.
+ */
+bool BKE_scene_frames_evaluate_parallel(
+        Main *bmain, Scene *scene, unsigned int lay,
+        const double *frames, int num_frames, int num_threads,
+        SceneFramesEvalFunc frame_func, void *userdata)
+{
+	SceneFramesState state = {NULL};
+	SceneFramesCopy *copies;
+	MemFile memfile = {{NULL}};
+	ListBase threads;
+	bool ok = true;
+	int i;
+
+	state.num_copies = min_ii(num_threads, num_frames);
+	if (state.num_copies < 2 || !BKE_scene_frames_parallel_check(bmain, scene)) {
+		return false;
+	}
+
+	if (!BLO_write_file_mem(bmain, NULL, &memfile, G.fileflags)) {
+		BLO_memfile_free(&memfile);
+		return false;
+	}
+
+	copies = MEM_callocN(sizeof(*copies) * state.num_copies, __func__);
+	for (i = 0; i < state.num_copies && ok; i++) {
+		copies[i].state = &state;
+		copies[i].first_frame = i;
+		ok = scene_frames_copy_init(&copies[i], bmain, scene, &memfile);
+	}
+	BLO_memfile_free(&memfile);
+
+	if (ok) {
+		state.frames = frames;
+		state.num_frames = num_frames;
+		state.lay = lay;
+		BLI_mutex_init(&state.mutex);
+		BLI_condition_init(&state.cond);
+
+		BLI_init_threads(&threads, scene_frames_thread, state.num_copies);
+		for (i = 0; i < state.num_copies; i++) {
+			BLI_insert_thread(&threads, &copies[i]);
+		}
+
+		for (i = 0; i < num_frames; i++) {
+			SceneFramesCopy *copy = &copies[i % state.num_copies];
+			bool frame_ok;
+
+			BLI_mutex_lock(&state.mutex);
+			while (!copy->ready) {
+				BLI_condition_wait(&state.cond, &state.mutex);
+			}
+			BLI_mutex_unlock(&state.mutex);
+
+			frame_ok = frame_func(userdata, copy->bmain, copy->scene, copy->object_map, frames[i]);
+
+			BLI_mutex_lock(&state.mutex);
+			copy->ready = false;
+			if (!frame_ok) {
+				state.stop = true;
+			}
+			BLI_condition_notify_all(&state.cond);
+			BLI_mutex_unlock(&state.mutex);
+
+			if (!frame_ok) {
+				break;
+			}
+		}
+
+		BLI_end_threads(&threads);
+		BLI_condition_end(&state.cond);
+		BLI_mutex_end(&state.mutex);
+	}
+
+	for (i = 0; i < state.num_copies; i++) {
+		scene_frames_copy_free(&copies[i]);
+	}
+	MEM_freeN(copies);
+
+	return ok;
+}
@@ -5163,6 +5163,20 @@ static bool subsurf_use_gpu_backend(SubsurfFlags flags)
 #endif
 }
 
+#ifdef WITH_OPENSUBDIV
+static bool subsurf_use_cpu_evaluator(SubsurfFlags flags, bool use_gpu_backend)
+{
+	/* Evaluate grids with OpenSubdiv's CPU evaluator when it's requested,
+	 * but GPU backend is not possible.
+	 */
+	return
+	        (flags & SUBSURF_USE_CPU_EVALUATOR) != 0 &&
+	        (flags & SUBSURF_FOR_EDIT_MODE) == 0 &&
+	        (U.opensubdiv_compute_type != USER_OPENSUBDIV_COMPUTE_NONE) &&
+	        !use_gpu_backend;
+}
+#endif
+
 struct DerivedMesh *subsurf_make_derived_from_derived(
         struct DerivedMesh *dm,
         struct SubsurfModifierData *smd,
@@ -5175,6 +5189,9 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 	int drawInteriorEdges = !(smd->flags & eSubsurfModifierFlag_ControlEdges);
 	CCGDerivedMesh *result;
 	bool use_gpu_backend = subsurf_use_gpu_backend(flags);
+#ifdef WITH_OPENSUBDIV
+	bool use_cpu_evaluator = subsurf_use_cpu_evaluator(flags, use_gpu_backend);
+#endif
 
 	/* note: editmode calculation can only run once per
 	 * modifier stack evaluation (uses freed cache) [#36299] */
@@ -5206,6 +5223,9 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 			return dm;
 		
 		ss = _getSubSurf(NULL, levels, 3, useSimple | CCG_USE_ARENA | CCG_CALC_NORMALS);
+#ifdef WITH_OPENSUBDIV
+		ccgSubSurf_setUseOpenSubdivGrids(ss, use_cpu_evaluator);
+#endif
 
 		ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
 
@@ -5237,6 +5257,9 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 
 		if (useIncremental && (flags & SUBSURF_IS_FINAL_CALC)) {
 			smd->mCache = ss = _getSubSurf(smd->mCache, levels, 3, useSimple | useAging | CCG_CALC_NORMALS);
+#ifdef WITH_OPENSUBDIV
+			ccgSubSurf_setUseOpenSubdivGrids(ss, use_cpu_evaluator);
+#endif
 
 			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
 
@@ -5259,7 +5282,7 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 				 * this is to be investigated still to be sure we don't have
 				 * regressions here.
 				 */
-				if (use_gpu_backend) {
+				if (use_gpu_backend || use_cpu_evaluator) {
 					prevSS = smd->mCache;
 				}
 				else
@@ -5277,6 +5300,7 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 			ss = _getSubSurf(prevSS, levels, 3, ccg_flags);
 #ifdef WITH_OPENSUBDIV
 			ccgSubSurf_setSkipGrids(ss, use_gpu_backend);
+			ccgSubSurf_setUseOpenSubdivGrids(ss, use_cpu_evaluator);
 #endif
 			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
 
@@ -57,6 +57,21 @@ void               *BLI_memarena_calloc(struct MemArena *ma, size_t size) ATTR_W
 
 void BLI_memarena_clear(MemArena *ma) ATTR_NONNULL(1);
 
+/* Position in an arena, allocations made after it can be released at once. */
+typedef struct MemArenaMark {
+	void *bufs;
+	unsigned char *curbuf;
+	size_t cursize;
+} MemArenaMark;
+
+void BLI_memarena_mark(const struct MemArena *ma, MemArenaMark *r_mark) ATTR_NONNULL(1, 2);
+void BLI_memarena_release_to_mark(struct MemArena *ma, const MemArenaMark *mark) ATTR_NONNULL(1, 2);
+
+/* Scoped access to the calling thread's scratch arena. */
+struct MemArena    *BLI_memarena_scope_begin(MemArenaMark *r_mark) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void                BLI_memarena_scope_end(const MemArenaMark *mark) ATTR_NONNULL(1);
+void                BLI_memarena_thread_local_free(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,7 @@ extern "C"
 
 struct BLI_mempool;
 struct BLI_mempool_chunk;
+struct BLI_freenode;
 
 typedef struct BLI_mempool BLI_mempool;
 
@@ -65,6 +66,19 @@ void       *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr) ATTR_
 void        BLI_mempool_set_memory_debug(void);
 #endif
 
+/** Per thread allocation state, allows allocating from multiple threads at once. */
+typedef struct BLI_mempool_local {
+	BLI_mempool *pool;
+	struct BLI_freenode *free;
+	int totused;
+} BLI_mempool_local;
+
+void  BLI_mempool_local_init(BLI_mempool *pool, BLI_mempool_local *local) ATTR_NONNULL(1, 2);
+void *BLI_mempool_local_alloc(BLI_mempool_local *local) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void *BLI_mempool_local_calloc(BLI_mempool_local *local) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void  BLI_mempool_local_free(BLI_mempool_local *local, void *addr) ATTR_NONNULL(1, 2);
+void  BLI_mempool_local_finalize(BLI_mempool_local *local) ATTR_NONNULL(1);
+
 /** iteration stuff.  note: this may easy to produce bugs with **/
 /* private structure */
 typedef struct BLI_mempool_iter {
@@ -35,11 +35,18 @@
  * needs to quickly allocate lots of little bits of data,
  * which are all freed at the same moment.
  *
- * \note Memory can't be freed during the arenas lifetime.
+ * \note Memory can't be freed during the arenas lifetime,
+ * other than releasing everything allocated after a #MemArenaMark.
+ *
+ * Each thread also has a scratch arena (see #BLI_memarena_scope_begin),
+ * its buffers are kept between scopes so hot paths with short-lived
+ * allocations don't have to create an arena (or go through MEM_mallocN)
+ * on every call.
  */
 
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -196,3 +203,123 @@ void BLI_memarena_clear(MemArena *ma)
 #endif
 
 }
+
+/**
+ * Store the current position of the arena,
+ * see #BLI_memarena_release_to_mark.
+ */
+void BLI_memarena_mark(const MemArena *ma, MemArenaMark *r_mark)
+{
+	r_mark->bufs = ma->bufs;
+	r_mark->curbuf = ma->curbuf;
+	r_mark->cursize = ma->cursize;
+}
+
+/**
+ * Release all memory allocated after \a mark was taken,
+ * marks have to be released in the reverse order they were taken.
+ *
+ * The first buffer allocated after the mark is kept for reuse,
+ * so releasing in a loop doesn't re-allocate buffers each time.
+ *
+ * \note Not supported for arenas using calloc.
+ */
+void BLI_memarena_release_to_mark(MemArena *ma, const MemArenaMark *mark)
+{
+	LinkNode *buf_keep = NULL;
+
+	BLI_assert(ma->use_calloc == false);
+
+	while (ma->bufs != mark->bufs) {
+		LinkNode *buf = ma->bufs;
+		BLI_assert(buf != NULL);
+		ma->bufs = buf->next;
+		if (ma->bufs == mark->bufs) {
+			buf_keep = buf;
+		}
+		else {
+			MEM_freeN(buf->link);
+			MEM_freeN(buf);
+		}
+	}
+
+	if (buf_keep) {
+		ma->bufs = buf_keep;
+		ma->curbuf = buf_keep->link;
+		ma->cursize = MEM_allocN_len(buf_keep->link);
+		memarena_curbuf_align(ma);
+	}
+	else {
+		ma->curbuf = mark->curbuf;
+		ma->cursize = mark->cursize;
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Thread Local Scratch Arena
+ * \{ */
+
+/* Large enough that typical scopes never need a second buffer. */
+#define MEMARENA_THREAD_LOCAL_BUFSIZE MEM_SIZE_OPTIMAL(1 << 18)
+
+static pthread_key_t memarena_tls_key;
+static pthread_once_t memarena_tls_key_once = PTHREAD_ONCE_INIT;
+
+static void memarena_thread_local_free_cb(void *ma)
+{
+	BLI_memarena_free(ma);
+}
+
+static void memarena_tls_key_create(void)
+{
+	/* Arenas of worker threads are freed on thread exit. */
+	pthread_key_create(&memarena_tls_key, memarena_thread_local_free_cb);
+}
+
+/**
+ * Begin a scope using the calling thread's scratch arena,
+ * everything allocated from it is released by #BLI_memarena_scope_end.
+ *
+ * Scopes may be nested, but have to be ended in reverse order on the same thread.
+ */
+MemArena *BLI_memarena_scope_begin(MemArenaMark *r_mark)
+{
+	MemArena *ma;
+
+	pthread_once(&memarena_tls_key_once, memarena_tls_key_create);
+
+	ma = pthread_getspecific(memarena_tls_key);
+	if (UNLIKELY(ma == NULL)) {
+		ma = BLI_memarena_new(MEMARENA_THREAD_LOCAL_BUFSIZE, "thread local memarena");
+		pthread_setspecific(memarena_tls_key, ma);
+	}
+
+	BLI_memarena_mark(ma, r_mark);
+	return ma;
+}
+
+void BLI_memarena_scope_end(const MemArenaMark *mark)
+{
+	MemArena *ma = pthread_getspecific(memarena_tls_key);
+	BLI_assert(ma != NULL);
+	BLI_memarena_release_to_mark(ma, mark);
+}
+
+/**
+ * Free the calling thread's scratch arena,
+ * the main thread has to call this before checking for leaks.
+ */
+void BLI_memarena_thread_local_free(void)
+{
+	MemArena *ma;
+
+	pthread_once(&memarena_tls_key_once, memarena_tls_key_create);
+
+	ma = pthread_getspecific(memarena_tls_key);
+	if (ma) {
+		pthread_setspecific(memarena_tls_key, NULL);
+		BLI_memarena_free(ma);
+	}
+}
+
+/** \} */
@@ -207,6 +207,40 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
 	return mpchunk;
 }
 
+/**
+ * Link all elements of \a mpchunk into a NULL terminated free list.
+ *
+ * \return The last element of the list.
+ */
+static BLI_freenode *mempool_chunk_freelist_init(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+	const uint esize = pool->esize;
+	BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+	uint j;
+
+	/* loop through the allocated data, building the pointer structures */
+	j = pool->pchunk;
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+		while (j--) {
+			curnode->next = NODE_STEP_NEXT(curnode);
+			curnode->freeword = FREEWORD;
+			curnode = curnode->next;
+		}
+	}
+	else {
+		while (j--) {
+			curnode->next = NODE_STEP_NEXT(curnode);
+			curnode = curnode->next;
+		}
+	}
+
+	/* terminate the list (rewind one) */
+	curnode = NODE_STEP_PREV(curnode);
+	curnode->next = NULL;
+
+	return curnode;
+}
+
 /**
  * Initialize a chunk and add into \a pool->chunks
  *
@@ -219,9 +253,7 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
 static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpchunk,
                                        BLI_freenode *lasttail)
 {
-	const uint esize = pool->esize;
 	BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-	uint j;
 
 	/* append */
 	if (pool->chunk_tail) {
@@ -239,26 +271,8 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpc
 		pool->free = curnode;
 	}
 
-	/* loop through the allocated data, building the pointer structures */
-	j = pool->pchunk;
-	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-		while (j--) {
-			curnode->next = NODE_STEP_NEXT(curnode);
-			curnode->freeword = FREEWORD;
-			curnode = curnode->next;
-		}
-	}
-	else {
-		while (j--) {
-			curnode->next = NODE_STEP_NEXT(curnode);
-			curnode = curnode->next;
-		}
-	}
-
-	/* terminate the list (rewind one)
-	 * will be overwritten if 'curnode' gets passed in again as 'lasttail' */
-	curnode = NODE_STEP_PREV(curnode);
-	curnode->next = NULL;
+	/* will be overwritten if 'curnode' gets passed in again as 'lasttail' */
+	curnode = mempool_chunk_freelist_init(pool, mpchunk);
 
 #ifdef USE_TOTALLOC
 	pool->totalloc += pool->pchunk;
@@ -272,6 +286,35 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpc
 	return curnode;
 }
 
+/**
+ * A version of #mempool_chunk_add which can be called from multiple threads at once,
+ * the chunk is appended to \a pool->chunks but its elements are not added to \a pool->free.
+ *
+ * \return The first element of the chunks free list.
+ */
+static BLI_freenode *mempool_chunk_add_threadsafe(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+	BLI_mempool_chunk *chunk_tail;
+
+	mempool_chunk_freelist_init(pool, mpchunk);
+	mpchunk->next = NULL;
+
+	/* Swap in the new tail, then link the previous tail to it,
+	 * the list is only read once all threads are done. */
+	do {
+		chunk_tail = pool->chunk_tail;
+	} while (atomic_cas_ptr((void **)&pool->chunk_tail, chunk_tail, mpchunk) != chunk_tail);
+
+	if (chunk_tail) {
+		chunk_tail->next = mpchunk;
+	}
+	else {
+		pool->chunks = mpchunk;
+	}
+
+	return CHUNK_DATA(mpchunk);
+}
+
 static void mempool_chunk_free(BLI_mempool_chunk *mpchunk)
 {
 
@@ -474,6 +517,124 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Thread Local Allocation
+ *
+ * Allows multiple threads to allocate from the same pool at once without locking.
+ * Each thread keeps its own free list in a #BLI_mempool_local and reserves whole
+ * chunks from the pool when it runs out of elements, only the chunk list is shared.
+ *
+ * While threads are allocating, the pool must not be accessed otherwise,
+ * once all threads called #BLI_mempool_local_finalize the pool can be used
+ * (and iterated over, e.g. with #BLI_task_parallel_mempool) as usual.
+ * \{ */
+
+void BLI_mempool_local_init(BLI_mempool *pool, BLI_mempool_local *local)
+{
+	local->pool = pool;
+	local->free = NULL;
+	local->totused = 0;
+}
+
+void *BLI_mempool_local_alloc(BLI_mempool_local *local)
+{
+	BLI_mempool *pool = local->pool;
+	BLI_freenode *free_pop;
+
+	if (UNLIKELY(local->free == NULL)) {
+		/* reserve a new chunk for this thread */
+		BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+		local->free = mempool_chunk_add_threadsafe(pool, mpchunk);
+	}
+
+	free_pop = local->free;
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+		free_pop->freeword = USEDWORD;
+	}
+
+	local->free = free_pop->next;
+	local->totused++;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+	return (void *)free_pop;
+}
+
+void *BLI_mempool_local_calloc(BLI_mempool_local *local)
+{
+	void *retval = BLI_mempool_local_alloc(local);
+	memset(retval, 0, (size_t)local->pool->esize);
+	return retval;
+}
+
+/**
+ * Free an element into the thread local free list,
+ * the element may have been allocated by another thread.
+ */
+void BLI_mempool_local_free(BLI_mempool_local *local, void *addr)
+{
+	BLI_mempool *pool = local->pool;
+	BLI_freenode *newhead = addr;
+
+#ifndef NDEBUG
+	if (UNLIKELY(mempool_debug_memset)) {
+		memset(addr, 255, pool->esize);
+	}
+#endif
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+		/* this will detect double free's */
+		BLI_assert(newhead->freeword != FREEWORD);
+#endif
+		newhead->freeword = FREEWORD;
+	}
+
+	newhead->next = local->free;
+	local->free = newhead;
+	local->totused--;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+}
+
+/**
+ * Hand unused elements and the count of used ones back to the pool,
+ * safe to call from multiple threads at once.
+ */
+void BLI_mempool_local_finalize(BLI_mempool_local *local)
+{
+	BLI_mempool *pool = local->pool;
+
+	if (local->free) {
+		BLI_freenode *free_tail = local->free;
+		BLI_freenode *free_head;
+
+		while (free_tail->next) {
+			free_tail = free_tail->next;
+		}
+
+		do {
+			free_head = pool->free;
+			free_tail->next = free_head;
+		} while (atomic_cas_ptr((void **)&pool->free, free_head, local->free) != free_head);
+
+		local->free = NULL;
+	}
+
+	if (local->totused != 0) {
+		/* unsigned overflow gives the expected result for negative values */
+		atomic_add_and_fetch_u(&pool->totused, (uint)local->totused);
+		local->totused = 0;
+	}
+}
+
+/** \} */
+
 int BLI_mempool_count(BLI_mempool *pool)
 {
 	return (int)pool->totused;
@@ -37,6 +37,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_gsqueue.h"
+#include "BLI_memarena.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
 
@@ -162,6 +163,7 @@ void BLI_threadapi_exit(void)
 	if (task_scheduler) {
 		BLI_task_scheduler_free(task_scheduler);
 	}
+	BLI_memarena_thread_local_free();
 	BLI_spin_end(&_malloc_lock);
 }
 
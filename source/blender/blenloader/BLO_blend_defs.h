@@ -77,4 +77,25 @@ enum {
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (2 + (size_t)(_x) * (size_t)(_y)))
 
+/**
+ * Frame compressed blend-file container, written when saving with #G_FILE_COMPRESS_FAST.
+ *
+ * The regular blend-file stream is split into frames of #BLEN_LZO_FRAME_SIZE bytes,
+ * each one LZO compressed on its own, so frames can be compressed in parallel on save
+ * and decompression can start at any frame on load.
+ *
+ * - header: #BLEN_LZO_MAGIC.
+ * - frames: raw length (uint32), data length (uint32), data
+ *   (stored uncompressed when both lengths match).
+ * - index: file offset of each frame (uint64).
+ * - footer: frame count (uint32), frame size (uint32), #BLEN_LZO_MAGIC.
+ *
+ * All integers are little-endian.
+ */
+#define BLEN_LZO_MAGIC "BLENDLZO"
+#define BLEN_LZO_MAGIC_LEN 8
+#define BLEN_LZO_FRAME_SIZE (1 << 19)
+#define BLEN_LZO_FRAME_HEADER_SIZE 8
+#define BLEN_LZO_FOOTER_SIZE (8 + BLEN_LZO_MAGIC_LEN)
+
 #endif  /* __BLO_BLEND_DEFS_H__ */
@@ -39,6 +39,10 @@ typedef struct {
 	char *buf;
 	unsigned int ident, size;
 	
+	/* Hash of 'buf', only valid when 'hash_valid' is set,
+	 * calculated on demand when chunks can't be matched by position. */
+	unsigned int hash;
+	bool hash_valid;
 } MemFileChunk;
 
 typedef struct MemFile {
@@ -46,8 +50,20 @@ typedef struct MemFile {
 	unsigned int size;
 } MemFile;
 
+/* State used while writing a memfile, compares new chunks with the previous memfile. */
+typedef struct MemFileWriteData {
+	MemFile *current;
+	MemFile *compare;
+	/* Chunk of 'compare' expected at the current position. */
+	MemFileChunk *compare_chunk;
+	/* Chunks of 'compare' by hash, created on the first chunk which doesn't match by position. */
+	struct GHash *compare_chunks_by_hash;
+} MemFileWriteData;
+
 /* actually only used writefile.c */
-extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
+extern void memfile_write_init(MemFileWriteData *mem_data, MemFile *compare, MemFile *current);
+extern void memfile_write_finalize(MemFileWriteData *mem_data);
+extern void memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, unsigned int size);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
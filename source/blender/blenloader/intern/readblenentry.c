@@ -214,7 +214,7 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 							size_t len = new_prv->w[0] * new_prv->h[0] * sizeof(unsigned int);
 							new_prv->rect[0] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
+							rect = blo_bhead_data(fd, bhead);
 							BLI_assert(len == bhead->len);
 							memcpy(new_prv->rect[0], rect, len);
 						}
@@ -231,7 +231,7 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 							size_t len = new_prv->w[1] * new_prv->h[1] * sizeof(unsigned int);
 							new_prv->rect[1] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
+							rect = blo_bhead_data(fd, bhead);
 							BLI_assert(len == bhead->len);
 							memcpy(new_prv->rect[1], rect, len);
 						}
@@ -110,6 +110,8 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_linklist.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -164,6 +166,14 @@
 
 #include <errno.h>
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
 /**
  * READ
  * ====
@@ -220,6 +230,19 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/* Link direct data of independent, heavy ID types on multiple threads after reading a file. */
+#define USE_PARALLEL_DIRECT_LINK
+
+/* Memory map uncompressed files, DATA blocks are only accessed when they're read
+ * (speeds up linking from large libraries, where most data is skipped). */
+#ifndef WIN32
+#  define USE_BHEAD_MMAP
+#endif
+
+#ifdef USE_BHEAD_MMAP
+#  include <sys/mman.h>
+#endif
+
 /* Define this to have verbose debug prints. */
 #define USE_DEBUG_PRINT
 
@@ -237,11 +260,17 @@ typedef struct OldNew {
 	int nr;
 } OldNew;
 
+/**
+ * Entries are stored in insertion order, with an open addressing hash table
+ * of indices into the entries for lookups.
+ */
 typedef struct OldNewMap {
 	OldNew *entries;
-	int nentries, entriessize;
-	bool sorted;
-	int lasthit;
+	int nentries;
+	/* Indices into entries, -1 for empty slots, has (entries capacity * 2) slots. */
+	int *map;
+	/* Entries capacity is (1 << capacity_exp). */
+	int capacity_exp;
 } OldNewMap;
 
 
@@ -284,31 +313,64 @@ static const char *library_parent_filepath(Library *lib)
 	return lib->parent ? lib->parent->filepath : "<direct>";
 }
 
-static OldNewMap *oldnewmap_new(void) 
+#define ONM_DEFAULT_CAPACITY_EXP 10
+#define ONM_ENTRIES_CAPACITY(onm) (1 << (onm)->capacity_exp)
+#define ONM_MAP_CAPACITY(onm) (1 << ((onm)->capacity_exp + 1))
+#define ONM_PERTURB_SHIFT 5
+
+/* Probing based on Python's dict, the perturbation uses all bits of the hash. */
+#define ONM_ITER_SLOTS(onm, key, slot, index) \
+	const unsigned int _mask = (unsigned int)ONM_MAP_CAPACITY(onm) - 1; \
+	unsigned int _perturb = BLI_ghashutil_ptrhash(key); \
+	unsigned int slot = _perturb & _mask; \
+	int index = (onm)->map[slot]; \
+	for (;; \
+	     slot = _mask & ((5 * slot) + 1 + _perturb), \
+	     _perturb >>= ONM_PERTURB_SHIFT, \
+	     index = (onm)->map[slot])
+
+static void oldnewmap_map_insert(OldNewMap *onm, const void *addr, int entry_index)
+{
+	ONM_ITER_SLOTS(onm, addr, slot, index) {
+		if (index == -1 || onm->entries[index].old == addr) {
+			/* on duplicates the last inserted entry wins */
+			onm->map[slot] = entry_index;
+			break;
+		}
+	}
+}
+
+static int oldnewmap_map_lookup(const OldNewMap *onm, const void *addr)
 {
-	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
-	
-	onm->entriessize = 1024;
-	onm->entries = MEM_malloc_arrayN(onm->entriessize, sizeof(*onm->entries), "OldNewMap.entries");
-	
-	return onm;
+	ONM_ITER_SLOTS(onm, addr, slot, index) {
+		if (index == -1 || onm->entries[index].old == addr) {
+			return index;
+		}
+	}
 }
 
-static int verg_oldnewmap(const void *v1, const void *v2)
+static void oldnewmap_map_clear(OldNewMap *onm)
 {
-	const struct OldNew *x1=v1, *x2=v2;
-	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
+	memset(onm->map, 0xff, sizeof(*onm->map) * (size_t)ONM_MAP_CAPACITY(onm));
 }
 
+static void oldnewmap_alloc(OldNewMap *onm, int capacity_exp)
+{
+	onm->capacity_exp = capacity_exp;
+	onm->entries = MEM_reallocN_id(
+	        onm->entries, sizeof(*onm->entries) * (size_t)ONM_ENTRIES_CAPACITY(onm), "OldNewMap.entries");
+	MEM_SAFE_FREE(onm->map);
+	onm->map = MEM_mallocN(sizeof(*onm->map) * (size_t)ONM_MAP_CAPACITY(onm), "OldNewMap.map");
+	oldnewmap_map_clear(onm);
+}
 
-static void oldnewmap_sort(FileData *fd) 
+static OldNewMap *oldnewmap_new(void) 
 {
-	BLI_assert(fd->libmap->sorted == false);
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
+	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
+	
+	oldnewmap_alloc(onm, ONM_DEFAULT_CAPACITY_EXP);
+	
+	return onm;
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -318,15 +380,19 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
 	
 	if (oldaddr==NULL || newaddr==NULL) return;
 	
-	if (UNLIKELY(onm->nentries == onm->entriessize)) {
-		onm->entriessize *= 2;
-		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+	if (UNLIKELY(onm->nentries == ONM_ENTRIES_CAPACITY(onm))) {
+		oldnewmap_alloc(onm, onm->capacity_exp + 1);
+		for (int i = 0; i < onm->nentries; i++) {
+			oldnewmap_map_insert(onm, onm->entries[i].old, i);
+		}
 	}
 
-	entry = &onm->entries[onm->nentries++];
+	entry = &onm->entries[onm->nentries];
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+
+	oldnewmap_map_insert(onm, oldaddr, onm->nentries++);
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
@@ -334,77 +400,16 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
 	oldnewmap_insert(onm, oldaddr, newaddr, nr);
 }
 
-/**
- * Do a full search (no state).
- *
- * \param lasthit: Use as a reference position to avoid a full search
- * from either end of the array, giving more efficient lookups.
- *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
- */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
-{
-	const int nentries = onm->nentries;
-	const OldNew *entries = onm->entries;
-	int i;
-
-	/* search relative to lasthit where possible */
-	if (lasthit >= 0 && lasthit < nentries) {
-
-		/* search forwards */
-		i = lasthit;
-		while (++i != nentries) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-
-		/* search backwards */
-		i = lasthit + 1;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-	}
-	else {
-		/* search backwards (full) */
-		i = nentries;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-	}
-
-	return -1;
-}
-
 static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
 {
 	int i;
 	
 	if (addr == NULL) return NULL;
 	
-	if (onm->lasthit < onm->nentries-1) {
-		OldNew *entry = &onm->entries[++onm->lasthit];
-		
-		if (entry->old == addr) {
-			if (increase_users)
-				entry->nr++;
-			return entry->newp;
-		}
-	}
-	
-	i = oldnewmap_lookup_entry_full(onm, addr, onm->lasthit);
+	i = oldnewmap_map_lookup(onm, addr);
 	if (i != -1) {
 		OldNew *entry = &onm->entries[i];
 		BLI_assert(entry->old == addr);
-		onm->lasthit = i;
 		if (increase_users)
 			entry->nr++;
 		return entry->newp;
@@ -416,32 +421,19 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool inc
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *lib)
 {
+	int i;
+
 	if (addr == NULL) {
 		return NULL;
 	}
 
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		const OldNew entry_s = {.old = addr};
-		OldNew *entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
-			ID *id = entry->newp;
-
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
-		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		const int i = oldnewmap_lookup_entry_full(onm, addr, -1);
-		if (i != -1) {
-			OldNew *entry = &onm->entries[i];
-			ID *id = entry->newp;
-			BLI_assert(entry->old == addr);
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
+	i = oldnewmap_map_lookup(onm, addr);
+	if (i != -1) {
+		OldNew *entry = &onm->entries[i];
+		ID *id = entry->newp;
+		BLI_assert(entry->old == addr);
+		if (id && (!lib || id->lib)) {
+			return id;
 		}
 	}
 
@@ -464,15 +456,55 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 static void oldnewmap_clear(OldNewMap *onm) 
 {
 	onm->nentries = 0;
-	onm->lasthit = 0;
+
+	/* shrink back, the map is cleared for every data-block read */
+	if (onm->capacity_exp != ONM_DEFAULT_CAPACITY_EXP) {
+		oldnewmap_alloc(onm, ONM_DEFAULT_CAPACITY_EXP);
+	}
+	else {
+		oldnewmap_map_clear(onm);
+	}
 }
 
 static void oldnewmap_free(OldNewMap *onm) 
 {
 	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
 	MEM_freeN(onm);
 }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+/**
+ * Move all entries into a new map sized to fit them, \a onm is cleared.
+ */
+static OldNewMap *oldnewmap_move_fit(OldNewMap *onm)
+{
+	OldNewMap *onm_dst = MEM_callocN(sizeof(*onm_dst), "OldNewMap");
+	int capacity_exp = 2;
+
+	while ((1 << capacity_exp) < onm->nentries) {
+		capacity_exp++;
+	}
+	oldnewmap_alloc(onm_dst, capacity_exp);
+
+	memcpy(onm_dst->entries, onm->entries, sizeof(*onm->entries) * (size_t)onm->nentries);
+	onm_dst->nentries = onm->nentries;
+	for (int i = 0; i < onm_dst->nentries; i++) {
+		oldnewmap_map_insert(onm_dst, onm_dst->entries[i].old, i);
+	}
+
+	oldnewmap_clear(onm);
+
+	return onm_dst;
+}
+#endif
+
+#undef ONM_DEFAULT_CAPACITY_EXP
+#undef ONM_ENTRIES_CAPACITY
+#undef ONM_MAP_CAPACITY
+#undef ONM_PERTURB_SHIFT
+#undef ONM_ITER_SLOTS
+
 /***/
 
 static void read_libraries(FileData *basefd, ListBase *mainlist);
@@ -797,10 +829,32 @@ static BHeadN *get_bhead(FileData *fd)
 			/* bhead now contains the (converted) bhead structure. Now read
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
-			if (!fd->eof) {
+			if (fd->eof) {
+				/* pass */
+			}
+#ifdef USE_BHEAD_MMAP
+			else if (fd->mmap && (bhead.code == DATA)) {
+				/* Data stays in the mapped file until it's read, see: blo_bhead_data(). */
+				if ((size_t)bhead.len <= fd->mmap_size - fd->mmap_offset) {
+					new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->has_data = false;
+					new_bhead->mmap_offset = fd->mmap_offset;
+					new_bhead->bhead = bhead;
+
+					fd->mmap_offset += (size_t)bhead.len;
+				}
+				else {
+					fd->eof = 1;
+				}
+			}
+#endif
+			else {
 				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
 				if (new_bhead) {
 					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->has_data = true;
+					new_bhead->mmap_offset = 0;
 					new_bhead->bhead = bhead;
 					
 					readsize = fd->read(fd, new_bhead + 1, bhead.len);
@@ -888,6 +942,22 @@ const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
 }
 
+/**
+ * Access the data following \a bhead, which may not be stored with it (memory mapped files).
+ */
+void *blo_bhead_data(FileData *fd, BHead *bhead)
+{
+	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(bhead, -offsetof(BHeadN, bhead));
+
+	if (bheadn->has_data) {
+		return bhead + 1;
+	}
+	else {
+		BLI_assert(fd->mmap != NULL);
+		return fd->mmap + bheadn->mmap_offset;
+	}
+}
+
 static void decode_blender_header(FileData *fd)
 {
 	char header[SIZEOFBLENDERHEADER], num[4];
@@ -1032,6 +1102,224 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, unsigned int
 	return (readsize);
 }
 
+#ifdef WITH_LZO
+/**
+ * Reading of frame compressed files (see: #BLEN_LZO_MAGIC).
+ *
+ * The frame index is read on open, frames are decompressed on demand
+ * from the current read position, so any position can be read without
+ * decompressing the frames before it.
+ *
+ * Like memory mapped files, #FileData.seek isn't used, since files may be larger than 2gb.
+ */
+typedef struct FileDataLzo {
+	uint64_t *frame_offsets;
+	unsigned int frames_len;
+	unsigned int frame_size;
+
+	/* read position in the uncompressed data */
+	uint64_t offset;
+
+	/* currently decompressed frame, -1 for none */
+	int frame_loaded;
+	unsigned int frame_loaded_len;
+	unsigned char *raw;
+	unsigned char *data;
+} FileDataLzo;
+
+static uint32_t lzo_decode_u32(const unsigned char *buf)
+{
+	return ((uint32_t)buf[0]) | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static uint64_t lzo_decode_u64(const unsigned char *buf)
+{
+	return ((uint64_t)lzo_decode_u32(&buf[4]) << 32) | (uint64_t)lzo_decode_u32(buf);
+}
+
+static bool fd_lzo_read_at(FileData *fd, uint64_t offset, void *buffer, size_t size)
+{
+	return ((lseek(fd->filedes, (off_t)offset, SEEK_SET) != (off_t)-1) &&
+	        (read(fd->filedes, buffer, size) == (ssize_t)size));
+}
+
+static bool fd_lzo_frame_load(FileData *fd, unsigned int frame)
+{
+	FileDataLzo *lzo = fd->lzo;
+	unsigned char header[BLEN_LZO_FRAME_HEADER_SIZE];
+	unsigned int raw_len, data_len;
+
+	lzo->frame_loaded = -1;
+
+	if (!fd_lzo_read_at(fd, lzo->frame_offsets[frame], header, sizeof(header))) {
+		return false;
+	}
+
+	raw_len = lzo_decode_u32(&header[0]);
+	data_len = lzo_decode_u32(&header[4]);
+	if ((raw_len > lzo->frame_size) || (data_len > raw_len)) {
+		return false;
+	}
+
+	if (data_len == raw_len) {
+		/* stored uncompressed */
+		if (read(fd->filedes, lzo->raw, raw_len) != (ssize_t)raw_len) {
+			return false;
+		}
+	}
+	else {
+		lzo_uint out_len = lzo->frame_size;
+		if ((read(fd->filedes, lzo->data, data_len) != (ssize_t)data_len) ||
+		    (lzo1x_decompress_safe(lzo->data, data_len, lzo->raw, &out_len, NULL) != LZO_E_OK) ||
+		    (out_len != raw_len))
+		{
+			return false;
+		}
+	}
+
+	lzo->frame_loaded = (int)frame;
+	lzo->frame_loaded_len = raw_len;
+	return true;
+}
+
+static int fd_read_lzo_from_file(FileData *filedata, void *buffer, unsigned int size)
+{
+	FileDataLzo *lzo = filedata->lzo;
+	unsigned int totread = 0;
+
+	while (totread < size) {
+		const uint64_t frame = lzo->offset / lzo->frame_size;
+		const unsigned int frame_offset = (unsigned int)(lzo->offset % lzo->frame_size);
+		unsigned int readsize;
+
+		if (frame >= lzo->frames_len) {
+			break;
+		}
+		if ((int)frame != lzo->frame_loaded) {
+			if (!fd_lzo_frame_load(filedata, (unsigned int)frame)) {
+				printf("%s: error reading frame %u\n", __func__, (unsigned int)frame);
+				return EOF;
+			}
+		}
+
+		/* only the last frame may be shorter */
+		if (frame_offset >= lzo->frame_loaded_len) {
+			break;
+		}
+
+		readsize = MIN2(size - totread, lzo->frame_loaded_len - frame_offset);
+		memcpy(POINTER_OFFSET(buffer, totread), lzo->raw + frame_offset, readsize);
+		totread += readsize;
+		lzo->offset += readsize;
+	}
+
+	return (int)totread;
+}
+
+/**
+ * Read the frame index from the footer, expects the magic header to be read already.
+ */
+static bool fd_read_lzo_init(FileData *fd)
+{
+	FileDataLzo *lzo;
+	unsigned char footer[BLEN_LZO_FOOTER_SIZE];
+	unsigned char *index;
+	size_t index_len;
+	off_t file_len;
+
+	if (lzo_init() != LZO_E_OK) {
+		return false;
+	}
+
+	file_len = lseek(fd->filedes, 0, SEEK_END);
+	if (file_len < BLEN_LZO_MAGIC_LEN + BLEN_LZO_FOOTER_SIZE ||
+	    !fd_lzo_read_at(fd, (uint64_t)(file_len - BLEN_LZO_FOOTER_SIZE), footer, sizeof(footer)) ||
+	    !STREQLEN((const char *)&footer[8], BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN))
+	{
+		return false;
+	}
+
+	lzo = MEM_callocN(sizeof(*lzo), __func__);
+	lzo->frames_len = lzo_decode_u32(&footer[0]);
+	lzo->frame_size = lzo_decode_u32(&footer[4]);
+	lzo->frame_loaded = -1;
+	fd->lzo = lzo;
+
+	index_len = sizeof(uint64_t) * (size_t)lzo->frames_len;
+	if ((lzo->frame_size == 0) || (lzo->frame_size > (1 << 30)) ||
+	    (index_len > (size_t)(file_len - (BLEN_LZO_MAGIC_LEN + BLEN_LZO_FOOTER_SIZE))))
+	{
+		return false;
+	}
+
+	index = MEM_mallocN(index_len + 1, __func__);
+	if (!fd_lzo_read_at(fd, (uint64_t)(file_len - BLEN_LZO_FOOTER_SIZE) - index_len, index, index_len)) {
+		MEM_freeN(index);
+		return false;
+	}
+
+	lzo->frame_offsets = MEM_mallocN(sizeof(*lzo->frame_offsets) * (lzo->frames_len + 1), __func__);
+	for (unsigned int i = 0; i < lzo->frames_len; i++) {
+		lzo->frame_offsets[i] = lzo_decode_u64(&index[i * sizeof(uint64_t)]);
+	}
+	MEM_freeN(index);
+
+	lzo->raw = MEM_mallocN(lzo->frame_size, "lzo frame raw");
+	lzo->data = MEM_mallocN(lzo->frame_size, "lzo frame data");
+
+	return true;
+}
+
+static void fd_read_lzo_free(FileDataLzo *lzo)
+{
+	MEM_SAFE_FREE(lzo->frame_offsets);
+	MEM_SAFE_FREE(lzo->raw);
+	MEM_SAFE_FREE(lzo->data);
+	MEM_freeN(lzo);
+}
+#endif  /* WITH_LZO */
+
+#ifdef USE_BHEAD_MMAP
+/**
+ * Reading of memory mapped files, only used for uncompressed files.
+ *
+ * Unlike other readers #FileData.seek isn't used, since files may be larger than 2gb.
+ */
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the file */
+	const size_t readsize = MIN2((size_t)size, filedata->mmap_size - filedata->mmap_offset);
+
+	memcpy(buffer, filedata->mmap + filedata->mmap_offset, readsize);
+	filedata->mmap_offset += readsize;
+
+	return (int)readsize;
+}
+
+static bool fd_read_mmap_init(FileData *fd, int file)
+{
+	const size_t size = (size_t)BLI_file_descriptor_size(file);
+	void *mem;
+
+	if ((size == (size_t)-1) || (size == 0)) {
+		return false;
+	}
+
+	/* Private and writable, since data is switched in-place when the file endian differs. */
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	if (mem == MAP_FAILED) {
+		return false;
+	}
+
+	fd->mmap = mem;
+	fd->mmap_size = size;
+	fd->mmap_offset = 0;
+	fd->filedes = file;
+	fd->read = fd_read_from_mmap;
+	return true;
+}
+#endif  /* USE_BHEAD_MMAP */
+
 static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
 	/* don't read more bytes then there are available in the buffer */
@@ -1141,24 +1429,89 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
-/* cannot be called with relative paths anymore! */
-/* on each new library added, it now checks for the current FileData and expands relativeness */
-FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+/**
+ * Open \a filepath for reading, either a regular (optionally gzip compressed)
+ * or a frame compressed blend-file, without reading the header.
+ */
+static FileData *blo_filedata_from_file_open(const char *filepath, ReportList *reports)
 {
-	gzFile gzfile;
+	char header[BLEN_LZO_MAGIC_LEN];
+	bool is_header_read, is_lzo;
+	int file;
+
 	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
-	
-	if (gzfile == (gzFile)Z_NULL) {
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
 		BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
 		            filepath, errno ? strerror(errno) : TIP_("unknown error reading file"));
 		return NULL;
 	}
-	else {
+
+	is_header_read = (read(file, header, sizeof(header)) == sizeof(header));
+	is_lzo = (is_header_read && STREQLEN(header, BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN));
+
+#ifdef USE_BHEAD_MMAP
+	if (is_header_read && STREQLEN(header, "BLENDER", 7)) {
 		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
-		
+
+		if (fd_read_mmap_init(fd, file)) {
+			return fd;
+		}
+
+		/* fall back to regular reading */
+		blo_freefiledata(fd);
+	}
+#endif
+
+	if (is_lzo) {
+#ifdef WITH_LZO
+		FileData *fd = filedata_new();
+		fd->filedes = file;
+		fd->read = fd_read_lzo_from_file;
+
+		if (fd_read_lzo_init(fd) == false) {
+			BKE_reportf(reports, RPT_ERROR, "Failed to read blend file '%s', invalid compressed frame index", filepath);
+			blo_freefiledata(fd);
+			return NULL;
+		}
+		return fd;
+#else
+		close(file);
+		BKE_reportf(reports, RPT_ERROR, "Failed to read blend file '%s', built without LZO support", filepath);
+		return NULL;
+#endif
+	}
+	else {
+		gzFile gzfile;
+
+		close(file);
+
+		errno = 0;
+		gzfile = BLI_gzopen(filepath, "rb");
+		if (gzfile == (gzFile)Z_NULL) {
+			BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
+			            filepath, errno ? strerror(errno) : TIP_("unknown error reading file"));
+			return NULL;
+		}
+		else {
+			FileData *fd = filedata_new();
+			fd->gzfiledes = gzfile;
+			fd->read = fd_read_gzip_from_file;
+			return fd;
+		}
+	}
+}
+
+/* cannot be called with relative paths anymore! */
+/* on each new library added, it now checks for the current FileData and expands relativeness */
+FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+{
+	FileData *fd = blo_filedata_from_file_open(filepath, reports);
+
+	if (fd == NULL) {
+		return NULL;
+	}
+	else {
 		/* needed for library_append and read_libraries */
 		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
 		
@@ -1172,15 +1525,9 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
  */
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
-	gzFile gzfile;
-	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
-
-	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
+	FileData *fd = blo_filedata_from_file_open(filepath, NULL);
 
+	if (fd != NULL) {
 		decode_blender_header(fd);
 
 		if (fd->flags & FD_FLAGS_FILE_OK) {
@@ -1290,6 +1637,18 @@ void blo_freefiledata(FileData *fd)
 		if (fd->gzfiledes != NULL) {
 			gzclose(fd->gzfiledes);
 		}
+
+#ifdef WITH_LZO
+		if (fd->lzo != NULL) {
+			fd_read_lzo_free(fd->lzo);
+		}
+#endif
+
+#ifdef USE_BHEAD_MMAP
+		if (fd->mmap != NULL) {
+			munmap(fd->mmap, fd->mmap_size);
+		}
+#endif
 		
 		if (fd->strm.next_in) {
 			if (inflateEnd(&fd->strm) != Z_OK) {
@@ -1463,31 +1822,6 @@ static void *newdataadr(FileData *fd, const void *adr)		/* only direct databocks
 	return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
-/* This is a special version of newdataadr() which allows us to keep lasthit of
- * map unchanged. In certain cases this makes file loading time significantly
- * faster.
- *
- * Use this function in cases like restoring pointer from one list element to
- * another list element, but keep lasthit value so we can continue restoring
- * pointers efficiently.
- *
- * Example of this could be found in direct_link_fcurves() which restores the
- * fcurve group pointer and keeps lasthit optimal for linking all further
- * fcurves.
- */
-static void *newdataadr_ex(FileData *fd, const void *adr, bool increase_lasthit)		/* only direct databocks */
-{
-	if (increase_lasthit) {
-		return newdataadr(fd, adr);
-	}
-	else {
-		int lasthit = fd->datamap->lasthit;
-		void *newadr = newdataadr(fd, adr);
-		fd->datamap->lasthit = lasthit;
-		return newadr;
-	}
-}
-
 static void *newdataadr_no_us(FileData *fd, const void *adr)		/* only direct databocks */
 {
 	return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
@@ -1565,9 +1899,6 @@ static void change_idid_adr_fd(FileData *fd, const void *old, void *new)
 {
 	int i;
 	
-	/* use a binary search if we have a sorted libmap, for now it's not needed. */
-	BLI_assert(fd->libmap->sorted == false);
-
 	for (i = 0; i < fd->libmap->nentries; i++) {
 		OldNew *entry = &fd->libmap->entries[i];
 		
@@ -1882,12 +2213,10 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
 /* ********** END OLD POINTERS ****************** */
 /* ********** READ FILE ****************** */
 
-static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
+static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead, char *data)
 {
 	int blocksize, nblocks;
-	char *data;
 	
-	data = (char *)(bhead+1);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1903,18 +2232,20 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 	void *temp = NULL;
 	
 	if (bh->len) {
+		char *data = blo_bhead_data(fd, bh);
+
 		/* switch is based on file dna */
 		if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN))
-			switch_endian_structs(fd->filesdna, bh);
+			switch_endian_structs(fd->filesdna, bh, data);
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, data);
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, data, bh->len);
 			}
 		}
 	}
@@ -2525,7 +2856,7 @@ static void direct_link_fcurves(FileData *fd, ListBase *list)
 		fcu->rna_path = newdataadr(fd, fcu->rna_path);
 		
 		/* group */
-		fcu->grp = newdataadr_ex(fd, fcu->grp, false);
+		fcu->grp = newdataadr(fd, fcu->grp);
 		
 		/* clear disabled flag - allows disabled drivers to be tried again ([#32155]),
 		 * but also means that another method for "reviving disabled F-Curves" exists
@@ -4395,7 +4726,7 @@ static void direct_link_particlesystems(FileData *fd, ListBase *particles)
 		}
 
 		psys->tree = NULL;
-		psys->bvhtree = NULL;
+		psys->spatial_hash = NULL;
 	}
 	return;
 }
@@ -8139,6 +8470,96 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
 	return bhead;
 }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+/**
+ * Linking direct data only resolves pointers within the data of a single ID,
+ * so for ID types which don't access any other state while doing so,
+ * it can be done for many ID's at once, each using its own data map.
+ */
+typedef struct DirectLinkDeferred {
+	ID *id;
+	OldNewMap *datamap;
+} DirectLinkDeferred;
+
+typedef struct DirectLinkDeferredData {
+	const FileData *fd;
+	DirectLinkDeferred **deferred;
+} DirectLinkDeferredData;
+
+static bool direct_link_can_defer(const short idcode)
+{
+	return ELEM(idcode, ID_ME, ID_IM, ID_NT, ID_AC);
+}
+
+static void direct_link_deferred_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	DirectLinkDeferredData *data = userdata;
+	DirectLinkDeferred *deferred = data->deferred[index];
+	ID *id = deferred->id;
+	/* shallow copy, only the data map differs */
+	FileData fd = *data->fd;
+
+	fd.datamap = deferred->datamap;
+
+	direct_link_id(&fd, id);
+
+	switch (GS(id->name)) {
+		case ID_ME:
+			direct_link_mesh(&fd, (Mesh *)id);
+			break;
+		case ID_IM:
+			direct_link_image(&fd, (Image *)id);
+			break;
+		case ID_NT:
+			direct_link_nodetree(&fd, (bNodeTree *)id);
+			break;
+		case ID_AC:
+			direct_link_action(&fd, (bAction *)id);
+			break;
+		default:
+			BLI_assert(0);
+			break;
+	}
+
+	oldnewmap_free_unused(deferred->datamap);
+	oldnewmap_free(deferred->datamap);
+	MEM_freeN(deferred);
+}
+
+/**
+ * Link direct data of all ID's deferred by #read_libblock.
+ */
+static void direct_link_deferred_all(FileData *fd)
+{
+	const int deferred_len = BLI_linklist_count(fd->direct_link_deferred);
+	DirectLinkDeferredData data;
+	int i;
+
+	if (deferred_len == 0) {
+		return;
+	}
+
+	data.fd = fd;
+	data.deferred = MEM_malloc_arrayN((size_t)deferred_len, sizeof(*data.deferred), __func__);
+	i = 0;
+	for (LinkNode *link = fd->direct_link_deferred; link; link = link->next) {
+		data.deferred[i++] = link->link;
+	}
+	BLI_linklist_free(fd->direct_link_deferred, NULL);
+	fd->direct_link_deferred = NULL;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	BLI_task_parallel_range(0, deferred_len, &data, direct_link_deferred_cb, &settings);
+
+	MEM_freeN(data.deferred);
+}
+#endif  /* USE_PARALLEL_DIRECT_LINK */
+
 static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short tag, ID **r_id)
 {
 	/* this routine reads a libblock and its direct data. Use link functions to connect it all
@@ -8244,6 +8665,16 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	
 	/* read all data into fd->datamap */
 	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+	if ((fd->flags & FD_FLAGS_DEFER_DIRECT_LINK) && direct_link_can_defer(GS(id->name))) {
+		DirectLinkDeferred *deferred = MEM_mallocN(sizeof(*deferred), __func__);
+		deferred->id = id;
+		deferred->datamap = oldnewmap_move_fit(fd->datamap);
+		BLI_linklist_prepend(&fd->direct_link_deferred, deferred);
+		return bhead;
+	}
+#endif
 	
 	/* init pointers direct data */
 	direct_link_id(fd, id);
@@ -8506,8 +8937,6 @@ static void do_versions_after_linking(Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
-	
 	/* No load UI for undo memfiles */
 	if (fd->memfile == NULL) {
 		lib_link_windowmanager(fd, main);
@@ -8664,6 +9093,13 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+	/* Not for undo, where image, sound... data may be restored from the old main. */
+	if (fd->memfile == NULL) {
+		fd->flags |= FD_FLAGS_DEFER_DIRECT_LINK;
+	}
+#endif
+
 	while (bhead) {
 		switch (bhead->code) {
 		case DATA:
@@ -8711,6 +9147,11 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 			}
 		}
 	}
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+	fd->flags &= ~FD_FLAGS_DEFER_DIRECT_LINK;
+	direct_link_deferred_all(fd);
+#endif
 	
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
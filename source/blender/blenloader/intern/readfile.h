@@ -37,6 +37,7 @@
 #include "DNA_windowmanager_types.h"  /* for ReportType */
 
 struct OldNewMap;
+struct FileDataLzo;
 struct MemFile;
 struct ReportList;
 struct Object;
@@ -61,6 +62,12 @@ typedef struct FileData {
 	// variables needed for reading from file
 	int filedes;
 	gzFile gzfiledes;
+	/* frame compressed file, see: BLEN_LZO_MAGIC */
+	struct FileDataLzo *lzo;
+	/* memory mapped (uncompressed) file, see: USE_BHEAD_MMAP */
+	char *mmap;
+	size_t mmap_size;
+	size_t mmap_offset;
 
 	// now only in use for library appending
 	char relabase[FILE_MAX];
@@ -96,6 +103,9 @@ typedef struct FileData {
 
 	/* see: USE_GHASH_BHEAD */
 	struct GHash *bhead_idname_hash;
+
+	/* see: USE_PARALLEL_DIRECT_LINK */
+	struct LinkNode *direct_link_deferred;
 	
 	ListBase *mainlist;
 	ListBase *old_mainlist;  /* Used for undo. */
@@ -109,6 +119,10 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* When false, the data isn't stored after the #BHead, see #blo_bhead_data. */
+	bool has_data;
+	/* Offset of the data in #FileData.mmap. */
+	size_t mmap_offset;
 	struct BHead bhead;
 } BHeadN;
 
@@ -120,6 +134,7 @@ enum {
 	FD_FLAGS_FILE_OK               = 1 << 3,
 	FD_FLAGS_NOT_MY_BUFFER         = 1 << 4,
 	FD_FLAGS_NOT_MY_LIBMAP         = 1 << 5,  /* XXX Unused in practice (checked once but never set). */
+	FD_FLAGS_DEFER_DIRECT_LINK     = 1 << 6,  /* See: USE_PARALLEL_DIRECT_LINK */
 };
 
 #define SIZEOFBLENDERHEADER 12
@@ -153,6 +168,7 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
 
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
+void *blo_bhead_data(FileData *fd, BHead *bhead);
 
 /* do versions stuff */
 
@@ -40,11 +40,19 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* Note: chunks are deduplicated here rather than stored in a BLI_array_store,
+ * which needs the whole file as one array: writing would have to build a flat
+ * copy of the file on every push, and reading would have to expand it again,
+ * while the reader works on chunks directly. Every ID is still written, recalc
+ * tags are cleared by evaluation and can't tell what changed since the last push. */
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
@@ -62,46 +70,93 @@ void BLO_memfile_free(MemFile *memfile)
 /* result is that 'first' is being freed */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
+	/* Chunks are shared by content, not by position, collect the buffers
+	 * 'second' takes over so 'first' doesn't free them. */
+	GSet *buf_shared = BLI_gset_ptr_new(__func__);
 	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
+
+	for (sc = second->chunks.first; sc; sc = sc->next) {
+		if (sc->ident) {
+			/* several chunks may share the same buffer, only one owns it */
+			if (BLI_gset_add(buf_shared, sc->buf)) {
 				sc->ident = 0;
-				fc->ident = 1;
 			}
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
 	}
-	
+
+	for (fc = first->chunks.first; fc; fc = fc->next) {
+		if (fc->ident == 0 && BLI_gset_haskey(buf_shared, fc->buf)) {
+			fc->ident = 1;
+		}
+	}
+
+	BLI_gset_free(buf_shared, NULL);
+
 	BLO_memfile_free(first);
 }
 
-void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
+BLI_INLINE unsigned int memfile_chunk_hash(MemFileChunk *chunk)
 {
-	static MemFileChunk *compchunk = NULL;
-	MemFileChunk *curchunk;
-	
-	/* this function inits when compare != NULL or when current == NULL  */
-	if (compare) {
-		compchunk = compare->chunks.first;
-		return;
+	if (!chunk->hash_valid) {
+		chunk->hash = BLI_hash_mm2((const unsigned char *)chunk->buf, chunk->size, 0);
+		chunk->hash_valid = true;
 	}
-	if (current == NULL) {
-		compchunk = NULL;
+	return chunk->hash;
+}
+
+/**
+ * Map all remaining chunks of the compare memfile by hash,
+ * allows finding unchanged chunks after data was inserted or removed.
+ */
+static void memfile_compare_chunks_by_hash_ensure(MemFileWriteData *mem_data)
+{
+	MemFileChunk *chunk;
+
+	if (mem_data->compare_chunks_by_hash) {
 		return;
 	}
+
+	mem_data->compare_chunks_by_hash = BLI_ghash_int_new(__func__);
+	for (chunk = mem_data->compare->chunks.first; chunk; chunk = chunk->next) {
+		void **val_p;
+		if (!BLI_ghash_ensure_p(mem_data->compare_chunks_by_hash,
+		                        SET_UINT_IN_POINTER(memfile_chunk_hash(chunk)), &val_p))
+		{
+			*val_p = chunk;
+		}
+	}
+}
+
+void memfile_write_init(MemFileWriteData *mem_data, MemFile *compare, MemFile *current)
+{
+	mem_data->current = current;
+	mem_data->compare = compare;
+	mem_data->compare_chunk = compare ? compare->chunks.first : NULL;
+	mem_data->compare_chunks_by_hash = NULL;
+}
+
+void memfile_write_finalize(MemFileWriteData *mem_data)
+{
+	if (mem_data->compare_chunks_by_hash) {
+		BLI_ghash_free(mem_data->compare_chunks_by_hash, NULL, NULL);
+		mem_data->compare_chunks_by_hash = NULL;
+	}
+}
+
+void memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, unsigned int size)
+{
+	MemFile *current = mem_data->current;
+	MemFileChunk *compchunk = mem_data->compare_chunk;
+	MemFileChunk *curchunk;
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
 	curchunk->buf = NULL;
 	curchunk->ident = 0;
+	curchunk->hash_valid = false;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	/* we compare compchunk with buf, while data stays aligned this is all that's needed */
 	if (compchunk) {
 		if (compchunk->size == curchunk->size) {
 			if (memcmp(compchunk->buf, buf, size) == 0) {
@@ -109,7 +164,30 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 				curchunk->ident = 1;
 			}
 		}
-		compchunk = compchunk->next;
+	}
+
+	/* otherwise look the chunk up by hash, and continue comparing after the match */
+	if (curchunk->buf == NULL && mem_data->compare) {
+		memfile_compare_chunks_by_hash_ensure(mem_data);
+
+		curchunk->hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+		curchunk->hash_valid = true;
+
+		MemFileChunk *compchunk_hash = BLI_ghash_lookup(
+		        mem_data->compare_chunks_by_hash, SET_UINT_IN_POINTER(curchunk->hash));
+		if (compchunk_hash && (compchunk_hash->size == size) && (memcmp(compchunk_hash->buf, buf, size) == 0)) {
+			curchunk->buf = compchunk_hash->buf;
+			curchunk->ident = 1;
+			compchunk = compchunk_hash;
+		}
+	}
+
+	if (compchunk) {
+		if (curchunk->ident && compchunk->hash_valid) {
+			curchunk->hash = compchunk->hash;
+			curchunk->hash_valid = true;
+		}
+		mem_data->compare_chunk = compchunk->next;
 	}
 	
 	/* not equal... */
@@ -119,4 +197,3 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 		current->size += size;
 	}
 }
-
@@ -154,6 +154,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -190,6 +191,14 @@
 
 #include <errno.h>
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
 /* ********* my write, buffered writing with minimum size chunks ************ */
 
 /* Use optimal allocation since blocks of this size are kept in memory for undo. */
@@ -203,6 +212,9 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+#ifdef WITH_LZO
+	WW_WRAP_LZO,
+#endif
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -216,6 +228,9 @@ struct WriteWrap {
 	union {
 		int file_handle;
 		gzFile gz_handle;
+#ifdef WITH_LZO
+		struct LzoWriteWrap *lzo_handle;
+#endif
 	} _user_data;
 };
 
@@ -275,6 +290,268 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+#ifdef WITH_LZO
+/* lzo, see: BLEN_LZO_MAGIC */
+#define FILE_HANDLE(ww) \
+	(ww)->_user_data.lzo_handle
+
+#define LZO_OUT_LEN(size)  ((size) + (size) / 16 + 64 + 3)
+/* Avoid large batches on machines with many cores, each batch frame holds ~1mb. */
+#define LZO_BATCH_FRAMES_MAX 16
+
+typedef struct LzoFrame {
+	const unsigned char *raw;
+	unsigned int raw_len;
+	unsigned char *data;
+	unsigned int data_len;
+	lzo_align_t *wrkmem;
+} LzoFrame;
+
+typedef struct LzoBatch {
+	LzoFrame *frames;
+	unsigned int frames_len;
+	unsigned char *raw;
+	size_t raw_len;
+} LzoBatch;
+
+/**
+ * Data is collected into one batch while the frames of the other batch
+ * are compressed by the task scheduler, so compression runs in parallel
+ * with writing the blend-file data.
+ */
+typedef struct LzoWriteWrap {
+	int file_handle;
+	TaskPool *task_pool;
+
+	LzoBatch batch[2];
+	int batch_active;
+	bool batch_pending;
+	unsigned int batch_frames;
+
+	uint64_t *frame_offsets;
+	unsigned int frame_offsets_len, frame_offsets_alloc;
+	uint64_t file_offset;
+} LzoWriteWrap;
+
+static void lzo_encode_u32(unsigned char *buf, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		buf[i] = (unsigned char)(value >> (i * 8));
+	}
+}
+
+static void lzo_encode_u64(unsigned char *buf, uint64_t value)
+{
+	for (int i = 0; i < 8; i++) {
+		buf[i] = (unsigned char)(value >> (i * 8));
+	}
+}
+
+static bool lzo_file_write(LzoWriteWrap *lzo, const void *buf, size_t buf_len)
+{
+	if (write(lzo->file_handle, buf, buf_len) != (ssize_t)buf_len) {
+		return false;
+	}
+	lzo->file_offset += buf_len;
+	return true;
+}
+
+static void lzo_frame_compress_task(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	LzoFrame *frame = taskdata;
+	lzo_uint data_len = LZO_OUT_LEN(BLEN_LZO_FRAME_SIZE);
+
+	const int r = lzo1x_1_compress(frame->raw, frame->raw_len, frame->data, &data_len, frame->wrkmem);
+
+	/* store uncompressed when compression doesn't help */
+	frame->data_len = ((r == LZO_E_OK) && (data_len < frame->raw_len)) ? (unsigned int)data_len : frame->raw_len;
+}
+
+static bool lzo_batch_write(LzoWriteWrap *lzo, LzoBatch *batch)
+{
+	for (unsigned int i = 0; i < batch->frames_len; i++) {
+		LzoFrame *frame = &batch->frames[i];
+		const bool is_stored = (frame->data_len == frame->raw_len);
+		unsigned char header[BLEN_LZO_FRAME_HEADER_SIZE];
+
+		if (lzo->frame_offsets_len == lzo->frame_offsets_alloc) {
+			lzo->frame_offsets_alloc *= 2;
+			lzo->frame_offsets = MEM_reallocN(lzo->frame_offsets, sizeof(*lzo->frame_offsets) * lzo->frame_offsets_alloc);
+		}
+		lzo->frame_offsets[lzo->frame_offsets_len++] = lzo->file_offset;
+
+		lzo_encode_u32(&header[0], frame->raw_len);
+		lzo_encode_u32(&header[4], frame->data_len);
+
+		if (!lzo_file_write(lzo, header, sizeof(header)) ||
+		    !lzo_file_write(lzo, is_stored ? frame->raw : frame->data, frame->data_len))
+		{
+			return false;
+		}
+	}
+
+	batch->frames_len = 0;
+	batch->raw_len = 0;
+	return true;
+}
+
+/* Wait for the batch being compressed and write it out. */
+static bool lzo_batch_finish_pending(LzoWriteWrap *lzo)
+{
+	if (lzo->batch_pending) {
+		BLI_task_pool_work_and_wait(lzo->task_pool);
+		lzo->batch_pending = false;
+		return lzo_batch_write(lzo, &lzo->batch[!lzo->batch_active]);
+	}
+	return true;
+}
+
+/* Start compressing the active batch, continuing to fill the other one. */
+static bool lzo_batch_submit(LzoWriteWrap *lzo)
+{
+	LzoBatch *batch = &lzo->batch[lzo->batch_active];
+
+	if (!lzo_batch_finish_pending(lzo)) {
+		return false;
+	}
+
+	batch->frames_len = (unsigned int)((batch->raw_len + BLEN_LZO_FRAME_SIZE - 1) / BLEN_LZO_FRAME_SIZE);
+	for (unsigned int i = 0; i < batch->frames_len; i++) {
+		LzoFrame *frame = &batch->frames[i];
+		frame->raw_len = (unsigned int)MIN2(batch->raw_len - (size_t)i * BLEN_LZO_FRAME_SIZE, BLEN_LZO_FRAME_SIZE);
+		BLI_task_pool_push(lzo->task_pool, lzo_frame_compress_task, frame, false, TASK_PRIORITY_HIGH);
+	}
+
+	lzo->batch_pending = true;
+	lzo->batch_active = !lzo->batch_active;
+	return true;
+}
+
+/* Close the file and free the handle, without writing anything. */
+static bool lzo_write_wrap_free(LzoWriteWrap *lzo)
+{
+	bool ok;
+
+	BLI_task_pool_free(lzo->task_pool);
+	for (int b = 0; b < 2; b++) {
+		LzoBatch *batch = &lzo->batch[b];
+		for (unsigned int i = 0; i < lzo->batch_frames; i++) {
+			MEM_freeN(batch->frames[i].data);
+			MEM_freeN(batch->frames[i].wrkmem);
+		}
+		MEM_freeN(batch->frames);
+		MEM_freeN(batch->raw);
+	}
+	MEM_freeN(lzo->frame_offsets);
+
+	ok = (close(lzo->file_handle) != -1);
+	MEM_freeN(lzo);
+
+	return ok;
+}
+
+static bool ww_open_lzo(WriteWrap *ww, const char *filepath)
+{
+	LzoWriteWrap *lzo;
+	int file;
+
+	if (lzo_init() != LZO_E_OK) {
+		return false;
+	}
+
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+	if (file == -1) {
+		return false;
+	}
+
+	lzo = MEM_callocN(sizeof(*lzo), __func__);
+	lzo->file_handle = file;
+	lzo->task_pool = BLI_task_pool_create(BLI_task_scheduler_get(), NULL);
+	lzo->batch_frames = (unsigned int)CLAMPIS(BLI_system_thread_count(), 1, LZO_BATCH_FRAMES_MAX);
+
+	for (int b = 0; b < 2; b++) {
+		LzoBatch *batch = &lzo->batch[b];
+		batch->raw = MEM_mallocN((size_t)lzo->batch_frames * BLEN_LZO_FRAME_SIZE, "lzo batch raw");
+		batch->frames = MEM_callocN(sizeof(*batch->frames) * lzo->batch_frames, "lzo batch frames");
+		for (unsigned int i = 0; i < lzo->batch_frames; i++) {
+			LzoFrame *frame = &batch->frames[i];
+			frame->raw = batch->raw + (size_t)i * BLEN_LZO_FRAME_SIZE;
+			frame->data = MEM_mallocN(LZO_OUT_LEN(BLEN_LZO_FRAME_SIZE), "lzo frame data");
+			frame->wrkmem = MEM_mallocN(LZO1X_1_MEM_COMPRESS, "lzo frame wrkmem");
+		}
+	}
+
+	lzo->frame_offsets_alloc = 64;
+	lzo->frame_offsets = MEM_mallocN(sizeof(*lzo->frame_offsets) * lzo->frame_offsets_alloc, __func__);
+
+	if (!lzo_file_write(lzo, BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN)) {
+		lzo_write_wrap_free(lzo);
+		return false;
+	}
+
+	FILE_HANDLE(ww) = lzo;
+
+	return true;
+}
+static bool ww_close_lzo(WriteWrap *ww)
+{
+	LzoWriteWrap *lzo = FILE_HANDLE(ww);
+	bool ok = true;
+
+	if (lzo->batch[lzo->batch_active].raw_len != 0) {
+		ok = lzo_batch_submit(lzo);
+	}
+	ok = lzo_batch_finish_pending(lzo) && ok;
+
+	if (ok) {
+		const size_t index_len = sizeof(uint64_t) * lzo->frame_offsets_len;
+		unsigned char *index = MEM_mallocN(index_len + BLEN_LZO_FOOTER_SIZE, __func__);
+		unsigned char *footer = index + index_len;
+
+		for (unsigned int i = 0; i < lzo->frame_offsets_len; i++) {
+			lzo_encode_u64(&index[i * sizeof(uint64_t)], lzo->frame_offsets[i]);
+		}
+		lzo_encode_u32(&footer[0], lzo->frame_offsets_len);
+		lzo_encode_u32(&footer[4], BLEN_LZO_FRAME_SIZE);
+		memcpy(&footer[8], BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN);
+
+		ok = lzo_file_write(lzo, index, index_len + BLEN_LZO_FOOTER_SIZE);
+		MEM_freeN(index);
+	}
+
+	ok = lzo_write_wrap_free(lzo) && ok;
+
+	return ok;
+}
+static size_t ww_write_lzo(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	LzoWriteWrap *lzo = FILE_HANDLE(ww);
+	const size_t batch_size = (size_t)lzo->batch_frames * BLEN_LZO_FRAME_SIZE;
+	size_t written = 0;
+
+	while (written < buf_len) {
+		LzoBatch *batch = &lzo->batch[lzo->batch_active];
+		const size_t len = MIN2(buf_len - written, batch_size - batch->raw_len);
+
+		memcpy(batch->raw + batch->raw_len, buf + written, len);
+		batch->raw_len += len;
+		written += len;
+
+		if (batch->raw_len == batch_size) {
+			if (!lzo_batch_submit(lzo)) {
+				return 0;
+			}
+		}
+	}
+
+	return buf_len;
+}
+#undef LZO_BATCH_FRAMES_MAX
+#undef LZO_OUT_LEN
+#undef FILE_HANDLE
+#endif  /* WITH_LZO */
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -289,6 +566,15 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 			r_ww->write = ww_write_zlib;
 			break;
 		}
+#ifdef WITH_LZO
+		case WW_WRAP_LZO:
+		{
+			r_ww->open  = ww_open_lzo;
+			r_ww->close = ww_close_lzo;
+			r_ww->write = ww_write_lzo;
+			break;
+		}
+#endif
 		default:
 		{
 			r_ww->open  = ww_open_none;
@@ -307,7 +593,8 @@ typedef struct {
 	const struct SDNA *sdna;
 
 	unsigned char *buf;
-	MemFile *compare, *current;
+	MemFile *current;
+	MemFileWriteData mem_data;
 
 	int tot, count;
 	bool error;
@@ -347,7 +634,7 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
 	/* memory based save */
 	if (wd->current) {
-		memfile_chunk_add(NULL, wd->current, mem, memlen);
+		memfile_chunk_add(&wd->mem_data, mem, memlen);
 	}
 	else {
 		if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
@@ -439,10 +726,11 @@ static WriteData *bgnwrite(WriteWrap *ww, MemFile *compare, MemFile *current)
 		return NULL;
 	}
 
-	wd->compare = compare;
 	wd->current = current;
-	/* this inits comparing */
-	memfile_chunk_add(compare, NULL, NULL, 0);
+	if (current) {
+		/* this inits comparing */
+		memfile_write_init(&wd->mem_data, compare, current);
+	}
 
 	return wd;
 }
@@ -460,6 +748,10 @@ static bool endwrite(WriteData *wd)
 		wd->count = 0;
 	}
 
+	if (wd->current) {
+		memfile_write_finalize(&wd->mem_data);
+	}
+
 	const bool err = wd->error;
 	writedata_free(wd);
 
@@ -4046,7 +4338,11 @@ bool BLO_write_file(
 	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
 	if (write_flags & G_FILE_COMPRESS) {
+#ifdef WITH_LZO
+		ww_type = (write_flags & G_FILE_COMPRESS_FAST) ? WW_WRAP_LZO : WW_WRAP_ZLIB;
+#else
 		ww_type = WW_WRAP_ZLIB;
+#endif
 	}
 	else {
 		ww_type = WW_WRAP_NONE;
@@ -4095,9 +4391,11 @@ bool BLO_write_file(
 	}
 
 	/* actual file writing */
-	const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+	bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
 
-	ww.close(&ww);
+	if (ww.close(&ww) == false) {
+		err = true;
+	}
 
 	if (UNLIKELY(path_list_backup)) {
 		BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
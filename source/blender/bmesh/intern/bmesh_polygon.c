@@ -1370,7 +1370,9 @@ void BM_mesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptri
 	BMFace *efa;
 	int i = 0;
 
+	/* Thread's scratch arena, avoids creating an arena on every tessellation. */
 	MemArena *arena = NULL;
+	MemArenaMark arena_mark;
 
 	BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
 		/* don't consider two-edged faces */
@@ -1455,7 +1457,7 @@ void BM_mesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptri
 			const int totfilltri = efa->len - 2;
 
 			if (UNLIKELY(arena == NULL)) {
-				arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+				arena = BLI_memarena_scope_begin(&arena_mark);
 			}
 
 			tris = BLI_memarena_alloc(arena, sizeof(*tris) * totfilltri);
@@ -1483,12 +1485,12 @@ void BM_mesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptri
 				l_ptr[2] = l_arr[tri[2]];
 			}
 
-			BLI_memarena_clear(arena);
+			BLI_memarena_release_to_mark(arena, &arena_mark);
 		}
 	}
 
 	if (arena) {
-		BLI_memarena_free(arena);
+		BLI_memarena_scope_end(&arena_mark);
 		arena = NULL;
 	}
 
@@ -187,6 +187,36 @@ void DEG_evaluate_on_refresh(struct EvaluationContext *eval_ctx,
 
 bool DEG_needs_eval(Depsgraph *graph);
 
+/* Partial Evaluation  --------------------------- */
+
+/* Data which is to be evaluated by partial evaluation. */
+typedef struct DEGEvalTarget {
+	struct ID *id;
+	/* eDepsObjectComponentType, or DEG_EVAL_TARGET_ALL_COMPONENTS to evaluate
+	 * the whole ID.
+	 */
+	int component;
+} DEGEvalTarget;
+
+#define DEG_EVAL_TARGET_ALL_COMPONENTS -1
+
+/* Frame changed recalculation of the given targets only.
+ *
+ * Evaluates the targets and everything they depend on, skipping the rest of
+ * the graph. Skipped operations stay tagged, so regular evaluation brings them
+ * up to date later on.
+ *
+ * < ctime: (frame) new frame to evaluate values on
+ * > returns: time spent in the call, in seconds
+ */
+double DEG_evaluate_targets_on_framechange(struct EvaluationContext *eval_ctx,
+                                           struct Main *bmain,
+                                           Depsgraph *graph,
+                                           float ctime,
+                                           const unsigned int layers,
+                                           const DEGEvalTarget *targets,
+                                           int num_targets);
+
 /* Editors Integration  -------------------------- */
 
 /* Mechanism to allow editors to be informed of depsgraph updates,
@@ -66,6 +66,11 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given object for update, in all the graphs.
+ * Only this object and ones depending on it are rebuilt then.
+ */
+void DEG_id_relations_tag_update(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -0,0 +1,231 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.cc
+ *  \ingroup depsgraph
+ *
+ * Partial rebuild of the graph when only some objects changed their relations.
+ *
+ * Nodes of the tagged objects and of everything which depends on them are
+ * removed and built again, the rest of the graph (including the evaluation
+ * statistics of its operations) is kept as is.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+
+extern "C" {
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_modifier.h"
+} /* extern "C" */
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+namespace {
+
+/* Objects which affect other objects without explicit relations to them,
+ * or which need scene level data to be rebuilt.
+ */
+bool object_needs_full_rebuild(Object *object)
+{
+	if (object->pd != NULL && object->pd->forcefield != 0) {
+		return true;
+	}
+	if (modifiers_findByType(object, eModifierType_Collision) != NULL) {
+		return true;
+	}
+	if (object->rigidbody_object != NULL ||
+	    object->rigidbody_constraint != NULL)
+	{
+		return true;
+	}
+	if (object->proxy != NULL ||
+	    object->proxy_group != NULL ||
+	    object->proxy_from != NULL)
+	{
+		return true;
+	}
+	return false;
+}
+
+void add_id_node_to_rebuild(IDDepsNode *id_node,
+                            GSet *rebuild_set,
+                            vector<IDDepsNode *> *rebuild_nodes)
+{
+	if (BLI_gset_add(rebuild_set, id_node)) {
+		rebuild_nodes->push_back(id_node);
+	}
+}
+
+}  // namespace
+
+bool deg_graph_build_incremental(Main *bmain, Depsgraph *graph, Scene *scene)
+{
+	GSet *tags = graph->id_relations_tags;
+	/* Tagged objects which are in the scene, only those are safe to access:
+	 * the other ones might have been freed already.
+	 */
+	GSet *objects = BLI_gset_ptr_new(__func__);
+	BLI_LISTBASE_FOREACH (Base *, base, &scene->base) {
+		if (BLI_gset_haskey(tags, base->object)) {
+			BLI_gset_add(objects, base->object);
+		}
+	}
+	for (Scene *set = scene->set; set != NULL; set = set->set) {
+		BLI_LISTBASE_FOREACH (Base *, base, &set->base) {
+			if (BLI_gset_haskey(tags, base->object)) {
+				BLI_gset_free(objects, NULL);
+				return false;
+			}
+		}
+	}
+	GSET_FOREACH_BEGIN(Object *, object, objects)
+	{
+		if (object_needs_full_rebuild(object)) {
+			BLI_gset_free(objects, NULL);
+			return false;
+		}
+	}
+	GSET_FOREACH_END();
+
+	/* Collect nodes of tagged IDs and everything depending on them. */
+	GSet *rebuild_set = BLI_gset_ptr_new(__func__);
+	vector<IDDepsNode *> rebuild_nodes;
+	GSET_FOREACH_BEGIN(ID *, id, tags)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node != NULL) {
+			add_id_node_to_rebuild(id_node, rebuild_set, &rebuild_nodes);
+		}
+	}
+	GSET_FOREACH_END();
+	bool need_full_rebuild = false;
+	for (size_t i = 0; i < rebuild_nodes.size() && !need_full_rebuild; ++i) {
+		IDDepsNode *id_node = rebuild_nodes[i];
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *op_node, comp_node->operations) {
+				foreach (DepsRelation *rel, op_node->outlinks) {
+					OperationDepsNode *to = (OperationDepsNode *)rel->to;
+					IDDepsNode *to_id_node = to->owner->owner;
+					if (BLI_gset_haskey(rebuild_set, to_id_node)) {
+						continue;
+					}
+					/* Tagged IDs were checked above, dependents are not
+					 * tagged so they are still valid.
+					 */
+					ID *to_id = to_id_node->id;
+					if (GS(to_id->name) != ID_OB ||
+					    object_needs_full_rebuild((Object *)to_id))
+					{
+						need_full_rebuild = true;
+						break;
+					}
+					BLI_gset_add(objects, to_id);
+					add_id_node_to_rebuild(to_id_node,
+					                       rebuild_set,
+					                       &rebuild_nodes);
+				}
+				if (need_full_rebuild) {
+					break;
+				}
+			}
+			if (need_full_rebuild) {
+				break;
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	/* Rebuilding most of the graph is not cheaper than building it from
+	 * scratch, and the latter one is more robust.
+	 */
+	if (rebuild_nodes.size() * 2 > graph->id_nodes.size()) {
+		need_full_rebuild = true;
+	}
+	BLI_gset_free(rebuild_set, NULL);
+	if (need_full_rebuild) {
+		BLI_gset_free(objects, NULL);
+		return false;
+	}
+
+	DEG_DEBUG_PRINTF("Incremental relations update: %u tagged, %d rebuilt\n",
+	                 BLI_gset_size(tags),
+	                 (int)rebuild_nodes.size());
+
+	graph->remove_id_nodes(rebuild_nodes);
+
+	/* Builders use LIB_TAG_DOIT to skip IDs which already have nodes. */
+	vector<ID *> kept_ids;
+	kept_ids.reserve(graph->id_nodes.size());
+	foreach (IDDepsNode *id_node, graph->id_nodes) {
+		kept_ids.push_back(id_node->id);
+	}
+
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build();
+	foreach (ID *id, kept_ids) {
+		id->tag |= LIB_TAG_DOIT;
+	}
+	node_builder.build_scene_objects(scene, objects);
+
+	DepsgraphRelationBuilder relation_builder(bmain, graph);
+	relation_builder.begin_build();
+	foreach (ID *id, kept_ids) {
+		id->tag |= LIB_TAG_DOIT;
+	}
+	relation_builder.build_scene_objects(scene, objects);
+
+	BLI_gset_free(objects, NULL);
+
+	deg_graph_detect_cycles(graph);
+	deg_graph_build_finalize(graph);
+	return true;
+}
+
+}  // namespace DEG
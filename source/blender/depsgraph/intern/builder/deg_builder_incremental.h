@@ -0,0 +1,45 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.h
+ *  \ingroup depsgraph
+ */
+
+#pragma once
+
+struct Main;
+struct Scene;
+
+namespace DEG {
+
+struct Depsgraph;
+
+/* Rebuild nodes and relations of the IDs tagged in graph->id_relations_tags
+ * and of everything depending on them, keeping the rest of the graph.
+ *
+ * Returns false without touching the graph when the change can not be
+ * handled locally, full rebuild is needed then.
+ */
+bool deg_graph_build_incremental(Main *bmain, Depsgraph *graph, Scene *scene);
+
+}  // namespace DEG
@@ -37,6 +37,7 @@ struct CacheFile;
 struct bGPdata;
 struct ListBase;
 struct GHash;
+struct GSet;
 struct ID;
 struct Image;
 struct FCurve;
@@ -119,6 +120,7 @@ struct DepsgraphNodeBuilder {
 	                                       int name_tag = -1);
 
 	void build_scene(Scene *scene);
+	void build_scene_objects(Scene *scene, GSet *objects);
 	void build_group(Base *base, Group *group);
 	void build_object(Base *base, Object *object);
 	void build_object_data(Object *object);
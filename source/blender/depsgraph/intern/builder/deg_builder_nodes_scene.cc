@@ -39,6 +39,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_string.h"
 
 extern "C" {
@@ -122,4 +123,27 @@ void DepsgraphNodeBuilder::build_scene(Scene *scene)
 	                   "Scene Eval");
 }
 
+/* Only build nodes of the given objects, used by incremental updates where
+ * the rest of the graph is kept from the previous build.
+ */
+void DepsgraphNodeBuilder::build_scene_objects(Scene *scene, GSet *objects)
+{
+	scene_ = scene;
+	/* Objects linked to the scene first, so they get their base flags. */
+	BLI_LISTBASE_FOREACH (Base *, base, &scene->base) {
+		Object *object = base->object;
+		if (BLI_gset_haskey(objects, object)) {
+			build_object(base, object);
+		}
+	}
+	/* Objects only reachable from other objects (parents, modifiers ...). */
+	GSET_FOREACH_BEGIN(Object *, object, objects)
+	{
+		if ((object->id.tag & LIB_TAG_DOIT) == 0) {
+			build_object(NULL, object);
+		}
+	}
+	GSET_FOREACH_END();
+}
+
 }  // namespace DEG
@@ -52,6 +52,7 @@ struct bGPdata;
 struct CacheFile;
 struct ListBase;
 struct GHash;
+struct GSet;
 struct ID;
 struct FCurve;
 struct Group;
@@ -190,6 +191,8 @@ struct DepsgraphRelationBuilder
 	                              bool check_unique = false);
 
 	void build_scene(Scene *scene);
+	void build_scene_objects(Scene *scene, GSet *objects);
+	void build_object_customdata_masks();
 	void build_group(Object *object, Group *group);
 	void build_object(Object *object);
 	void build_object_data(Object *object);
@@ -40,6 +40,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 
 extern "C" {
 #include "DNA_node_types.h"
@@ -108,6 +109,25 @@ void DepsgraphRelationBuilder::build_scene(Scene *scene)
 	BLI_LISTBASE_FOREACH (MovieClip *, clip, &bmain_->movieclip) {
 		build_movieclip(clip);
 	}
+	build_object_customdata_masks();
+}
+
+/* Only build relations of the given objects, used by incremental updates where
+ * the rest of the graph is kept from the previous build.
+ */
+void DepsgraphRelationBuilder::build_scene_objects(Scene *scene, GSet *objects)
+{
+	scene_ = scene;
+	GSET_FOREACH_BEGIN(Object *, object, objects)
+	{
+		build_object(object);
+	}
+	GSET_FOREACH_END();
+	build_object_customdata_masks();
+}
+
+void DepsgraphRelationBuilder::build_object_customdata_masks()
+{
 	for (Depsgraph::OperationNodes::const_iterator it_op = graph_->operations.begin();
 	     it_op != graph_->operations.end();
 	     ++it_op)
@@ -87,6 +87,7 @@ Depsgraph::Depsgraph()
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
@@ -94,6 +95,7 @@ Depsgraph::~Depsgraph()
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
@@ -300,6 +302,53 @@ void Depsgraph::clear_id_nodes()
 	id_nodes.clear();
 }
 
+void Depsgraph::remove_id_nodes(const vector<IDDepsNode *>& nodes)
+{
+	if (nodes.empty()) {
+		return;
+	}
+	GSet *removed_nodes = BLI_gset_ptr_new_ex(__func__, nodes.size());
+	foreach (IDDepsNode *id_node, nodes) {
+		BLI_gset_add(removed_nodes, id_node);
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *op_node, comp_node->operations) {
+				BLI_gset_remove(entry_tags, op_node, NULL);
+				while (!op_node->inlinks.empty()) {
+					DepsRelation *rel = op_node->inlinks.back();
+					rel->unlink();
+					OBJECT_GUARDED_DELETE(rel, DepsRelation);
+				}
+				while (!op_node->outlinks.empty()) {
+					DepsRelation *rel = op_node->outlinks.back();
+					rel->unlink();
+					OBJECT_GUARDED_DELETE(rel, DepsRelation);
+				}
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	/* Keep order of the remaining nodes. */
+	size_t num_operations = 0;
+	foreach (OperationDepsNode *op_node, operations) {
+		if (!BLI_gset_haskey(removed_nodes, op_node->owner->owner)) {
+			operations[num_operations++] = op_node;
+		}
+	}
+	operations.resize(num_operations);
+	size_t num_id_nodes = 0;
+	foreach (IDDepsNode *id_node, id_nodes) {
+		if (!BLI_gset_haskey(removed_nodes, id_node)) {
+			id_nodes[num_id_nodes++] = id_node;
+		}
+	}
+	id_nodes.resize(num_id_nodes);
+	foreach (IDDepsNode *id_node, nodes) {
+		BLI_ghash_remove(id_hash, id_node->id, NULL, id_node_deleter);
+	}
+	BLI_gset_free(removed_nodes, NULL);
+}
+
 /* Add new relationship between two nodes. */
 DepsRelation *Depsgraph::add_new_relation(OperationDepsNode *from,
                                           OperationDepsNode *to,
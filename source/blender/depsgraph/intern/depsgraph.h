@@ -117,6 +117,10 @@ struct Depsgraph {
 	IDDepsNode *find_id_node(const ID *id) const;
 	IDDepsNode *add_id_node(ID *id, const char *name = "");
 	void clear_id_nodes();
+	/* Remove given ID nodes together with all relations to and from their
+	 * operations.
+	 */
+	void remove_id_nodes(const vector<IDDepsNode *>& nodes);
 
 	/* Add new relationship between two nodes. */
 	DepsRelation *add_new_relation(OperationDepsNode *from,
@@ -162,6 +166,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations are to be updated, used when only some IDs changed
+	 * and there is no need to rebuild the whole graph.
+	 */
+	GSet *id_relations_tags;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
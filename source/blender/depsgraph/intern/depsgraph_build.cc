@@ -60,6 +60,7 @@ extern "C" {
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -88,7 +89,7 @@ static DEG::eDepsNode_Type deg_build_scene_component_type(
 	return DEG::DEG_NODE_TYPE_UNDEFINED;
 }
 
-static DEG::eDepsNode_Type deg_build_object_component_type(
+DEG::eDepsNode_Type DEG::deg_build_object_component_type(
         eDepsObjectComponentType component)
 {
 	switch (component) {
@@ -129,7 +130,7 @@ void DEG_add_object_relation(DepsNodeHandle *handle,
                              eDepsObjectComponentType component,
                              const char *description)
 {
-	DEG::eDepsNode_Type type = deg_build_object_component_type(component);
+	DEG::eDepsNode_Type type = DEG::deg_build_object_component_type(component);
 	DEG::ComponentKey comp_key(&object->id, type);
 	DEG::DepsNodeHandle *deg_handle = get_handle(handle);
 	deg_handle->builder->add_node_handle_relation(comp_key,
@@ -142,7 +143,7 @@ void DEG_add_object_cache_relation(DepsNodeHandle *handle,
                                    eDepsObjectComponentType component,
                                    const char *description)
 {
-	DEG::eDepsNode_Type type = deg_build_object_component_type(component);
+	DEG::eDepsNode_Type type = DEG::deg_build_object_component_type(component);
 	DEG::ComponentKey comp_key(&cache_file->id, type);
 	DEG::DepsNodeHandle *deg_handle = get_handle(handle);
 	deg_handle->builder->add_node_handle_relation(comp_key,
@@ -156,7 +157,7 @@ void DEG_add_bone_relation(DepsNodeHandle *handle,
                            eDepsObjectComponentType component,
                            const char *description)
 {
-	DEG::eDepsNode_Type type = deg_build_object_component_type(component);
+	DEG::eDepsNode_Type type = DEG::deg_build_object_component_type(component);
 	DEG::ComponentKey comp_key(&object->id, type, bone_name);
 	DEG::DepsNodeHandle *deg_handle = get_handle(handle);
 	/* XXX: "Geometry Eval" might not always be true, but this only gets called
@@ -265,6 +266,30 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of a single object for update. */
+void DEG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	/* Only objects are rebuilt incrementally, everything else might be
+	 * used by other IDs in a way which is not visible from the graph.
+	 */
+	if (GS(id->name) != ID_OB) {
+		DEG_relations_tag_update(bmain);
+		return;
+	}
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph != NULL) {
+			DEG::Depsgraph *graph =
+			        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+			if (!graph->need_update) {
+				BLI_gset_add(graph->id_relations_tags, id);
+			}
+		}
+	}
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -279,9 +304,18 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		/* Only some objects changed, try to only rebuild them. */
+		bool done = DEG::deg_graph_build_incremental(bmain, graph, scene);
+		BLI_gset_clear(graph->id_relations_tags, NULL);
+		if (done) {
+			return;
+		}
 	}
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 
 	/* Clear all previous nodes and operations. */
 	graph->clear_all_nodes();
@@ -32,6 +32,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 
@@ -48,10 +50,15 @@ extern "C" {
 #include "intern/eval/deg_eval_flush.h"
 
 #include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
 #include "intern/nodes/deg_node_operation.h"
 #include "intern/nodes/deg_node_time.h"
 
 #include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+
+#include "util/deg_util_foreach.h"
 
 #ifdef WITH_LEGACY_DEPSGRAPH
 static bool use_legacy_depsgraph = true;
@@ -157,3 +164,96 @@ bool DEG_needs_eval(Depsgraph *graph)
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
 	return BLI_gset_size(deg_graph->entry_tags) != 0;
 }
+
+/* Tag operations of the given component and everything they depend on for
+ * partial evaluation.
+ */
+static void deg_partial_tag_component(DEG::ComponentDepsNode *comp_node,
+                                      std::vector<DEG::OperationDepsNode *> *stack)
+{
+	foreach (DEG::OperationDepsNode *op_node, comp_node->operations) {
+		if ((op_node->flag & DEG::DEPSOP_FLAG_PARTIAL_EVAL) == 0) {
+			op_node->flag |= DEG::DEPSOP_FLAG_PARTIAL_EVAL;
+			stack->push_back(op_node);
+		}
+	}
+	while (!stack->empty()) {
+		DEG::OperationDepsNode *op_node = stack->back();
+		stack->pop_back();
+		foreach (DEG::DepsRelation *rel, op_node->inlinks) {
+			if (rel->from->type != DEG::DEG_NODE_TYPE_OPERATION) {
+				continue;
+			}
+			DEG::OperationDepsNode *from = (DEG::OperationDepsNode *)rel->from;
+			if ((from->flag & DEG::DEPSOP_FLAG_PARTIAL_EVAL) == 0) {
+				from->flag |= DEG::DEPSOP_FLAG_PARTIAL_EVAL;
+				stack->push_back(from);
+			}
+		}
+	}
+}
+
+/* Frame-change happened, evaluate given targets only. */
+double DEG_evaluate_targets_on_framechange(EvaluationContext *eval_ctx,
+                                           Main *bmain,
+                                           Depsgraph *graph,
+                                           float ctime,
+                                           const unsigned int layers,
+                                           const DEGEvalTarget *targets,
+                                           int num_targets)
+{
+	const double start_time = PIL_check_seconds_timer();
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	/* Tag the upstream closure of the targets. */
+	std::vector<DEG::OperationDepsNode *> stack;
+	for (int i = 0; i < num_targets; i++) {
+		DEG::IDDepsNode *id_node = deg_graph->find_id_node(targets[i].id);
+		if (id_node == NULL) {
+			continue;
+		}
+		if (targets[i].component == DEG_EVAL_TARGET_ALL_COMPONENTS) {
+			GHASH_FOREACH_BEGIN(DEG::ComponentDepsNode *, comp_node, id_node->components)
+			{
+				deg_partial_tag_component(comp_node, &stack);
+			}
+			GHASH_FOREACH_END();
+		}
+		else {
+			DEG::eDepsNode_Type type = DEG::deg_build_object_component_type(
+			        (eDepsObjectComponentType)targets[i].component);
+			/* Bones are addressed by the pose they belong to. */
+			if (type == DEG::DEG_NODE_TYPE_BONE) {
+				GHASH_FOREACH_BEGIN(DEG::ComponentDepsNode *, comp_node, id_node->components)
+				{
+					if (comp_node->type == type) {
+						deg_partial_tag_component(comp_node, &stack);
+					}
+				}
+				GHASH_FOREACH_END();
+			}
+			else {
+				DEG::ComponentDepsNode *comp_node = id_node->find_component(type);
+				if (comp_node != NULL) {
+					deg_partial_tag_component(comp_node, &stack);
+				}
+			}
+		}
+	}
+	/* Update time on primary timesource. */
+	DEG::TimeSourceDepsNode *tsrc = deg_graph->find_time_source();
+	tsrc->cfra = ctime;
+	tsrc->tag_update(deg_graph);
+	DEG::deg_graph_flush_updates(bmain, deg_graph);
+	/* Perform recalculation updates. */
+	DEG::deg_evaluate_partial(eval_ctx, deg_graph, layers);
+	/* Operations which were not tagged for update are still marked. */
+	foreach (DEG::OperationDepsNode *op_node, deg_graph->operations) {
+		op_node->flag &= ~DEG::DEPSOP_FLAG_PARTIAL_EVAL;
+	}
+	const double time = PIL_check_seconds_timer() - start_time;
+	DEG_DEBUG_PRINTF("%s: %d targets evaluated in %f sec\n",
+	                 __func__,
+	                 num_targets,
+	                 time);
+	return time;
+}
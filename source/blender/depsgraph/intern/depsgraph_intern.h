@@ -41,6 +41,8 @@ extern "C" {
 #include "BKE_global.h"
 }
 
+#include "DEG_depsgraph_build.h"
+
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -103,6 +105,9 @@ void deg_register_node_typeinfo(DepsNodeFactory *factory);
 /* Get typeinfo for specified type */
 DepsNodeFactory *deg_type_get_factory(const eDepsNode_Type type);
 
+/* Get node type of the object component from public API */
+eDepsNode_Type deg_build_object_component_type(eDepsObjectComponentType component);
+
 /* Editors Integration -------------------------------------------------- */
 
 void deg_editors_id_update(struct Main *bmain, struct ID *id);
@@ -327,15 +327,25 @@ void DEG_graph_on_visible_update(Main *bmain, Scene *scene)
 	if (graph->need_update) {
 		return;
 	}
-	/* Special trick to get local view to work.  */
+	/* Special trick to get local view to work.
+	 *
+	 * NOTE: Objects tagged for incremental relations update might not have
+	 * nodes yet, they get proper layers when nodes are built.
+	 */
 	BLI_LISTBASE_FOREACH (Base *, base, &scene->base) {
 		Object *object = base->object;
 		DEG::IDDepsNode *id_node = graph->find_id_node(&object->id);
+		if (id_node == NULL) {
+			continue;
+		}
 		id_node->layers = 0;
 	}
 	BLI_LISTBASE_FOREACH (Base *, base, &scene->base) {
 		Object *object = base->object;
 		DEG::IDDepsNode *id_node = graph->find_id_node(&object->id);
+		if (id_node == NULL) {
+			continue;
+		}
 		id_node->layers |= base->lay;
 		if (object == scene->camera || object->type == OB_CAMERA) {
 			/* Camera should always be updated, it used directly by viewport. */
@@ -346,6 +356,9 @@ void DEG_graph_on_visible_update(Main *bmain, Scene *scene)
 	BLI_LISTBASE_FOREACH (Base *, base, &scene->base) {
 		Object *object = base->object;
 		DEG::IDDepsNode *id_node = graph->find_id_node(&object->id);
+		if (id_node == NULL) {
+			continue;
+		}
 		GHASH_FOREACH_BEGIN(DEG::ComponentDepsNode *, comp, id_node->components)
 		{
 			id_node->layers |= comp->layers;
@@ -32,6 +32,8 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
 #include "PIL_time.h"
 
 #include "BLI_utildefines.h"
@@ -64,47 +66,115 @@ namespace DEG {
 /* ********************** */
 /* Evaluation Entrypoints */
 
-/* Forward declarations. */
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
-                              const int thread_id);
+/* Operations which are known to take less time than this (in seconds) are
+ * considered tiny: their scheduling overhead is comparable with the evaluation
+ * itself, so they are evaluated by the thread which made them ready instead of
+ * going through the task scheduler.
+ */
+#define DEG_EVAL_TINY_TIME 20e-6
+/* Maximum estimated time a thread spends on tiny operations batched from a
+ * single task before the rest of them is pushed to the scheduler.
+ */
+#define DEG_EVAL_BATCH_TIME 100e-6
+#define DEG_EVAL_BATCH_SIZE 64
 
 struct DepsgraphEvalState {
 	EvaluationContext *eval_ctx;
 	Depsgraph *graph;
 	unsigned int layers;
+	/* Flags operation needs to have to be evaluated. */
+	int eval_flag;
 	bool do_stats;
+	/* Per-thread storage of operations which became ready for evaluation,
+	 * indexed by thread_id.
+	 */
+	vector<OperationDepsNode *> *ready_nodes;
+};
+
+/* Operations evaluated by a single task, one after another. */
+struct DepsgraphEvalBatch {
+	OperationDepsNode *nodes[DEG_EVAL_BATCH_SIZE];
+	int num_nodes;
+	double time;
 };
 
+/* Forward declarations. */
+static void schedule_children(TaskPool *pool,
+                              DepsgraphEvalState *state,
+                              OperationDepsNode *node,
+                              DepsgraphEvalBatch *batch,
+                              const int thread_id);
+
+/* Estimated evaluation time of the operation, negative when it is unknown. */
+BLI_INLINE double operation_estimated_time(const OperationDepsNode *node)
+{
+	if (node->is_noop()) {
+		return 0.0;
+	}
+	if (node->stats.num_samples == 0) {
+		return -1.0;
+	}
+	return node->stats.average_time;
+}
+
+BLI_INLINE bool operation_is_tiny(const OperationDepsNode *node)
+{
+	const double time = operation_estimated_time(node);
+	return time >= 0.0 && time < DEG_EVAL_TINY_TIME;
+}
+
+BLI_INLINE bool operation_needs_eval(const OperationDepsNode *node,
+                                     const unsigned int layers,
+                                     const int eval_flag)
+{
+	return (node->owner->owner->layers & layers) != 0 &&
+	       (node->flag & eval_flag) == eval_flag;
+}
+
+static void evaluate_operation(DepsgraphEvalState *state,
+                               OperationDepsNode *node)
+{
+	/* Sanity checks. */
+	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
+	/* Perform operation. Timing is always gathered, the cost model used by
+	 * the scheduler is based on it.
+	 */
+	const double start_time = PIL_check_seconds_timer();
+	node->evaluate(state->eval_ctx);
+	const double time = PIL_check_seconds_timer() - start_time;
+	node->stats.add_sample(time);
+	if (state->do_stats) {
+		node->stats.current_time += time;
+	}
+}
+
 static void deg_task_run_func(TaskPool *pool,
                               void *taskdata,
                               int thread_id)
 {
 	void *userdata_v = BLI_task_pool_userdata(pool);
 	DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
-	OperationDepsNode *node = (OperationDepsNode *)taskdata;
-	/* Sanity checks. */
-	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
-	/* Perform operation. */
-	if (state->do_stats) {
-		const double start_time = PIL_check_seconds_timer();
-		node->evaluate(state->eval_ctx);
-		node->stats.current_time += PIL_check_seconds_timer() - start_time;
+	DepsgraphEvalBatch batch;
+	batch.nodes[0] = (OperationDepsNode *)taskdata;
+	batch.num_nodes = 1;
+	batch.time = 0.0;
+	while (batch.num_nodes != 0) {
+		OperationDepsNode *node = batch.nodes[--batch.num_nodes];
+		evaluate_operation(state, node);
+		/* Schedule children. Pushed tasks are flushed to the scheduler before
+		 * evaluating next operation from the batch, so other threads can pick
+		 * them up meanwhile.
+		 */
+		BLI_task_pool_delayed_push_begin(pool, thread_id);
+		schedule_children(pool, state, node, &batch, thread_id);
+		BLI_task_pool_delayed_push_end(pool, thread_id);
 	}
-	else {
-		node->evaluate(state->eval_ctx);
-	}
-	/* Schedule children. */
-	BLI_task_pool_delayed_push_begin(pool, thread_id);
-	schedule_children(pool, state->graph, node, state->layers, thread_id);
-	BLI_task_pool_delayed_push_end(pool, thread_id);
 }
 
 typedef struct CalculatePengindData {
 	Depsgraph *graph;
 	unsigned int layers;
+	int eval_flag;
 } CalculatePengindData;
 
 static void calculate_pending_func(
@@ -115,38 +185,51 @@ static void calculate_pending_func(
 	CalculatePengindData *data = (CalculatePengindData *)data_v;
 	Depsgraph *graph = data->graph;
 	unsigned int layers = data->layers;
+	const int eval_flag = data->eval_flag;
 	OperationDepsNode *node = graph->operations[i];
-	IDDepsNode *id_node = node->owner->owner;
 
 	node->num_links_pending = 0;
+	node->num_children_pending = 0;
 	node->scheduled = false;
 
 	/* count number of inputs that need updates */
-	if ((id_node->layers & layers) != 0 &&
-	    (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0)
-	{
+	if (operation_needs_eval(node, layers, eval_flag)) {
 		foreach (DepsRelation *rel, node->inlinks) {
 			if (rel->from->type == DEG_NODE_TYPE_OPERATION &&
 			    (rel->flag & DEPSREL_FLAG_CYCLIC) == 0)
 			{
 				OperationDepsNode *from = (OperationDepsNode *)rel->from;
-				IDDepsNode *id_from_node = from->owner->owner;
-				if ((id_from_node->layers & layers) != 0 &&
-				    (from->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0)
-				{
+				if (operation_needs_eval(from, layers, eval_flag)) {
 					++node->num_links_pending;
 				}
 			}
 		}
+		/* Same for outputs, used by critical path calculation. */
+		foreach (DepsRelation *rel, node->outlinks) {
+			OperationDepsNode *to = (OperationDepsNode *)rel->to;
+			if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0 &&
+			    operation_needs_eval(to, layers, eval_flag))
+			{
+				++node->num_children_pending;
+			}
+		}
+		/* Operations which were not evaluated yet are assumed to be cheap
+		 * but not free.
+		 */
+		node->critical_path_time = std::max(operation_estimated_time(node),
+		                                    DEG_EVAL_TINY_TIME);
 	}
 }
 
-static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
+static void calculate_pending_parents(Depsgraph *graph,
+                                      unsigned int layers,
+                                      const int eval_flag)
 {
 	const int num_operations = graph->operations.size();
 	CalculatePengindData data;
 	data.graph = graph;
 	data.layers = layers;
+	data.eval_flag = eval_flag;
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
 	settings.min_iter_per_thread = 1024;
@@ -157,10 +240,62 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 	                        &settings);
 }
 
-static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
+/* Accumulate estimated evaluation time from the leaves of the graph up to the
+ * roots, so each operation knows how long the longest chain of operations
+ * depending on it takes.
+ */
+static void calculate_critical_path(Depsgraph *graph,
+                                    unsigned int layers,
+                                    const int eval_flag)
+{
+	vector<OperationDepsNode *> stack;
+	foreach (OperationDepsNode *node, graph->operations) {
+		if (operation_needs_eval(node, layers, eval_flag) &&
+		    node->num_children_pending == 0)
+		{
+			stack.push_back(node);
+		}
+	}
+	while (!stack.empty()) {
+		OperationDepsNode *node = stack.back();
+		stack.pop_back();
+		double children_time = 0.0;
+		foreach (DepsRelation *rel, node->outlinks) {
+			OperationDepsNode *to = (OperationDepsNode *)rel->to;
+			if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0 &&
+			    operation_needs_eval(to, layers, eval_flag))
+			{
+				children_time = std::max(children_time, to->critical_path_time);
+			}
+		}
+		node->critical_path_time += children_time;
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type != DEG_NODE_TYPE_OPERATION ||
+			    (rel->flag & DEPSREL_FLAG_CYCLIC) != 0)
+			{
+				continue;
+			}
+			OperationDepsNode *from = (OperationDepsNode *)rel->from;
+			if (operation_needs_eval(from, layers, eval_flag)) {
+				BLI_assert(from->num_children_pending > 0);
+				if (--from->num_children_pending == 0) {
+					stack.push_back(from);
+				}
+			}
+		}
+	}
+}
+
+static void initialize_execution(DepsgraphEvalState *state,
+                                 Depsgraph *graph,
+                                 const int num_threads)
 {
 	const bool do_stats = state->do_stats;
-	calculate_pending_parents(graph, state->layers);
+	calculate_pending_parents(graph, state->layers, state->eval_flag);
+	/* Priorities do not matter when there is nobody to run other tasks. */
+	if (num_threads > 1) {
+		calculate_critical_path(graph, state->layers, state->eval_flag);
+	}
 	/* Clear tags and other things which needs to be clear. */
 	foreach (OperationDepsNode *node, graph->operations) {
 		node->done = 0;
@@ -170,60 +305,37 @@ static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 	}
 }
 
-/* Schedule a node if it needs evaluation.
+/* Check whether node is to be scheduled now, and claim it if so.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
-                          OperationDepsNode *node, bool dec_parents,
-                          const int thread_id)
+static bool claim_node(DepsgraphEvalState *state,
+                       OperationDepsNode *node,
+                       bool dec_parents)
 {
-	unsigned int id_layers = node->owner->owner->layers;
-
-	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
-	    (id_layers & layers) != 0)
-	{
-		if (dec_parents) {
-			BLI_assert(node->num_links_pending > 0);
-			atomic_sub_and_fetch_uint32(&node->num_links_pending, 1);
-		}
-
-		if (node->num_links_pending == 0) {
-			bool is_scheduled = atomic_fetch_and_or_uint8(
-			        (uint8_t *)&node->scheduled, (uint8_t)true);
-			if (!is_scheduled) {
-				if (node->is_noop()) {
-					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, layers, thread_id);
-				}
-				else {
-					/* children are scheduled once this task is completed */
-					BLI_task_pool_push_from_thread(pool,
-					                               deg_task_run_func,
-					                               node,
-					                               false,
-					                               TASK_PRIORITY_HIGH,
-					                               thread_id);
-				}
-			}
+	if (!operation_needs_eval(node, state->layers, state->eval_flag)) {
+		return false;
+	}
+	if (dec_parents) {
+		BLI_assert(node->num_links_pending > 0);
+		if (atomic_sub_and_fetch_uint32(&node->num_links_pending, 1) != 0) {
+			return false;
 		}
 	}
-}
-
-static void schedule_graph(TaskPool *pool,
-                           Depsgraph *graph,
-                           const unsigned int layers)
-{
-	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, layers, node, false, 0);
+	else if (node->num_links_pending != 0) {
+		return false;
 	}
+	bool is_scheduled = atomic_fetch_and_or_uint8(
+	        (uint8_t *)&node->scheduled, (uint8_t)true);
+	return !is_scheduled;
 }
 
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
-                              const int thread_id)
+/* Collect children of the node which became ready for evaluation.
+ * NOOP nodes are skipped, their children are collected right away.
+ */
+static void collect_ready_children(DepsgraphEvalState *state,
+                                   OperationDepsNode *node,
+                                   vector<OperationDepsNode *> *ready_nodes)
 {
 	foreach (DepsRelation *rel, node->outlinks) {
 		OperationDepsNode *child = (OperationDepsNode *)rel->to;
@@ -232,30 +344,118 @@ static void schedule_children(TaskPool *pool,
 			/* Happens when having cyclic dependencies. */
 			continue;
 		}
-		schedule_node(pool,
-		              graph,
-		              layers,
-		              child,
-		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
-		              thread_id);
+		if (!claim_node(state, child, (rel->flag & DEPSREL_FLAG_CYCLIC) == 0))
+		{
+			continue;
+		}
+		if (child->is_noop()) {
+			collect_ready_children(state, child, ready_nodes);
+		}
+		else {
+			ready_nodes->push_back(child);
+		}
 	}
 }
 
-/**
- * Evaluate all nodes tagged for updating,
- * \warning This is usually done as part of main loop, but may also be
- * called from frame-change update.
+static bool critical_path_greater(const OperationDepsNode *a,
+                                  const OperationDepsNode *b)
+{
+	return a->critical_path_time > b->critical_path_time;
+}
+
+/* Hand ready nodes over for evaluation, longest critical path first.
  *
- * \note Time sources should be all valid!
+ * Tiny nodes are appended to the batch of the current task while it has time
+ * budget left. The most critical of the remaining nodes is put on top of the
+ * batch, so the current thread evaluates it right away, before the batched
+ * tiny nodes. The others go to the scheduler in increasing order, so the most
+ * critical of them ends up at the head of the queue for idle threads.
  */
-void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
-                             Depsgraph *graph,
-                             const unsigned int layers)
+static void schedule_ready_nodes(TaskPool *pool,
+                                 vector<OperationDepsNode *> *ready_nodes,
+                                 DepsgraphEvalBatch *batch,
+                                 const int thread_id)
 {
-	/* Nothing to update, early out. */
-	if (BLI_gset_size(graph->entry_tags) == 0) {
+	vector<OperationDepsNode *> &nodes = *ready_nodes;
+	if (nodes.empty()) {
 		return;
 	}
+	std::sort(nodes.begin(), nodes.end(), critical_path_greater);
+	size_t num_pushed = 0, first = 0;
+	if (batch != NULL) {
+		/* Iterate backwards, so the most critical batched node is evaluated
+		 * first.
+		 */
+		for (size_t i = nodes.size(); i-- > 0;) {
+			OperationDepsNode *node = nodes[i];
+			const double time = operation_estimated_time(node);
+			if (operation_is_tiny(node) &&
+			    batch->num_nodes < DEG_EVAL_BATCH_SIZE &&
+			    batch->time + time <= DEG_EVAL_BATCH_TIME)
+			{
+				batch->nodes[batch->num_nodes++] = node;
+				batch->time += time;
+				nodes[i] = NULL;
+			}
+		}
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i] != NULL) {
+				nodes[num_pushed++] = nodes[i];
+			}
+		}
+		nodes.resize(num_pushed);
+		if (!nodes.empty() && batch->num_nodes < DEG_EVAL_BATCH_SIZE) {
+			batch->nodes[batch->num_nodes++] = nodes[0];
+			batch->time += std::max(operation_estimated_time(nodes[0]), 0.0);
+			first = 1;
+		}
+	}
+	for (size_t i = nodes.size(); i-- > first;) {
+		BLI_task_pool_push_from_thread(pool,
+		                               deg_task_run_func,
+		                               nodes[i],
+		                               false,
+		                               TASK_PRIORITY_HIGH,
+		                               thread_id);
+	}
+	nodes.clear();
+}
+
+static void schedule_graph(TaskPool *pool, DepsgraphEvalState *state)
+{
+	Depsgraph *graph = state->graph;
+	vector<OperationDepsNode *> *ready_nodes = &state->ready_nodes[0];
+	foreach (OperationDepsNode *node, graph->operations) {
+		if (!claim_node(state, node, false)) {
+			continue;
+		}
+		if (node->is_noop()) {
+			/* skip NOOP node, schedule children right away */
+			collect_ready_children(state, node, ready_nodes);
+		}
+		else {
+			ready_nodes->push_back(node);
+		}
+	}
+	schedule_ready_nodes(pool, ready_nodes, NULL, 0);
+}
+
+static void schedule_children(TaskPool *pool,
+                              DepsgraphEvalState *state,
+                              OperationDepsNode *node,
+                              DepsgraphEvalBatch *batch,
+                              const int thread_id)
+{
+	vector<OperationDepsNode *> *ready_nodes = &state->ready_nodes[thread_id];
+	collect_ready_children(state, node, ready_nodes);
+	schedule_ready_nodes(pool, ready_nodes, batch, thread_id);
+}
+
+static void deg_evaluate(EvaluationContext *eval_ctx,
+                         Depsgraph *graph,
+                         const unsigned int layers,
+                         const int eval_flag)
+{
 	DEG_DEBUG_PRINTF("%s: layers:%u, graph->layers:%u\n",
 	                 __func__,
 	                 layers,
@@ -268,6 +468,7 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	state.eval_ctx = eval_ctx;
 	state.graph = graph;
 	state.layers = layers;
+	state.eval_flag = eval_flag;
 	state.do_stats = (G.debug_value != 0);
 	/* Set up task scheduler and pull for threaded evaluation. */
 	TaskScheduler *task_scheduler;
@@ -280,11 +481,14 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 		task_scheduler = BLI_task_scheduler_get();
 		need_free_scheduler = false;
 	}
+	const int num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+	vector<vector<OperationDepsNode *> > ready_nodes(num_threads);
+	state.ready_nodes = &ready_nodes[0];
 	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
 	/* Prepare all nodes for evaluation. */
-	initialize_execution(&state, graph);
+	initialize_execution(&state, graph, num_threads);
 	/* Do actual evaluation now. */
-	schedule_graph(task_pool, graph, layers);
+	schedule_graph(task_pool, &state);
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 	/* Finalize statistics gathering. This is because we only gather single
@@ -294,11 +498,48 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	if (state.do_stats) {
 		deg_eval_stats_aggregate(graph);
 	}
-	/* Clear any uncleared tags - just in case. */
-	deg_graph_clear_tags(graph);
 	if (need_free_scheduler) {
 		BLI_task_scheduler_free(task_scheduler);
 	}
 }
 
+/**
+ * Evaluate all nodes tagged for updating,
+ * \warning This is usually done as part of main loop, but may also be
+ * called from frame-change update.
+ *
+ * \note Time sources should be all valid!
+ */
+void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
+                             Depsgraph *graph,
+                             const unsigned int layers)
+{
+	/* Nothing to update, early out. */
+	if (BLI_gset_size(graph->entry_tags) == 0) {
+		return;
+	}
+	deg_evaluate(eval_ctx, graph, layers, DEPSOP_FLAG_NEEDS_UPDATE);
+	/* Clear any uncleared tags - just in case. */
+	deg_graph_clear_tags(graph);
+}
+
+/**
+ * Evaluate nodes tagged for updating which are also tagged with
+ * DEPSOP_FLAG_PARTIAL_EVAL, the rest of the graph stays tagged.
+ */
+void deg_evaluate_partial(EvaluationContext *eval_ctx,
+                          Depsgraph *graph,
+                          const unsigned int layers)
+{
+	/* Nothing to update, early out. */
+	if (BLI_gset_size(graph->entry_tags) == 0) {
+		return;
+	}
+	deg_evaluate(eval_ctx,
+	             graph,
+	             layers,
+	             DEPSOP_FLAG_NEEDS_UPDATE | DEPSOP_FLAG_PARTIAL_EVAL);
+	deg_graph_clear_tags_partial(graph);
+}
+
 }  // namespace DEG
@@ -49,4 +49,12 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
                              Depsgraph *graph,
                              const unsigned int layers);
 
+/**
+ * Evaluate nodes tagged for updating which are also tagged with
+ * DEPSOP_FLAG_PARTIAL_EVAL, the rest of the graph stays tagged.
+ */
+void deg_evaluate_partial(EvaluationContext *eval_ctx,
+                          Depsgraph *graph,
+                          const unsigned int layers);
+
 }  // namespace DEG
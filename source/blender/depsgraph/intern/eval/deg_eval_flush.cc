@@ -322,4 +322,23 @@ void deg_graph_clear_tags(Depsgraph *graph)
 	BLI_gset_clear(graph->entry_tags, NULL);
 }
 
+/* Clear tags from operation nodes evaluated by partial evaluation. */
+void deg_graph_clear_tags_partial(Depsgraph *graph)
+{
+	BLI_gset_clear(graph->entry_tags, NULL);
+	foreach (OperationDepsNode *node, graph->operations) {
+		if (node->flag & DEPSOP_FLAG_PARTIAL_EVAL) {
+			node->flag &= ~(DEPSOP_FLAG_DIRECTLY_MODIFIED |
+			                DEPSOP_FLAG_NEEDS_UPDATE |
+			                DEPSOP_FLAG_PARTIAL_EVAL);
+		}
+		else if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+			/* Keep the update pending, so regular evaluation will bring
+			 * the node up to date.
+			 */
+			BLI_gset_add(graph->entry_tags, node);
+		}
+	}
+}
+
 }  // namespace DEG
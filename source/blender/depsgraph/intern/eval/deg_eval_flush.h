@@ -46,4 +46,9 @@ void deg_graph_flush_updates(struct Main *bmain, struct Depsgraph *graph);
 /* Clear tags from all operation nodes. */
 void deg_graph_clear_tags(struct Depsgraph *graph);
 
+/* Clear tags from operation nodes evaluated by partial evaluation, nodes
+ * which are still tagged for update become entry tags again.
+ */
+void deg_graph_clear_tags_partial(struct Depsgraph *graph);
+
 }  // namespace DEG
@@ -69,6 +69,8 @@ DepsNode::Stats::Stats()
 void DepsNode::Stats::reset()
 {
 	current_time = 0.0;
+	average_time = 0.0;
+	num_samples = 0;
 }
 
 void DepsNode::Stats::reset_current()
@@ -76,6 +78,17 @@ void DepsNode::Stats::reset_current()
 	current_time = 0.0;
 }
 
+void DepsNode::Stats::add_sample(double time)
+{
+	/* Plain average for the first few samples, exponential moving average
+	 * afterwards.
+	 */
+	if (num_samples < 8) {
+		++num_samples;
+	}
+	average_time += (time - average_time) / num_samples;
+}
+
 /*******************************************************************************
  * Node itself.
  */
@@ -66,8 +66,16 @@ struct DepsNode {
 		 * touch averaging accumulators.
 		 */
 		void reset_current();
+		/* Accumulate time of a single evaluation into the running average. */
+		void add_sample(double time);
 		/* Time spend on this node during current graph evaluation. */
 		double current_time;
+		/* Running average of the evaluation time, only meaningful when
+		 * num_samples is not zero. The most recent evaluations dominate, so
+		 * the average follows changes in the scene.
+		 */
+		double average_time;
+		int num_samples;
 	};
 	/* Relationships between nodes
 	 * The reason why all depsgraph nodes are descended from this type (apart
@@ -166,7 +166,7 @@ string ComponentDepsNode::identifier() const
 
 OperationDepsNode *ComponentDepsNode::find_operation(OperationIDKey key) const
 {
-	OperationDepsNode *node;
+	OperationDepsNode *node = NULL;
 	if (operations_map != NULL) {
 		node = (OperationDepsNode *)BLI_ghash_lookup(operations_map, &key);
 	}
@@ -348,6 +348,12 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	/* Component was finalized already, happens for nodes which are kept
+	 * during incremental update of the graph.
+	 */
+	if (operations_map == NULL) {
+		return;
+	}
 	operations.reserve(BLI_ghash_size(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
@@ -45,6 +45,8 @@ namespace DEG {
 /* Inner Nodes */
 
 OperationDepsNode::OperationDepsNode() :
+    critical_path_time(0.0),
+    num_children_pending(0),
     flag(0),
     customdata_mask(0)
 {
@@ -47,6 +47,9 @@ typedef enum eDepsOperation_Flag {
 
 	/* node was directly modified, causing need for update */
 	DEPSOP_FLAG_DIRECTLY_MODIFIED  = (1 << 1),
+
+	/* node is needed by the IDs requested for partial evaluation */
+	DEPSOP_FLAG_PARTIAL_EVAL       = (1 << 2),
 } eDepsOperation_Flag;
 
 /* Atomic Operation - Base type for all operations */
@@ -78,6 +81,13 @@ struct OperationDepsNode : public DepsNode {
 	uint32_t num_links_pending;
 	bool scheduled;
 
+	/* Estimated time needed to evaluate this operation and the longest chain
+	 * of operations depending on it, used to schedule the critical path first.
+	 */
+	double critical_path_time;
+	/* How many outlinks are still waiting for their critical path time. */
+	uint32_t num_children_pending;
+
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
 
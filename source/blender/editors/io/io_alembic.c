@@ -132,6 +132,7 @@ static int wm_alembic_export_exec(bContext *C, wmOperator *op)
 	    .triangulate = RNA_boolean_get(op->ptr, "triangulate"),
 	    .quad_method = RNA_enum_get(op->ptr, "quad_method"),
 	    .ngon_method = RNA_enum_get(op->ptr, "ngon_method"),
+	    .frame_parallel = RNA_boolean_get(op->ptr, "frame_parallel"),
 
 	    .global_scale = RNA_float_get(op->ptr, "global_scale"),
 	};
@@ -208,6 +209,9 @@ static void ui_alembic_export_settings(uiLayout *layout, PointerRNA *imfptr)
 	row = uiLayoutRow(box, false);
 	uiItemR(row, imfptr, "flatten", 0, NULL, ICON_NONE);
 
+	row = uiLayoutRow(box, false);
+	uiItemR(row, imfptr, "frame_parallel", 0, NULL, ICON_NONE);
+
 	/* Object Data */
 	box = uiLayoutBox(layout);
 	row = uiLayoutRow(box, false);
@@ -382,6 +386,10 @@ void WM_OT_alembic_export(wmOperatorType *ot)
 	RNA_def_boolean(ot->srna, "export_hair", 1, "Export Hair", "Exports hair particle systems as animated curves");
 	RNA_def_boolean(ot->srna, "export_particles", 1, "Export Particles", "Exports non-hair particle systems");
 
+	RNA_def_boolean(ot->srna, "frame_parallel", false, "Parallel Frames",
+	                "Evaluate several frames at once on copies of the scene, when the scene has no simulations "
+	                "(frame change handlers are not run)");
+
 	RNA_def_boolean(ot->srna, "as_background_job", true, "Run as Background Job",
 	                "Enable this to run the import in the background, disable to block Blender while importing");
 
@@ -431,7 +431,7 @@ Object *ED_object_add_type(
 	}
 
 	DAG_id_type_tag(bmain, ID_OB);
-	DAG_relations_tag_update(bmain);
+	DAG_id_relations_tag_update(bmain, &ob->id);
 	if (ob->data) {
 		ED_render_id_flush_update(bmain, ob->data);
 	}
@@ -45,6 +45,7 @@
 #include "BKE_main.h"
 #include "BKE_particle.h"
 #include "BKE_pointcache.h"
+#include "BKE_report.h"
 
 #include "ED_particle.h"
 
@@ -141,6 +142,11 @@ static void ptcache_job_endjob(void *customdata)
 
 	WM_set_locked_interface(G.main->wm.first, false);
 
+	if (job->baker->failed_frames) {
+		WM_reportf(RPT_ERROR, "Bake failed, %d frames could not be written to the disk cache",
+		           job->baker->failed_frames);
+	}
+
 	WM_main_add_notifier(NC_SCENE | ND_FRAME, scene);
 	WM_main_add_notifier(NC_OBJECT | ND_POINTCACHE, job->baker->pid.ob);
 }
@@ -196,9 +202,18 @@ static int ptcache_bake_exec(bContext *C, wmOperator *op)
 	bool all = STREQ(op->type->idname, "PTCACHE_OT_bake_all");
 
 	PTCacheBaker *baker = ptcache_baker_create(C, op, all);
+	int failed_frames;
+
 	BKE_ptcache_bake(baker);
+	failed_frames = baker->failed_frames;
 	MEM_freeN(baker);
 
+	if (failed_frames) {
+		BKE_reportf(op->reports, RPT_ERROR, "Bake failed, %d frames could not be written to the disk cache",
+		            failed_frames);
+		return OPERATOR_CANCELLED;
+	}
+
 	return OPERATOR_FINISHED;
 }
 
@@ -49,6 +49,7 @@
 #include "BKE_displist.h"
 #include "BKE_DerivedMesh.h"
 #include "BKE_key.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_paint.h"
 #include "BKE_particle.h"
 #include "BKE_editmesh.h"
@@ -384,6 +385,9 @@ static void stats_string(Scene *scene)
 	uintptr_t mem_in_use, mmap_in_use;
 	char memstr[MAX_INFO_MEM_LEN];
 	char gpumemstr[MAX_INFO_MEM_LEN] = "";
+	char modcachestr[MAX_INFO_MEM_LEN] = "";
+	size_t modcache_mem;
+	unsigned int modcache_hits, modcache_misses;
 	char *s;
 	size_t ofs = 0;
 
@@ -436,6 +440,13 @@ static void stats_string(Scene *scene)
 		}
 	}
 
+	/* modifier result cache, only used outside of edit mode */
+	BKE_modifier_cache_stats(&modcache_mem, &modcache_hits, &modcache_misses);
+	if (modcache_hits + modcache_misses) {
+		BLI_snprintf(modcachestr, MAX_INFO_MEM_LEN, IFACE_(" | Modifier Cache:%.2fM (%u/%u hits)"),
+		             (double)(modcache_mem >> 10) / 1024.0, modcache_hits, modcache_hits + modcache_misses);
+	}
+
 	s = stats->infostr;
 	ofs = 0;
 
@@ -473,11 +484,11 @@ static void stats_string(Scene *scene)
 	}
 	else {
 		ofs += BLI_snprintf(s + ofs, MAX_INFO_LEN - ofs,
-		                    IFACE_("Verts:%s | Faces:%s | Tris:%s | Objects:%s/%s | Lamps:%s/%s%s%s"),
+		                    IFACE_("Verts:%s | Faces:%s | Tris:%s | Objects:%s/%s | Lamps:%s/%s%s%s%s"),
 		                    stats_fmt.totvert, stats_fmt.totface,
 		                    stats_fmt.tottri, stats_fmt.totobjsel,
 		                    stats_fmt.totobj, stats_fmt.totlampsel,
-		                    stats_fmt.totlamp, memstr, gpumemstr);
+		                    stats_fmt.totlamp, memstr, modcachestr, gpumemstr);
 	}
 
 	if (ob)
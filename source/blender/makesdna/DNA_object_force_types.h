@@ -412,6 +412,8 @@ typedef struct SoftBody {
 /* high resolution cache is saved for smoke for backwards compatibility, so set this flag to know it's a "fake" cache */
 #define PTCACHE_FAKE_SMOKE			(1<<12)
 #define PTCACHE_IGNORE_CLEAR		(1<<13)
+/* all frames are stored in one file */
+#define PTCACHE_SINGLE_FILE		(1<<14)
 
 /* PTCACHE_OUTDATED + PTCACHE_FRAMES_SKIPPED */
 #define PTCACHE_REDO_NEEDED			258
@@ -419,6 +421,7 @@ typedef struct SoftBody {
 #define PTCACHE_COMPRESS_NO			0
 #define PTCACHE_COMPRESS_LZO		1
 #define PTCACHE_COMPRESS_LZMA		2
+#define PTCACHE_COMPRESS_LZMA_FAST	3
 
 /* ob->softflag */
 #define OB_SB_ENABLE	1		/* deprecated, use modifier */
@@ -1213,7 +1213,7 @@ static void rna_def_modifier_subsurf(BlenderRNA *brna)
 #ifdef WITH_OPENSUBDIV
 	prop = RNA_def_property(srna, "use_opensubdiv", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "use_opensubdiv", 1);
-	RNA_def_property_ui_text(prop, "Use OpenSubdiv", "Use OpenSubdiv for the subdivisions (viewport only)");
+	RNA_def_property_ui_text(prop, "Use OpenSubdiv", "Use OpenSubdiv for the subdivisions (GPU when possible, CPU evaluator otherwise)");
 	RNA_def_property_update(prop, 0, "rna_Modifier_update");
 #endif
 }
@@ -91,6 +91,8 @@ static const EnumPropertyItem rigidbody_mesh_source_items[] = {
 #  include "RBI_api.h"
 #endif
 
+#include "BLI_threads.h"
+
 #include "BKE_depsgraph.h"
 #include "BKE_rigidbody.h"
 
@@ -144,6 +146,19 @@ static void rna_RigidBodyWorld_split_impulse_set(PointerRNA *ptr, int value)
 #endif
 }
 
+static void rna_RigidBodyWorld_parallel_solver_set(PointerRNA *ptr, int value)
+{
+	RigidBodyWorld *rbw = (RigidBodyWorld *)ptr->data;
+
+	RB_FLAG_SET(rbw->flag, value, RBW_FLAG_USE_PARALLEL_SOLVER);
+
+#ifdef WITH_BULLET
+	if (rbw->physics_world) {
+		RB_dworld_set_num_threads(rbw->physics_world, value ? BLI_system_thread_count() : 1);
+	}
+#endif
+}
+
 /* ******************************** */
 
 static void rna_RigidBodyOb_reset(Main *UNUSED(bmain), Scene *scene, PointerRNA *UNUSED(ptr))
@@ -799,6 +814,15 @@ static void rna_def_rigidbody_world(BlenderRNA *brna)
 	                         "stability a little so use only when necessary)");
 	RNA_def_property_update(prop, NC_SCENE, "rna_RigidBodyWorld_reset");
 
+	/* parallel solver */
+	prop = RNA_def_property(srna, "use_parallel_solver", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", RBW_FLAG_USE_PARALLEL_SOLVER);
+	RNA_def_property_boolean_funcs(prop, NULL, "rna_RigidBodyWorld_parallel_solver_set");
+	RNA_def_property_ui_text(prop, "Parallel Solver",
+	                         "Solve separate groups of touching objects on multiple threads, "
+	                         "speeds up scenes with many independent pieces");
+	RNA_def_property_update(prop, NC_SCENE, "rna_RigidBodyWorld_reset");
+
 	/* cache */
 	prop = RNA_def_property(srna, "point_cache", PROP_POINTER, PROP_NONE);
 	RNA_def_property_flag(prop, PROP_NEVER_NULL);
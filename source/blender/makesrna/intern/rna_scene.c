@@ -649,7 +649,7 @@ static Base *rna_Scene_object_link(Scene *scene, bContext *C, ReportList *report
 		ob->lay = base->lay;
 
 	/* TODO(sergey): Only update relations for the current scene. */
-	DAG_relations_tag_update(CTX_data_main(C));
+	DAG_id_relations_tag_update(CTX_data_main(C), &ob->id);
 	DAG_id_tag_update(&ob->id, OB_RECALC_OB | OB_RECALC_DATA | OB_RECALC_TIME);
 
 	/* slows down importers too much, run scene.update() */
@@ -681,7 +681,7 @@ static void rna_Scene_object_unlink(Scene *scene, ReportList *reports, Object *o
 	id_us_min(&ob->id);
 
 	/* needed otherwise the depgraph will contain freed objects which can crash, see [#20958] */
-	DAG_relations_tag_update(G.main);
+	DAG_id_relations_tag_update(G.main, &ob->id);
 
 	WM_main_add_notifier(NC_SCENE | ND_OB_ACTIVE, scene);
 }
@@ -449,6 +449,15 @@ static void rna_def_smoke_domain_settings(BlenderRNA *brna)
 		{0, NULL, 0, NULL, NULL}
 	};
 
+	static const EnumPropertyItem smoke_pressure_solver_items[] = {
+		{SM_PRESSURE_SOLVER_PCG, "PCG", 0, "Conjugate Gradient",
+		 "Jacobi preconditioned conjugate gradient, fast for low resolutions"},
+		{SM_PRESSURE_SOLVER_MGPCG, "MGPCG", 0, "Multigrid",
+		 "Multigrid preconditioned conjugate gradient, needs fewer iterations at high resolutions "
+		 "and uses all threads"},
+		{0, NULL, 0, NULL, NULL}
+	};
+
 	static const EnumPropertyItem cache_file_type_items[] = {
 		{PTCACHE_FILE_PTCACHE, "POINTCACHE", 0, "Point Cache", "Blender specific point cache file format"},
 #ifdef WITH_OPENVDB
@@ -613,6 +622,11 @@ static void rna_def_smoke_domain_settings(BlenderRNA *brna)
 	                         "Select which domain border will be treated as collision object");
 	RNA_def_property_update(prop, NC_OBJECT | ND_MODIFIER, "rna_Smoke_reset");
 
+	prop = RNA_def_property(srna, "pressure_solver", PROP_ENUM, PROP_NONE);
+	RNA_def_property_enum_items(prop, smoke_pressure_solver_items);
+	RNA_def_property_ui_text(prop, "Pressure Solver", "Solver for the pressure of the simulation");
+	RNA_def_property_update(prop, NC_OBJECT | ND_MODIFIER, "rna_Smoke_resetCache");
+
 	prop = RNA_def_property(srna, "effector_weights", PROP_POINTER, PROP_NONE);
 	RNA_def_property_struct_type(prop, "EffectorWeights");
 	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
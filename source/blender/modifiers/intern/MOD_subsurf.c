@@ -137,9 +137,16 @@ static DerivedMesh *applyModifier(ModifierData *md, Object *ob,
 			subsurf_flags |= SUBSURF_USE_GPU_BACKEND;
 			do_cddm_convert = false;
 		}
-		else {
-			modifier_setError(md, "OpenSubdiv is disabled due to dependencies");
-		}
+	}
+
+	/* When GPU can not be used the mesh is still evaluated with OpenSubdiv,
+	 * on CPU, re-using topology refiner while topology does not change.
+	 */
+	if (smd->use_opensubdiv &&
+	    U.opensubdiv_compute_type != USER_OPENSUBDIV_COMPUTE_NONE &&
+	    (subsurf_flags & SUBSURF_USE_GPU_BACKEND) == 0)
+	{
+		subsurf_flags |= SUBSURF_USE_CPU_EVALUATOR;
 	}
 #endif
 
@@ -41,6 +41,7 @@ extern "C" {
 
 #include "BLI_math.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cloth.h"
@@ -333,7 +334,9 @@ static int UNUSED_FUNCTION(cloth_calc_helper_forces)(Object *UNUSED(ob), ClothMo
 	return 1;
 }
 
-BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
+/* slot is -1 to add the force to the solver directly, otherwise the force is only
+ * stored in that spring slot (angular bending springs don't support slots) */
+BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s, int slot)
 {
 	Cloth *cloth = clmd->clothObject;
 	ClothSimSettings *parms = clmd->sim_parms;
@@ -353,13 +356,15 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
 		scaling = parms->structural + s->stiffness * fabsf(parms->max_struct - parms->structural);
 		k = scaling / (parms->avg_spring_len + FLT_EPSILON);
 		
-		if (s->type & CLOTH_SPRING_TYPE_SEWING) {
-			// TODO: verify, half verified (couldn't see error)
-			// sewing springs usually have a large distance at first so clamp the force so we don't get tunnelling through colission objects
-			BPH_mass_spring_force_spring_linear(data, s->ij, s->kl, s->restlen, k, parms->Cdis, no_compress, parms->max_sewing);
+		// TODO: verify, half verified (couldn't see error)
+		// sewing springs usually have a large distance at first so clamp the force so we don't get tunnelling through colission objects
+		float clamp_force = (s->type & CLOTH_SPRING_TYPE_SEWING) ? parms->max_sewing : 0.0f;
+		
+		if (slot != -1) {
+			BPH_mass_spring_force_spring_linear_slot(data, slot, s->ij, s->kl, s->restlen, k, parms->Cdis, no_compress, clamp_force);
 		}
 		else {
-			BPH_mass_spring_force_spring_linear(data, s->ij, s->kl, s->restlen, k, parms->Cdis, no_compress, 0.0f);
+			BPH_mass_spring_force_spring_linear(data, s->ij, s->kl, s->restlen, k, parms->Cdis, no_compress, clamp_force);
 		}
 #endif
 	}
@@ -375,7 +380,12 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
 		// Fix for [#45084] for cloth stiffness must have cb proportional to kb
 		cb = kb * parms->bending_damping;
 		
-		BPH_mass_spring_force_spring_bending(data, s->ij, s->kl, s->restlen, kb, cb);
+		if (slot != -1) {
+			BPH_mass_spring_force_spring_bending_slot(data, slot, s->ij, s->kl, s->restlen, kb, cb);
+		}
+		else {
+			BPH_mass_spring_force_spring_bending(data, s->ij, s->kl, s->restlen, kb, cb);
+		}
 #endif
 	}
 	else if (s->type & CLOTH_SPRING_TYPE_BENDING_ANG) {
@@ -384,6 +394,8 @@ BLI_INLINE void cloth_calc_spring_force(ClothModifierData *clmd, ClothSpring *s)
 		
 		s->flags |= CLOTH_SPRING_FLAG_NEEDED;
 		
+		BLI_assert(slot == -1);
+		
 		/* XXX WARNING: angular bending springs for hair apply stiffness factor as an overall factor, unlike cloth springs!
 		 * this is crap, but needed due to cloth/hair mixing ...
 		 * max_bend factor is not even used for hair, so ...
@@ -433,6 +445,71 @@ static void hair_get_boundbox(ClothModifierData *clmd, float gmin[3], float gmax
 	}
 }
 
+typedef struct SpringForceData {
+	ClothModifierData *clmd;
+	ClothSpring **springs;
+} SpringForceData;
+
+static void cloth_calc_spring_force_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SpringForceData *data = (SpringForceData *)userdata;
+	ClothSpring *spring = data->springs[i];
+	
+	// only handle active springs
+	if (!(spring->flags & CLOTH_SPRING_FLAG_DEACTIVATE)) {
+		cloth_calc_spring_force(data->clmd, spring, i);
+	}
+}
+
+/* Calculate the spring forces of large cloth meshes in parallel, each spring into
+ * its own slot. Slots are added to the solver in spring order afterwards, so the
+ * result is the same as calculating the springs one by one.
+ * Returns false when the springs have to be calculated serially. */
+static bool cloth_calc_spring_forces_parallel(ClothModifierData *clmd)
+{
+#ifdef IMPLICIT_SOLVER_BLENDER
+	Cloth *cloth = clmd->clothObject;
+	SpringForceData data;
+	ParallelRangeSettings settings;
+	int i, num_springs;
+	
+	if (cloth->mvert_num <= CLOTH_PARALLEL_LIMIT || cloth->springs == NULL) {
+		return false;
+	}
+	
+	num_springs = BLI_linklist_count(cloth->springs);
+	data.clmd = clmd;
+	data.springs = (ClothSpring **)MEM_mallocN(sizeof(ClothSpring *) * num_springs, "cloth springs");
+	i = 0;
+	for (LinkNode *link = cloth->springs; link; link = link->next, i++) {
+		ClothSpring *spring = (ClothSpring *)link->link;
+		/* angular springs add several blocks, leave them to the serial loop */
+		if (spring->type & CLOTH_SPRING_TYPE_BENDING_ANG) {
+			MEM_freeN(data.springs);
+			return false;
+		}
+		data.springs[i] = spring;
+	}
+	
+	BPH_mass_spring_begin_spring_slots(cloth->implicit, num_springs);
+	
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = CLOTH_PARALLEL_LIMIT / 4;
+	BLI_task_parallel_range(0, num_springs, &data, cloth_calc_spring_force_cb, &settings);
+	
+	BPH_mass_spring_apply_spring_slots(cloth->implicit, num_springs);
+	
+	MEM_freeN(data.springs);
+	return true;
+#else
+	UNUSED_VARS(clmd);
+	return false;
+#endif
+}
+
 static void cloth_calc_force(ClothModifierData *clmd, float UNUSED(frame), ListBase *effectors, float time)
 {
 	/* Collect forces and derivatives:  F, dFdX, dFdV */
@@ -533,11 +610,14 @@ static void cloth_calc_force(ClothModifierData *clmd, float UNUSED(frame), ListB
 	}
 	
 	// calculate spring forces
+	if (cloth_calc_spring_forces_parallel(clmd)) {
+		return;
+	}
 	for (LinkNode *link = cloth->springs; link; link = link->next) {
 		ClothSpring *spring = (ClothSpring *)link->link;
 		// only handle active springs
 		if (!(spring->flags & CLOTH_SPRING_FLAG_DEACTIVATE)) {
-			cloth_calc_spring_force(clmd, spring);
+			cloth_calc_spring_force(clmd, spring, -1);
 		}
 	}
 }
@@ -56,6 +56,9 @@ extern "C" {
 
 //#define IMPLICIT_PRINT_SOLVER_INPUT_OUTPUT
 
+/* Vertex count above which long vector and matrix operations are multi-threaded. */
+#define CLOTH_PARALLEL_LIMIT 1024
+
 //#define IMPLICIT_ENABLE_EIGEN_DEBUG
 
 struct Implicit_Data;
@@ -117,6 +120,18 @@ bool BPH_mass_spring_force_spring_linear(struct Implicit_Data *data, int i, int
                                          float stiffness, float damping, bool no_compress, float clamp_force);
 /* Bending force, forming a triangle at the base of two structural springs */
 bool BPH_mass_spring_force_spring_bending(struct Implicit_Data *data, int i, int j, float restlen, float kb, float cb);
+#ifdef IMPLICIT_SOLVER_BLENDER
+/* Prepare num_slots spring slots, the spring functions below can then run in parallel */
+void BPH_mass_spring_begin_spring_slots(struct Implicit_Data *data, int num_slots);
+/* Linear spring force, stored in a slot */
+bool BPH_mass_spring_force_spring_linear_slot(struct Implicit_Data *data, int slot, int i, int j, float restlen,
+                                              float stiffness, float damping, bool no_compress, float clamp_force);
+/* Bending spring force, stored in a slot */
+bool BPH_mass_spring_force_spring_bending_slot(struct Implicit_Data *data, int slot, int i, int j, float restlen,
+                                               float kb, float cb);
+/* Add the forces of all active slots, in slot order */
+void BPH_mass_spring_apply_spring_slots(struct Implicit_Data *data, int num_slots);
+#endif
 /* Angular bending force based on local target vectors */
 bool BPH_mass_spring_force_spring_bending_angular(struct Implicit_Data *data, int i, int j, int k,
                                                   const float target[3], float stiffness, float damping);
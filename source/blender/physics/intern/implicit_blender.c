@@ -43,6 +43,7 @@
 
 #include "BLI_math.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cloth.h"
@@ -56,9 +57,9 @@
 #  pragma GCC diagnostic ignored "-Wtype-limits"
 #endif
 
-#ifdef _OPENMP
-#  define CLOTH_OPENMP_LIMIT 512
-#endif
+/* Vertices per partial sum of dot products. Partial sums are added in a fixed order,
+ * so results do not depend on the number of threads. */
+#define CLOTH_DOT_CHUNK_SIZE 1024
 
 //#define DEBUG_TIME
 
@@ -196,18 +197,76 @@ DO_INLINE void submul_lfvectorS(float (*to)[3], float (*fLongVector)[3], float s
 	}
 }
 /* dot product for big vector */
-DO_INLINE float dot_lfvector(float (*fLongVectorA)[3], float (*fLongVectorB)[3], unsigned int verts)
+typedef struct DotLFVectorData {
+	float (*fLongVectorA)[3];
+	float (*fLongVectorB)[3];
+	unsigned int verts;
+	float *chunk_sums;
+} DotLFVectorData;
+
+static void dot_lfvector_chunk_cb(
+        void *__restrict userdata,
+        const int chunk,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	DotLFVectorData *data = userdata;
+	const unsigned int start = (unsigned int)chunk * CLOTH_DOT_CHUNK_SIZE;
+	const unsigned int end = MIN2(start + CLOTH_DOT_CHUNK_SIZE, data->verts);
+	unsigned int i;
+	float temp = 0.0f;
+
+	for (i = start; i < end; i++) {
+		temp += dot_v3v3(data->fLongVectorA[i], data->fLongVectorB[i]);
+	}
+	data->chunk_sums[chunk] = temp;
+}
+
+/* scratch buffer for the chunk sums of dot_lfvector_ex, NULL when verts fit in a single chunk */
+static float *create_dot_chunk_sums(unsigned int verts)
 {
-	long i = 0;
-	float temp = 0.0;
-// XXX brecht, disabled this for now (first schedule line was already disabled),
-// due to non-commutative nature of floating point ops this makes the sim give
-// different results each time you run it!
-// schedule(guided, 2)
-//#pragma omp parallel for reduction(+: temp) if (verts > CLOTH_OPENMP_LIMIT)
-	for (i = 0; i < (long)verts; i++) {
-		temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
+	const unsigned int num_chunks = (verts + CLOTH_DOT_CHUNK_SIZE - 1) / CLOTH_DOT_CHUNK_SIZE;
+	return (num_chunks > 1) ? MEM_mallocN(sizeof(float) * num_chunks, "cloth_implicit_dot_chunks") : NULL;
+}
+static void del_dot_chunk_sums(float *chunk_sums)
+{
+	if (chunk_sums) {
+		MEM_freeN(chunk_sums);
 	}
+}
+/* chunk_sums is a buffer from create_dot_chunk_sums(verts) */
+DO_INLINE float dot_lfvector_ex(float (*fLongVectorA)[3], float (*fLongVectorB)[3], unsigned int verts, float *chunk_sums)
+{
+	const int num_chunks = (int)((verts + CLOTH_DOT_CHUNK_SIZE - 1) / CLOTH_DOT_CHUNK_SIZE);
+	float temp = 0.0f;
+	int i;
+
+	/* Summing in a thread dependent order (like OpenMP reduction does) gives different
+	 * results each time the simulation runs, so chunks are always the same size and
+	 * their sums are added in order. */
+	if (num_chunks > 1) {
+		DotLFVectorData data = {fLongVectorA, fLongVectorB, verts, chunk_sums};
+		ParallelRangeSettings settings;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (verts > CLOTH_PARALLEL_LIMIT);
+		BLI_task_parallel_range(0, num_chunks, &data, dot_lfvector_chunk_cb, &settings);
+
+		for (i = 0; i < num_chunks; i++) {
+			temp += chunk_sums[i];
+		}
+	}
+	else {
+		for (i = 0; i < (int)verts; i++) {
+			temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
+		}
+	}
+	return temp;
+}
+DO_INLINE float dot_lfvector(float (*fLongVectorA)[3], float (*fLongVectorB)[3], unsigned int verts)
+{
+	float *chunk_sums = create_dot_chunk_sums(verts);
+	const float temp = dot_lfvector_ex(fLongVectorA, fLongVectorB, verts, chunk_sums);
+	del_dot_chunk_sums(chunk_sums);
 	return temp;
 }
 /* A = B + C  --> for big vector */
@@ -221,10 +280,37 @@ DO_INLINE void add_lfvector_lfvector(float (*to)[3], float (*fLongVectorA)[3], f
 
 }
 /* A = B + C * float --> for big vector */
+typedef struct AddLFVectorSData {
+	float (*to)[3];
+	float (*fLongVectorA)[3];
+	float (*fLongVectorB)[3];
+	float bS;
+} AddLFVectorSData;
+
+static void add_lfvector_lfvectorS_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	AddLFVectorSData *data = userdata;
+
+	VECADDS(data->to[i], data->fLongVectorA[i], data->fLongVectorB[i], data->bS);
+}
+
 DO_INLINE void add_lfvector_lfvectorS(float (*to)[3], float (*fLongVectorA)[3], float (*fLongVectorB)[3], float bS, unsigned int verts)
 {
 	unsigned int i = 0;
 
+	if (verts > CLOTH_PARALLEL_LIMIT) {
+		AddLFVectorSData data = {to, fLongVectorA, fLongVectorB, bS};
+		ParallelRangeSettings settings;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.min_iter_per_thread = CLOTH_PARALLEL_LIMIT / 4;
+		BLI_task_parallel_range(0, (int)verts, &data, add_lfvector_lfvectorS_cb, &settings);
+		return;
+	}
+
 	for (i = 0; i < verts; i++) {
 		VECADDS(to[i], fLongVectorA[i], fLongVectorB[i], bS);
 
@@ -585,36 +671,139 @@ DO_INLINE void initdiag_bfmatrix(fmatrix3x3 *matrix, float m3[3][3])
 	}
 }
 
+/* Off-diagonal blocks of a big matrix listed per row and per column (in block order),
+ * so products with a long vector can be gathered per vertex instead of scattered.
+ * All matrices of the solver share the same block layout. */
+typedef struct bfmatrixIndex {
+	unsigned int vcount, scount;
+	unsigned int *row_start, *row_blocks;	/* blocks with r == vertex: row_blocks[row_start[v] .. row_start[v + 1]] */
+	unsigned int *col_start, *col_blocks;	/* blocks with c == vertex */
+} bfmatrixIndex;
+
+static bfmatrixIndex *create_bfmatrix_index(unsigned int verts, unsigned int springs)
+{
+	bfmatrixIndex *index = MEM_callocN(sizeof(bfmatrixIndex), "cloth_implicit_alloc_matrix_index");
+
+	index->vcount = verts;
+	index->row_start = MEM_callocN(sizeof(unsigned int) * (verts + 1), "cloth_implicit_matrix_rows");
+	index->col_start = MEM_callocN(sizeof(unsigned int) * (verts + 1), "cloth_implicit_matrix_cols");
+	index->row_blocks = MEM_mallocN(sizeof(unsigned int) * max_ii(springs, 1), "cloth_implicit_matrix_row_blocks");
+	index->col_blocks = MEM_mallocN(sizeof(unsigned int) * max_ii(springs, 1), "cloth_implicit_matrix_col_blocks");
+
+	return index;
+}
+
+static void del_bfmatrix_index(bfmatrixIndex *index)
+{
+	MEM_freeN(index->row_start);
+	MEM_freeN(index->col_start);
+	MEM_freeN(index->row_blocks);
+	MEM_freeN(index->col_blocks);
+	MEM_freeN(index);
+}
+
+/* Rebuild the index for the first num_blocks off-diagonal blocks of the matrix. */
+static void update_bfmatrix_index(bfmatrixIndex *index, fmatrix3x3 *matrix, unsigned int num_blocks)
+{
+	const unsigned int vcount = index->vcount;
+	unsigned int *row_start = index->row_start, *col_start = index->col_start;
+	unsigned int i;
+
+	BLI_assert(matrix[0].vcount == vcount && num_blocks <= matrix[0].scount);
+
+	memset(row_start, 0, sizeof(unsigned int) * (vcount + 1));
+	memset(col_start, 0, sizeof(unsigned int) * (vcount + 1));
+
+	/* Counting sort keeps blocks of a vertex in block order, which keeps results
+	 * of the gathered product identical to accumulating blocks one by one. */
+	for (i = vcount; i < vcount + num_blocks; i++) {
+		row_start[matrix[i].r + 1]++;
+		col_start[matrix[i].c + 1]++;
+	}
+	for (i = 0; i < vcount; i++) {
+		row_start[i + 1] += row_start[i];
+		col_start[i + 1] += col_start[i];
+	}
+	for (i = vcount; i < vcount + num_blocks; i++) {
+		index->row_blocks[row_start[matrix[i].r]++] = i;
+		index->col_blocks[col_start[matrix[i].c]++] = i;
+	}
+	/* Filling advanced the starts to the ends, shift them back. */
+	for (i = vcount; i > 0; i--) {
+		row_start[i] = row_start[i - 1];
+		col_start[i] = col_start[i - 1];
+	}
+	row_start[0] = col_start[0] = 0;
+
+	index->scount = num_blocks;
+}
+
+typedef struct MulBFMatrixLFVectorData {
+	float (*to)[3];
+	fmatrix3x3 *from;
+	const bfmatrixIndex *index;
+	lfVector *fLongVector;
+} MulBFMatrixLFVectorData;
+
+static void mul_bfmatrix_lfvector_cb(
+        void *__restrict userdata,
+        const int v,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	MulBFMatrixLFVectorData *data = userdata;
+	fmatrix3x3 *from = data->from;
+	const bfmatrixIndex *index = data->index;
+	lfVector *fLongVector = data->fLongVector;
+	float col_sum[3] = {0.0f, 0.0f, 0.0f};
+	float row_sum[3] = {0.0f, 0.0f, 0.0f};
+	unsigned int j;
+
+	/* Same accumulation order as the serial scatter below. */
+	for (j = index->col_start[v]; j < index->col_start[v + 1]; j++) {
+		fmatrix3x3 *block = &from[index->col_blocks[j]];
+		muladd_fmatrix_fvector(col_sum, block->m, fLongVector[block->r]);
+	}
+
+	muladd_fmatrix_fvector(row_sum, from[v].m, fLongVector[v]);
+	for (j = index->row_start[v]; j < index->row_start[v + 1]; j++) {
+		fmatrix3x3 *block = &from[index->row_blocks[j]];
+		muladd_fmatrix_fvector(row_sum, block->m, fLongVector[block->c]);
+	}
+
+	VECADD(data->to[v], col_sum, row_sum);
+}
+
 /* SPARSE SYMMETRIC multiply big matrix with long vector*/
 /* STATUS: verified */
-DO_INLINE void mul_bfmatrix_lfvector( float (*to)[3], fmatrix3x3 *from, lfVector *fLongVector)
+/* index is optional, without it the product is calculated serially */
+DO_INLINE void mul_bfmatrix_lfvector( float (*to)[3], fmatrix3x3 *from, const bfmatrixIndex *index, lfVector *fLongVector)
 {
 	unsigned int i = 0;
 	unsigned int vcount = from[0].vcount;
-	lfVector *temp = create_lfvector(vcount);
-	
+	lfVector *temp;
+
+	if (index && vcount > CLOTH_PARALLEL_LIMIT) {
+		MulBFMatrixLFVectorData data = {to, from, index, fLongVector};
+		ParallelRangeSettings settings;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.min_iter_per_thread = CLOTH_PARALLEL_LIMIT / 4;
+		BLI_task_parallel_range(0, (int)vcount, &data, mul_bfmatrix_lfvector_cb, &settings);
+		return;
+	}
+
+	temp = create_lfvector(vcount);
 	zero_lfvector(to, vcount);
 
-#pragma omp parallel sections private(i) if (vcount > CLOTH_OPENMP_LIMIT)
-	{
-#pragma omp section
-		{
-			for (i = from[0].vcount; i < from[0].vcount+from[0].scount; i++) {
-				muladd_fmatrix_fvector(to[from[i].c], from[i].m, fLongVector[from[i].r]);
-			}
-		}
-#pragma omp section
-		{
-			for (i = 0; i < from[0].vcount+from[0].scount; i++) {
-				muladd_fmatrix_fvector(temp[from[i].r], from[i].m, fLongVector[from[i].c]);
-			}
-		}
+	for (i = from[0].vcount; i < from[0].vcount+from[0].scount; i++) {
+		muladd_fmatrix_fvector(to[from[i].c], from[i].m, fLongVector[from[i].r]);
+	}
+	for (i = 0; i < from[0].vcount+from[0].scount; i++) {
+		muladd_fmatrix_fvector(temp[from[i].r], from[i].m, fLongVector[from[i].c]);
 	}
 	add_lfvector_lfvector(to, to, temp, from[0].vcount);
 	
 	del_lfvector(temp);
-	
-	
 }
 
 /* SPARSE SYMMETRIC sub big matrix with big matrix*/
@@ -635,6 +824,14 @@ DO_INLINE void subadd_bfmatrixS_bfmatrixS( fmatrix3x3 *to, fmatrix3x3 *from, flo
 // simulator start
 ///////////////////////////////////////////////////////////////////
 
+/* force and jacobians of a single spring, before adding it to the matrices */
+typedef struct ImplicitSpringSlot {
+	int i, j;
+	bool active;
+	float f[3];
+	float dfdx[3][3], dfdv[3][3];
+} ImplicitSpringSlot;
+
 typedef struct Implicit_Data  {
 	/* inputs */
 	fmatrix3x3 *bigI;			/* identity (constant) */
@@ -656,6 +853,12 @@ typedef struct Implicit_Data  {
 	lfVector *z;				/* target velocity in constrained directions */
 	fmatrix3x3 *S;				/* filtering matrix for constraints */
 	fmatrix3x3 *P, *Pinv;		/* pre-conditioning matrix */
+	bfmatrixIndex *index;		/* off-diagonal blocks per vertex, for parallel products */
+	
+	/* spring forces calculated in parallel, see BPH_mass_spring_apply_spring_slots */
+	ImplicitSpringSlot *spring_slots;
+	int *block_slots;			/* slot of each block added by the slots */
+	int num_spring_slots;		/* allocated slots */
 } Implicit_Data;
 
 Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
@@ -680,6 +883,7 @@ Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
 	id->B = create_lfvector(numverts);
 	id->dV = create_lfvector(numverts);
 	id->z = create_lfvector(numverts);
+	id->index = create_bfmatrix_index(numverts, numsprings);
 
 	initdiag_bfmatrix(id->bigI, I);
 
@@ -706,6 +910,12 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
 	del_lfvector(id->B);
 	del_lfvector(id->dV);
 	del_lfvector(id->z);
+	del_bfmatrix_index(id->index);
+	
+	if (id->spring_slots) {
+		MEM_freeN(id->spring_slots);
+		MEM_freeN(id->block_slots);
+	}
 	
 	MEM_freeN(id);
 }
@@ -768,7 +978,7 @@ static int  cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z
 
 	// r = B - Mul(tmp, A, X);    // just use B if X known to be zero
 	cp_lfvector(r, lB, numverts);
-	mul_bfmatrix_lfvector(tmp, lA, ldV);
+	mul_bfmatrix_lfvector(tmp, lA, NULL, ldV);
 	sub_lfvector_lfvector(r, r, tmp, numverts);
 
 	filter(r, S);
@@ -780,7 +990,7 @@ static int  cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z
 
 	while (s>starget && conjgrad_loopcount < conjgrad_looplimit) {
 		// Mul(q, A, d); // q = A*d;
-		mul_bfmatrix_lfvector(q, lA, d);
+		mul_bfmatrix_lfvector(q, lA, NULL, d);
 
 		filter(q, S);
 
@@ -814,7 +1024,7 @@ static int  cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z
 }
 #endif
 
-static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z, fmatrix3x3 *S, ImplicitSolverResult *result)
+static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, const bfmatrixIndex *index, lfVector *lB, lfVector *z, fmatrix3x3 *S, ImplicitSolverResult *result)
 {
 	// Solves for unknown X in equation AX=B
 	unsigned int conjgrad_loopcount=0, conjgrad_looplimit=100;
@@ -827,6 +1037,7 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	lfVector *c = create_lfvector(numverts);
 	lfVector *q = create_lfvector(numverts);
 	lfVector *s = create_lfvector(numverts);
+	float *dot_chunk_sums = create_dot_chunk_sums(numverts);
 	float bnorm2, delta_new, delta_old, delta_target, alpha;
 	
 	cp_lfvector(ldV, z, numverts);
@@ -834,11 +1045,11 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	/* d0 = filter(B)^T * P * filter(B) */
 	cp_lfvector(fB, lB, numverts);
 	filter(fB, S);
-	bnorm2 = dot_lfvector(fB, fB, numverts);
+	bnorm2 = dot_lfvector_ex(fB, fB, numverts, dot_chunk_sums);
 	delta_target = conjgrad_epsilon*conjgrad_epsilon * bnorm2;
 	
 	/* r = filter(B - A * dV) */
-	mul_bfmatrix_lfvector(AdV, lA, ldV);
+	mul_bfmatrix_lfvector(AdV, lA, index, ldV);
 	sub_lfvector_lfvector(r, lB, AdV, numverts);
 	filter(r, S);
 	
@@ -847,7 +1058,7 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	filter(c, S);
 	
 	/* delta = r^T * c */
-	delta_new = dot_lfvector(r, c, numverts);
+	delta_new = dot_lfvector_ex(r, c, numverts, dot_chunk_sums);
 	
 #ifdef IMPLICIT_PRINT_SOLVER_INPUT_OUTPUT
 	printf("==== A ====\n");
@@ -861,10 +1072,10 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 #endif
 	
 	while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-		mul_bfmatrix_lfvector(q, lA, c);
+		mul_bfmatrix_lfvector(q, lA, index, c);
 		filter(q, S);
 		
-		alpha = delta_new / dot_lfvector(c, q, numverts);
+		alpha = delta_new / dot_lfvector_ex(c, q, numverts, dot_chunk_sums);
 		
 		add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
 		
@@ -873,7 +1084,7 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 		/* s = P^-1 * r */
 		cp_lfvector(s, r, numverts);
 		delta_old = delta_new;
-		delta_new = dot_lfvector(r, s, numverts);
+		delta_new = dot_lfvector_ex(r, s, numverts, dot_chunk_sums);
 		
 		add_lfvector_lfvectorS(c, s, c, delta_new / delta_old, numverts);
 		filter(c, S);
@@ -893,6 +1104,7 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	del_lfvector(c);
 	del_lfvector(q);
 	del_lfvector(s);
+	del_dot_chunk_sums(dot_chunk_sums);
 	// printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
 	result->status = conjgrad_loopcount < conjgrad_looplimit ? BPH_SOLVER_SUCCESS : BPH_SOLVER_NO_CONVERGENCE;
@@ -934,7 +1146,7 @@ static int cg_filtered_pre(lfVector *dv, fmatrix3x3 *lA, lfVector *lB, lfVector
 	filter(dv, S);
 	add_lfvector_lfvector(dv, dv, z, numverts);
 	
-	mul_bfmatrix_lfvector(r, lA, dv);
+	mul_bfmatrix_lfvector(r, lA, NULL, dv);
 	sub_lfvector_lfvector(r, lB, r, numverts);
 	filter(r, S);
 	
@@ -953,7 +1165,7 @@ static int cg_filtered_pre(lfVector *dv, fmatrix3x3 *lA, lfVector *lB, lfVector
 	{
 		iterations++;
 		
-		mul_bfmatrix_lfvector(s, lA, p);
+		mul_bfmatrix_lfvector(s, lA, NULL, p);
 		filter(s, S);
 		
 		alpha = deltaNew / dot_lfvector(p, s, numverts);
@@ -1012,12 +1224,12 @@ static int cg_filtered_pre(lfVector *dv, fmatrix3x3 *lA, lfVector *lB, lfVector
 	add_lfvector_lfvector(dv, dv, z, numverts);
 	
 	// b_hat = S(b-A(I-S)z)
-	mul_bfmatrix_lfvector(r, lA, z);
-	mul_bfmatrix_lfvector(bhat, bigI, r);
+	mul_bfmatrix_lfvector(r, lA, NULL, z);
+	mul_bfmatrix_lfvector(bhat, bigI, NULL, r);
 	sub_lfvector_lfvector(bhat, lB, bhat, numverts);
 	
 	// r = S(b-Ax)
-	mul_bfmatrix_lfvector(r, lA, dv);
+	mul_bfmatrix_lfvector(r, lA, NULL, dv);
 	sub_lfvector_lfvector(r, lB, r, numverts);
 	filter(r, S);
 	
@@ -1036,7 +1248,7 @@ static int cg_filtered_pre(lfVector *dv, fmatrix3x3 *lA, lfVector *lB, lfVector
 	filter(dv, S);
 	add_lfvector_lfvector(dv, dv, z, numverts);
 	
-	mul_bfmatrix_lfvector(r, lA, dv);
+	mul_bfmatrix_lfvector(r, lA, NULL, dv);
 	sub_lfvector_lfvector(r, lB, r, numverts);
 	filter(r, S);
 	
@@ -1058,7 +1270,7 @@ static int cg_filtered_pre(lfVector *dv, fmatrix3x3 *lA, lfVector *lB, lfVector
 	{
 		iterations++;
 		
-		mul_bfmatrix_lfvector(s, lA, p);
+		mul_bfmatrix_lfvector(s, lA, NULL, p);
 		filter(s, S);
 		
 		alpha = deltaNew / dot_lfvector(p, s, numverts);
@@ -1109,7 +1321,9 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 
 	subadd_bfmatrixS_bfmatrixS(data->A, data->dFdV, dt, data->dFdX, (dt*dt));
 
-	mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->V);
+	update_bfmatrix_index(data->index, data->A, data->num_blocks);
+
+	mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->index, data->V);
 
 	add_lfvectorS_lfvectorS(data->B, data->F, dt, dFdXmV, (dt*dt), numverts);
 
@@ -1117,7 +1331,7 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 	double start = PIL_check_seconds_timer();
 #endif
 
-	cg_filtered(data->dV, data->A, data->B, data->z, data->S, result); /* conjugate gradient algorithm to solve Ax=b */
+	cg_filtered(data->dV, data->A, data->index, data->B, data->z, data->S, result); /* conjugate gradient algorithm to solve Ax=b */
 	// cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
 #ifdef DEBUG_TIME
@@ -1578,8 +1792,9 @@ BLI_INLINE void apply_spring(Implicit_Data *data, int i, int j, const float f[3]
 	sub_m3_m3m3(data->dFdV[block_ij].m, data->dFdV[block_ij].m, dfdv);
 }
 
-bool BPH_mass_spring_force_spring_linear(Implicit_Data *data, int i, int j, float restlen,
-                                         float stiffness, float damping, bool no_compress, float clamp_force)
+static bool spring_linear_calc(Implicit_Data *data, int i, int j, float restlen,
+                               float stiffness, float damping, bool no_compress, float clamp_force,
+                               float f[3], float dfdx[3][3], float dfdv[3][3])
 {
 	float extent[3], length, dir[3], vel[3];
 	
@@ -1590,7 +1805,7 @@ bool BPH_mass_spring_force_spring_linear(Implicit_Data *data, int i, int j, floa
 	   Zero derivative effectively disables the spring for the implicit solver.
 	   Thus length > restlen makes cloth unconstrained at the start of simulation. */
 	if ((length >= restlen && length > 0) || no_compress) {
-		float stretch_force, f[3], dfdx[3][3], dfdv[3][3];
+		float stretch_force;
 		
 		stretch_force = stiffness * (length - restlen);
 		if (clamp_force > 0.0f && stretch_force > clamp_force) {
@@ -1605,8 +1820,20 @@ bool BPH_mass_spring_force_spring_linear(Implicit_Data *data, int i, int j, floa
 		dfdx_spring(dfdx, dir, length, restlen, stiffness);
 		dfdv_damp(dfdv, dir, damping);
 		
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+
+bool BPH_mass_spring_force_spring_linear(Implicit_Data *data, int i, int j, float restlen,
+                                         float stiffness, float damping, bool no_compress, float clamp_force)
+{
+	float f[3], dfdx[3][3], dfdv[3][3];
+	
+	if (spring_linear_calc(data, i, j, restlen, stiffness, damping, no_compress, clamp_force, f, dfdx, dfdv)) {
 		apply_spring(data, i, j, f, dfdx, dfdv);
-		
 		return true;
 	}
 	else {
@@ -1615,7 +1842,8 @@ bool BPH_mass_spring_force_spring_linear(Implicit_Data *data, int i, int j, floa
 }
 
 /* See "Stable but Responsive Cloth" (Choi, Ko 2005) */
-bool BPH_mass_spring_force_spring_bending(Implicit_Data *data, int i, int j, float restlen, float kb, float cb)
+static bool spring_bending_calc(Implicit_Data *data, int i, int j, float restlen, float kb, float cb,
+                                float f[3], float dfdx[3][3], float dfdv[3][3])
 {
 	float extent[3], length, dir[3], vel[3];
 	
@@ -1623,8 +1851,6 @@ bool BPH_mass_spring_force_spring_bending(Implicit_Data *data, int i, int j, flo
 	spring_length(data, i, j, extent, dir, &length, vel);
 	
 	if (length < restlen) {
-		float f[3], dfdx[3][3], dfdv[3][3];
-		
 		mul_v3_v3fl(f, dir, fbstar(length, restlen, kb, cb));
 		
 		outerproduct(dfdx, dir, dir);
@@ -1633,8 +1859,19 @@ bool BPH_mass_spring_force_spring_bending(Implicit_Data *data, int i, int j, flo
 		/* XXX damping not supported */
 		zero_m3(dfdv);
 		
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+
+bool BPH_mass_spring_force_spring_bending(Implicit_Data *data, int i, int j, float restlen, float kb, float cb)
+{
+	float f[3], dfdx[3][3], dfdv[3][3];
+	
+	if (spring_bending_calc(data, i, j, restlen, kb, cb, f, dfdx, dfdv)) {
 		apply_spring(data, i, j, f, dfdx, dfdv);
-		
 		return true;
 	}
 	else {
@@ -1642,6 +1879,126 @@ bool BPH_mass_spring_force_spring_bending(Implicit_Data *data, int i, int j, flo
 	}
 }
 
+/* Spring slots: forces of independent springs can be calculated in parallel into
+ * their own slot, then added in slot order by BPH_mass_spring_apply_spring_slots.
+ * The result is identical to calling the spring functions above one by one. */
+
+void BPH_mass_spring_begin_spring_slots(Implicit_Data *data, int num_slots)
+{
+	int i;
+	
+	if (num_slots > data->num_spring_slots) {
+		if (data->spring_slots) {
+			MEM_freeN(data->spring_slots);
+			MEM_freeN(data->block_slots);
+		}
+		data->spring_slots = MEM_mallocN(sizeof(ImplicitSpringSlot) * num_slots, "cloth spring slots");
+		data->block_slots = MEM_mallocN(sizeof(int) * num_slots, "cloth spring block slots");
+		data->num_spring_slots = num_slots;
+	}
+	
+	for (i = 0; i < num_slots; i++) {
+		data->spring_slots[i].active = false;
+	}
+}
+
+bool BPH_mass_spring_force_spring_linear_slot(Implicit_Data *data, int slot, int i, int j, float restlen,
+                                              float stiffness, float damping, bool no_compress, float clamp_force)
+{
+	ImplicitSpringSlot *s = &data->spring_slots[slot];
+	
+	BLI_assert(slot < data->num_spring_slots);
+	s->i = i;
+	s->j = j;
+	s->active = spring_linear_calc(data, i, j, restlen, stiffness, damping, no_compress, clamp_force,
+	                               s->f, s->dfdx, s->dfdv);
+	return s->active;
+}
+
+bool BPH_mass_spring_force_spring_bending_slot(Implicit_Data *data, int slot, int i, int j, float restlen, float kb, float cb)
+{
+	ImplicitSpringSlot *s = &data->spring_slots[slot];
+	
+	BLI_assert(slot < data->num_spring_slots);
+	s->i = i;
+	s->j = j;
+	s->active = spring_bending_calc(data, i, j, restlen, kb, cb, s->f, s->dfdx, s->dfdv);
+	return s->active;
+}
+
+typedef struct SpringSlotsGatherData {
+	Implicit_Data *data;
+	unsigned int first_block;
+} SpringSlotsGatherData;
+
+static void spring_slots_gather_cb(
+        void *__restrict userdata,
+        const int v,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	SpringSlotsGatherData *gather = userdata;
+	Implicit_Data *data = gather->data;
+	const bfmatrixIndex *index = data->index;
+	unsigned int r = index->row_start[v], r_end = index->row_start[v + 1];
+	unsigned int c = index->col_start[v], c_end = index->col_start[v + 1];
+	
+	/* blocks added before the slots have been applied already */
+	while (r < r_end && index->row_blocks[r] < gather->first_block) {
+		r++;
+	}
+	while (c < c_end && index->col_blocks[c] < gather->first_block) {
+		c++;
+	}
+	
+	/* Merge the row and column blocks of the vertex in block order,
+	 * which is the order apply_spring would have added them in. */
+	while (r < r_end || c < c_end) {
+		const bool is_row = (c == c_end) || (r < r_end && index->row_blocks[r] <= index->col_blocks[c]);
+		const unsigned int block = is_row ? index->row_blocks[r++] : index->col_blocks[c++];
+		ImplicitSpringSlot *s = &data->spring_slots[data->block_slots[block - gather->first_block]];
+		
+		if (is_row) {
+			add_v3_v3(data->F[v], s->f);
+			/* every block is in exactly one row list */
+			sub_m3_m3m3(data->dFdX[block].m, data->dFdX[block].m, s->dfdx);
+			sub_m3_m3m3(data->dFdV[block].m, data->dFdV[block].m, s->dfdv);
+		}
+		else {
+			sub_v3_v3(data->F[v], s->f);
+		}
+		add_m3_m3m3(data->dFdX[v].m, data->dFdX[v].m, s->dfdx);
+		add_m3_m3m3(data->dFdV[v].m, data->dFdV[v].m, s->dfdv);
+	}
+}
+
+void BPH_mass_spring_apply_spring_slots(Implicit_Data *data, int num_slots)
+{
+	const unsigned int numverts = data->M[0].vcount;
+	SpringSlotsGatherData gather;
+	ParallelRangeSettings settings;
+	int i;
+	
+	BLI_assert(num_slots <= data->num_spring_slots);
+	
+	/* blocks are allocated in slot order, same as applying the springs serially */
+	gather.data = data;
+	gather.first_block = numverts + data->num_blocks;
+	for (i = 0; i < num_slots; i++) {
+		const ImplicitSpringSlot *s = &data->spring_slots[i];
+		if (s->active) {
+			int block = BPH_mass_spring_add_block(data, s->i, s->j);
+			data->block_slots[block - gather.first_block] = i;
+		}
+	}
+	
+	update_bfmatrix_index(data->index, data->dFdX, data->num_blocks);
+	
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (numverts > CLOTH_PARALLEL_LIMIT);
+	settings.min_iter_per_thread = CLOTH_PARALLEL_LIMIT / 4;
+	BLI_task_parallel_range(0, (int)numverts, &gather, spring_slots_gather_cb, &settings);
+}
+
 /* Jacobian of a direction vector.
  * Basically the part of the differential orthogonal to the direction,
  * inversely proportional to the length of the edge.
@@ -3159,6 +3159,11 @@ static void update_physics_cache(Render *re, Scene *scene, int UNUSED(anim_init)
 	baker.quick_step = 1;
 
 	BKE_ptcache_bake(&baker);
+
+	if (baker.failed_frames) {
+		BKE_reportf(re->reports, RPT_ERROR, "%d physics cache frames could not be written to disk",
+		            baker.failed_frames);
+	}
 }
 
 void RE_SetActiveRenderView(Render *re, const char *viewname)
@@ -86,6 +86,7 @@
 #include "BKE_scene.h"
 #include "BKE_screen.h"
 
+#include "BLO_blend_defs.h"
 #include "BLO_readfile.h"
 #include "BLO_writefile.h"
 
@@ -377,7 +378,9 @@ static int wm_read_exotic(const char *name)
 		else {
 			len = gzread(gzfile, header, sizeof(header));
 			gzclose(gzfile);
-			if (len == sizeof(header) && STREQLEN(header, "BLENDER", 7)) {
+			if (len == sizeof(header) &&
+			    (STREQLEN(header, "BLENDER", 7) || STREQLEN(header, BLEN_LZO_MAGIC, sizeof(header))))
+			{
 				retval = BKE_READ_EXOTIC_OK_BLEND;
 			}
 			else {
@@ -1166,6 +1169,7 @@ static int wm_file_write(bContext *C, const char *filepath, int fileflags, Repor
 		}
 
 		SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
+		SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS_FAST, G_FILE_COMPRESS_FAST);
 		SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_AUTOPLAY, G_FILE_AUTOPLAY);
 
 		/* prevent background mode scripts from clobbering history */
@@ -1995,6 +1999,13 @@ static void save_set_compress(wmOperator *op)
 			RNA_property_boolean_set(op->ptr, prop, (U.flag & USER_FILECOMPRESS) != 0);
 		}
 	}
+
+	prop = RNA_struct_find_property(op->ptr, "compress_fast");
+	if (!RNA_property_is_set(op->ptr, prop)) {
+		if (G.save_over) {  /* keep flag for existing file */
+			RNA_property_boolean_set(op->ptr, prop, (G.fileflags & G_FILE_COMPRESS_FAST) != 0);
+		}
+	}
 }
 
 static void save_set_filepath(wmOperator *op)
@@ -2051,6 +2062,9 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 	SET_FLAG_FROM_TEST(
 	        fileflags, RNA_boolean_get(op->ptr, "compress"),
 	        G_FILE_COMPRESS);
+	SET_FLAG_FROM_TEST(
+	        fileflags, RNA_boolean_get(op->ptr, "compress_fast"),
+	        G_FILE_COMPRESS_FAST);
 	SET_FLAG_FROM_TEST(
 	        fileflags, RNA_boolean_get(op->ptr, "relative_remap"),
 	        G_FILE_RELATIVE_REMAP);
@@ -2110,6 +2124,8 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_fast", false, "Fast Compression",
+	                "Compress using multiple threads with LZO, faster to save and load but larger than gzip");
 	RNA_def_boolean(ot->srna, "relative_remap", true, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 	prop = RNA_def_boolean(ot->srna, "copy", false, "Save Copy",
@@ -2176,6 +2192,8 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_fast", false, "Fast Compression",
+	                "Compress using multiple threads with LZO, faster to save and load but larger than gzip");
 	RNA_def_boolean(ot->srna, "relative_remap", false, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 }
@@ -269,6 +269,7 @@ int main(
 	 *       guarded allocator before any allocation happened.
 	 */
 	{
+		bool use_guarded = false;
 		int i;
 		for (i = 0; i < argc; i++) {
 			if (STREQ(argv[i], "--debug") || STREQ(argv[i], "-d") ||
@@ -276,12 +277,23 @@ int main(
 			{
 				printf("Switching to fully guarded memory allocator.\n");
 				MEM_use_guarded_allocator();
+				use_guarded = true;
 				break;
 			}
 			else if (STREQ(argv[i], "--")) {
 				break;
 			}
 		}
+
+#ifdef NDEBUG
+		/* Release builds reuse small blocks per thread instead of
+		 * going to the system allocator for each of them. */
+		if (!use_guarded) {
+			MEM_use_pooled_allocator();
+		}
+#else
+		UNUSED_VARS(use_guarded);
+#endif
 	}
 
 #ifdef BUILD_DATE
@@ -74,3 +74,63 @@ TEST(task, MempoolIter)
 
 	BLI_mempool_destroy(mempool);
 }
+
+static void task_mempool_local_alloc_func(void *__restrict userdata,
+                                          const int iter,
+                                          const ParallelRangeTLS *__restrict tls)
+{
+	BLI_mempool_local *local = (BLI_mempool_local *)tls->userdata_chunk;
+	int **data = (int **)userdata;
+
+	data[iter] = (int *)BLI_mempool_local_alloc(local);
+	*data[iter] = iter;
+
+	/* Free some extra items again through the per-task copy of the local pool,
+	 * they must not be counted once the copies are finalized. */
+	if (iter % 5 == 0) {
+		int *item = (int *)BLI_mempool_local_alloc(local);
+		BLI_mempool_local_free(local, item);
+	}
+}
+
+static void task_mempool_local_finalize_func(void *__restrict UNUSED(userdata),
+                                             void *__restrict userdata_chunk)
+{
+	BLI_mempool_local_finalize((BLI_mempool_local *)userdata_chunk);
+}
+
+TEST(task, MempoolLocalAlloc)
+{
+	int *data[NUM_ITEMS];
+	BLI_mempool *mempool = BLI_mempool_create(sizeof(*data[0]), 0, 32, BLI_MEMPOOL_ALLOW_ITER);
+	BLI_mempool_local local;
+
+	BLI_mempool_local_init(mempool, &local);
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.userdata_chunk = &local;
+	settings.userdata_chunk_size = sizeof(local);
+	settings.func_finalize = task_mempool_local_finalize_func;
+	settings.min_iter_per_thread = 64;
+
+	BLI_task_parallel_range(0, NUM_ITEMS, data, task_mempool_local_alloc_func, &settings);
+
+	EXPECT_EQ(BLI_mempool_count(mempool), NUM_ITEMS);
+
+	/* Iteration sees every allocated item exactly once. */
+	int num_items = NUM_ITEMS;
+	BLI_task_parallel_mempool(mempool, &num_items, task_mempool_iter_func, true);
+	EXPECT_EQ(num_items, 0);
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		EXPECT_EQ(*data[i], i + 1);
+	}
+
+	/* Pool is usable serially again, including the elements handed back on finalize. */
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		BLI_mempool_free(mempool, data[i]);
+	}
+	EXPECT_EQ(BLI_mempool_count(mempool), 0);
+
+	BLI_mempool_destroy(mempool);
+}
@@ -0,0 +1,131 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_depsgraph.h"
+#include "BKE_global.h"
+#include "BKE_library.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+}
+
+/* Scene with a target A parented to P, a child C of A and an unrelated B. */
+class DepsgraphPartialEvalTest : public testing::Test {
+protected:
+	static void SetUpTestCase()
+	{
+		BLI_threadapi_init();
+		DEG_register_node_types();
+	}
+
+	static void TearDownTestCase()
+	{
+		DEG_free_node_types();
+		BLI_threadapi_exit();
+	}
+
+	virtual void SetUp()
+	{
+		bmain = BKE_main_new();
+		/* Freeing a scene looks for it in G.main. */
+		G.main = bmain;
+		/* Bare scene, the defaults of BKE_scene_add() need color management. */
+		scene = (Scene *)BKE_libblock_alloc(bmain, ID_SCE, "Scene", 0);
+		scene->lay = scene->layact = 1;
+		scene->r.cfra = 1;
+		scene->r.frs_sec = 24;
+		scene->r.frs_sec_base = 1.0f;
+		ob_p = add_object("P", NULL);
+		ob_a = add_object("A", ob_p);
+		ob_b = add_object("B", NULL);
+		ob_c = add_object("C", ob_a);
+
+		eval_ctx = DEG_evaluation_context_new(DAG_EVAL_VIEWPORT);
+		scene->depsgraph = DEG_graph_new();
+		DEG_graph_build_from_scene(scene->depsgraph, bmain, scene);
+		DEG_graph_on_visible_update(bmain, scene);
+		DEG_evaluate_on_framechange(eval_ctx, bmain, scene->depsgraph, 1.0f, scene->lay);
+	}
+
+	virtual void TearDown()
+	{
+		DEG_evaluation_context_free(eval_ctx);
+		/* Frees the scene depsgraph as well. */
+		BKE_main_free(bmain);
+		G.main = NULL;
+	}
+
+	Object *add_object(const char *name, Object *parent)
+	{
+		Object *ob = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+		ob->lay = scene->lay;
+		if (parent) {
+			ob->parent = parent;
+			ob->partype = PAROBJECT;
+		}
+		BKE_scene_base_add(scene, ob);
+		return ob;
+	}
+
+	void move_all(float offset)
+	{
+		Object *obs[4] = {ob_p, ob_a, ob_b, ob_c};
+		for (int i = 0; i < 4; i++) {
+			obs[i]->loc[0] += offset;
+			DEG_id_tag_update_ex(bmain, &obs[i]->id, OB_RECALC_OB);
+		}
+	}
+
+	Main *bmain;
+	Scene *scene;
+	EvaluationContext *eval_ctx;
+	Object *ob_p, *ob_a, *ob_b, *ob_c;
+};
+
+TEST_F(DepsgraphPartialEvalTest, TransformTarget)
+{
+	EXPECT_EQ(0.0f, ob_a->obmat[3][0]);
+	EXPECT_EQ(0.0f, ob_c->obmat[3][0]);
+
+	move_all(1.0f);
+
+	DEGEvalTarget target = {&ob_a->id, DEG_OB_COMP_TRANSFORM};
+	DEG_evaluate_targets_on_framechange(eval_ctx, bmain, scene->depsgraph, 2.0f, scene->lay, &target, 1);
+
+	/* The target and what it depends on are evaluated. */
+	EXPECT_EQ(1.0f, ob_p->obmat[3][0]);
+	EXPECT_EQ(2.0f, ob_a->obmat[3][0]);
+	/* Unrelated objects and dependents of the target are not. */
+	EXPECT_EQ(0.0f, ob_b->obmat[3][0]);
+	EXPECT_EQ(0.0f, ob_c->obmat[3][0]);
+
+	/* They are still tagged, and picked up by the next full update. */
+	EXPECT_TRUE(DEG_needs_eval(scene->depsgraph));
+	DEG_evaluate_on_refresh(eval_ctx, scene->depsgraph, scene);
+	EXPECT_EQ(1.0f, ob_b->obmat[3][0]);
+	EXPECT_EQ(3.0f, ob_c->obmat[3][0]);
+}
+
+TEST_F(DepsgraphPartialEvalTest, AllComponents)
+{
+	move_all(1.0f);
+
+	DEGEvalTarget target = {&ob_b->id, DEG_EVAL_TARGET_ALL_COMPONENTS};
+	DEG_evaluate_targets_on_framechange(eval_ctx, bmain, scene->depsgraph, 2.0f, scene->lay, &target, 1);
+
+	EXPECT_EQ(1.0f, ob_b->obmat[3][0]);
+	EXPECT_EQ(0.0f, ob_p->obmat[3][0]);
+	EXPECT_EQ(0.0f, ob_a->obmat[3][0]);
+	EXPECT_EQ(0.0f, ob_c->obmat[3][0]);
+}
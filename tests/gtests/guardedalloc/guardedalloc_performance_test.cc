@@ -0,0 +1,84 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <pthread.h>
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_memarena.h"
+#include "PIL_time_utildefines.h"
+}
+
+#include "MEM_guardedalloc.h"
+
+/* Allocation pattern of modifier evaluation and BMesh operators:
+ * many short-lived small buffers, freed shortly after allocation. */
+
+#define NUM_THREADS 4
+#define NUM_ITERATIONS 1000000
+#define NUM_LIVE 16
+
+namespace {
+
+void *MallocFreeThread(void * /*arg*/)
+{
+	void *live[NUM_LIVE] = {NULL};
+	for (int i = 0; i < NUM_ITERATIONS; i++) {
+		const int slot = i % NUM_LIVE;
+		if (live[slot]) {
+			MEM_freeN(live[slot]);
+		}
+		live[slot] = MEM_mallocN((size_t)((i * 7) % 512) + 8, __func__);
+	}
+	for (int slot = 0; slot < NUM_LIVE; slot++) {
+		MEM_freeN(live[slot]);
+	}
+	return NULL;
+}
+
+void *ArenaScopeThread(void * /*arg*/)
+{
+	for (int i = 0; i < NUM_ITERATIONS / NUM_LIVE; i++) {
+		MemArenaMark mark;
+		MemArena *arena = BLI_memarena_scope_begin(&mark);
+		for (int j = 0; j < NUM_LIVE; j++) {
+			void *mem = BLI_memarena_alloc(arena, (size_t)(((i + j) * 7) % 512) + 8);
+			UNUSED_VARS(mem);
+		}
+		BLI_memarena_scope_end(&mark);
+	}
+	BLI_memarena_thread_local_free();
+	return NULL;
+}
+
+void RunThreads(void *(*func)(void *))
+{
+	pthread_t threads[NUM_THREADS];
+	for (int i = 0; i < NUM_THREADS; i++) {
+		pthread_create(&threads[i], NULL, func, NULL);
+	}
+	for (int i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+}
+
+}  // namespace
+
+/* Order matters, pooled mode can't be disabled once enabled. */
+TEST(guardedalloc, PerformanceMallocFree)
+{
+	TIMEIT_START(lockfree_malloc_free);
+	RunThreads(MallocFreeThread);
+	TIMEIT_END(lockfree_malloc_free);
+
+	TIMEIT_START(arena_scope);
+	RunThreads(ArenaScopeThread);
+	TIMEIT_END(arena_scope);
+
+	MEM_use_pooled_allocator();
+
+	TIMEIT_START(pooled_malloc_free);
+	RunThreads(MallocFreeThread);
+	TIMEIT_END(pooled_malloc_free);
+}
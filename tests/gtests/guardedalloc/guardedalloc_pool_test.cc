@@ -0,0 +1,93 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+namespace {
+
+void *AllocFreeThread(void * /*arg*/)
+{
+	for (int i = 0; i < 1000; i++) {
+		void *mem = MEM_mallocN((size_t)(i % 300) + 1, "AllocFreeThread");
+		memset(mem, i & 0xff, MEM_allocN_len(mem));
+		MEM_freeN(mem);
+	}
+	return NULL;
+}
+
+}  // namespace
+
+TEST(guardedalloc, PooledReuse)
+{
+	MEM_use_pooled_allocator();
+	const unsigned int totblock = MEM_get_memory_blocks_in_use();
+
+	void *mem = MEM_mallocN(24, "PooledReuse");
+	EXPECT_EQ(MEM_allocN_len(mem), 24);
+	MEM_freeN(mem);
+	EXPECT_EQ(MEM_get_memory_blocks_in_use(), totblock);
+
+	/* Different size in the same class, block is reused. */
+	void *mem_reuse = MEM_mallocN(20, "PooledReuse");
+	EXPECT_EQ(MEM_allocN_len(mem_reuse), 20);
+	EXPECT_EQ(MEM_get_memory_blocks_in_use(), totblock + 1);
+	EXPECT_EQ(mem, mem_reuse);
+	MEM_freeN(mem_reuse);
+}
+
+TEST(guardedalloc, PooledCalloc)
+{
+	MEM_use_pooled_allocator();
+
+	char *mem = (char *)MEM_mallocN(64, "PooledCalloc");
+	memset(mem, 255, 64);
+	MEM_freeN(mem);
+
+	char *mem_zero = (char *)MEM_callocN(64, "PooledCalloc");
+	for (int i = 0; i < 64; i++) {
+		EXPECT_EQ(mem_zero[i], 0);
+	}
+	MEM_freeN(mem_zero);
+}
+
+TEST(guardedalloc, PooledRealloc)
+{
+	MEM_use_pooled_allocator();
+	const size_t mem_in_use = MEM_get_memory_in_use();
+
+	int *mem = (int *)MEM_mallocN(sizeof(int) * 4, "PooledRealloc");
+	for (int i = 0; i < 4; i++) {
+		mem[i] = i;
+	}
+	/* Grow past the largest size class. */
+	mem = (int *)MEM_reallocN(mem, sizeof(int) * 1024);
+	EXPECT_EQ(MEM_allocN_len(mem), sizeof(int) * 1024);
+	for (int i = 0; i < 4; i++) {
+		EXPECT_EQ(mem[i], i);
+	}
+	mem = (int *)MEM_reallocN(mem, sizeof(int) * 2);
+	EXPECT_EQ(mem[1], 1);
+	MEM_freeN(mem);
+	EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+}
+
+TEST(guardedalloc, PooledThreads)
+{
+	MEM_use_pooled_allocator();
+	const unsigned int totblock = MEM_get_memory_blocks_in_use();
+	const size_t mem_in_use = MEM_get_memory_in_use();
+
+	pthread_t threads[4];
+	for (int i = 0; i < 4; i++) {
+		pthread_create(&threads[i], NULL, AllocFreeThread, NULL);
+	}
+	for (int i = 0; i < 4; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	EXPECT_EQ(MEM_get_memory_blocks_in_use(), totblock);
+	EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+}
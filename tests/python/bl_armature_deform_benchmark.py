@@ -0,0 +1,142 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+
+# <pep8 compliant>
+
+"""
+Measure playback speed of a single dense mesh deformed by an armature,
+optionally followed by a lattice:
+
+./blender.bin --background --factory-startup -t 8 \
+    --python tests/python/bl_armature_deform_benchmark.py -- \
+    --verts=1000000 \
+    --bones=32 \
+    --frames=50 \
+    --deform=GROUPS
+"""
+
+import os
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+def rig_create(scene, bones, verts, deform):
+    arm = bpy.data.armatures.new("Rig")
+    ob_arm = bpy.data.objects.new(arm.name, arm)
+    scene.objects.link(ob_arm)
+    scene.objects.active = ob_arm
+
+    # One chain of bones along X, across the whole grid.
+    bpy.ops.object.mode_set(mode='EDIT')
+    parent = None
+    step = 2.0 / bones
+    for b in range(bones):
+        eb = arm.edit_bones.new("b%d" % b)
+        eb.head = -1.0 + step * b, 0.0, 0.0
+        eb.tail = -1.0 + step * (b + 1), 0.0, 0.0
+        eb.envelope_distance = step
+        eb.bbone_segments = 4
+        if parent is not None:
+            eb.parent = parent
+            eb.use_connect = True
+        parent = eb
+    bpy.ops.object.mode_set(mode='OBJECT')
+
+    for pb in ob_arm.pose.bones:
+        pb.rotation_mode = 'XYZ'
+        for frame, value in ((1, 0.0), (25, 0.1), (50, -0.1)):
+            pb.rotation_euler.z = value
+            pb.keyframe_insert("rotation_euler", frame=frame)
+    for fcu in ob_arm.animation_data.action.fcurves:
+        fcu.modifiers.new('CYCLES')
+
+    cuts = max(int(verts ** 0.5), 2)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=cuts, y_subdivisions=cuts, radius=1.0)
+    ob = bpy.context.object
+
+    if deform in {'GROUPS', 'LATTICE'}:
+        # Every vertex is weighted to the bone above it and its neighbor.
+        columns = [[] for _ in range(bones)]
+        for v in ob.data.vertices:
+            b = min(int((v.co.x + 1.0) / step), bones - 1)
+            columns[b].append(v.index)
+        groups = [ob.vertex_groups.new("b%d" % b) for b in range(bones)]
+        for b, indices in enumerate(columns):
+            groups[b].add(indices, 0.75, 'REPLACE')
+            if b + 1 < bones:
+                groups[b + 1].add(indices, 0.25, 'REPLACE')
+
+    mod = ob.modifiers.new("Armature", 'ARMATURE')
+    mod.object = ob_arm
+    mod.use_vertex_groups = deform != 'ENVELOPE'
+    mod.use_bone_envelopes = deform == 'ENVELOPE'
+
+    if deform == 'LATTICE':
+        lt = bpy.data.lattices.new("Lattice")
+        lt.points_u = lt.points_v = lt.points_w = 4
+        ob_lt = bpy.data.objects.new(lt.name, lt)
+        ob_lt.scale = 2.2, 2.2, 1.0
+        scene.objects.link(ob_lt)
+        for i, point in enumerate(lt.points):
+            point.co_deform.z += 0.1 * (i % 3)
+        mod = ob.modifiers.new("Lattice", 'LATTICE')
+        mod.object = ob_lt
+
+    return ob
+
+
+def deform_benchmark(verts=1000000, bones=32, frames=50, deform='GROUPS'):
+    scene = bpy.context.scene
+    ob = rig_create(scene, bones, verts, deform)
+    scene.update()
+
+    # Warm up.
+    for frame in range(1, 4):
+        scene.frame_set(frame)
+
+    times = bl_benchmark_utils.frame_times(scene, [frame % 50 + 1 for frame in range(frames)])
+
+    print("verts=%d  bones=%d  deform=%s  fps=%.2f  %s" % (
+        len(ob.data.vertices), bones, deform,
+        frames / sum(times),
+        bl_benchmark_utils.times_report(times),
+    ))
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__)
+    parser.add_argument("--verts", type=int, default=1000000, help="Approximate vertices of the deformed mesh")
+    parser.add_argument("--bones", type=int, default=32, help="Number of bones in the chain")
+    parser.add_argument("--frames", type=int, default=50, help="Number of frames to play back")
+    parser.add_argument(
+        "--deform", default='GROUPS', choices=('GROUPS', 'ENVELOPE', 'LATTICE'),
+        help="Deform using vertex groups, bone envelopes, or vertex groups followed by a lattice")
+    args, _ = bl_benchmark_utils.parse_args(parser)
+
+    deform_benchmark(verts=args.verts, bones=args.bones, frames=args.frames, deform=args.deform)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
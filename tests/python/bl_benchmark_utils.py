@@ -0,0 +1,138 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Helpers shared by the bl_*_benchmark.py scripts.
+
+Benchmarks print their timings, those with results which must not depend on
+the number of threads also print a "checksum=..." line per result. Passing
+--threads=1,4 runs the benchmark again in a new Blender process for each
+thread count, and exits with an error when the checksums differ.
+"""
+
+import hashlib
+import os
+import struct
+import subprocess
+import sys
+import time
+
+import bpy
+
+CHECKSUM_PREFIX = "checksum="
+
+
+def argument_parser(description, threads=False):
+    import argparse
+
+    parser = argparse.ArgumentParser(description=description)
+    if threads:
+        parser.add_argument(
+            "--threads", default="",
+            help="Comma separated thread counts, run once with each and fail when the checksums differ")
+    return parser
+
+
+def parse_args(parser):
+    argv = sys.argv
+    argv = argv[argv.index("--") + 1:] if "--" in argv else []
+    return parser.parse_args(argv), argv
+
+
+def timeit(fn):
+    t = time.perf_counter()
+    fn()
+    return time.perf_counter() - t
+
+
+def frame_times(scene, frames):
+    """Time setting each frame of the sequence *frames*."""
+    times = []
+    for frame in frames:
+        t = time.perf_counter()
+        scene.frame_set(frame)
+        times.append(time.perf_counter() - t)
+    return times
+
+
+def times_report(times):
+    times = sorted(times)
+    return "median=%.3fms  max=%.3fms  total=%.3fs" % (
+        times[len(times) // 2] * 1000.0,
+        times[-1] * 1000.0,
+        sum(times),
+    )
+
+
+def float_checksum(values):
+    return hashlib.md5(struct.pack("%df" % len(values), *values)).hexdigest()
+
+
+def checksum_print(checksum):
+    print(CHECKSUM_PREFIX + checksum)
+    sys.stdout.flush()
+
+
+def _run_threads(script, argv, threads):
+    env = dict(os.environ, OMP_NUM_THREADS=str(threads))
+    command = [
+        bpy.app.binary_path,
+        "--background", "-noaudio", "--factory-startup",
+        "--python-exit-code", "1",
+        "-t", str(threads),
+        "--python", script, "--",
+    ] + argv
+
+    print("Running with %d threads" % threads)
+    sys.stdout.flush()
+    output = subprocess.check_output(command, env=env, universal_newlines=True)
+    sys.stdout.write(output)
+    return [line[len(CHECKSUM_PREFIX):] for line in output.splitlines() if line.startswith(CHECKSUM_PREFIX)]
+
+
+def threads_compare(script, argv, threads):
+    """
+    Run *script* with the arguments *argv* once for every thread count in the
+    comma separated *threads*, and return 0 when all runs printed the same
+    checksums, 1 otherwise.
+    """
+    argv = [arg for arg in argv if not arg.startswith("--threads")]
+    thread_counts = [int(t) for t in threads.split(",")]
+
+    results = []
+    for t in thread_counts:
+        try:
+            results.append(_run_threads(script, argv, t))
+        except subprocess.CalledProcessError as ex:
+            print("Run with %d threads failed: %s" % (t, ex))
+            return 1
+
+    if not results[0]:
+        print("No checksums printed")
+        return 1
+
+    for t, checksums in zip(thread_counts[1:], results[1:]):
+        if checksums != results[0]:
+            print("Checksums with %d threads %r differ from %d threads %r" % (
+                t, checksums, thread_counts[0], results[0]))
+            return 1
+
+    print("Checksums match for %s threads" % threads)
+    return 0
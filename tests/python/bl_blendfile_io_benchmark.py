@@ -0,0 +1,105 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure .blend save and load time and file size for each compression mode.
+
+./blender.bin --background --factory-startup --python tests/python/bl_blendfile_io_benchmark.py -- \
+    --objects=200 \
+    --verts=100000 \
+    --repeat=3 \
+    --directory=/tmp
+"""
+
+import os
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+from bl_benchmark_utils import timeit
+
+
+# (name, compress, compress_fast)
+MODES = (
+    ("none", False, False),
+    ("gzip", True, False),
+    ("lzo", True, True),
+)
+
+
+def scene_create(objects, verts):
+    cuts = max(int(verts ** 0.5) - 2, 0)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=cuts + 2, y_subdivisions=cuts + 2)
+    ob_src = bpy.context.object
+    scene = bpy.context.scene
+    for i in range(objects - 1):
+        ob = ob_src.copy()
+        ob.data = ob_src.data.copy()
+        ob.location = (i % 100) * 3.0, (i // 100) * 3.0, 0.0
+        scene.objects.link(ob)
+    scene.update()
+
+
+def io_benchmark(objects=200, verts=100000, repeat=3, directory="/tmp"):
+    scene_create(objects, verts)
+
+    filepath_src = os.path.join(directory, "bl_blendfile_io_benchmark_src.blend")
+    bpy.ops.wm.save_as_mainfile(filepath=filepath_src)
+
+    for name, compress, compress_fast in MODES:
+        filepath = os.path.join(directory, "bl_blendfile_io_benchmark_%s.blend" % name)
+
+        bpy.ops.wm.open_mainfile(filepath=filepath_src)
+        times_save = [
+            timeit(lambda: bpy.ops.wm.save_as_mainfile(
+                filepath=filepath, compress=compress, compress_fast=compress_fast, copy=True))
+            for _ in range(repeat)
+        ]
+        times_load = [
+            timeit(lambda: bpy.ops.wm.open_mainfile(filepath=filepath))
+            for _ in range(repeat)
+        ]
+
+        print("%-5s size=%.2fmb  save=%.3fs  load=%.3fs" % (
+            name,
+            os.path.getsize(filepath) / (1024.0 * 1024.0),
+            min(times_save),
+            min(times_load),
+        ))
+        os.remove(filepath)
+
+    os.remove(filepath_src)
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__)
+    parser.add_argument("--objects", type=int, default=200, help="Number of mesh objects")
+    parser.add_argument("--verts", type=int, default=100000, help="Approximate vertices per mesh")
+    parser.add_argument("--repeat", type=int, default=3, help="Number of timed runs, the fastest is reported")
+    parser.add_argument("--directory", default="/tmp", help="Directory to write the test files into")
+    args, _ = bl_benchmark_utils.parse_args(parser)
+
+    io_benchmark(objects=args.objects, verts=args.verts, repeat=args.repeat, directory=args.directory)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure listing and linking a few data-blocks from a (large) library file.
+
+./blender.bin --background --factory-startup --python tests/python/bl_blendfile_library_link_benchmark.py -- \
+    --library=/path/to/assets.blend \
+    --type=objects \
+    --count=10 \
+    --repeat=3
+
+Uncompressed libraries are memory mapped, so only the data of linked blocks is read.
+Without --library, a library of --library-objects mesh objects is written first.
+"""
+
+import os
+import sys
+import tempfile
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+from bl_benchmark_utils import timeit
+
+
+def library_create(filepath, objects, verts):
+    cuts = max(int(verts ** 0.5) - 2, 0)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=cuts + 2, y_subdivisions=cuts + 2)
+    ob_src = bpy.context.object
+    datablocks = {ob_src}
+    for _ in range(objects - 1):
+        ob = ob_src.copy()
+        ob.data = ob_src.data.copy()
+        datablocks.add(ob)
+    bpy.data.libraries.write(filepath, datablocks)
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+
+
+def library_names(filepath, id_type):
+    with bpy.data.libraries.load(filepath) as (data_from, data_to):
+        return list(getattr(data_from, id_type))
+
+
+def library_link(filepath, id_type, names, link):
+    with bpy.data.libraries.load(filepath, link=link) as (data_from, data_to):
+        setattr(data_to, id_type, names)
+
+
+def link_benchmark(filepath, id_type="objects", count=10, repeat=3):
+    names = []
+
+    def names_fn():
+        names[:] = library_names(filepath, id_type)
+
+    times_names = [timeit(names_fn) for _ in range(repeat)]
+    names_link = names[:count]
+
+    results = [("names", times_names)]
+    for link in (True, False):
+        times = []
+        for _ in range(repeat):
+            bpy.ops.wm.read_factory_settings(use_empty=True)
+            times.append(timeit(lambda: library_link(filepath, id_type, names_link, link)))
+        results.append(("link" if link else "append", times))
+
+    print("%s: %d %s, using %d" % (filepath, len(names), id_type, len(names_link)))
+    for name, times in results:
+        print("%-6s best=%.3fs  mean=%.3fs" % (name, min(times), sum(times) / len(times)))
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__)
+    parser.add_argument("--library", default="", help="Library .blend file")
+    parser.add_argument("--library-objects", type=int, default=1000,
+                        help="Number of objects of the library written when --library isn't given")
+    parser.add_argument("--type", default="objects", help="Data-block type, as named in bpy.data")
+    parser.add_argument("--count", type=int, default=10, help="Number of data-blocks to link and append")
+    parser.add_argument("--repeat", type=int, default=3, help="Number of timed runs")
+    args, _ = bl_benchmark_utils.parse_args(parser)
+
+    if args.library:
+        link_benchmark(args.library, id_type=args.type, count=args.count, repeat=args.repeat)
+    else:
+        with tempfile.TemporaryDirectory() as directory:
+            filepath = os.path.join(directory, "library.blend")
+            library_create(filepath, args.library_objects, 1000)
+            link_benchmark(filepath, id_type=args.type, count=args.count, repeat=args.repeat)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+
+# <pep8 compliant>
+
+"""
+Measure simulation time per frame of a hanging cloth sheet, and print a checksum
+of the final vertex positions. The checksum must be the same for any number of
+threads, --threads runs the benchmark with each thread count and compares:
+
+./blender.bin --background --factory-startup -t 8 \
+    --python tests/python/bl_cloth_solver_benchmark.py -- \
+    --verts=40000 \
+    --frames=20 \
+    --threads=1,8
+"""
+
+import os
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+def cloth_create(scene, verts, quality):
+    cuts = max(int(verts ** 0.5), 2)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=cuts, y_subdivisions=cuts, radius=1.0)
+    ob = bpy.context.object
+    ob.rotation_euler.x = 1.2
+
+    # Pin the top edge.
+    pin = ob.vertex_groups.new("Pin")
+    pin.add([v.index for v in ob.data.vertices if v.co.y > 0.999], 1.0, 'REPLACE')
+
+    md = ob.modifiers.new("Cloth", 'CLOTH')
+    md.settings.quality = quality
+    md.settings.use_pin_cloth = True
+    md.settings.vertex_group_mass = pin.name
+    md.collision_settings.use_collision = False
+    md.collision_settings.use_self_collision = False
+    md.point_cache.frame_end = scene.frame_end
+
+    return ob
+
+
+def positions_checksum(scene, ob):
+    mesh = ob.to_mesh(scene, True, 'PREVIEW')
+    co = [0.0] * (len(mesh.vertices) * 3)
+    mesh.vertices.foreach_get("co", co)
+    bpy.data.meshes.remove(mesh)
+    return bl_benchmark_utils.float_checksum(co)
+
+
+def cloth_benchmark(verts=40000, frames=20, quality=5):
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = frames + 1
+    ob = cloth_create(scene, verts, quality)
+    scene.frame_set(1)
+
+    times = bl_benchmark_utils.frame_times(scene, range(2, frames + 2))
+
+    print("verts=%d  frames=%d  quality=%d  %s" % (
+        len(ob.data.vertices), frames, quality,
+        bl_benchmark_utils.times_report(times),
+    ))
+    bl_benchmark_utils.checksum_print(positions_checksum(scene, ob))
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__, threads=True)
+    parser.add_argument("--verts", type=int, default=40000, help="Approximate vertices of the cloth sheet")
+    parser.add_argument("--frames", type=int, default=20, help="Number of frames to simulate")
+    parser.add_argument("--quality", type=int, default=5, help="Cloth solver steps per frame")
+    args, argv = bl_benchmark_utils.parse_args(parser)
+
+    if args.threads:
+        sys.exit(bl_benchmark_utils.threads_compare(__file__, argv, args.threads))
+
+    cloth_benchmark(verts=args.verts, frames=args.frames, quality=args.quality)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,143 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure animation playback speed of rigged characters (armature -> mesh deform -> subsurf).
+
+Reports frames per second and the share of core time the evaluation left idle,
+computed from wall clock time and process CPU time:
+
+./blender.bin --background --factory-startup --enable-new-depsgraph -t 8 \
+    --python tests/python/bl_depsgraph_playback_benchmark.py -- \
+    --rigs=8 \
+    --chains=20 \
+    --bones=10 \
+    --verts=10000 \
+    --frames=100 \
+    --threads=8
+"""
+
+import math
+import os
+import sys
+import time
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+def rig_create(scene, index, chains, bones, verts):
+    offset = index * 4.0
+
+    arm = bpy.data.armatures.new("Rig%d" % index)
+    ob_arm = bpy.data.objects.new(arm.name, arm)
+    ob_arm.location = offset, 0.0, 0.0
+    scene.objects.link(ob_arm)
+    scene.objects.active = ob_arm
+
+    # Fan of bone chains, each bone parented to the previous one.
+    bpy.ops.object.mode_set(mode='EDIT')
+    for c in range(chains):
+        angle = 2.0 * math.pi * c / chains
+        direction = math.cos(angle) / bones, math.sin(angle) / bones, 0.0
+        parent = None
+        for b in range(bones):
+            eb = arm.edit_bones.new("c%d_b%d" % (c, b))
+            eb.head = tuple(d * b for d in direction)
+            eb.tail = tuple(d * (b + 1) for d in direction)
+            eb.envelope_distance = 0.5
+            if parent is not None:
+                eb.parent = parent
+                eb.use_connect = True
+            parent = eb
+    bpy.ops.object.mode_set(mode='OBJECT')
+
+    for i, pb in enumerate(ob_arm.pose.bones):
+        pb.rotation_mode = 'XYZ'
+        for frame, value in ((1, 0.0), (25, 0.3), (50, -0.3)):
+            pb.rotation_euler.z = value * (1 + i % 3)
+            pb.keyframe_insert("rotation_euler", frame=frame)
+    for fcu in ob_arm.animation_data.action.fcurves:
+        fcu.modifiers.new('CYCLES')
+
+    cuts = max(int(verts ** 0.5) - 2, 0)
+    bpy.ops.mesh.primitive_grid_add(
+        x_subdivisions=cuts + 2, y_subdivisions=cuts + 2, radius=1.0, location=(offset, 0.0, 0.0))
+    ob = bpy.context.object
+    mod = ob.modifiers.new("Armature", 'ARMATURE')
+    mod.object = ob_arm
+    mod.use_vertex_groups = False
+    mod.use_bone_envelopes = True
+    mod = ob.modifiers.new("Subsurf", 'SUBSURF')
+    mod.levels = 1
+
+
+def playback_benchmark(rigs=8, chains=20, bones=10, verts=10000, frames=100, threads=0):
+    scene = bpy.context.scene
+    for i in range(rigs):
+        rig_create(scene, i, chains, bones, verts)
+    scene.update()
+
+    threads = threads or os.cpu_count()
+
+    # Warm up, so per-operation timings used for scheduling are known.
+    for frame in range(1, 4):
+        scene.frame_set(frame)
+
+    wall = time.perf_counter()
+    cpu = time.process_time()
+    frame_times = bl_benchmark_utils.frame_times(scene, [frame % 50 + 1 for frame in range(frames)])
+    wall = time.perf_counter() - wall
+    cpu = time.process_time() - cpu
+
+    frame_times.sort()
+    idle = max(wall * threads - cpu, 0.0)
+    print("frames=%d  threads=%d  fps=%.2f  median=%.3fms  max=%.3fms" % (
+        frames, threads,
+        frames / wall,
+        frame_times[len(frame_times) // 2] * 1000.0,
+        frame_times[-1] * 1000.0,
+    ))
+    print("core time: busy=%.3fs  idle=%.3fs (%.1f%%)" % (
+        cpu, idle, idle / (wall * threads) * 100.0))
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__)
+    parser.add_argument("--rigs", type=int, default=8, help="Number of rigged characters")
+    parser.add_argument("--chains", type=int, default=20, help="Bone chains per rig")
+    parser.add_argument("--bones", type=int, default=10, help="Bones per chain")
+    parser.add_argument("--verts", type=int, default=10000, help="Approximate vertices per deformed mesh")
+    parser.add_argument("--frames", type=int, default=100, help="Number of frames to play back")
+    parser.add_argument("--threads", type=int, default=0, help="Threads used by evaluation (default: all cores)")
+    args, _ = bl_benchmark_utils.parse_args(parser)
+
+    playback_benchmark(
+        rigs=args.rigs, chains=args.chains, bones=args.bones,
+        verts=args.verts, frames=args.frames, threads=args.threads,
+    )
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure how long dependency graph relations update takes after adding and
+removing objects and modifiers in a large scene.
+
+./blender.bin --background --factory-startup --enable-new-depsgraph \
+    --python tests/python/bl_depsgraph_relations_update_benchmark.py -- \
+    --objects=5000 \
+    --iterations=50
+"""
+
+import os
+import sys
+import time
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+def scene_populate(scene, objects):
+    mesh = bpy.data.meshes.new("Mesh")
+    mesh.from_pydata(((0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (0.0, 1.0, 0.0)), (), ((0, 1, 2),))
+    parent = None
+    for i in range(objects):
+        ob = bpy.data.objects.new("Object%d" % i, mesh)
+        ob.location = (i % 100) * 2.0, (i // 100) * 2.0, 0.0
+        # Short parent chains, so the graph has some relations to keep.
+        if i % 10 != 0:
+            ob.parent = parent
+        parent = ob
+        scene.objects.link(ob)
+    return mesh
+
+
+def timed_update(scene, timings, key):
+    timings.setdefault(key, []).append(bl_benchmark_utils.timeit(scene.update))
+
+
+def relations_update_benchmark(objects=5000, iterations=50):
+    scene = bpy.context.scene
+    mesh = scene_populate(scene, objects)
+
+    t = time.perf_counter()
+    scene.update()
+    print("objects=%d  initial build=%.3fms" % (objects, (time.perf_counter() - t) * 1000.0))
+
+    timings = {}
+    for i in range(iterations):
+        ob = bpy.data.objects.new("Extra%d" % i, mesh)
+        scene.objects.link(ob)
+        timed_update(scene, timings, "add object")
+
+        md = ob.modifiers.new("Subsurf", 'SUBSURF')
+        timed_update(scene, timings, "add modifier")
+
+        ob.modifiers.remove(md)
+        timed_update(scene, timings, "remove modifier")
+
+        scene.objects.unlink(ob)
+        timed_update(scene, timings, "remove object")
+
+    for key in ("add object", "add modifier", "remove modifier", "remove object"):
+        values = sorted(timings[key])
+        print("%-16s median=%.3fms  max=%.3fms" % (
+            key,
+            values[len(values) // 2] * 1000.0,
+            values[-1] * 1000.0,
+        ))
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__)
+    parser.add_argument("--objects", type=int, default=5000, help="Number of objects in the scene")
+    parser.add_argument("--iterations", type=int, default=50, help="Number of add/remove rounds")
+    args, _ = bl_benchmark_utils.parse_args(parser)
+
+    relations_update_benchmark(objects=args.objects, iterations=args.iterations)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
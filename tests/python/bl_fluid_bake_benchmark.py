@@ -0,0 +1,116 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+
+# <pep8 compliant>
+
+"""
+Measure bake time per frame of a block of fluid collapsing in a fluid
+simulation domain, at several domain resolutions, and print a checksum of
+the baked surfaces. The checksum must be the same for any number of threads,
+--threads runs the benchmark with each thread count and compares:
+
+./blender.bin --background --factory-startup -t 8 \
+    --python tests/python/bl_fluid_bake_benchmark.py -- \
+    --resolutions=64,128,192 \
+    --frames=20 \
+    --subdivisions=1 \
+    --threads=1,8
+"""
+
+import glob
+import gzip
+import hashlib
+import os
+import sys
+import tempfile
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+def fluid_scene_create(resolution, subdivisions, filepath):
+    bpy.ops.mesh.primitive_cube_add(radius=1.0, location=(0.0, 0.0, 0.0))
+    domain = bpy.context.object
+    domain.modifiers.new("Fluid", 'FLUID_SIMULATION')
+    settings = domain.modifiers["Fluid"].settings
+    settings.type = 'DOMAIN'
+    settings.resolution = resolution
+    settings.preview_resolution = 0
+    settings.surface_subdivisions = subdivisions
+    settings.filepath = filepath
+
+    bpy.ops.mesh.primitive_cube_add(radius=0.45, location=(-0.5, -0.5, 0.0))
+    fluid = bpy.context.object
+    fluid.scale = (1.0, 1.0, 2.0)
+    fluid.modifiers.new("Fluid", 'FLUID_SIMULATION')
+    fluid.modifiers["Fluid"].settings.type = 'FLUID'
+
+    return domain, [domain, fluid]
+
+
+def surface_checksum(filepath):
+    md5 = hashlib.md5()
+    for filename in sorted(glob.glob(os.path.join(filepath, "fluidsurface_final_*.bobj.gz"))):
+        with gzip.open(filename, "rb") as f:
+            md5.update(f.read())
+    return md5.hexdigest()
+
+
+def fluid_benchmark(resolution=64, frames=20, subdivisions=1):
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = frames
+
+    with tempfile.TemporaryDirectory() as filepath:
+        domain, objects = fluid_scene_create(resolution, subdivisions, filepath + os.sep)
+        scene.objects.active = domain
+
+        total = bl_benchmark_utils.timeit(bpy.ops.fluid.bake)
+
+        print("resolution=%d  subdivisions=%d  frames=%d  %.3fs/frame  total=%.3fs" % (
+            resolution, subdivisions, frames,
+            total / frames,
+            total,
+        ))
+        bl_benchmark_utils.checksum_print(surface_checksum(filepath))
+
+        for ob in objects:
+            bpy.data.objects.remove(ob)
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__, threads=True)
+    parser.add_argument("--resolutions", default="64,128,192", help="Comma separated domain resolutions")
+    parser.add_argument("--frames", type=int, default=20, help="Number of frames to bake")
+    parser.add_argument("--subdivisions", type=int, default=1, help="Surface subdivisions")
+    args, argv = bl_benchmark_utils.parse_args(parser)
+
+    if args.threads:
+        sys.exit(bl_benchmark_utils.threads_compare(__file__, argv, args.threads))
+
+    for resolution in [int(r) for r in args.resolutions.split(",")]:
+        fluid_benchmark(resolution=resolution, frames=args.frames, subdivisions=args.subdivisions)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
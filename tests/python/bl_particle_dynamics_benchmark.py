@@ -0,0 +1,126 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+
+# <pep8 compliant>
+
+"""
+Measure simulation time per frame of a block of SPH fluid or boid particles
+falling into a box, and print a checksum of the final particle locations.
+The checksum must be the same for any number of threads, --threads runs the
+benchmark with each thread count and compares:
+
+./blender.bin --background --factory-startup -t 8 \
+    --python tests/python/bl_particle_dynamics_benchmark.py -- \
+    --count=1000000 \
+    --frames=10 \
+    --physics=ALL \
+    --threads=1,8
+"""
+
+import os
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+# Average number of neighbors of a fluid particle.
+FLUID_NEIGHBORS = 30
+
+
+def particle_scene_create(count, physics):
+    bpy.ops.mesh.primitive_cube_add(radius=1.0, location=(0.0, 0.0, 0.0))
+    emitter = bpy.context.object
+    emitter.modifiers.new("Particles", 'PARTICLE_SYSTEM')
+    psys = emitter.particle_systems[0]
+
+    part = psys.settings
+    part.count = count
+    part.frame_start = 1
+    part.frame_end = 1
+    part.lifetime = 1000
+    part.emit_from = 'VOLUME'
+    part.distribution = 'RAND'
+    part.normal_factor = 0.0
+    part.physics_type = 'FLUID' if physics in {'DDR', 'CLASSICAL'} else 'BOIDS'
+
+    if part.physics_type == 'FLUID':
+        # Radius that gives every particle about FLUID_NEIGHBORS neighbors.
+        volume = 8.0
+        part.fluid.solver = physics
+        part.fluid.factor_radius = False
+        part.fluid.fluid_radius = (3.0 * FLUID_NEIGHBORS * volume / (4.0 * 3.14159 * count)) ** (1.0 / 3.0)
+        part.fluid.use_viscoelastic_springs = (physics == 'DDR')
+
+    bpy.ops.mesh.primitive_cube_add(radius=3.0, location=(0.0, 0.0, 1.0))
+    container = bpy.context.object
+    container.modifiers.new("Collision", 'COLLISION')
+
+    return emitter, [emitter, container]
+
+
+def location_checksum(emitter):
+    particles = emitter.particle_systems[0].particles
+    locations = [0.0] * (len(particles) * 3)
+    particles.foreach_get("location", locations)
+    return bl_benchmark_utils.float_checksum(locations)
+
+
+def particle_benchmark(count=1000000, frames=10, physics='DDR'):
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = frames + 1
+    emitter, objects = particle_scene_create(count, physics)
+    scene.frame_set(1)
+
+    times = bl_benchmark_utils.frame_times(scene, range(2, frames + 2))
+
+    print("physics=%s  count=%d  frames=%d  %s" % (
+        physics, count, frames,
+        bl_benchmark_utils.times_report(times),
+    ))
+    bl_benchmark_utils.checksum_print(location_checksum(emitter))
+
+    for ob in objects:
+        bpy.data.objects.remove(ob)
+    scene.frame_set(1)
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__, threads=True)
+    parser.add_argument("--count", type=int, default=1000000, help="Number of particles")
+    parser.add_argument("--frames", type=int, default=10, help="Number of frames to simulate")
+    parser.add_argument("--physics", default='ALL', choices=('DDR', 'CLASSICAL', 'BOIDS', 'ALL'),
+                        help="Fluid solver, or boids")
+    args, argv = bl_benchmark_utils.parse_args(parser)
+
+    if args.threads:
+        sys.exit(bl_benchmark_utils.threads_compare(__file__, argv, args.threads))
+
+    physics_types = ('DDR', 'CLASSICAL', 'BOIDS') if args.physics == 'ALL' else (args.physics,)
+    for physics in physics_types:
+        particle_benchmark(count=args.count, frames=args.frames, physics=physics)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --python tests/python/bl_pointcache_single_file.py -- --verbose
+import os
+import struct
+import tempfile
+import unittest
+
+import bpy
+
+CONTAINER_MAGIC = b"BPHYSPAK"
+# PTCacheContainerRecord: frame, flag, size
+CONTAINER_RECORD = struct.Struct("=iIQ")
+CONTAINER_REMOVED = 1
+
+
+def container_frames(filepath):
+    """Frames of a single file cache, fails on records not ending at the end of the file."""
+    with open(filepath, "rb") as f:
+        data = f.read()
+
+    assert data[:len(CONTAINER_MAGIC)] == CONTAINER_MAGIC
+    offset = len(CONTAINER_MAGIC) + struct.calcsize("=I")
+    frames = set()
+
+    while offset < len(data):
+        frame, flag, size = CONTAINER_RECORD.unpack_from(data, offset)
+        offset += CONTAINER_RECORD.size + size
+        assert offset <= len(data), "record of frame %d is cut off" % frame
+
+        if flag & CONTAINER_REMOVED:
+            frames.discard(frame)
+        else:
+            frames.add(frame)
+
+    return frames
+
+
+def particle_locations(psys):
+    return [tuple(p.location) for p in psys.particles if p.alive_state == 'ALIVE']
+
+
+class TestPointCacheSingleFile(unittest.TestCase):
+    def setUp(self):
+        self.tempdir = tempfile.TemporaryDirectory()
+        bpy.ops.wm.read_factory_settings()
+
+        scene = bpy.context.scene
+        scene.frame_start = 1
+        scene.frame_end = 10
+
+        bpy.ops.mesh.primitive_plane_add()
+        ob = bpy.context.object
+        ob.modifiers.new("Particles", 'PARTICLE_SYSTEM')
+        self.psys = ob.particle_systems[0]
+        self.psys.settings.count = 50
+        self.psys.settings.frame_start = 1
+        self.psys.settings.frame_end = 5
+        self.psys.settings.lifetime = 100
+
+        cache = self.psys.point_cache
+        cache.frame_start = 1
+        cache.frame_end = 10
+        cache.name = "single_file"
+
+        # disk caches need a saved file
+        bpy.ops.wm.save_as_mainfile(filepath=os.path.join(self.tempdir.name, "pointcache.blend"))
+        cache.use_disk_cache = True
+        cache.use_single_file = True
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+        self.tempdir.cleanup()
+
+    def cache_filepath(self):
+        cachedir = os.path.join(self.tempdir.name, "blendcache_pointcache")
+        files = [name for name in os.listdir(cachedir) if name.endswith(".bpack")]
+        self.assertEqual(len(files), 1)
+        return os.path.join(cachedir, files[0])
+
+    def simulate(self, frames):
+        locations = {}
+        for frame in frames:
+            bpy.context.scene.frame_set(frame)
+            locations[frame] = particle_locations(self.psys)
+        return locations
+
+    def test_append_after_truncated_record(self):
+        locations = self.simulate(range(1, 6))
+        # read the frames back, which waits for them to be written
+        self.simulate(range(1, 6))
+        filepath = self.cache_filepath()
+        self.assertIn(5, container_frames(filepath))
+
+        # record of an interrupted write, claiming more data than there is
+        with open(filepath, "ab") as f:
+            f.write(CONTAINER_RECORD.pack(6, 0, 1000))
+            f.write(b"\0" * 10)
+
+        locations.update(self.simulate(range(6, 11)))
+        self.assertEqual(self.simulate(range(1, 11)), locations)
+        self.assertLessEqual(set(range(5, 11)), container_frames(filepath))
+
+
+if __name__ == '__main__':
+    import sys
+
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
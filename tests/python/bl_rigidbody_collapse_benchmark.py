@@ -0,0 +1,146 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+
+
+# <pep8 compliant>
+
+"""
+Measure simulation time per frame of a collapsing field of stacked pieces,
+with the serial and the parallel rigid body solver, and print a checksum of the
+final piece locations. The checksum must be the same for both solvers, which
+--solver=ALL checks, and for any number of threads, which --threads checks by
+running the benchmark with each thread count:
+
+./blender.bin --background --factory-startup -t 8 \
+    --python tests/python/bl_rigidbody_collapse_benchmark.py -- \
+    --pieces=20000 \
+    --frames=50 \
+    --solver=ALL \
+    --threads=1,8
+"""
+
+import os
+import random
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+# Number of pieces stacked on top of each other.
+STACK_HEIGHT = 10
+
+
+def collapse_scene_create(scene, pieces, frames, parallel):
+    bpy.ops.mesh.primitive_plane_add(radius=500.0, location=(0.0, 0.0, 0.0))
+    ground = bpy.context.object
+    bpy.ops.rigidbody.object_add(type='PASSIVE')
+
+    rbw = scene.rigidbody_world
+    rbw.use_parallel_solver = parallel
+    rbw.point_cache.frame_start = 1
+    rbw.point_cache.frame_end = frames + 1
+
+    bpy.ops.mesh.primitive_cube_add(radius=0.25)
+    mesh = bpy.context.object.data
+    bpy.data.objects.remove(bpy.context.object)
+
+    # Leaning stacks, close enough to knock each other over.
+    rng = random.Random(0)
+    stacks = max(pieces // STACK_HEIGHT, 1)
+    columns = max(int(stacks ** 0.5), 1)
+    objects = []
+    for i in range(pieces):
+        stack, level = divmod(i, STACK_HEIGHT)
+        ob = bpy.data.objects.new("Piece", mesh)
+        ob.location = (
+            (stack % columns) * 0.8 + level * 0.05 + rng.uniform(-0.02, 0.02),
+            (stack // columns) * 0.8 + rng.uniform(-0.02, 0.02),
+            0.25 + level * 0.51,
+        )
+        scene.objects.link(ob)
+        objects.append(ob)
+
+    bpy.ops.object.select_all(action='DESELECT')
+    for ob in objects:
+        ob.select = True
+    scene.objects.active = objects[0]
+    bpy.ops.rigidbody.objects_add(type='ACTIVE')
+
+    return objects, ground
+
+
+def location_checksum(objects):
+    locations = []
+    for ob in objects:
+        locations.extend(ob.matrix_world.translation)
+    return bl_benchmark_utils.float_checksum(locations)
+
+
+def collapse_benchmark(pieces=20000, frames=50, parallel=True):
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = frames + 1
+    objects, ground = collapse_scene_create(scene, pieces, frames, parallel)
+    scene.frame_set(1)
+
+    times = bl_benchmark_utils.frame_times(scene, range(2, frames + 2))
+
+    print("solver=%s  pieces=%d  frames=%d  %s" % (
+        'PARALLEL' if parallel else 'SERIAL', pieces, frames,
+        bl_benchmark_utils.times_report(times),
+    ))
+    checksum = location_checksum(objects)
+    bl_benchmark_utils.checksum_print(checksum)
+
+    mesh = objects[0].data
+    for ob in objects + [ground]:
+        bpy.data.objects.remove(ob)
+    bpy.data.meshes.remove(mesh)
+    scene.frame_set(1)
+
+    return checksum
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__, threads=True)
+    parser.add_argument("--pieces", type=int, default=20000, help="Number of rigid body pieces")
+    parser.add_argument("--frames", type=int, default=50, help="Number of frames to simulate")
+    parser.add_argument("--solver", default='ALL', choices=('SERIAL', 'PARALLEL', 'ALL'),
+                        help="Constraint solver to use")
+    args, argv = bl_benchmark_utils.parse_args(parser)
+
+    if args.threads:
+        sys.exit(bl_benchmark_utils.threads_compare(__file__, argv, args.threads))
+
+    solvers = (False, True) if args.solver == 'ALL' else (args.solver == 'PARALLEL',)
+    checksums = [collapse_benchmark(pieces=args.pieces, frames=args.frames, parallel=parallel)
+                 for parallel in solvers]
+
+    if len(set(checksums)) != 1:
+        print("Checksums of the serial and the parallel solver differ")
+        sys.exit(1)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+
+# <pep8 compliant>
+
+"""
+Measure simulation time per frame of a smoke plume rising around an obstacle,
+for every pressure solver, and print a checksum of the final density grid.
+The checksum of a solver must be the same for any number of threads,
+--threads runs the benchmark with each thread count and compares:
+
+./blender.bin --background --factory-startup -t 8 \
+    --python tests/python/bl_smoke_solver_benchmark.py -- \
+    --resolution=128 \
+    --frames=20 \
+    --solver=ALL \
+    --threads=1,8
+"""
+
+import os
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+
+
+def smoke_scene_create(scene, resolution, solver, border):
+    bpy.ops.mesh.primitive_cube_add(radius=1.0)
+    domain = bpy.context.object
+    md = domain.modifiers.new("Smoke", 'SMOKE')
+    md.smoke_type = 'DOMAIN'
+    settings = md.domain_settings
+    settings.resolution_max = resolution
+    settings.pressure_solver = solver
+    settings.collision_extents = border
+    settings.point_cache.frame_start = scene.frame_start
+    settings.point_cache.frame_end = scene.frame_end
+
+    bpy.ops.mesh.primitive_ico_sphere_add(size=0.15, location=(0.0, 0.0, -0.8))
+    flow = bpy.context.object
+    flow.modifiers.new("Smoke", 'SMOKE').smoke_type = 'FLOW'
+
+    bpy.ops.mesh.primitive_ico_sphere_add(size=0.3, location=(0.1, 0.0, 0.1))
+    obstacle = bpy.context.object
+    obstacle.modifiers.new("Smoke", 'SMOKE').smoke_type = 'COLLISION'
+
+    return domain, [domain, flow, obstacle]
+
+
+def density_checksum(domain):
+    density = domain.modifiers["Smoke"].domain_settings.density_grid[:]
+    return bl_benchmark_utils.float_checksum(density)
+
+
+def smoke_benchmark(resolution=128, frames=20, solver='MGPCG', border='BORDERCLOSED'):
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = frames + 1
+    domain, objects = smoke_scene_create(scene, resolution, solver, border)
+    scene.frame_set(1)
+
+    times = bl_benchmark_utils.frame_times(scene, range(2, frames + 2))
+
+    print("solver=%s  resolution=%d  frames=%d  %s" % (
+        solver, resolution, frames,
+        bl_benchmark_utils.times_report(times),
+    ))
+    bl_benchmark_utils.checksum_print(density_checksum(domain))
+
+    for ob in objects:
+        bpy.data.objects.remove(ob)
+    scene.frame_set(1)
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__, threads=True)
+    parser.add_argument("--resolution", type=int, default=128, help="Divisions of the longest domain axis")
+    parser.add_argument("--frames", type=int, default=20, help="Number of frames to simulate")
+    parser.add_argument("--solver", default='ALL', choices=('PCG', 'MGPCG', 'ALL'), help="Pressure solver")
+    parser.add_argument("--border", default='BORDERCLOSED',
+                        choices=('BORDEROPEN', 'BORDERVERTICAL', 'BORDERCLOSED'), help="Domain border collisions")
+    args, argv = bl_benchmark_utils.parse_args(parser)
+
+    if args.threads:
+        sys.exit(bl_benchmark_utils.threads_compare(__file__, argv, args.threads))
+
+    solvers = ('PCG', 'MGPCG') if args.solver == 'ALL' else (args.solver,)
+    for solver in solvers:
+        smoke_benchmark(resolution=args.resolution, frames=args.frames, solver=solver, border=args.border)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()
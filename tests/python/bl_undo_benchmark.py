@@ -0,0 +1,117 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure global undo push/undo/redo latency over a scripted edit session.
+
+Undo and redo operators need a window, in background mode only pushes are timed:
+
+./blender.bin --factory-startup --debug --python tests/python/bl_undo_benchmark.py -- \
+    --objects=2000 \
+    --verts=10000 \
+    --steps=50
+
+With --debug, the size of each undo step which isn't shared with the previous one is printed too.
+"""
+
+import os
+import sys
+
+import bpy
+
+sys.path.append(os.path.dirname(__file__))
+import bl_benchmark_utils
+from bl_benchmark_utils import timeit
+
+
+def scene_create(objects, verts):
+    # Rows of planes, subdivided to reach roughly the requested vertex count per mesh.
+    cuts = max(int(verts ** 0.5) - 2, 0)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=cuts + 2, y_subdivisions=cuts + 2)
+    ob_src = bpy.context.object
+    scene = bpy.context.scene
+    for i in range(objects - 1):
+        ob = ob_src.copy()
+        ob.data = ob_src.data.copy()
+        ob.location = (i % 100) * 3.0, (i // 100) * 3.0, 0.0
+        scene.objects.link(ob)
+    scene.update()
+
+
+def edit_step(step):
+    # Typical small edits: move an object, change a mesh, add an object.
+    scene = bpy.context.scene
+    objects = scene.objects
+    kind = step % 3
+    if kind == 0:
+        ob = objects[step % len(objects)]
+        ob.location.z += 1.0
+    elif kind == 1:
+        me = objects[step % len(objects)].data
+        me.vertices[0].co.z += 0.1
+    else:
+        bpy.ops.object.empty_add(location=(0.0, 0.0, step * 0.1))
+
+
+def report(name, times):
+    times = sorted(times)
+    print("%-6s steps=%d  mean=%.3fms  median=%.3fms  max=%.3fms" % (
+        name, len(times),
+        sum(times) / len(times) * 1000.0,
+        times[len(times) // 2] * 1000.0,
+        times[-1] * 1000.0,
+    ))
+
+
+def undo_benchmark(objects=2000, verts=1000, steps=50):
+    scene_create(objects, verts)
+    bpy.ops.ed.undo_push(message="Initial")
+
+    times_push = []
+    for step in range(steps):
+        edit_step(step)
+        times_push.append(timeit(lambda: bpy.ops.ed.undo_push(message="Step %d" % step)))
+
+    report("push", times_push)
+
+    if bpy.context.window is not None:
+        times_undo = [timeit(bpy.ops.ed.undo) for _ in range(steps)]
+        times_redo = [timeit(bpy.ops.ed.redo) for _ in range(steps)]
+
+        report("undo", times_undo)
+        report("redo", times_redo)
+
+    bpy.ops.wm.memory_statistics()
+
+
+def main():
+    parser = bl_benchmark_utils.argument_parser(__doc__)
+    parser.add_argument("--objects", type=int, default=2000, help="Number of mesh objects")
+    parser.add_argument("--verts", type=int, default=1000, help="Approximate vertices per mesh")
+    parser.add_argument("--steps", type=int, default=50, help="Number of undo steps to push")
+    args, _ = bl_benchmark_utils.parse_args(parser)
+
+    undo_benchmark(objects=args.objects, verts=args.verts, steps=args.steps)
+
+    bpy.ops.wm.quit_blender()
+
+
+if __name__ == "__main__":
+    main()